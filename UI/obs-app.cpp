@@ -392,6 +392,10 @@ bool OBSApp::InitGlobalConfigDefaults()
 
 	config_set_default_bool(globalConfig, "BasicWindow", "PreviewEnabled",
 				true);
+	config_set_default_bool(globalConfig, "BasicWindow",
+				"PreviewPausedWhileActive", false);
+	config_set_default_double(globalConfig, "BasicWindow", "PreviewMaxFPS",
+				  60.0);
 	config_set_default_bool(globalConfig, "BasicWindow",
 				"PreviewProgramMode", false);
 	config_set_default_bool(globalConfig, "BasicWindow",
@@ -447,6 +451,9 @@ bool OBSApp::InitGlobalConfigDefaults()
 	config_set_default_bool(globalConfig, "BasicWindow",
 				"MultiviewDrawAreas", true);
 
+	config_set_default_uint(globalConfig, "BasicWindow",
+				"MultiviewThumbnailInterval", 2);
+
 #ifdef _WIN32
 	uint32_t winver = GetWindowsVersion();
 
@@ -5,6 +5,7 @@
 #include <QScreen>
 #include <QResizeEvent>
 #include <QShowEvent>
+#include <QHideEvent>
 
 static inline long long color_to_int(const QColor &color)
 {
@@ -33,6 +34,8 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 	setAttribute(Qt::WA_NativeWindow);
 
 	auto windowVisible = [this](bool visible) {
+		UpdateOccluded();
+
 		if (!visible)
 			return;
 
@@ -92,10 +95,18 @@ void OBSQTDisplay::CreateDisplay()
 	QTToGSWindow(winId(), info.window);
 
 	display = obs_display_create(&info, backgroundColor);
+	UpdateOccluded();
 
 	emit DisplayCreated(this);
 }
 
+/* displays that can't be seen are not rendered at all */
+void OBSQTDisplay::UpdateOccluded()
+{
+	bool minimized = topLevel && topLevel->isMinimized();
+	obs_display_set_occluded(display, !isVisible() || minimized);
+}
+
 void OBSQTDisplay::resizeEvent(QResizeEvent *event)
 {
 	QWidget::resizeEvent(event);
@@ -121,3 +132,32 @@ QPaintEngine *OBSQTDisplay::paintEngine() const
 {
 	return nullptr;
 }
+
+void OBSQTDisplay::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+
+	/* the top level window can change when docks are floated */
+	if (topLevel != window()) {
+		if (topLevel)
+			topLevel->removeEventFilter(this);
+		topLevel = window();
+		topLevel->installEventFilter(this);
+	}
+
+	UpdateOccluded();
+}
+
+void OBSQTDisplay::hideEvent(QHideEvent *event)
+{
+	QWidget::hideEvent(event);
+	UpdateOccluded();
+}
+
+bool OBSQTDisplay::eventFilter(QObject *obj, QEvent *event)
+{
+	if (obj == topLevel && event->type() == QEvent::WindowStateChange)
+		UpdateOccluded();
+
+	return QWidget::eventFilter(obj, event);
+}
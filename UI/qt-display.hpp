@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QWidget>
+#include <QPointer>
 #include <obs.hpp>
 
 #define GREY_COLOR_BACKGROUND 0xFF4C4C4C
@@ -17,6 +18,12 @@ class OBSQTDisplay : public QWidget {
 
 	void resizeEvent(QResizeEvent *event) override;
 	void paintEvent(QPaintEvent *event) override;
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+	bool eventFilter(QObject *obj, QEvent *event) override;
+
+	QPointer<QWidget> topLevel;
+	void UpdateOccluded();
 
 signals:
 	void DisplayCreated(OBSQTDisplay *window);
@@ -1663,6 +1663,9 @@ void OBSBasic::OBSInit()
 
 	previewEnabled = config_get_bool(App()->GlobalConfig(), "BasicWindow",
 					 "PreviewEnabled");
+	previewPausedWhileActive = config_get_bool(App()->GlobalConfig(),
+						   "BasicWindow",
+						   "PreviewPausedWhileActive");
 
 	if (!previewEnabled && !IsPreviewProgramMode())
 		QMetaObject::invokeMethod(this, "EnablePreviewDisplay",
@@ -1686,6 +1689,12 @@ void OBSBasic::OBSInit()
 		obs_display_add_draw_callback(window->GetDisplay(),
 					      OBSBasic::RenderMain, this);
 
+		double maxFPS = config_get_double(
+			App()->GlobalConfig(), "BasicWindow", "PreviewMaxFPS");
+		obs_display_set_max_fps(window->GetDisplay(), maxFPS);
+		obs_display_set_pause_while_active(window->GetDisplay(),
+						   previewPausedWhileActive);
+
 		struct obs_video_info ovi;
 		if (obs_get_video_info(&ovi))
 			ResizePreview(ovi.base_width, ovi.base_height);
@@ -2337,6 +2346,8 @@ OBSBasic::~OBSBasic()
 
 	config_set_bool(App()->GlobalConfig(), "BasicWindow", "PreviewEnabled",
 			previewEnabled);
+	config_set_bool(App()->GlobalConfig(), "BasicWindow",
+			"PreviewPausedWhileActive", previewPausedWhileActive);
 	config_set_bool(App()->GlobalConfig(), "BasicWindow", "AlwaysOnTop",
 			alwaysOnTop);
 	config_set_bool(App()->GlobalConfig(), "BasicWindow",
@@ -3425,7 +3436,9 @@ void OBSBasic::RenderMain(void *data, uint32_t cx, uint32_t cy)
 		OBSScene scene = window->GetCurrentScene();
 		obs_source_t *source = obs_scene_get_source(scene);
 		if (source)
-			obs_source_video_render(source);
+			obs_source_video_render_cached(
+				source, window->previewScale,
+				window->previewScale);
 	} else {
 		obs_render_main_texture_src_color_only();
 	}
@@ -4415,6 +4428,12 @@ void OBSBasic::CreateSourcePopupMenu(int idx, bool preview)
 		if (IsPreviewProgramMode())
 			action->setEnabled(false);
 
+		action = popup.addAction(
+			QTStr("Basic.Main.PreviewConextMenu.PauseWhileActive"),
+			this, SLOT(TogglePreviewPausedWhileActive()));
+		action->setCheckable(true);
+		action->setChecked(previewPausedWhileActive);
+
 		popup.addAction(ui->actionLockPreview);
 		popup.addMenu(ui->scalingMenu);
 
@@ -6374,6 +6393,13 @@ void OBSBasic::TogglePreview()
 	EnablePreviewDisplay(previewEnabled);
 }
 
+void OBSBasic::TogglePreviewPausedWhileActive()
+{
+	previewPausedWhileActive = !previewPausedWhileActive;
+	obs_display_set_pause_while_active(ui->preview->GetDisplay(),
+					   previewPausedWhileActive);
+}
+
 void OBSBasic::EnablePreview()
 {
 	if (previewProgramMode)
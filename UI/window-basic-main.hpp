@@ -186,6 +186,7 @@ private:
 	long disableSaving = 1;
 	bool projectChanged = false;
 	bool previewEnabled = true;
+	bool previewPausedWhileActive = false;
 
 	std::list<const char *> copyStrings;
 	const char *copyFiltersString = nullptr;
@@ -911,6 +912,7 @@ private slots:
 
 	void EnablePreviewDisplay(bool enable);
 	void TogglePreview();
+	void TogglePreviewPausedWhileActive();
 
 	void NudgeUp();
 	void NudgeDown();
@@ -148,6 +148,8 @@ OBSProjector::~OBSProjector()
 				obs_source_dec_showing(src);
 		}
 
+		SetMultiviewThumbnails({});
+
 		obs_enter_graphics();
 		gs_vertexbuffer_destroy(actionSafeMargin);
 		gs_vertexbuffer_destroy(graphicsSafeMargin);
@@ -427,6 +429,18 @@ void OBSProjector::OBSRenderMultiview(void *data, uint32_t cx, uint32_t cy)
 	};
 
 	// Define the whole usable region for the multiview
+	// Thumbnails are rendered at the size they are shown at
+	uint32_t thumbnailCX = uint32_t(window->siCX * scale);
+	uint32_t thumbnailCY = uint32_t(window->siCY * scale);
+	if (thumbnailCX != window->thumbnailCX ||
+	    thumbnailCY != window->thumbnailCY) {
+		for (obs_thumbnail_t *thumbnail : window->multiviewThumbnails)
+			obs_thumbnail_set_size(thumbnail, thumbnailCX,
+					       thumbnailCY);
+		window->thumbnailCX = thumbnailCX;
+		window->thumbnailCY = thumbnailCY;
+	}
+
 	startRegion(x, y, targetCX * scale, targetCY * scale, 0.0f, window->fw,
 		    0.0f, window->fh);
 
@@ -474,7 +488,8 @@ void OBSProjector::OBSRenderMultiview(void *data, uint32_t cx, uint32_t cy)
 		gs_matrix_translate3f(window->siX, window->siY, 0.0f);
 		gs_matrix_scale3f(window->siScaleX, window->siScaleY, 1.0f);
 		setRegion(window->siX, window->siY, window->siCX, window->siCY);
-		obs_source_video_render(src);
+		if (i < window->multiviewThumbnails.size())
+			obs_thumbnail_render(window->multiviewThumbnails[i]);
 		endRegion();
 		gs_matrix_pop();
 
@@ -521,7 +536,9 @@ void OBSProjector::OBSRenderMultiview(void *data, uint32_t cx, uint32_t cy)
 	setRegion(window->sourceX, window->sourceY, window->ppiCX,
 		  window->ppiCY);
 	if (studioMode)
-		obs_source_video_render(previewSrc);
+		obs_source_video_render_cached(previewSrc,
+					       window->ppiScaleX * scale,
+					       window->ppiScaleY * scale);
 	else
 		obs_render_main_texture();
 	if (drawSafeArea) {
@@ -656,7 +673,7 @@ void OBSProjector::OBSRender(void *data, uint32_t cx, uint32_t cy)
 	}
 
 	if (source)
-		obs_source_video_render(source);
+		obs_source_video_render_cached(source, scale, scale);
 	else
 		obs_render_main_texture();
 
@@ -857,11 +874,26 @@ void OBSProjector::EscapeTriggered()
 	main->DeleteProjector(this);
 }
 
+void OBSProjector::SetMultiviewThumbnails(
+	std::vector<obs_thumbnail_t *> thumbnails)
+{
+	/* the render callback uses the thumbnails on the graphics thread, so
+	 * they are only swapped while the graphics context is held */
+	obs_enter_graphics();
+	multiviewThumbnails.swap(thumbnails);
+	obs_leave_graphics();
+
+	for (obs_thumbnail_t *thumbnail : thumbnails)
+		obs_thumbnail_destroy(thumbnail);
+}
+
 void OBSProjector::UpdateMultiview()
 {
 	multiviewScenes.clear();
 	multiviewLabels.clear();
 
+	std::vector<obs_thumbnail_t *> thumbnails;
+
 	struct obs_video_info ovi;
 	obs_get_video_info(&ovi);
 
@@ -894,6 +926,9 @@ void OBSProjector::UpdateMultiview()
 	transitionOnDoubleClick = config_get_bool(
 		GetGlobalConfig(), "BasicWindow", "TransitionOnDoubleClick");
 
+	uint32_t thumbnailInterval = (uint32_t)config_get_uint(
+		GetGlobalConfig(), "BasicWindow", "MultiviewThumbnailInterval");
+
 	switch (multiviewLayout) {
 	case MultiviewLayout::HORIZONTAL_TOP_24_SCENES:
 		pvwprgCX = fw / 3;
@@ -936,6 +971,8 @@ void OBSProjector::UpdateMultiview()
 
 		multiviewScenes.emplace_back(OBSGetWeakRef(src));
 		obs_source_inc_showing(src);
+		thumbnails.push_back(obs_thumbnail_create(
+			src, thumbnailCX, thumbnailCY, thumbnailInterval));
 
 		std::string name = std::to_string(numSrcs) + " - " +
 				   obs_source_get_name(src);
@@ -943,6 +980,8 @@ void OBSProjector::UpdateMultiview()
 	}
 
 	obs_frontend_source_list_free(&scenes);
+
+	SetMultiviewThumbnails(std::move(thumbnails));
 }
 
 void OBSProjector::UpdateProjectorTitle(QString name)
@@ -40,6 +40,8 @@ private:
 	ProjectorType type = ProjectorType::Source;
 	std::vector<OBSWeakSource> multiviewScenes;
 	std::vector<OBSSource> multiviewLabels;
+	std::vector<obs_thumbnail_t *> multiviewThumbnails;
+	uint32_t thumbnailCX = 0, thumbnailCY = 0;
 	gs_vertbuffer_t *actionSafeMargin = nullptr;
 	gs_vertbuffer_t *graphicsSafeMargin = nullptr;
 	gs_vertbuffer_t *fourByThreeSafeMargin = nullptr;
@@ -70,6 +72,7 @@ private:
 	static const uint32_t programColor = 0xFFD00000;
 
 	void UpdateMultiview();
+	void SetMultiviewThumbnails(std::vector<obs_thumbnail_t *> thumbnails);
 	void UpdateProjectorTitle(QString name);
 
 	QRect prevGeometry;
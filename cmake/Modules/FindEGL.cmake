@@ -0,0 +1,33 @@
+# Once done these will be defined:
+#
+#  EGL_FOUND
+#  EGL_INCLUDE_DIRS
+#  EGL_LIBRARIES
+
+find_package(PkgConfig QUIET)
+if (PKG_CONFIG_FOUND)
+	pkg_check_modules(_EGL QUIET egl)
+endif()
+
+find_path(EGL_INCLUDE_DIR
+	NAMES EGL/egl.h
+	HINTS
+		${_EGL_INCLUDE_DIRS}
+	PATHS
+		/usr/include /usr/local/include /opt/local/include)
+
+find_library(EGL_LIB
+	NAMES EGL
+	HINTS
+		${_EGL_LIBRARY_DIRS}
+	PATHS
+		/usr/lib /usr/local/lib /opt/local/lib)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(EGL DEFAULT_MSG EGL_LIB EGL_INCLUDE_DIR)
+mark_as_advanced(EGL_INCLUDE_DIR EGL_LIB)
+
+if(EGL_FOUND)
+	set(EGL_INCLUDE_DIRS ${EGL_INCLUDE_DIR})
+	set(EGL_LIBRARIES ${EGL_LIB})
+endif()
@@ -23,14 +23,21 @@ static enum AVPixelFormat closest_format(enum AVPixelFormat fmt)
 		return AV_PIX_FMT_YUYV422;
 	case AV_PIX_FMT_YUV444P:
 		return AV_PIX_FMT_YUV444P;
-
 	case AV_PIX_FMT_YUV422P:
+		return AV_PIX_FMT_YUV422P;
+
+	/* 10-bit formats are converted on the GPU */
+	case AV_PIX_FMT_YUV420P10LE:
+	case AV_PIX_FMT_P010LE:
+	case AV_PIX_FMT_YUV422P10LE:
+	case AV_PIX_FMT_YUV444P10LE:
+		return fmt;
+
 	case AV_PIX_FMT_YUVJ422P:
 	case AV_PIX_FMT_UYVY422:
 	case AV_PIX_FMT_YUV422P16LE:
 	case AV_PIX_FMT_YUV422P16BE:
 	case AV_PIX_FMT_YUV422P10BE:
-	case AV_PIX_FMT_YUV422P10LE:
 	case AV_PIX_FMT_YUV422P9BE:
 	case AV_PIX_FMT_YUV422P9LE:
 	case AV_PIX_FMT_YVYU422:
@@ -54,7 +61,6 @@ static enum AVPixelFormat closest_format(enum AVPixelFormat fmt)
 	case AV_PIX_FMT_YUV420P9BE:
 	case AV_PIX_FMT_YUV420P9LE:
 	case AV_PIX_FMT_YUV420P10BE:
-	case AV_PIX_FMT_YUV420P10LE:
 	case AV_PIX_FMT_YUV420P12BE:
 	case AV_PIX_FMT_YUV420P12LE:
 	case AV_PIX_FMT_YUV420P14BE:
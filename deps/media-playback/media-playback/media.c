@@ -18,6 +18,7 @@
 #include <util/platform.h>
 
 #include <assert.h>
+#include <inttypes.h>
 
 #include "media.h"
 #include "closest-format.h"
@@ -40,6 +41,8 @@ static inline enum video_format convert_pixel_format(int f)
 		return VIDEO_FORMAT_YUY2;
 	case AV_PIX_FMT_YUV444P:
 		return VIDEO_FORMAT_I444;
+	case AV_PIX_FMT_YUV422P:
+		return VIDEO_FORMAT_I422;
 	case AV_PIX_FMT_UYVY422:
 		return VIDEO_FORMAT_UYVY;
 	case AV_PIX_FMT_RGBA:
@@ -54,6 +57,14 @@ static inline enum video_format convert_pixel_format(int f)
 		return VIDEO_FORMAT_I42A;
 	case AV_PIX_FMT_YUVA444P:
 		return VIDEO_FORMAT_YUVA;
+	case AV_PIX_FMT_YUV420P10LE:
+		return VIDEO_FORMAT_I010;
+	case AV_PIX_FMT_P010LE:
+		return VIDEO_FORMAT_P010;
+	case AV_PIX_FMT_YUV422P10LE:
+		return VIDEO_FORMAT_I210;
+	case AV_PIX_FMT_YUV444P10LE:
+		return VIDEO_FORMAT_I410;
 	default:;
 	}
 
@@ -225,7 +236,7 @@ static bool mp_media_init_scaling(mp_media_t *m)
 	return true;
 }
 
-static bool mp_media_prepare_frames(mp_media_t *m)
+static bool mp_media_decode_frames(mp_media_t *m)
 {
 	while (!mp_media_ready_to_start(m)) {
 		if (!m->eof) {
@@ -242,6 +253,14 @@ static bool mp_media_prepare_frames(mp_media_t *m)
 			return false;
 	}
 
+	return true;
+}
+
+static bool mp_media_prepare_frames(mp_media_t *m)
+{
+	if (!mp_media_decode_frames(m))
+		return false;
+
 	if (m->has_video && m->v.frame_ready && !m->swscale) {
 		m->scale_format = closest_format(m->v.frame->format);
 		if (m->scale_format != m->v.frame->format) {
@@ -254,10 +273,234 @@ static bool mp_media_prepare_frames(mp_media_t *m)
 	return true;
 }
 
+/* ------------------------------------------------------------------------- */
+/* loop cache */
+
+static void mp_cache_free(struct mp_cache *c)
+{
+	for (size_t i = 0; i < c->video.num; i++)
+		obs_source_frame_destroy(c->video.array[i].frame);
+	for (size_t i = 0; i < c->audio.num; i++) {
+		struct obs_source_audio *audio = &c->audio.array[i].audio;
+		for (size_t j = 0; j < MAX_AV_PLANES; j++)
+			bfree((void *)audio->data[j]);
+	}
+
+	da_free(c->video);
+	da_free(c->audio);
+	c->v_idx = 0;
+	c->a_idx = 0;
+	c->size = 0;
+	c->end_pts = 0;
+	c->caching = false;
+	c->complete = false;
+}
+
+static void mp_cache_abort(mp_media_t *m, const char *reason)
+{
+	blog(LOG_INFO, "MP: Not caching '%s': %s", m->path, reason);
+	mp_cache_free(&m->cache);
+	m->cache.failed = true;
+}
+
+static inline bool mp_cache_add_size(mp_media_t *m, size_t size)
+{
+	m->cache.size += size;
+	if (m->cache.size > m->cache_max_size) {
+		char reason[64];
+		snprintf(reason, sizeof(reason),
+			 "frames exceed the cache limit of %zu MB",
+			 m->cache_max_size / (1024 * 1024));
+		mp_cache_abort(m, reason);
+		return false;
+	}
+
+	return true;
+}
+
+static inline bool has_half_height_chroma(enum video_format format)
+{
+	return format == VIDEO_FORMAT_I420 || format == VIDEO_FORMAT_NV12 ||
+	       format == VIDEO_FORMAT_I40A || format == VIDEO_FORMAT_I010 ||
+	       format == VIDEO_FORMAT_P010;
+}
+
+static size_t get_frame_size(const struct obs_source_frame *frame)
+{
+	bool half_height = has_half_height_chroma(frame->format);
+	size_t size = 0;
+
+	for (size_t i = 0; i < MAX_AV_PLANES && frame->data[i]; i++) {
+		uint32_t lines = frame->height;
+		if (half_height && (i == 1 || i == 2))
+			lines /= 2;
+
+		size += (size_t)frame->linesize[i] * lines;
+	}
+
+	return size;
+}
+
+static void mp_cache_add_video(mp_media_t *m,
+			       const struct obs_source_frame *frame,
+			       int64_t pts)
+{
+	struct obs_source_frame *copy = obs_source_frame_create(
+		frame->format, frame->width, frame->height);
+	struct mp_cache_video *entry;
+
+	obs_source_frame_copy(copy, frame);
+
+	if (!mp_cache_add_size(m, get_frame_size(copy))) {
+		obs_source_frame_destroy(copy);
+		return;
+	}
+
+	entry = da_push_back_new(m->cache.video);
+	entry->frame = copy;
+	entry->pts = pts;
+}
+
+static void mp_cache_add_audio(mp_media_t *m,
+			       const struct obs_source_audio *audio,
+			       int64_t pts)
+{
+	size_t planes = get_audio_planes(audio->format, audio->speakers);
+	size_t size = get_audio_size(audio->format, audio->speakers,
+				     audio->frames);
+	struct mp_cache_audio *entry;
+
+	if (!size)
+		return;
+	if (!mp_cache_add_size(m, planes * size))
+		return;
+
+	entry = da_push_back_new(m->cache.audio);
+	entry->audio = *audio;
+	entry->pts = pts;
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		entry->audio.data[i] =
+			i < planes ? bmemdup(audio->data[i], size) : NULL;
+}
+
+static void mp_cache_begin(mp_media_t *m)
+{
+	struct mp_cache *c = &m->cache;
+	int64_t duration_ns;
+
+	if (!m->cache_max_ns || !m->is_local_file || c->complete || c->failed)
+		return;
+
+	/* restarting in the middle of the first pass records it again */
+	mp_cache_free(c);
+
+	if (m->fmt->duration == AV_NOPTS_VALUE) {
+		mp_cache_abort(m, "unknown duration");
+		return;
+	}
+
+	duration_ns = av_rescale_q(m->fmt->duration, AV_TIME_BASE_Q,
+				   (AVRational){1, 1000000000});
+	if (duration_ns > m->cache_max_ns) {
+		c->failed = true;
+		return;
+	}
+
+	c->caching = true;
+}
+
+static inline int64_t mp_cache_get_next_min_pts(struct mp_cache *c)
+{
+	int64_t min_next_ns = 0x7FFFFFFFFFFFFFFFLL;
+
+	if (c->v_idx < c->video.num) {
+		if (c->video.array[c->v_idx].pts < min_next_ns)
+			min_next_ns = c->video.array[c->v_idx].pts;
+	}
+	if (c->a_idx < c->audio.num) {
+		if (c->audio.array[c->a_idx].pts < min_next_ns)
+			min_next_ns = c->audio.array[c->a_idx].pts;
+	}
+
+	return min_next_ns;
+}
+
+static inline int64_t mp_cache_get_base_pts(struct mp_cache *c)
+{
+	bool v_ended = c->v_idx == c->video.num;
+	bool a_ended = c->a_idx == c->audio.num;
+	int64_t base_ts = 0;
+
+	if (v_ended && a_ended)
+		return c->end_pts;
+
+	if (!v_ended && c->video.array[c->v_idx].pts > base_ts)
+		base_ts = c->video.array[c->v_idx].pts;
+	if (!a_ended && c->audio.array[c->a_idx].pts > base_ts)
+		base_ts = c->audio.array[c->a_idx].pts;
+
+	return base_ts;
+}
+
+static inline int64_t mp_media_get_frame_ts(mp_media_t *m, int64_t pts)
+{
+	return m->base_ts + pts - m->start_ts + m->play_sys_ts - base_sys_ts;
+}
+
+static void mp_media_next_cached(mp_media_t *m)
+{
+	struct mp_cache *c = &m->cache;
+
+	if (c->v_idx < c->video.num) {
+		struct mp_cache_video *entry = &c->video.array[c->v_idx];
+
+		if (entry->pts <= m->next_pts_ns) {
+			c->v_idx++;
+
+			if (m->v_cb) {
+				entry->frame->timestamp =
+					mp_media_get_frame_ts(m, entry->pts);
+				m->v_cb(m->opaque, entry->frame);
+			}
+		}
+	}
+
+	if (c->a_idx < c->audio.num) {
+		struct mp_cache_audio *entry = &c->audio.array[c->a_idx];
+
+		if (entry->pts <= m->next_pts_ns) {
+			c->a_idx++;
+
+			if (m->a_cb) {
+				entry->audio.timestamp =
+					mp_media_get_frame_ts(m, entry->pts);
+				m->a_cb(m->opaque, &entry->audio);
+			}
+		}
+	}
+}
+
+static void mp_cache_preload(mp_media_t *m)
+{
+	struct mp_cache *c = &m->cache;
+
+	if (c->video.num) {
+		struct mp_cache_video *entry = &c->video.array[0];
+		entry->frame->timestamp = mp_media_get_frame_ts(m, entry->pts);
+		m->v_preload_cb(m->opaque, entry->frame);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
 static inline int64_t mp_media_get_next_min_pts(mp_media_t *m)
 {
 	int64_t min_next_ns = 0x7FFFFFFFFFFFFFFFLL;
 
+	if (m->cache.complete)
+		return mp_cache_get_next_min_pts(&m->cache);
+
 	if (m->has_video && m->v.frame_ready) {
 		if (m->v.frame_pts < min_next_ns)
 			min_next_ns = m->v.frame_pts;
@@ -297,7 +540,7 @@ static void mp_media_next_audio(mp_media_t *m)
 		return;
 
 	d->frame_ready = false;
-	if (!m->a_cb)
+	if (!m->a_cb && !m->prerolling)
 		return;
 
 	for (size_t i = 0; i < MAX_AV_PLANES; i++)
@@ -307,13 +550,16 @@ static void mp_media_next_audio(mp_media_t *m)
 	audio.speakers = convert_speaker_layout(f->channels);
 	audio.format = convert_sample_format(f->format);
 	audio.frames = f->nb_samples;
-	audio.timestamp = m->base_ts + d->frame_pts - m->start_ts +
-			  m->play_sys_ts - base_sys_ts;
+	audio.timestamp = mp_media_get_frame_ts(m, d->frame_pts);
 
 	if (audio.format == AUDIO_FORMAT_UNKNOWN)
 		return;
 
-	m->a_cb(m->opaque, &audio);
+	if (!m->prerolling)
+		m->a_cb(m->opaque, &audio);
+
+	if (m->cache.caching)
+		mp_cache_add_audio(m, &audio, d->frame_pts);
 }
 
 static void mp_media_next_video(mp_media_t *m, bool preload)
@@ -331,7 +577,7 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 
 		d->frame_ready = false;
 
-		if (!m->v_cb)
+		if (!m->v_cb && !m->prerolling)
 			return;
 	} else if (!d->frame_ready) {
 		return;
@@ -394,8 +640,7 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 	if (frame->format == VIDEO_FORMAT_NONE)
 		return;
 
-	frame->timestamp = m->base_ts + d->frame_pts - m->start_ts +
-			   m->play_sys_ts - base_sys_ts;
+	frame->timestamp = mp_media_get_frame_ts(m, d->frame_pts);
 	frame->width = f->width;
 	frame->height = f->height;
 	frame->flip = flip;
@@ -407,10 +652,15 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 		d->got_first_keyframe = true;
 	}
 
-	if (preload)
+	if (preload) {
 		m->v_preload_cb(m->opaque, frame);
-	else
-		m->v_cb(m->opaque, frame);
+	} else {
+		if (!m->prerolling)
+			m->v_cb(m->opaque, frame);
+
+		if (m->cache.caching)
+			mp_cache_add_video(m, frame, d->frame_pts);
+	}
 }
 
 static void mp_media_calc_next_ns(mp_media_t *m)
@@ -430,13 +680,11 @@ static void mp_media_calc_next_ns(mp_media_t *m)
 	m->next_pts_ns = min_next_ns;
 }
 
-static bool mp_media_reset(mp_media_t *m)
+static void mp_media_seek_start(mp_media_t *m)
 {
 	AVStream *stream = m->fmt->streams[0];
 	int64_t seek_pos;
 	int seek_flags;
-	bool stopping;
-	bool active;
 
 	if (m->fmt->duration == AV_NOPTS_VALUE) {
 		seek_pos = 0;
@@ -463,11 +711,88 @@ static bool mp_media_reset(mp_media_t *m)
 		mp_decode_flush(&m->v);
 	if (m->has_audio && m->is_local_file)
 		mp_decode_flush(&m->a);
+}
 
-	int64_t next_ts = mp_media_get_base_pts(m);
-	int64_t offset = next_ts - m->next_pts_ns;
+/* must only be called while the standby thread is idle */
+static void mp_standby_swap(mp_media_t *m)
+{
+	mp_media_t *s = m->standby.media;
+	AVFormatContext *fmt = m->fmt;
+	struct mp_decode v = m->v;
+	struct mp_decode a = m->a;
+	bool eof = m->eof;
+
+	m->fmt = s->fmt;
+	m->v = s->v;
+	m->a = s->a;
+	m->eof = s->eof;
+
+	s->fmt = fmt;
+	s->v = v;
+	s->a = a;
+	s->eof = eof;
+
+	m->v.m = m->a.m = m;
+	s->v.m = s->a.m = s;
+}
+
+/* must only be called while the standby thread is idle */
+static void mp_standby_free_context(mp_media_t *m)
+{
+	mp_media_t *s = m->standby.media;
+
+	if (s) {
+		mp_decode_free(&s->v);
+		mp_decode_free(&s->a);
+		avformat_close_input(&s->fmt);
+		s->eof = false;
+	}
+
+	m->standby.ready = false;
+}
+
+/* swaps the primed standby context in at a loop point.  the context that
+ * was just played becomes the standby and is rewound on the next request */
+static bool mp_standby_take(mp_media_t *m)
+{
+	struct mp_standby *s = &m->standby;
+	bool ready;
+
+	if (!s->thread_valid)
+		return false;
+
+	pthread_mutex_lock(&s->mutex);
+	ready = s->ready && !s->busy;
+	if (ready) {
+		mp_standby_swap(m);
+		s->ready = false;
+	}
+	pthread_mutex_unlock(&s->mutex);
+
+	return ready;
+}
+
+static bool mp_media_reset(mp_media_t *m)
+{
+	bool stopping;
+	bool active;
+	int64_t next_ts;
+
+	if (m->cache.complete) {
+		next_ts = mp_cache_get_base_pts(&m->cache);
+		m->cache.v_idx = 0;
+		m->cache.a_idx = 0;
+	} else {
+		next_ts = mp_media_get_base_pts(m);
+
+		if (!mp_standby_take(m))
+			mp_media_seek_start(m);
+		m->eof = false;
 
-	m->eof = false;
+		mp_cache_begin(m);
+	}
+
+	int64_t offset = next_ts - m->next_pts_ns;
 	m->base_ts += next_ts;
 
 	pthread_mutex_lock(&m->mutex);
@@ -476,7 +801,7 @@ static bool mp_media_reset(mp_media_t *m)
 	m->stopping = false;
 	pthread_mutex_unlock(&m->mutex);
 
-	if (!mp_media_prepare_frames(m))
+	if (!m->cache.complete && !mp_media_prepare_frames(m))
 		return false;
 
 	if (active) {
@@ -491,8 +816,12 @@ static bool mp_media_reset(mp_media_t *m)
 		m->next_ns = 0;
 	}
 
-	if (!active && m->is_local_file && m->v_preload_cb)
-		mp_media_next_video(m, true);
+	if (!active && m->is_local_file && m->v_preload_cb) {
+		if (m->cache.complete)
+			mp_cache_preload(m);
+		else
+			mp_media_next_video(m, true);
+	}
 	if (stopping && m->stop_cb)
 		m->stop_cb(m->opaque);
 	return true;
@@ -519,10 +848,154 @@ static inline bool mp_media_sleepto(mp_media_t *m)
 	return timeout;
 }
 
+static void mp_cache_finish(mp_media_t *m)
+{
+	struct mp_cache *c = &m->cache;
+
+	c->caching = false;
+
+	if (!c->video.num && !c->audio.num) {
+		mp_cache_abort(m, "no frames");
+		return;
+	}
+
+	c->complete = true;
+	c->end_pts = mp_media_get_base_pts(m);
+	c->v_idx = c->video.num;
+	c->a_idx = c->audio.num;
+
+	blog(LOG_INFO,
+	     "MP: Cached %zu video and %zu audio frames (%zu KB) "
+	     "of '%s'",
+	     c->video.num, c->audio.num, c->size / 1024, m->path);
+
+	/* the decoders are no longer needed for looping.  if the standby
+	 * thread is still priming, its context is freed with the media */
+	if (m->standby.thread_valid) {
+		pthread_mutex_lock(&m->standby.mutex);
+		if (!m->standby.busy)
+			mp_standby_free_context(m);
+		pthread_mutex_unlock(&m->standby.mutex);
+	}
+}
+
+static inline bool mp_media_killed(mp_media_t *m)
+{
+	bool kill;
+
+	pthread_mutex_lock(&m->mutex);
+	kill = m->kill;
+	pthread_mutex_unlock(&m->mutex);
+
+	return kill;
+}
+
+/* decodes the whole file into the cache as fast as possible before it is
+ * first played, so starting playback never has to wait on the decoders.
+ * if the file does not fit in the cache, it is played from the start as
+ * usual instead. */
+/* memory the decoded video frames of the file take, going by its duration
+ * and frame rate, or 0 if that can't be told before decoding */
+static size_t mp_media_estimate_video_size(mp_media_t *m)
+{
+	AVRational rate;
+	double frames;
+	int frame_size;
+
+	if (!m->has_video || m->fmt->duration == AV_NOPTS_VALUE)
+		return 0;
+
+	rate = m->v.stream->avg_frame_rate;
+	if (!rate.num || !rate.den)
+		return 0;
+
+	/* fails for hardware formats, whose frame size isn't known yet */
+	frame_size = av_image_get_buffer_size(m->v.decoder->pix_fmt,
+					      m->v.decoder->width,
+					      m->v.decoder->height, 1);
+	if (frame_size <= 0)
+		return 0;
+
+	frames = (double)m->fmt->duration / AV_TIME_BASE * av_q2d(rate);
+	return (size_t)(frames * frame_size);
+}
+
+static void mp_media_preroll(mp_media_t *m)
+{
+	struct mp_cache *c = &m->cache;
+	uint64_t start_time = os_gettime_ns();
+	size_t estimate;
+
+	if (!m->preroll || !m->is_local_file)
+		return;
+
+	/* don't spend the time decoding a file that can't fit */
+	estimate = mp_media_estimate_video_size(m);
+	if (estimate > m->cache_max_size) {
+		blog(LOG_WARNING,
+		     "MP: Not prerolling '%s': its frames need about %zu MB, "
+		     "more than the limit of %zu MB.  It is decoded during "
+		     "playback instead",
+		     m->path, estimate / (1024 * 1024),
+		     m->cache_max_size / (1024 * 1024));
+		c->failed = true;
+		return;
+	}
+
+	c->caching = true;
+	m->prerolling = true;
+	m->next_pts_ns = 0x7FFFFFFFFFFFFFFFLL;
+
+	while (c->caching) {
+		if (!mp_media_prepare_frames(m)) {
+			mp_cache_abort(m, "failed to decode");
+			break;
+		}
+		if (mp_media_killed(m)) {
+			mp_cache_abort(m, "media closed");
+			break;
+		}
+
+		bool v_ready = m->has_video && m->v.frame_ready;
+		bool a_ready = m->has_audio && m->a.frame_ready;
+
+		if (!v_ready && !a_ready) {
+			mp_cache_finish(m);
+			break;
+		}
+
+		if (v_ready)
+			mp_media_next_video(m, false);
+		if (a_ready)
+			mp_media_next_audio(m);
+	}
+
+	m->prerolling = false;
+	m->next_pts_ns = 0;
+
+	if (c->complete) {
+		blog(LOG_INFO, "MP: Prerolled '%s' in %" PRIu64 " ms", m->path,
+		     (os_gettime_ns() - start_time) / 1000000);
+	} else {
+		blog(LOG_WARNING,
+		     "MP: Could not preroll '%s', it is decoded during "
+		     "playback instead",
+		     m->path);
+		mp_media_seek_start(m);
+		m->eof = false;
+	}
+}
+
 static inline bool mp_media_eof(mp_media_t *m)
 {
 	bool v_ended = !m->has_video || !m->v.frame_ready;
 	bool a_ended = !m->has_audio || !m->a.frame_ready;
+
+	if (m->cache.complete) {
+		v_ended = m->cache.v_idx == m->cache.video.num;
+		a_ended = m->cache.a_idx == m->cache.audio.num;
+	}
+
 	bool eof = v_ended && a_ended;
 
 	if (eof) {
@@ -536,6 +1009,9 @@ static inline bool mp_media_eof(mp_media_t *m)
 		}
 		pthread_mutex_unlock(&m->mutex);
 
+		if (m->cache.caching)
+			mp_cache_finish(m);
+
 		mp_media_reset(m);
 	}
 
@@ -611,6 +1087,147 @@ static bool init_avformat(mp_media_t *m)
 	return true;
 }
 
+/* asks the standby thread to open (or rewind) the standby context if it is
+ * not primed yet */
+static void mp_standby_request(mp_media_t *m)
+{
+	struct mp_standby *s = &m->standby;
+	bool looping;
+	bool post;
+
+	if (!s->thread_valid || m->cache.complete)
+		return;
+
+	pthread_mutex_lock(&m->mutex);
+	looping = m->looping;
+	pthread_mutex_unlock(&m->mutex);
+
+	if (!looping)
+		return;
+
+	pthread_mutex_lock(&s->mutex);
+	post = !s->busy && !s->ready && !s->failed;
+	if (post)
+		s->busy = true;
+	pthread_mutex_unlock(&s->mutex);
+
+	if (post)
+		os_sem_post(s->sem);
+}
+
+/* opens (or rewinds) the standby context and decodes its first frames.  only
+ * called on the standby thread, which owns the context while it is busy */
+static bool mp_standby_prime(mp_media_t *m)
+{
+	mp_media_t *s = m->standby.media;
+
+	if (!s->fmt) {
+		if (!init_avformat(s))
+			return false;
+		if (s->has_video != m->has_video ||
+		    s->has_audio != m->has_audio)
+			return false;
+	} else {
+		mp_media_seek_start(s);
+	}
+
+	s->eof = false;
+	return mp_media_decode_frames(s);
+}
+
+static void *mp_standby_thread(void *opaque)
+{
+	mp_media_t *m = opaque;
+	struct mp_standby *s = &m->standby;
+
+	os_set_thread_name("mp_standby_thread");
+
+	while (os_sem_wait(s->sem) == 0) {
+		bool kill;
+		bool success;
+
+		pthread_mutex_lock(&s->mutex);
+		kill = s->kill;
+		pthread_mutex_unlock(&s->mutex);
+
+		if (kill)
+			break;
+
+		success = mp_standby_prime(m);
+		if (!success)
+			blog(LOG_WARNING,
+			     "MP: Failed to preload next loop of '%s'",
+			     m->path);
+
+		pthread_mutex_lock(&s->mutex);
+		if (!success) {
+			mp_standby_free_context(m);
+			s->failed = true;
+		}
+		s->ready = success;
+		s->busy = false;
+		pthread_mutex_unlock(&s->mutex);
+	}
+
+	return NULL;
+}
+
+static bool mp_standby_init(mp_media_t *m)
+{
+	struct mp_standby *s = &m->standby;
+	mp_media_t *c;
+
+	if (!m->seamless_loop || !m->is_local_file)
+		return true;
+
+	if (pthread_mutex_init(&s->mutex, NULL) != 0) {
+		blog(LOG_WARNING, "MP: Failed to init standby mutex");
+		return false;
+	}
+	if (os_sem_init(&s->sem, 0) != 0) {
+		blog(LOG_WARNING, "MP: Failed to init standby semaphore");
+		return false;
+	}
+
+	c = s->media = bzalloc(sizeof(*c));
+	c->path = m->path;
+	c->format_name = m->format_name;
+	c->buffering = m->buffering;
+	c->speed = m->speed;
+	c->is_local_file = m->is_local_file;
+	c->hw = m->hw;
+
+	if (pthread_create(&s->thread, NULL, mp_standby_thread, m) != 0) {
+		blog(LOG_WARNING, "MP: Could not create standby thread");
+		return false;
+	}
+
+	s->thread_valid = true;
+	return true;
+}
+
+static void mp_standby_free(mp_media_t *m)
+{
+	struct mp_standby *s = &m->standby;
+
+	if (s->thread_valid) {
+		pthread_mutex_lock(&s->mutex);
+		s->kill = true;
+		pthread_mutex_unlock(&s->mutex);
+		os_sem_post(s->sem);
+
+		pthread_join(s->thread, NULL);
+		s->thread_valid = false;
+	}
+
+	mp_standby_free_context(m);
+	bfree(s->media);
+	s->media = NULL;
+	pthread_mutex_destroy(&s->mutex);
+	os_sem_destroy(s->sem);
+	s->sem = NULL;
+}
+
 static inline bool mp_media_thread(mp_media_t *m)
 {
 	os_set_thread_name("mp_media_thread");
@@ -618,6 +1235,9 @@ static inline bool mp_media_thread(mp_media_t *m)
 	if (!init_avformat(m)) {
 		return false;
 	}
+
+	mp_media_preroll(m);
+
 	if (!mp_media_reset(m)) {
 		return false;
 	}
@@ -656,17 +1276,23 @@ static inline bool mp_media_thread(mp_media_t *m)
 
 		/* frames are ready */
 		if (is_active && !timeout) {
-			if (m->has_video)
-				mp_media_next_video(m, false);
-			if (m->has_audio)
-				mp_media_next_audio(m);
+			if (m->cache.complete) {
+				mp_media_next_cached(m);
+			} else {
+				if (m->has_video)
+					mp_media_next_video(m, false);
+				if (m->has_audio)
+					mp_media_next_audio(m);
+
+				if (!mp_media_prepare_frames(m))
+					return false;
+			}
 
-			if (!mp_media_prepare_frames(m))
-				return false;
 			if (mp_media_eof(m))
 				continue;
 
 			mp_media_calc_next_ns(m);
+			mp_standby_request(m);
 		}
 	}
 
@@ -702,6 +1328,9 @@ static inline bool mp_media_init_internal(mp_media_t *m,
 	m->format_name = info->format ? bstrdup(info->format) : NULL;
 	m->hw = info->hardware_decoding;
 
+	if (!mp_standby_init(m))
+		return false;
+
 	if (pthread_create(&m->thread, NULL, mp_media_thread_start, m) != 0) {
 		blog(LOG_WARNING, "MP: Could not create media thread");
 		return false;
@@ -715,6 +1344,7 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 {
 	memset(media, 0, sizeof(*media));
 	pthread_mutex_init_value(&media->mutex);
+	pthread_mutex_init_value(&media->standby.mutex);
 	media->opaque = info->opaque;
 	media->v_cb = info->v_cb;
 	media->a_cb = info->a_cb;
@@ -724,6 +1354,14 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 	media->buffering = info->buffering;
 	media->speed = info->speed;
 	media->is_local_file = info->is_local_file;
+	media->seamless_loop = info->seamless_loop;
+	media->cache_max_ns = (int64_t)info->loop_cache_seconds * 1000000000LL;
+	media->cache_max_size = (size_t)info->loop_cache_max_mb * 1024 * 1024;
+	media->preroll = info->preroll_max_mb > 0;
+
+	if (media->preroll)
+		media->cache_max_size = (size_t)info->preroll_max_mb * 1024 *
+					1024;
 
 	if (!info->is_local_file || media->speed < 1 || media->speed > 200)
 		media->speed = 100;
@@ -772,6 +1410,8 @@ void mp_media_free(mp_media_t *media)
 	mp_decode_free(&media->v);
 	mp_decode_free(&media->a);
 	avformat_close_input(&media->fmt);
+	mp_standby_free(media);
+	mp_cache_free(&media->cache);
 	pthread_mutex_destroy(&media->mutex);
 	os_sem_destroy(media->sem);
 	sws_freeContext(media->swscale);
@@ -780,6 +1420,7 @@ void mp_media_free(mp_media_t *media)
 	bfree(media->format_name);
 	memset(media, 0, sizeof(*media));
 	pthread_mutex_init_value(&media->mutex);
+	pthread_mutex_init_value(&media->standby.mutex);
 }
 
 void mp_media_play(mp_media_t *m, bool loop)
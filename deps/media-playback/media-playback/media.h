@@ -33,6 +33,7 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libswscale/swscale.h>
 #include <util/threading.h>
+#include <util/darray.h>
 
 #ifdef _MSC_VER
 #pragma warning(pop)
@@ -42,6 +43,48 @@ typedef void (*mp_video_cb)(void *opaque, struct obs_source_frame *frame);
 typedef void (*mp_audio_cb)(void *opaque, struct obs_source_audio *audio);
 typedef void (*mp_stop_cb)(void *opaque);
 
+struct mp_cache_video {
+	struct obs_source_frame *frame;
+	int64_t pts;
+};
+
+struct mp_cache_audio {
+	struct obs_source_audio audio;
+	int64_t pts;
+};
+
+/* decoded frames of a short looping file, recorded during the first pass
+ * and replayed on subsequent passes without touching the decoders */
+struct mp_cache {
+	DARRAY(struct mp_cache_video) video;
+	DARRAY(struct mp_cache_audio) audio;
+	size_t v_idx;
+	size_t a_idx;
+	size_t size;
+	int64_t end_pts;
+	bool caching;
+	bool complete;
+	bool failed;
+};
+
+/* second demux/decode context kept primed at the start of the file so that
+ * a loop point only has to swap contexts instead of seeking and decoding.
+ * it is opened and rewound on its own thread so that priming it never
+ * delays the frames of the media thread. */
+struct mp_standby {
+	struct mp_media *media;
+
+	pthread_mutex_t mutex;
+	os_sem_t *sem;
+	bool busy;
+	bool ready;
+	bool failed;
+	bool kill;
+
+	bool thread_valid;
+	pthread_t thread;
+};
+
 struct mp_media {
 	AVFormatContext *fmt;
 
@@ -83,6 +126,14 @@ struct mp_media {
 
 	uint64_t interrupt_poll_ts;
 
+	bool seamless_loop;
+	int64_t cache_max_ns;
+	size_t cache_max_size;
+	bool preroll;
+	bool prerolling;
+	struct mp_standby standby;
+	struct mp_cache cache;
+
 	pthread_mutex_t mutex;
 	os_sem_t *sem;
 	bool stopping;
@@ -112,6 +163,15 @@ struct mp_media_info {
 	enum video_range_type force_range;
 	bool hardware_decoding;
 	bool is_local_file;
+	bool seamless_loop;
+	int loop_cache_seconds;
+
+	/* memory limit of the loop cache, in megabytes */
+	int loop_cache_max_mb;
+
+	/* if above zero, the file is fully decoded into a cache of at most
+	 * this many megabytes when opened, and played from it */
+	int preroll_max_mb;
 };
 
 extern bool mp_media_init(mp_media_t *media, const struct mp_media_info *info);
@@ -30,6 +30,10 @@ struct obs_script {
 	struct dstr path;
 	struct dstr file;
 	struct dstr desc;
+
+	/* protected by the exec mutex in obs-scripting.c */
+	struct obs_script_exec_stats exec;
+	uint64_t last_slow_warn;
 };
 
 struct script_callback;
@@ -37,6 +41,24 @@ typedef void (*defer_call_cb)(void *param);
 
 extern void defer_call_post(defer_call_cb call, void *cb);
 
+/* runs a call on the script thread */
+extern void script_call_post(defer_call_cb call, void *cb);
+
+typedef void (*script_tick_cb)(void *param, float seconds);
+
+extern void script_tick_add(script_tick_cb tick, void *param);
+extern void script_tick_remove(script_tick_cb tick, void *param);
+
+/* accounts the time spent in a script's code, calls may be nested */
+struct script_exec {
+	obs_script_t *script;
+	uint64_t start;
+	bool outer;
+};
+
+extern void script_exec_begin(struct script_exec *exec, obs_script_t *script);
+extern void script_exec_end(struct script_exec *exec);
+
 extern void script_log(obs_script_t *script, int level, const char *format,
 		       ...);
 extern void script_log_va(obs_script_t *script, int level, const char *format,
@@ -316,7 +316,7 @@ static int timer_add(lua_State *script)
 	struct lua_obs_timer *timer = lua_obs_callback_extra_data(cb);
 
 	timer->interval = (uint64_t)ms * 1000000ULL;
-	timer->last_ts = obs_get_video_frame_time();
+	timer->last_ts = os_gettime_ns();
 
 	defer_call_post(defer_timer_init, cb);
 	return 0;
@@ -378,7 +378,7 @@ static void obs_lua_tick_callback(void *priv, float seconds)
 	lua_State *script = cb->script;
 
 	if (cb->base.removed) {
-		obs_remove_tick_callback(obs_lua_tick_callback, cb);
+		script_tick_remove(obs_lua_tick_callback, cb);
 		return;
 	}
 
@@ -401,18 +401,38 @@ static int obs_lua_remove_tick_callback(lua_State *script)
 	return 0;
 }
 
-static void defer_add_tick(void *cb)
+static int obs_lua_add_tick_callback(lua_State *script)
 {
-	obs_add_tick_callback(obs_lua_tick_callback, cb);
+	if (!verify_args1(script, is_function))
+		return 0;
+
+	struct lua_obs_callback *cb = add_lua_obs_callback(script, 1);
+	script_tick_add(obs_lua_tick_callback, cb);
+	return 0;
 }
 
-static int obs_lua_add_tick_callback(lua_State *script)
+/* -------------------------------------------- */
+
+static void queued_call(void *p_cb)
+{
+	struct lua_obs_callback *cb = p_cb;
+
+	if (cb->base.removed)
+		return;
+
+	lock_callback();
+	call_func_(cb->script, cb->reg_idx, 0, 0, "queue_call", __FUNCTION__);
+	remove_lua_obs_callback(cb);
+	unlock_callback();
+}
+
+static int queue_call(lua_State *script)
 {
 	if (!verify_args1(script, is_function))
 		return 0;
 
 	struct lua_obs_callback *cb = add_lua_obs_callback(script, 1);
-	defer_call_post(defer_add_tick, cb);
+	script_call_post(queued_call, cb);
 	return 0;
 }
 
@@ -1009,6 +1029,7 @@ static void add_hook_functions(lua_State *script)
 	add_func("script_log", lua_script_log);
 	add_func("timer_remove", timer_remove);
 	add_func("timer_add", timer_add);
+	add_func("queue_call", queue_call);
 	add_func("obs_enum_sources", enum_sources);
 	add_func("obs_source_enum_filters", source_enum_filters);
 	add_func("obs_scene_enum_items", scene_enum_items);
@@ -1046,7 +1067,7 @@ static void lua_tick(void *param, float seconds)
 {
 	struct obs_lua_script *data;
 	struct lua_obs_timer *timer;
-	uint64_t ts = obs_get_video_frame_time();
+	uint64_t ts = os_gettime_ns();
 
 	/* --------------------------------- */
 	/* process script_tick calls         */
@@ -1055,13 +1076,17 @@ static void lua_tick(void *param, float seconds)
 	data = first_tick_script;
 	while (data) {
 		lua_State *script = data->script;
+		struct script_exec exec;
+
 		current_lua_script = data;
 
 		pthread_mutex_lock(&data->mutex);
+		script_exec_begin(&exec, &data->base);
 
 		lua_pushnumber(script, (double)seconds);
 		call_func_(script, data->tick, 1, 0, "tick", __FUNCTION__);
 
+		script_exec_end(&exec);
 		pthread_mutex_unlock(&data->mutex);
 
 		data = data->next_tick;
@@ -1340,12 +1365,12 @@ void obs_lua_load(void)
 
 	dstr_free(&dep_paths);
 
-	obs_add_tick_callback(lua_tick, NULL);
+	script_tick_add(lua_tick, NULL);
 }
 
 void obs_lua_unload(void)
 {
-	obs_remove_tick_callback(lua_tick, NULL);
+	script_tick_remove(lua_tick, NULL);
 
 	bfree(startup_script);
 	pthread_mutex_destroy(&tick_mutex);
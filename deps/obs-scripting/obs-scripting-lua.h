@@ -89,10 +89,13 @@ struct obs_lua_script {
 #define lock_callback()                                                \
 	struct obs_lua_script *__last_script = current_lua_script;     \
 	struct lua_obs_callback *__last_callback = current_lua_cb;     \
+	struct script_exec __exec;                                     \
 	current_lua_cb = cb;                                           \
 	current_lua_script = (struct obs_lua_script *)cb->base.script; \
-	pthread_mutex_lock(&current_lua_script->mutex);
+	pthread_mutex_lock(&current_lua_script->mutex);                \
+	script_exec_begin(&__exec, cb->base.script);
 #define unlock_callback()                                 \
+	script_exec_end(&__exec);                         \
 	pthread_mutex_unlock(&current_lua_script->mutex); \
 	current_lua_script = __last_script;               \
 	current_lua_cb = __last_callback;
@@ -116,9 +116,12 @@ bool libobs_to_py_(const char *type, void *libobs_in, bool ownership,
 	lock_python();                                                   \
 	struct obs_python_script *__last_script = cur_python_script;     \
 	struct python_obs_callback *__last_cb = cur_python_cb;           \
+	struct script_exec __exec;                                       \
 	cur_python_script = (struct obs_python_script *)cb->base.script; \
-	cur_python_cb = cb
+	cur_python_cb = cb;                                              \
+	script_exec_begin(&__exec, cb->base.script)
 #define unlock_callback()                  \
+	script_exec_end(&__exec);          \
 	cur_python_cb = __last_cb;         \
 	cur_python_script = __last_script; \
 	unlock_python()
@@ -458,7 +461,7 @@ static PyObject *timer_add(PyObject *self, PyObject *args)
 	struct python_obs_timer *timer = python_obs_callback_extra_data(cb);
 
 	timer->interval = (uint64_t)ms * 1000000ULL;
-	timer->last_ts = obs_get_video_frame_time();
+	timer->last_ts = os_gettime_ns();
 
 	defer_call_post(defer_timer_init, cb);
 	return python_none();
@@ -471,7 +474,7 @@ static void obs_python_tick_callback(void *priv, float seconds)
 	struct python_obs_callback *cb = priv;
 
 	if (cb->base.removed) {
-		obs_remove_tick_callback(obs_python_tick_callback, cb);
+		script_tick_remove(obs_python_tick_callback, cb);
 		return;
 	}
 
@@ -530,7 +533,50 @@ static PyObject *obs_python_add_tick_callback(PyObject *self, PyObject *args)
 		return python_none();
 
 	struct python_obs_callback *cb = add_python_obs_callback(script, py_cb);
-	obs_add_tick_callback(obs_python_tick_callback, cb);
+	script_tick_add(obs_python_tick_callback, cb);
+	return python_none();
+}
+
+/* -------------------------------------------- */
+
+static void queued_call(void *p_cb)
+{
+	struct python_obs_callback *cb = p_cb;
+
+	if (cb->base.removed)
+		return;
+
+	lock_callback(cb);
+
+	PyObject *py_ret = PyObject_CallObject(cb->func, NULL);
+	py_error();
+	Py_XDECREF(py_ret);
+
+	remove_python_obs_callback(cb);
+
+	unlock_callback();
+}
+
+static PyObject *queue_call(PyObject *self, PyObject *args)
+{
+	struct obs_python_script *script = cur_python_script;
+	PyObject *py_cb = NULL;
+
+	if (!script) {
+		PyErr_SetString(PyExc_RuntimeError,
+				"No active script, report this to Jim");
+		return NULL;
+	}
+
+	UNUSED_PARAMETER(self);
+
+	if (!parse_args(args, "O", &py_cb))
+		return python_none();
+	if (!py_cb || !PyFunction_Check(py_cb))
+		return python_none();
+
+	struct python_obs_callback *cb = add_python_obs_callback(script, py_cb);
+	script_call_post(queued_call, cb);
 	return python_none();
 }
 
@@ -1222,6 +1268,7 @@ static void add_hook_functions(PyObject *module)
 		DEF_FUNC("script_log", py_script_log),
 		DEF_FUNC("timer_remove", timer_remove),
 		DEF_FUNC("timer_add", timer_add),
+		DEF_FUNC("queue_call", queue_call),
 		DEF_FUNC("calldata_source", calldata_source),
 		DEF_FUNC("calldata_sceneitem", calldata_sceneitem),
 		DEF_FUNC("source_list_release", source_list_release),
@@ -1481,7 +1528,7 @@ static void python_tick(void *param, float seconds)
 {
 	struct obs_python_script *data;
 	bool valid;
-	uint64_t ts = obs_get_video_frame_time();
+	uint64_t ts = os_gettime_ns();
 
 	pthread_mutex_lock(&tick_mutex);
 	valid = !!first_tick_script;
@@ -1498,13 +1545,17 @@ static void python_tick(void *param, float seconds)
 		pthread_mutex_lock(&tick_mutex);
 		data = first_tick_script;
 		while (data) {
+			struct script_exec exec;
+
 			cur_python_script = data;
+			script_exec_begin(&exec, &data->base);
 
 			PyObject *py_ret =
 				PyObject_CallObject(data->tick, args);
 			Py_XDECREF(py_ret);
 			py_error();
 
+			script_exec_end(&exec);
 			data = data->next_tick;
 		}
 
@@ -1688,7 +1739,7 @@ out:
 	python_loaded_at_all = success;
 
 	if (python_loaded)
-		obs_add_tick_callback(python_tick, NULL);
+		script_tick_add(python_tick, NULL);
 
 	return python_loaded;
 }
@@ -1698,6 +1749,8 @@ void obs_python_unload(void)
 	if (!python_loaded_at_all)
 		return;
 
+	script_tick_remove(python_tick, NULL);
+
 	if (python_loaded && Py_IsInitialized()) {
 		PyGILState_Ensure();
 
@@ -1707,8 +1760,6 @@ void obs_python_unload(void)
 
 	/* ---------------------- */
 
-	obs_remove_tick_callback(python_tick, NULL);
-
 	for (size_t i = 0; i < python_paths.num; i++)
 		bfree(python_paths.array[i]);
 	da_free(python_paths);
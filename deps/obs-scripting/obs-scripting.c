@@ -15,8 +15,10 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <inttypes.h>
 #include <obs.h>
 #include <util/dstr.h>
+#include <util/darray.h>
 #include <util/platform.h>
 #include <util/threading.h>
 #include <util/circlebuf.h>
@@ -118,6 +120,377 @@ void defer_call_post(defer_call_cb call, void *cb)
 	os_sem_post(defer_call_semaphore);
 }
 
+/* -------------------------------------------- */
+/* Script thread.
+ *
+ * Script ticks, timers and tick callbacks run here on their own cadence
+ * instead of on the graphics thread, so a slow script or a busy Python
+ * interpreter can't make frames lag.  The same thread runs calls queued
+ * with script_call_post, which scripts use to change scenes and sources
+ * from callbacks that run on other libobs threads.
+ *
+ * Ticks can only be added through a pending list and are otherwise only
+ * touched on the script thread, so adding one never waits on a script. */
+
+#define SCRIPT_SLOW_CALL_NS 10000000ULL
+#define SCRIPT_SLOW_WARN_INTERVAL_NS 10000000000ULL
+#define SCRIPT_WATCHDOG_NS 1000000000ULL
+#define SCRIPT_WATCHDOG_CHECK_MS 250
+#define DEFAULT_TICK_INTERVAL_NS 16666667ULL
+
+struct script_tick {
+	script_tick_cb tick;
+	void *param;
+};
+
+static pthread_mutex_t script_tick_mutex;
+static DARRAY(struct script_tick) script_ticks;
+static DARRAY(struct script_tick) pending_ticks;
+
+static pthread_mutex_t script_call_mutex;
+static struct circlebuf script_call_queue;
+
+static pthread_t script_thread;
+static os_event_t *script_wake_event;
+static volatile bool script_thread_exit = false;
+static bool script_thread_active = false;
+static volatile long script_tick_interval_ms = 0;
+
+static pthread_mutex_t exec_mutex;
+static THREAD_LOCAL bool on_script_thread = false;
+static THREAD_LOCAL int exec_depth = 0;
+
+static pthread_t watchdog_thread;
+static os_event_t *watchdog_stop_event;
+static uint64_t watched_start = 0;
+static bool watched_warned = false;
+static struct dstr watched_name = {0};
+
+void script_tick_add(script_tick_cb tick, void *param)
+{
+	struct script_tick info = {tick, param};
+
+	pthread_mutex_lock(&script_call_mutex);
+	da_push_back(pending_ticks, &info);
+	pthread_mutex_unlock(&script_call_mutex);
+}
+
+static inline void remove_tick(struct script_tick *ticks, size_t *num,
+			       script_tick_cb tick, void *param)
+{
+	for (size_t i = 0; i < *num; i++) {
+		if (ticks[i].tick == tick && ticks[i].param == param) {
+			memmove(ticks + i, ticks + i + 1,
+				(*num - i - 1) * sizeof(*ticks));
+			(*num)--;
+			return;
+		}
+	}
+}
+
+/* waits for the current ticks to finish, so must not be called while
+ * holding a lock that a tick can wait on (such as the GIL), except from a
+ * tick itself */
+void script_tick_remove(script_tick_cb tick, void *param)
+{
+	pthread_mutex_lock(&script_call_mutex);
+	remove_tick(pending_ticks.array, &pending_ticks.num, tick, param);
+	pthread_mutex_unlock(&script_call_mutex);
+
+	pthread_mutex_lock(&script_tick_mutex);
+	remove_tick(script_ticks.array, &script_ticks.num, tick, param);
+	pthread_mutex_unlock(&script_tick_mutex);
+}
+
+void script_call_post(defer_call_cb call, void *cb)
+{
+	struct defer_call info;
+	info.call = call;
+	info.cb = cb;
+
+	pthread_mutex_lock(&script_call_mutex);
+	if (!script_thread_exit)
+		circlebuf_push_back(&script_call_queue, &info, sizeof(info));
+	pthread_mutex_unlock(&script_call_mutex);
+
+	os_event_signal(script_wake_event);
+}
+
+static void run_script_calls(void)
+{
+	struct defer_call info;
+
+	for (;;) {
+		pthread_mutex_lock(&script_call_mutex);
+		if (!script_call_queue.size) {
+			pthread_mutex_unlock(&script_call_mutex);
+			break;
+		}
+		circlebuf_pop_front(&script_call_queue, &info, sizeof(info));
+		pthread_mutex_unlock(&script_call_mutex);
+
+		info.call(info.cb);
+	}
+}
+
+static void run_script_ticks(float seconds)
+{
+	pthread_mutex_lock(&script_tick_mutex);
+
+	pthread_mutex_lock(&script_call_mutex);
+	da_push_back_da(script_ticks, pending_ticks);
+	da_resize(pending_ticks, 0);
+	pthread_mutex_unlock(&script_call_mutex);
+
+	/* backwards, so ticks can remove themselves */
+	for (size_t i = script_ticks.num; i > 0; i--) {
+		struct script_tick *info = script_ticks.array + (i - 1);
+		info->tick(info->param, seconds);
+	}
+
+	pthread_mutex_unlock(&script_tick_mutex);
+}
+
+static uint64_t get_tick_interval(void)
+{
+	long ms = os_atomic_load_long(&script_tick_interval_ms);
+	video_t *video;
+
+	if (ms > 0)
+		return (uint64_t)ms * 1000000ULL;
+
+	video = obs_get_video();
+	return video ? video_output_get_frame_time(video)
+		     : DEFAULT_TICK_INTERVAL_NS;
+}
+
+static void *script_thread_proc(void *unused)
+{
+	uint64_t last_time = os_gettime_ns();
+	uint64_t next_time = last_time;
+
+	UNUSED_PARAMETER(unused);
+
+	os_set_thread_name("obs-scripting: script thread");
+	on_script_thread = true;
+
+	while (!os_atomic_load_bool(&script_thread_exit)) {
+		uint64_t interval = get_tick_interval();
+		uint64_t cur_time = os_gettime_ns();
+
+		run_script_calls();
+
+		if (cur_time >= next_time) {
+			float seconds = (float)((double)(cur_time - last_time) /
+						1000000000.0);
+
+			run_script_ticks(seconds);
+			last_time = cur_time;
+
+			next_time += interval;
+			if (next_time <= cur_time)
+				next_time = cur_time + interval;
+		}
+
+		cur_time = os_gettime_ns();
+		if (cur_time < next_time) {
+			unsigned long ms = (unsigned long)((next_time -
+							    cur_time) /
+							   1000000ULL);
+			os_event_timedwait(script_wake_event, ms ? ms : 1);
+		}
+	}
+
+	run_script_calls();
+	return NULL;
+}
+
+/* -------------------------------------------- */
+/* execution time accounting                    */
+
+void script_exec_begin(struct script_exec *exec, obs_script_t *script)
+{
+	exec->script = script;
+	exec->start = os_gettime_ns();
+	exec->outer = exec_depth++ == 0;
+
+	if (exec->outer && on_script_thread) {
+		pthread_mutex_lock(&exec_mutex);
+		dstr_copy_dstr(&watched_name, &script->file);
+		watched_start = exec->start;
+		watched_warned = false;
+		pthread_mutex_unlock(&exec_mutex);
+	}
+}
+
+void script_exec_end(struct script_exec *exec)
+{
+	obs_script_t *script = exec->script;
+	uint64_t end = os_gettime_ns();
+	uint64_t ns = end - exec->start;
+	uint64_t slow_calls = 0;
+	bool warn = false;
+
+	exec_depth--;
+	if (!exec->outer)
+		return;
+
+	pthread_mutex_lock(&exec_mutex);
+
+	if (on_script_thread)
+		watched_start = 0;
+
+	script->exec.calls++;
+	script->exec.total_ns += ns;
+	if (ns > script->exec.max_ns)
+		script->exec.max_ns = ns;
+
+	if (ns >= SCRIPT_SLOW_CALL_NS) {
+		script->exec.slow_calls++;
+
+		if (!script->last_slow_warn ||
+		    end - script->last_slow_warn >=
+			    SCRIPT_SLOW_WARN_INTERVAL_NS) {
+			script->last_slow_warn = end;
+			slow_calls = script->exec.slow_calls;
+			warn = true;
+		}
+	}
+
+	pthread_mutex_unlock(&exec_mutex);
+
+	if (warn)
+		script_warn(script,
+			    "callback took %.1f ms, which delays other scripts "
+			    "(%" PRIu64 " slow callbacks so far)",
+			    (double)ns / 1000000.0, slow_calls);
+}
+
+static void *watchdog_thread_proc(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	os_set_thread_name("obs-scripting: watchdog");
+
+	while (os_event_timedwait(watchdog_stop_event,
+				  SCRIPT_WATCHDOG_CHECK_MS) == ETIMEDOUT) {
+		uint64_t cur_time = os_gettime_ns();
+
+		pthread_mutex_lock(&exec_mutex);
+		if (watched_start && !watched_warned &&
+		    cur_time - watched_start >= SCRIPT_WATCHDOG_NS) {
+			watched_warned = true;
+			blog(LOG_WARNING,
+			     "[Scripting] '%s' has been running for %d ms, "
+			     "script ticks and timers are stalled",
+			     watched_name.array ? watched_name.array : "",
+			     (int)((cur_time - watched_start) / 1000000));
+		}
+		pthread_mutex_unlock(&exec_mutex);
+	}
+
+	return NULL;
+}
+
+static bool script_thread_start(void)
+{
+	pthread_mutexattr_t attr;
+
+	if (pthread_mutexattr_init(&attr) != 0)
+		return false;
+	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0 ||
+	    pthread_mutex_init(&script_tick_mutex, &attr) != 0) {
+		pthread_mutexattr_destroy(&attr);
+		return false;
+	}
+	pthread_mutexattr_destroy(&attr);
+	if (pthread_mutex_init(&script_call_mutex, NULL) != 0)
+		goto fail_call_mutex;
+	if (pthread_mutex_init(&exec_mutex, NULL) != 0)
+		goto fail_exec_mutex;
+	if (os_event_init(&script_wake_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail_wake_event;
+	if (os_event_init(&watchdog_stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail_stop_event;
+
+	script_thread_exit = false;
+	if (pthread_create(&script_thread, NULL, script_thread_proc, NULL) !=
+	    0)
+		goto fail_thread;
+	if (pthread_create(&watchdog_thread, NULL, watchdog_thread_proc,
+			   NULL) != 0)
+		goto fail_watchdog;
+
+	script_thread_active = true;
+	return true;
+
+fail_watchdog:
+	os_atomic_set_bool(&script_thread_exit, true);
+	os_event_signal(script_wake_event);
+	pthread_join(script_thread, NULL);
+fail_thread:
+	os_event_destroy(watchdog_stop_event);
+fail_stop_event:
+	os_event_destroy(script_wake_event);
+fail_wake_event:
+	pthread_mutex_destroy(&exec_mutex);
+fail_exec_mutex:
+	pthread_mutex_destroy(&script_call_mutex);
+fail_call_mutex:
+	pthread_mutex_destroy(&script_tick_mutex);
+	return false;
+}
+
+static void script_thread_stop(void)
+{
+	if (!script_thread_active)
+		return;
+
+	os_atomic_set_bool(&script_thread_exit, true);
+	os_event_signal(script_wake_event);
+	pthread_join(script_thread, NULL);
+
+	os_event_signal(watchdog_stop_event);
+	pthread_join(watchdog_thread, NULL);
+
+	script_thread_active = false;
+}
+
+static void script_thread_free(void)
+{
+	circlebuf_free(&script_call_queue);
+	da_free(script_ticks);
+	da_free(pending_ticks);
+	dstr_free(&watched_name);
+
+	os_event_destroy(watchdog_stop_event);
+	os_event_destroy(script_wake_event);
+	pthread_mutex_destroy(&exec_mutex);
+	pthread_mutex_destroy(&script_call_mutex);
+	pthread_mutex_destroy(&script_tick_mutex);
+}
+
+void obs_scripting_set_tick_interval(uint32_t interval_ms)
+{
+	os_atomic_set_long(&script_tick_interval_ms, (long)interval_ms);
+}
+
+bool obs_script_get_exec_stats(const obs_script_t *script,
+			       struct obs_script_exec_stats *stats)
+{
+	if (!stats)
+		return false;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!script || !scripting_loaded)
+		return false;
+
+	pthread_mutex_lock(&exec_mutex);
+	*stats = script->exec;
+	pthread_mutex_unlock(&exec_mutex);
+	return true;
+}
+
 /* -------------------------------------------- */
 
 bool obs_scripting_load(void)
@@ -144,6 +517,19 @@ bool obs_scripting_load(void)
 		return false;
 	}
 
+	if (!script_thread_start()) {
+		pthread_mutex_lock(&defer_call_mutex);
+		defer_call_exit = true;
+		pthread_mutex_unlock(&defer_call_mutex);
+		os_sem_post(defer_call_semaphore);
+		pthread_join(defer_call_thread, NULL);
+
+		os_sem_destroy(defer_call_semaphore);
+		pthread_mutex_destroy(&defer_call_mutex);
+		pthread_mutex_destroy(&detach_mutex);
+		return false;
+	}
+
 #if COMPILE_LUA
 	obs_lua_load();
 #endif
@@ -164,7 +550,12 @@ void obs_scripting_unload(void)
 	if (!scripting_loaded)
 		return;
 
-		/* ---------------------- */
+	/* ---------------------- */
+
+	/* stop running script code before the languages unload */
+	script_thread_stop();
+
+	/* ---------------------- */
 
 #if COMPILE_LUA
 	obs_lua_unload();
@@ -214,6 +605,8 @@ void obs_scripting_unload(void)
 	pthread_mutex_destroy(&defer_call_mutex);
 	os_sem_destroy(defer_call_semaphore);
 
+	script_thread_free();
+
 	scripting_loaded = false;
 }
 
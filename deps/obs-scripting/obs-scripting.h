@@ -63,6 +63,26 @@ EXPORT obs_data_t *obs_script_get_settings(obs_script_t *script);
 EXPORT void obs_script_update(obs_script_t *script, obs_data_t *settings);
 
 EXPORT bool obs_script_loaded(const obs_script_t *script);
+
+struct obs_script_exec_stats {
+	uint64_t calls;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t slow_calls;
+};
+
+/**
+ * Gets how much time has been spent running a script's code, including
+ * script_tick, timers and callbacks.
+ */
+EXPORT bool obs_script_get_exec_stats(const obs_script_t *script,
+				      struct obs_script_exec_stats *stats);
+
+/**
+ * Sets how often script_tick, tick callbacks and timers are processed on
+ * the script thread.  0 (default) uses the video frame interval.
+ */
+EXPORT void obs_scripting_set_tick_interval(uint32_t interval_ms);
 EXPORT bool obs_script_reload(obs_script_t *script);
 
 #ifdef __cplusplus
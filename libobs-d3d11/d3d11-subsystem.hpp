@@ -100,6 +100,8 @@ static inline DXGI_FORMAT ConvertGSTextureFormat(gs_color_format format)
 		return DXGI_FORMAT_BC3_UNORM;
 	case GS_R8G8:
 		return DXGI_FORMAT_R8G8_UNORM;
+	case GS_R16G16:
+		return DXGI_FORMAT_R16G16_UNORM;
 	}
 
 	return DXGI_FORMAT_UNKNOWN;
@@ -114,6 +116,8 @@ static inline gs_color_format ConvertDXGITextureFormat(DXGI_FORMAT format)
 		return GS_R8;
 	case DXGI_FORMAT_R8G8_UNORM:
 		return GS_R8G8;
+	case DXGI_FORMAT_R16G16_UNORM:
+		return GS_R16G16;
 	case DXGI_FORMAT_R8G8B8A8_UNORM:
 		return GS_RGBA;
 	case DXGI_FORMAT_B8G8R8X8_UNORM:
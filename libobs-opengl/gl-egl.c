@@ -0,0 +1,380 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/* Headless EGL backend.
+ *
+ * Creates an OpenGL 3.3 core context without a window system, so libobs can
+ * render and encode on servers with no display, including with Mesa's
+ * llvmpipe software renderer.  It is built as a separate module
+ * (libobs-opengl-egl) so it can be chosen with obs_video_info.graphics_module
+ * when calling obs_reset_video.
+ *
+ * The display is picked in this order:
+ *
+ *  - the EGL device matching the adapter index (EGL_EXT_platform_device)
+ *  - the Mesa surfaceless platform (EGL_MESA_platform_surfaceless)
+ *  - the default display
+ *
+ * Contexts are made current without a surface when EGL_KHR_surfaceless_context
+ * is available, otherwise on a small pbuffer.  There are no windows, so swap
+ * chains cannot be created. */
+
+#include "gl-subsystem.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+#define MAX_EGL_DEVICES 16
+
+static const EGLint ctx_attribs[] = {
+#ifdef _DEBUG
+	EGL_CONTEXT_OPENGL_DEBUG,
+	EGL_TRUE,
+#endif
+	EGL_CONTEXT_OPENGL_PROFILE_MASK,
+	EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+	EGL_CONTEXT_MAJOR_VERSION,
+	3,
+	EGL_CONTEXT_MINOR_VERSION,
+	3,
+	EGL_NONE,
+};
+
+static const EGLint ctx_config_attribs[] = {EGL_RED_SIZE,
+					    8,
+					    EGL_GREEN_SIZE,
+					    8,
+					    EGL_BLUE_SIZE,
+					    8,
+					    EGL_ALPHA_SIZE,
+					    8,
+					    EGL_DEPTH_SIZE,
+					    0,
+					    EGL_STENCIL_SIZE,
+					    0,
+					    EGL_RENDERABLE_TYPE,
+					    EGL_OPENGL_BIT,
+					    EGL_SURFACE_TYPE,
+					    EGL_PBUFFER_BIT,
+					    EGL_NONE};
+
+static const EGLint ctx_pbuffer_attribs[] = {EGL_WIDTH, 2, EGL_HEIGHT, 2,
+					     EGL_NONE};
+
+struct gl_windowinfo {
+	int unused;
+};
+
+struct gl_platform {
+	EGLDisplay display;
+	EGLConfig config;
+	EGLContext context;
+	EGLSurface pbuffer;
+};
+
+static bool has_extension(const char *extensions, const char *name)
+{
+	size_t len = strlen(name);
+	const char *pos = extensions;
+
+	while (pos && (pos = strstr(pos, name)) != NULL) {
+		bool start = pos == extensions || pos[-1] == ' ';
+		bool end = pos[len] == ' ' || pos[len] == '\0';
+
+		if (start && end)
+			return true;
+		pos += len;
+	}
+
+	return false;
+}
+
+static EGLDisplay get_device_display(uint32_t adapter)
+{
+	PFNEGLQUERYDEVICESEXTPROC query_devices =
+		(PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress(
+			"eglQueryDevicesEXT");
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+			"eglGetPlatformDisplayEXT");
+	EGLDeviceEXT devices[MAX_EGL_DEVICES];
+	EGLint num_devices = 0;
+
+	if (!query_devices || !get_platform_display)
+		return EGL_NO_DISPLAY;
+	if (!query_devices(MAX_EGL_DEVICES, devices, &num_devices))
+		return EGL_NO_DISPLAY;
+	if (adapter >= (uint32_t)num_devices) {
+		blog(LOG_WARNING,
+		     "EGL: adapter %u not found, %d device(s) "
+		     "available",
+		     adapter, num_devices);
+		return EGL_NO_DISPLAY;
+	}
+
+	return get_platform_display(EGL_PLATFORM_DEVICE_EXT, devices[adapter],
+				    NULL);
+}
+
+static EGLDisplay get_surfaceless_display(void)
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+			"eglGetPlatformDisplayEXT");
+
+	if (!get_platform_display)
+		return EGL_NO_DISPLAY;
+
+	return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+				    EGL_DEFAULT_DISPLAY, NULL);
+}
+
+static bool init_display(EGLDisplay display, const char *type)
+{
+	EGLint major, minor;
+
+	if (display == EGL_NO_DISPLAY)
+		return false;
+
+	if (!eglInitialize(display, &major, &minor)) {
+		blog(LOG_DEBUG, "EGL: failed to initialize %s display", type);
+		return false;
+	}
+
+	blog(LOG_INFO, "EGL: using %s display, EGL %d.%d (%s)", type, major,
+	     minor, eglQueryString(display, EGL_VENDOR));
+	return true;
+}
+
+static EGLDisplay open_headless_display(uint32_t adapter)
+{
+	const char *client_exts =
+		eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	EGLDisplay display;
+
+	if (has_extension(client_exts, "EGL_EXT_platform_device") &&
+	    has_extension(client_exts, "EGL_EXT_device_enumeration")) {
+		display = get_device_display(adapter);
+		if (init_display(display, "device"))
+			return display;
+	}
+
+	if (has_extension(client_exts, "EGL_MESA_platform_surfaceless")) {
+		display = get_surfaceless_display();
+		if (init_display(display, "surfaceless"))
+			return display;
+	}
+
+	display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (init_display(display, "default"))
+		return display;
+
+	blog(LOG_ERROR, "EGL: unable to open a display");
+	return EGL_NO_DISPLAY;
+}
+
+static bool gl_context_create(struct gl_platform *plat)
+{
+	const char *exts = eglQueryString(plat->display, EGL_EXTENSIONS);
+	EGLint num_configs = 0;
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		blog(LOG_ERROR, "EGL: OpenGL API not supported");
+		return false;
+	}
+
+	if (!eglChooseConfig(plat->display, ctx_config_attribs, &plat->config,
+			     1, &num_configs) ||
+	    !num_configs) {
+		blog(LOG_ERROR, "EGL: failed to find a config");
+		return false;
+	}
+
+	plat->context = eglCreateContext(plat->display, plat->config,
+					 EGL_NO_CONTEXT, ctx_attribs);
+	if (plat->context == EGL_NO_CONTEXT) {
+		blog(LOG_ERROR, "EGL: failed to create OpenGL context: 0x%X",
+		     eglGetError());
+		return false;
+	}
+
+	plat->pbuffer = EGL_NO_SURFACE;
+
+	if (!has_extension(exts, "EGL_KHR_surfaceless_context")) {
+		plat->pbuffer = eglCreatePbufferSurface(
+			plat->display, plat->config, ctx_pbuffer_attribs);
+		if (plat->pbuffer == EGL_NO_SURFACE) {
+			blog(LOG_ERROR, "EGL: failed to create pbuffer");
+			eglDestroyContext(plat->display, plat->context);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void gl_context_destroy(struct gl_platform *plat)
+{
+	eglMakeCurrent(plat->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+		       EGL_NO_CONTEXT);
+	if (plat->pbuffer != EGL_NO_SURFACE)
+		eglDestroySurface(plat->display, plat->pbuffer);
+	eglDestroyContext(plat->display, plat->context);
+}
+
+static inline bool make_current(struct gl_platform *plat)
+{
+	return eglMakeCurrent(plat->display, plat->pbuffer, plat->pbuffer,
+			      plat->context);
+}
+
+static bool load_gl_functions(struct gl_platform *plat)
+{
+	const char *client_exts =
+		eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	const char *exts = eglQueryString(plat->display, EGL_EXTENSIONS);
+
+	/* core functions can only be queried through eglGetProcAddress with
+	 * this extension, otherwise use glad's libGL loader */
+	if (has_extension(client_exts,
+			  "EGL_KHR_client_get_all_proc_addresses") ||
+	    has_extension(exts, "EGL_KHR_get_all_proc_addresses")) {
+		gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+		return GLVersion.major > 0;
+	}
+
+	return gladLoadGL() != 0;
+}
+
+extern struct gl_windowinfo *
+gl_windowinfo_create(const struct gs_init_data *info)
+{
+	UNUSED_PARAMETER(info);
+	return bzalloc(sizeof(struct gl_windowinfo));
+}
+
+extern void gl_windowinfo_destroy(struct gl_windowinfo *info)
+{
+	bfree(info);
+}
+
+extern struct gl_platform *gl_platform_create(gs_device_t *device,
+					      uint32_t adapter)
+{
+	struct gl_platform *plat = bzalloc(sizeof(struct gl_platform));
+
+	plat->display = open_headless_display(adapter);
+	if (plat->display == EGL_NO_DISPLAY)
+		goto fail_display_open;
+
+	device->plat = plat;
+
+	if (!gl_context_create(plat)) {
+		blog(LOG_ERROR, "Failed to create context!");
+		goto fail_context_create;
+	}
+
+	if (!make_current(plat)) {
+		blog(LOG_ERROR, "Failed to make context current.");
+		goto fail_make_current;
+	}
+
+	if (!load_gl_functions(plat)) {
+		blog(LOG_ERROR, "Failed to load OpenGL entry functions.");
+		goto fail_load_gl;
+	}
+
+	return plat;
+
+fail_load_gl:
+fail_make_current:
+	gl_context_destroy(plat);
+fail_context_create:
+	eglTerminate(plat->display);
+fail_display_open:
+	device->plat = NULL;
+	bfree(plat);
+	return NULL;
+}
+
+extern void gl_platform_destroy(struct gl_platform *plat)
+{
+	if (!plat)
+		return;
+
+	gl_context_destroy(plat);
+	eglTerminate(plat->display);
+	eglReleaseThread();
+	bfree(plat);
+}
+
+extern bool gl_platform_init_swapchain(struct gs_swap_chain *swap)
+{
+	UNUSED_PARAMETER(swap);
+	blog(LOG_ERROR, "EGL: the headless backend has no windows, swap "
+			"chains are not supported");
+	return false;
+}
+
+extern void gl_platform_cleanup_swapchain(struct gs_swap_chain *swap)
+{
+	UNUSED_PARAMETER(swap);
+}
+
+extern void device_enter_context(gs_device_t *device)
+{
+	if (!make_current(device->plat))
+		blog(LOG_ERROR, "Failed to make context current.");
+}
+
+extern void device_leave_context(gs_device_t *device)
+{
+	if (!eglMakeCurrent(device->plat->display, EGL_NO_SURFACE,
+			    EGL_NO_SURFACE, EGL_NO_CONTEXT))
+		blog(LOG_ERROR, "Failed to reset current context.");
+}
+
+void *device_get_device_obj(gs_device_t *device)
+{
+	return device->plat->context;
+}
+
+extern void gl_getclientsize(const struct gs_swap_chain *swap, uint32_t *width,
+			     uint32_t *height)
+{
+	*width = swap->info.cx;
+	*height = swap->info.cy;
+}
+
+extern void gl_update(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+extern void device_load_swapchain(gs_device_t *device, gs_swapchain_t *swap)
+{
+	device->cur_swap = swap;
+}
+
+extern void device_present(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
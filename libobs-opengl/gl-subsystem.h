@@ -61,6 +61,8 @@ static inline GLenum convert_gs_format(enum gs_color_format format)
 		return GL_RG;
 	case GS_R8G8:
 		return GL_RG;
+	case GS_R16G16:
+		return GL_RG;
 	case GS_R16F:
 		return GL_RED;
 	case GS_R32F:
@@ -107,6 +109,8 @@ static inline GLenum convert_gs_internal_format(enum gs_color_format format)
 		return GL_RG32F;
 	case GS_R8G8:
 		return GL_RG8;
+	case GS_R16G16:
+		return GL_RG16;
 	case GS_R16F:
 		return GL_R16F;
 	case GS_R32F:
@@ -153,6 +157,8 @@ static inline GLenum get_gl_format_type(enum gs_color_format format)
 		return GL_FLOAT;
 	case GS_R8G8:
 		return GL_UNSIGNED_BYTE;
+	case GS_R16G16:
+		return GL_UNSIGNED_SHORT;
 	case GS_R16F:
 		return GL_UNSIGNED_SHORT;
 	case GS_R32F:
@@ -251,6 +251,43 @@ failed:
 	blog(LOG_ERROR, "gs_texture_unmap (GL) failed");
 }
 
+void gs_texture_set_image_rows(gs_texture_t *tex, const uint8_t *data,
+			       uint32_t linesize, uint32_t y, uint32_t height)
+{
+	struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
+	uint32_t pixel_size;
+
+	if (!is_texture_2d(tex, "gs_texture_set_image_rows"))
+		goto failed;
+	if (gs_is_compressed_format(tex->format))
+		goto failed;
+
+	/* the rows are read straight from client memory */
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
+		goto failed;
+	if (!gl_bind_texture(GL_TEXTURE_2D, tex2d->base.texture))
+		goto failed;
+
+	pixel_size = gs_get_format_bpp(tex->format) / 8;
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, linesize / pixel_size);
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, tex2d->width, height,
+			tex->gl_format, tex->gl_type,
+			data + (size_t)y * linesize);
+	if (!gl_success("glTexSubImage2D")) {
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		goto failed;
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	gl_bind_texture(GL_TEXTURE_2D, 0);
+	return;
+
+failed:
+	gl_bind_texture(GL_TEXTURE_2D, 0);
+	blog(LOG_ERROR, "gs_texture_set_image_rows (GL) failed");
+}
+
 bool gs_texture_is_rect(const gs_texture_t *tex)
 {
 	const struct gs_texture_2d *tex2d = (const struct gs_texture_2d *)tex;
@@ -21,3 +21,9 @@ void audio_monitor_destroy(struct audio_monitor *monitor)
 {
 	UNUSED_PARAMETER(monitor);
 }
+
+bool audio_monitoring_get_stats(struct obs_audio_monitoring_stats *stats)
+{
+	UNUSED_PARAMETER(stats);
+	return false;
+}
@@ -1,13 +1,37 @@
 #include "obs-internal.h"
+#include "util/sse-intrin.h"
 #include "pulseaudio-wrapper.h"
 
-#define PULSE_DATA(voidptr) struct audio_monitor *data = voidptr;
+#define PULSE_DATA(voidptr) struct monitor_bus *data = voidptr;
 #define blog(level, msg, ...) blog(level, "pulse-am: " msg, ##__VA_ARGS__)
 
-struct audio_monitor {
-	obs_source_t *source;
-	pa_stream *stream;
+/* All monitored sources are mixed into a single playback stream, the
+ * monitoring bus, at the OBS sample rate and then converted to the device
+ * format.
+ *
+ * Sources deliver audio from their own threads, so mixed frames are only
+ * played once every source that is still delivering audio has passed them.
+ * A source that has not delivered anything for MONITOR_STALE_NS is left out
+ * so it cannot hold back the others.
+ *
+ * Clock drift between OBS and the device is absorbed by playing the mix
+ * very slightly faster or slower, keeping the queued audio near the
+ * latency target instead of letting it grow.  Audio is only dropped when
+ * the queue gets far behind. */
+
+#define DEFAULT_LATENCY_MS 25
+#define MONITOR_STALE_NS 100000000ULL
+#define MAX_DRIFT 0.005
+#define DRIFT_GAIN 0.05
+#define DRIFT_SMOOTHING 0.05
+
+struct monitor_bus {
+	long refs;
+	char *device_id;
 	char *device;
+	uint32_t latency_ms;
+
+	pa_stream *stream;
 	pa_buffer_attr attr;
 	enum speaker_layout speakers;
 	pa_sample_format_t format;
@@ -18,16 +42,51 @@ struct audio_monitor {
 	uint_fast32_t packets;
 	uint_fast64_t frames;
 
-	struct circlebuf new_data;
+	pthread_mutex_t mutex;
+	DARRAY(struct audio_monitor *) monitors;
+
+	/* mix of all monitors at the OBS sample rate, mix_frames frames
+	 * starting at mix_ts have been written to */
+	uint32_t obs_rate;
+	size_t obs_channels;
+	float *mix[MAX_AUDIO_CHANNELS];
+	size_t mix_frames;
+	size_t mix_capacity;
+	uint64_t mix_start_ts;
+	uint64_t mix_pos;
+	bool mix_started;
+
+	/* drift compensation */
+	double drift_ratio;
+	double drift_error;
+	double drift_pos;
+	float drift_last[MAX_AUDIO_CHANNELS];
+	float *drift_out[MAX_AUDIO_CHANNELS];
+	size_t drift_capacity;
+
 	audio_resampler_t *resampler;
-	size_t buffer_size;
-	size_t bytesRemaining;
-	size_t bytes_per_channel;
+	struct circlebuf new_data;
+	size_t bytes_remaining;
+	uint64_t device_latency_ns;
+
+	struct obs_audio_monitoring_stats stats;
+};
+
+struct audio_monitor {
+	obs_source_t *source;
+	struct monitor_bus *bus;
+
+	/* timestamp just past the last audio mixed, and when it arrived */
+	uint64_t end_ts;
+	uint64_t last_time;
 
 	bool ignore;
 	pthread_mutex_t playback_mutex;
 };
 
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct monitor_bus *cur_bus = NULL;
+
 static enum speaker_layout
 pulseaudio_channels_to_obs_speakers(uint_fast32_t channels)
 {
@@ -125,122 +184,343 @@ static pa_channel_map pulseaudio_channel_map(enum speaker_layout layout)
 	return ret;
 }
 
-static void process_byte(void *p, size_t frames, size_t channels, float vol)
+/* ------------------------------------------------------------------------- */
+/* mixing */
+
+static void mix_float(float *dst, const float *src, size_t frames, float vol)
 {
-	register char *cur = (char *)p;
-	register char *end = cur + frames * channels;
+	const __m128 vol_val = _mm_set1_ps(vol);
+	size_t i = 0;
+
+	for (; i + 4 <= frames; i += 4) {
+		__m128 val = _mm_mul_ps(_mm_loadu_ps(src + i), vol_val);
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), val));
+	}
 
-	while (cur < end)
-		*(cur++) *= vol;
+	for (; i < frames; i++)
+		dst[i] += src[i] * vol;
 }
 
-static void process_short(void *p, size_t frames, size_t channels, float vol)
+static inline uint64_t bus_mix_ts(const struct monitor_bus *bus)
 {
-	register short *cur = (short *)p;
-	register short *end = cur + frames * channels;
+	return bus->mix_start_ts + audio_frames_to_ns(bus->obs_rate,
+						      bus->mix_pos);
+}
 
-	while (cur < end)
-		*(cur++) *= vol;
+static inline int64_t ts_to_frames(const struct monitor_bus *bus,
+				   int64_t diff)
+{
+	double frames = (double)diff * (double)bus->obs_rate / 1000000000.0;
+	return (int64_t)(frames < 0.0 ? frames - 0.5 : frames + 0.5);
 }
 
-static void process_float(void *p, size_t frames, size_t channels, float vol)
+static void ensure_mix_capacity(struct monitor_bus *bus, size_t frames)
 {
-	register float *cur = (float *)p;
-	register float *end = cur + frames * channels;
+	if (frames <= bus->mix_capacity)
+		return;
+
+	for (size_t ch = 0; ch < bus->obs_channels; ch++) {
+		bus->mix[ch] = brealloc(bus->mix[ch], frames * sizeof(float));
+		memset(bus->mix[ch] + bus->mix_capacity, 0,
+		       (frames - bus->mix_capacity) * sizeof(float));
+	}
 
-	while (cur < end)
-		*(cur++) *= vol;
+	bus->mix_capacity = frames;
 }
 
-void process_volume(const struct audio_monitor *monitor, float vol,
-		    uint8_t *const *resample_data, uint32_t resample_frames)
+static void mix_audio(struct monitor_bus *bus, struct audio_monitor *monitor,
+		      const struct audio_data *audio_data, float vol)
 {
-	switch (monitor->bytes_per_channel) {
-	case 1:
-		process_byte(resample_data[0], resample_frames,
-			     monitor->channels, vol);
-		break;
-	case 2:
-		process_short(resample_data[0], resample_frames,
-			      monitor->channels, vol);
-		break;
-	default:
-		process_float(resample_data[0], resample_frames,
-			      monitor->channels, vol);
-		break;
+	uint32_t frames = audio_data->frames;
+	size_t skip = 0;
+
+	if (!bus->mix_started) {
+		bus->mix_start_ts = audio_data->timestamp;
+		bus->mix_pos = 0;
+		bus->mix_started = true;
 	}
+
+	int64_t offset = ts_to_frames(
+		bus, (int64_t)(audio_data->timestamp - bus_mix_ts(bus)));
+
+	monitor->end_ts = audio_data->timestamp +
+			  audio_frames_to_ns(bus->obs_rate, frames);
+	monitor->last_time = os_gettime_ns();
+
+	/* a timestamp jump, start mixing again from this source */
+	if (offset > (int64_t)bus->obs_rate) {
+		bus->stats.dropped_frames += bus->mix_frames;
+		for (size_t ch = 0; ch < bus->obs_channels; ch++)
+			memset(bus->mix[ch], 0,
+			       bus->mix_frames * sizeof(float));
+
+		bus->mix_start_ts = audio_data->timestamp;
+		bus->mix_pos = 0;
+		bus->mix_frames = 0;
+		offset = 0;
+	}
+
+	/* the part of the data that has already been played is too late */
+	if (offset < 0) {
+		skip = (size_t)-offset;
+		if (skip >= frames) {
+			bus->stats.late_frames += frames;
+			return;
+		}
+
+		bus->stats.late_frames += skip;
+		offset = 0;
+	}
+
+	size_t end = (size_t)offset + frames - skip;
+	ensure_mix_capacity(bus, end);
+
+	if (vol > 0.0f) {
+		for (size_t ch = 0; ch < bus->obs_channels; ch++) {
+			const float *src = (const float *)audio_data->data[ch];
+			mix_float(bus->mix[ch] + offset, src + skip,
+				  frames - skip, vol);
+		}
+	}
+
+	if (end > bus->mix_frames)
+		bus->mix_frames = end;
 }
 
-static void do_stream_write(void *param)
+/* frames of the mix that every active monitor has passed */
+static size_t get_ready_frames(struct monitor_bus *bus)
 {
-	PULSE_DATA(param);
-	uint8_t *buffer = NULL;
+	uint64_t now = os_gettime_ns();
+	uint64_t mix_ts = bus_mix_ts(bus);
+	uint64_t ready_ts = 0;
+	bool found = false;
+
+	for (size_t i = 0; i < bus->monitors.num; i++) {
+		struct audio_monitor *monitor = bus->monitors.array[i];
+
+		if (!monitor->last_time ||
+		    now - monitor->last_time > MONITOR_STALE_NS)
+			continue;
+		if (!found || monitor->end_ts < ready_ts)
+			ready_ts = monitor->end_ts;
+		found = true;
+	}
 
-	while (data->new_data.size >= data->buffer_size &&
-	       data->bytesRemaining > 0) {
-		size_t bytesToFill = data->buffer_size;
+	if (!found || ready_ts <= mix_ts)
+		return 0;
 
-		if (bytesToFill > data->bytesRemaining)
-			bytesToFill = data->bytesRemaining;
+	size_t frames = (size_t)ts_to_frames(bus, (int64_t)(ready_ts - mix_ts));
+	return frames < bus->mix_frames ? frames : bus->mix_frames;
+}
 
-		pa_stream_begin_write(data->stream, (void **)&buffer,
-				      &bytesToFill);
+/* ------------------------------------------------------------------------- */
+/* drift compensation */
 
-		circlebuf_pop_front(&data->new_data, buffer, bytesToFill);
+/* how far the queued audio is from the target, in seconds, with the data
+ * about to be queued not counted yet */
+static double get_queue_error(const struct monitor_bus *bus)
+{
+	size_t tlength = bus->attr.tlength;
+	size_t device_queued = bus->bytes_remaining < tlength
+				       ? tlength - bus->bytes_remaining
+				       : 0;
+	size_t queued = bus->new_data.size + device_queued;
+	double error = (double)queued - (double)tlength;
+
+	return error / (double)bus->bytes_per_frame /
+	       (double)bus->samples_per_sec;
+}
 
-		pulseaudio_lock();
-		pa_stream_write(data->stream, buffer, bytesToFill, NULL, 0LL,
-				PA_SEEK_RELATIVE);
-		pulseaudio_unlock();
+static void update_drift_ratio(struct monitor_bus *bus)
+{
+	bus->drift_error += (get_queue_error(bus) - bus->drift_error) *
+			    DRIFT_SMOOTHING;
+
+	double ratio = 1.0 + bus->drift_error * DRIFT_GAIN;
+	if (ratio > 1.0 + MAX_DRIFT)
+		ratio = 1.0 + MAX_DRIFT;
+	else if (ratio < 1.0 - MAX_DRIFT)
+		ratio = 1.0 - MAX_DRIFT;
+
+	bus->drift_ratio = ratio;
+	bus->stats.drift_ratio = ratio;
+}
 
-		data->bytesRemaining -= bytesToFill;
+/* plays frames of the mix at drift_ratio times the normal speed, with
+ * linear interpolation.  drift_last holds the sample before the input and
+ * drift_pos the position of the next output relative to it. */
+static size_t compensate_drift(struct monitor_bus *bus, size_t frames)
+{
+	double ratio = bus->drift_ratio;
+	size_t max_out = (size_t)((double)frames / ratio) + 2;
+	size_t out = 0;
+	double pos = bus->drift_pos - 1.0;
+
+	if (max_out > bus->drift_capacity) {
+		for (size_t ch = 0; ch < bus->obs_channels; ch++)
+			bus->drift_out[ch] = brealloc(bus->drift_out[ch],
+						      max_out * sizeof(float));
+		bus->drift_capacity = max_out;
 	}
+
+	for (; pos < (double)frames - 1.0; pos += ratio, out++) {
+		long idx = (long)floor(pos);
+		float frac = (float)(pos - (double)idx);
+
+		for (size_t ch = 0; ch < bus->obs_channels; ch++) {
+			const float *in = bus->mix[ch];
+			float s0 = idx < 0 ? bus->drift_last[ch] : in[idx];
+			float s1 = in[idx + 1];
+
+			bus->drift_out[ch][out] = s0 + (s1 - s0) * frac;
+		}
+	}
+
+	for (size_t ch = 0; ch < bus->obs_channels; ch++)
+		bus->drift_last[ch] = bus->mix[ch][frames - 1];
+
+	bus->drift_pos = pos - (double)frames + 1.0;
+	return out;
 }
 
-static void on_audio_playback(void *param, obs_source_t *source,
-			      const struct audio_data *audio_data, bool muted)
+/* ------------------------------------------------------------------------- */
+/* output */
+
+static void drop_excess(struct monitor_bus *bus)
 {
-	struct audio_monitor *monitor = param;
-	float vol = source->user_volume;
-	size_t bytes;
+	size_t slack = pa_usec_to_bytes(100000, &(pa_sample_spec){
+		.format = bus->format,
+		.rate = (uint32_t)bus->samples_per_sec,
+		.channels = bus->channels});
+	size_t max_size = bus->attr.tlength * 2 + slack;
+
+	if (bus->new_data.size <= max_size)
+		return;
+
+	size_t drop = bus->new_data.size - bus->attr.tlength;
+	drop -= drop % bus->bytes_per_frame;
+
+	circlebuf_pop_front(&bus->new_data, NULL, drop);
+	bus->stats.dropped_frames += drop / bus->bytes_per_frame;
+}
 
+static void queue_ready_frames(struct monitor_bus *bus)
+{
+	size_t frames = get_ready_frames(bus);
 	uint8_t *resample_data[MAX_AV_PLANES];
 	uint32_t resample_frames;
 	uint64_t ts_offset;
-	bool success;
 
-	if (pthread_mutex_trylock(&monitor->playback_mutex) != 0)
+	if (!frames)
 		return;
 
-	if (os_atomic_load_long(&source->activate_refs) == 0)
-		goto unlock;
+	update_drift_ratio(bus);
+	size_t out = compensate_drift(bus, frames);
 
-	success = audio_resampler_resample(
-		monitor->resampler, resample_data, &resample_frames, &ts_offset,
-		(const uint8_t *const *)audio_data->data,
-		(uint32_t)audio_data->frames);
+	/* shift the rest of the mix down */
+	for (size_t ch = 0; ch < bus->obs_channels; ch++) {
+		float *mix = bus->mix[ch];
+		size_t left = bus->mix_capacity - frames;
 
-	if (!success)
-		goto unlock;
+		memmove(mix, mix + frames, left * sizeof(float));
+		memset(mix + left, 0, frames * sizeof(float));
+	}
 
-	bytes = monitor->bytes_per_frame * resample_frames;
+	bus->mix_frames -= frames;
+	bus->mix_pos += frames;
 
-	if (muted) {
-		memset(resample_data[0], 0, bytes);
-	} else {
-		if (!close_float(vol, 1.0f, EPSILON)) {
-			process_volume(monitor, vol, resample_data,
-				       resample_frames);
-		}
+	if (!out)
+		return;
+
+	if (!audio_resampler_resample(bus->resampler, resample_data,
+				      &resample_frames, &ts_offset,
+				      (const uint8_t *const *)bus->drift_out,
+				      (uint32_t)out))
+		return;
+
+	circlebuf_push_back(&bus->new_data, resample_data[0],
+			    bus->bytes_per_frame * resample_frames);
+	bus->packets++;
+	bus->frames += resample_frames;
+
+	drop_excess(bus);
+}
+
+/* requires the mainloop lock */
+static void update_latency(struct monitor_bus *bus)
+{
+	pa_usec_t usec;
+	int negative;
+
+	if (pa_stream_get_latency(bus->stream, &usec, &negative) == 0)
+		bus->device_latency_ns = negative ? 0 : usec * 1000;
+
+	size_t queued_frames = bus->new_data.size / bus->bytes_per_frame;
+	uint64_t latency = bus->device_latency_ns +
+			   audio_frames_to_ns((uint32_t)bus->samples_per_sec,
+					      queued_frames);
+
+	bus->stats.latency_ms = (uint32_t)(latency / 1000000);
+	if (bus->stats.latency_ms > bus->stats.max_latency_ms)
+		bus->stats.max_latency_ms = bus->stats.latency_ms;
+}
+
+static void do_stream_write(struct monitor_bus *bus)
+{
+	uint8_t *buffer = NULL;
+
+	pulseaudio_lock();
+	pthread_mutex_lock(&bus->mutex);
+
+	while (bus->new_data.size && bus->bytes_remaining) {
+		size_t bytes = bus->new_data.size < bus->bytes_remaining
+				       ? bus->new_data.size
+				       : bus->bytes_remaining;
+
+		bytes -= bytes % bus->bytes_per_frame;
+		if (!bytes)
+			break;
+
+		if (pa_stream_begin_write(bus->stream, (void **)&buffer,
+					  &bytes) != 0 ||
+		    !buffer)
+			break;
+
+		circlebuf_pop_front(&bus->new_data, buffer, bytes);
+		pa_stream_write(bus->stream, buffer, bytes, NULL, 0LL,
+				PA_SEEK_RELATIVE);
+
+		bus->bytes_remaining -= bytes;
 	}
 
-	circlebuf_push_back(&monitor->new_data, resample_data[0], bytes);
-	monitor->packets++;
-	monitor->frames += resample_frames;
+	update_latency(bus);
+
+	pthread_mutex_unlock(&bus->mutex);
+	pulseaudio_unlock();
+}
+
+static void on_audio_playback(void *param, obs_source_t *source,
+			      const struct audio_data *audio_data, bool muted)
+{
+	struct audio_monitor *monitor = param;
+	struct monitor_bus *bus = monitor->bus;
+	float vol = muted ? 0.0f : source->user_volume;
+
+	if (pthread_mutex_trylock(&monitor->playback_mutex) != 0)
+		return;
+
+	if (os_atomic_load_long(&source->activate_refs) == 0) {
+		pthread_mutex_unlock(&monitor->playback_mutex);
+		return;
+	}
+
+	pthread_mutex_lock(&bus->mutex);
+	mix_audio(bus, monitor, audio_data, vol);
+	queue_ready_frames(bus);
+	pthread_mutex_unlock(&bus->mutex);
 
-unlock:
 	pthread_mutex_unlock(&monitor->playback_mutex);
-	do_stream_write(param);
+	do_stream_write(bus);
 }
 
 static void pulseaudio_stream_write(pa_stream *p, size_t nbytes, void *userdata)
@@ -248,9 +528,9 @@ static void pulseaudio_stream_write(pa_stream *p, size_t nbytes, void *userdata)
 	UNUSED_PARAMETER(p);
 	PULSE_DATA(userdata);
 
-	pthread_mutex_lock(&data->playback_mutex);
-	data->bytesRemaining += nbytes;
-	pthread_mutex_unlock(&data->playback_mutex);
+	pthread_mutex_lock(&data->mutex);
+	data->bytes_remaining += nbytes;
+	pthread_mutex_unlock(&data->mutex);
 
 	pulseaudio_signal(0);
 }
@@ -260,12 +540,16 @@ static void pulseaudio_underflow(pa_stream *p, void *userdata)
 	UNUSED_PARAMETER(p);
 	PULSE_DATA(userdata);
 
-	pthread_mutex_lock(&data->playback_mutex);
-	if (obs_source_active(data->source))
-		data->attr.tlength = (data->attr.tlength * 3) / 2;
+	pthread_mutex_lock(&data->mutex);
+	data->stats.underruns++;
 
-	pa_stream_set_buffer_attr(data->stream, &data->attr, NULL, NULL);
-	pthread_mutex_unlock(&data->playback_mutex);
+	/* with no latency target, trade latency for fewer underruns */
+	if (!data->latency_ms && data->monitors.num) {
+		data->attr.tlength = (data->attr.tlength * 3) / 2;
+		pa_stream_set_buffer_attr(data->stream, &data->attr, NULL,
+					  NULL);
+	}
+	pthread_mutex_unlock(&data->mutex);
 
 	pulseaudio_signal(0);
 }
@@ -328,79 +612,83 @@ skip:
 	pulseaudio_signal(0);
 }
 
-static void pulseaudio_stop_playback(struct audio_monitor *monitor)
+/* ------------------------------------------------------------------------- */
+/* bus */
+
+static void bus_stop_playback(struct monitor_bus *bus)
 {
-	if (monitor->stream) {
-		pa_stream_disconnect(monitor->stream);
-		pa_stream_unref(monitor->stream);
-		monitor->stream = NULL;
+	if (bus->stream) {
+		pulseaudio_lock();
+		pa_stream_disconnect(bus->stream);
+		pa_stream_unref(bus->stream);
+		pulseaudio_unlock();
+		bus->stream = NULL;
 	}
 
-	blog(LOG_INFO, "Stopped Monitoring in '%s'", monitor->device);
+	blog(LOG_INFO, "Stopped Monitoring in '%s'", bus->device);
 	blog(LOG_INFO,
-	     "Got %" PRIuFAST32 " packets with %" PRIuFAST64 " frames",
-	     monitor->packets, monitor->frames);
-
-	monitor->packets = 0;
-	monitor->frames = 0;
+	     "Got %" PRIuFAST32 " packets with %" PRIuFAST64 " frames, "
+	     "%" PRIu64 " underruns, %" PRIu64 " dropped frames, "
+	     "%" PRIu64 " late frames",
+	     bus->packets, bus->frames, bus->stats.underruns,
+	     bus->stats.dropped_frames, bus->stats.late_frames);
+
+	bus->packets = 0;
+	bus->frames = 0;
 }
 
-static bool audio_monitor_init(struct audio_monitor *monitor,
-			       obs_source_t *source)
+static void bus_destroy(struct monitor_bus *bus)
 {
-	pthread_mutex_init_value(&monitor->playback_mutex);
+	if (bus->stream)
+		bus_stop_playback(bus);
 
-	monitor->source = source;
-
-	const char *id = obs->audio.monitoring_device_id;
-	if (!id)
-		return false;
-
-	if (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) {
-		obs_data_t *s = obs_source_get_settings(source);
-		const char *s_dev_id = obs_data_get_string(s, "device_id");
-		bool match = devices_match(s_dev_id, id);
-		obs_data_release(s);
-
-		if (match) {
-			monitor->ignore = true;
-			blog(LOG_INFO, "Prevented feedback-loop in '%s'",
-			     s_dev_id);
-			return true;
-		}
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++) {
+		bfree(bus->mix[ch]);
+		bfree(bus->drift_out[ch]);
 	}
 
-	pulseaudio_init();
+	audio_resampler_destroy(bus->resampler);
+	circlebuf_free(&bus->new_data);
+	da_free(bus->monitors);
+	pthread_mutex_destroy(&bus->mutex);
+	pulseaudio_unref();
+
+	bfree(bus->device_id);
+	bfree(bus->device);
+	bfree(bus);
+}
 
-	if (strcmp(id, "default") == 0)
-		get_default_id(&monitor->device);
+static bool bus_init(struct monitor_bus *bus)
+{
+	if (strcmp(bus->device_id, "default") == 0)
+		get_default_id(&bus->device);
 	else
-		monitor->device = bstrdup(id);
+		bus->device = bstrdup(bus->device_id);
 
-	if (!monitor->device)
+	if (!bus->device)
 		return false;
 
-	if (pulseaudio_get_server_info(pulseaudio_server_info,
-				       (void *)monitor) < 0) {
+	if (pulseaudio_get_server_info(pulseaudio_server_info, (void *)bus) <
+	    0) {
 		blog(LOG_ERROR, "Unable to get server info !");
 		return false;
 	}
 
-	if (pulseaudio_get_source_info(pulseaudio_source_info, monitor->device,
-				       (void *)monitor) < 0) {
+	if (pulseaudio_get_source_info(pulseaudio_source_info, bus->device,
+				       (void *)bus) < 0) {
 		blog(LOG_ERROR, "Unable to get source info !");
 		return false;
 	}
-	if (monitor->format == PA_SAMPLE_INVALID) {
+	if (bus->format == PA_SAMPLE_INVALID) {
 		blog(LOG_ERROR,
 		     "An error occurred while getting the source info!");
 		return false;
 	}
 
 	pa_sample_spec spec;
-	spec.format = monitor->format;
-	spec.rate = (uint32_t)monitor->samples_per_sec;
-	spec.channels = monitor->channels;
+	spec.format = bus->format;
+	spec.rate = (uint32_t)bus->samples_per_sec;
+	spec.channels = bus->channels;
 
 	if (!pa_sample_spec_valid(&spec)) {
 		blog(LOG_ERROR, "Sample spec is not valid");
@@ -410,83 +698,191 @@ static bool audio_monitor_init(struct audio_monitor *monitor,
 	const struct audio_output_info *info =
 		audio_output_get_info(obs->audio.audio);
 
+	bus->obs_rate = info->samples_per_sec;
+	bus->obs_channels = get_audio_channels(info->speakers);
+	bus->drift_ratio = 1.0;
+
 	struct resample_info from = {.samples_per_sec = info->samples_per_sec,
 				     .speakers = info->speakers,
 				     .format = AUDIO_FORMAT_FLOAT_PLANAR};
 	struct resample_info to = {
-		.samples_per_sec = (uint32_t)monitor->samples_per_sec,
-		.speakers =
-			pulseaudio_channels_to_obs_speakers(monitor->channels),
-		.format = pulseaudio_to_obs_audio_format(monitor->format)};
+		.samples_per_sec = (uint32_t)bus->samples_per_sec,
+		.speakers = pulseaudio_channels_to_obs_speakers(bus->channels),
+		.format = pulseaudio_to_obs_audio_format(bus->format)};
 
-	monitor->resampler = audio_resampler_create(&to, &from);
-	if (!monitor->resampler) {
+	bus->resampler = audio_resampler_create(&to, &from);
+	if (!bus->resampler) {
 		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
 		     "Failed to create resampler");
 		return false;
 	}
 
-	monitor->bytes_per_channel = get_audio_bytes_per_channel(
-		pulseaudio_to_obs_audio_format(monitor->format));
-	monitor->speakers = pulseaudio_channels_to_obs_speakers(spec.channels);
-	monitor->bytes_per_frame = pa_frame_size(&spec);
+	bus->speakers = pulseaudio_channels_to_obs_speakers(spec.channels);
+	bus->bytes_per_frame = pa_frame_size(&spec);
 
-	pa_channel_map channel_map = pulseaudio_channel_map(monitor->speakers);
+	pa_channel_map channel_map = pulseaudio_channel_map(bus->speakers);
 
-	monitor->stream = pulseaudio_stream_new(
-		obs_source_get_name(monitor->source), &spec, &channel_map);
-	if (!monitor->stream) {
+	bus->stream = pulseaudio_stream_new("Monitoring", &spec, &channel_map);
+	if (!bus->stream) {
 		blog(LOG_ERROR, "Unable to create stream");
 		return false;
 	}
 
-	monitor->attr.fragsize = (uint32_t)-1;
-	monitor->attr.maxlength = (uint32_t)-1;
-	monitor->attr.minreq = (uint32_t)-1;
-	monitor->attr.prebuf = (uint32_t)-1;
-	monitor->attr.tlength = pa_usec_to_bytes(25000, &spec);
+	uint32_t latency_ms = bus->latency_ms ? bus->latency_ms
+					      : DEFAULT_LATENCY_MS;
 
-	monitor->buffer_size =
-		monitor->bytes_per_frame * pa_usec_to_bytes(5000, &spec);
+	bus->attr.fragsize = (uint32_t)-1;
+	bus->attr.maxlength = (uint32_t)-1;
+	bus->attr.minreq = (uint32_t)-1;
+	bus->attr.prebuf = (uint32_t)-1;
+	bus->attr.tlength = pa_usec_to_bytes(latency_ms * 1000, &spec);
 
 	pa_stream_flags_t flags = PA_STREAM_INTERPOLATE_TIMING |
 				  PA_STREAM_AUTO_TIMING_UPDATE;
 
-	if (pthread_mutex_init(&monitor->playback_mutex, NULL) != 0) {
+	/* with a latency target, ask the server to keep its own buffering
+	 * within it as well */
+	if (bus->latency_ms)
+		flags |= PA_STREAM_ADJUST_LATENCY;
+
+	pulseaudio_write_callback(bus->stream, pulseaudio_stream_write,
+				  (void *)bus);
+	pulseaudio_set_underflow_callback(bus->stream, pulseaudio_underflow,
+					  (void *)bus);
+
+	int_fast32_t ret = pulseaudio_connect_playback(bus->stream, bus->device,
+						       &bus->attr, flags);
+	if (ret < 0) {
+		bus_stop_playback(bus);
+		blog(LOG_ERROR, "Unable to connect to stream");
+		return false;
+	}
+
+	bus->stats.target_latency_ms = latency_ms;
+
+	blog(LOG_INFO, "Started Monitoring in '%s', %" PRIu32 " ms target",
+	     bus->device, latency_ms);
+	return true;
+}
+
+/* monitors share the bus for the current device and latency target.  when
+ * either changes a new bus is created, and the old one goes away once all
+ * of its monitors have been reset. */
+static struct monitor_bus *bus_acquire(const char *device_id)
+{
+	struct monitor_bus *bus;
+	uint32_t latency_ms = obs->audio.monitoring_latency_ms;
+
+	pthread_mutex_lock(&bus_mutex);
+
+	bus = cur_bus;
+	if (bus && strcmp(bus->device_id, device_id) == 0 &&
+	    bus->latency_ms == latency_ms) {
+		bus->refs++;
+		goto unlock;
+	}
+
+	pulseaudio_init();
+
+	bus = bzalloc(sizeof(struct monitor_bus));
+	bus->refs = 1;
+	bus->device_id = bstrdup(device_id);
+	bus->latency_ms = latency_ms;
+
+	if (pthread_mutex_init(&bus->mutex, NULL) != 0) {
 		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
 		     "Failed to init mutex");
+		bfree(bus->device_id);
+		bfree(bus);
+		pulseaudio_unref();
+		bus = NULL;
+		goto unlock;
+	}
+
+	if (!bus_init(bus)) {
+		bus_destroy(bus);
+		bus = NULL;
+		goto unlock;
+	}
+
+	cur_bus = bus;
+
+unlock:
+	pthread_mutex_unlock(&bus_mutex);
+	return bus;
+}
+
+static void bus_release(struct monitor_bus *bus)
+{
+	if (!bus)
+		return;
+
+	pthread_mutex_lock(&bus_mutex);
+	if (--bus->refs == 0) {
+		if (cur_bus == bus)
+			cur_bus = NULL;
+		bus_destroy(bus);
+	}
+	pthread_mutex_unlock(&bus_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool audio_monitor_init(struct audio_monitor *monitor,
+			       obs_source_t *source)
+{
+	pthread_mutex_init_value(&monitor->playback_mutex);
+
+	monitor->source = source;
+
+	const char *id = obs->audio.monitoring_device_id;
+	if (!id)
 		return false;
+
+	if (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) {
+		obs_data_t *s = obs_source_get_settings(source);
+		const char *s_dev_id = obs_data_get_string(s, "device_id");
+		bool match = devices_match(s_dev_id, id);
+		obs_data_release(s);
+
+		if (match) {
+			monitor->ignore = true;
+			blog(LOG_INFO, "Prevented feedback-loop in '%s'",
+			     s_dev_id);
+			return true;
+		}
 	}
 
-	int_fast32_t ret = pulseaudio_connect_playback(
-		monitor->stream, monitor->device, &monitor->attr, flags);
-	if (ret < 0) {
-		pulseaudio_stop_playback(monitor);
-		blog(LOG_ERROR, "Unable to connect to stream");
+	if (pthread_mutex_init(&monitor->playback_mutex, NULL) != 0) {
+		blog(LOG_WARNING, "%s: %s", __FUNCTION__,
+		     "Failed to init mutex");
 		return false;
 	}
 
-	blog(LOG_INFO, "Started Monitoring in '%s'", monitor->device);
-	return true;
+	monitor->bus = bus_acquire(id);
+	return monitor->bus != NULL;
 }
 
 static void audio_monitor_init_final(struct audio_monitor *monitor)
 {
+	struct monitor_bus *bus = monitor->bus;
+
 	if (monitor->ignore)
 		return;
 
+	pthread_mutex_lock(&bus->mutex);
+	da_push_back(bus->monitors, &monitor);
+	bus->stats.sources = (uint32_t)bus->monitors.num;
+	pthread_mutex_unlock(&bus->mutex);
+
 	obs_source_add_audio_capture_callback(monitor->source,
 					      on_audio_playback, monitor);
-
-	pulseaudio_write_callback(monitor->stream, pulseaudio_stream_write,
-				  (void *)monitor);
-
-	pulseaudio_set_underflow_callback(monitor->stream, pulseaudio_underflow,
-					  (void *)monitor);
 }
 
 static inline void audio_monitor_free(struct audio_monitor *monitor)
 {
+	struct monitor_bus *bus = monitor->bus;
+
 	if (monitor->ignore)
 		return;
 
@@ -494,14 +890,17 @@ static inline void audio_monitor_free(struct audio_monitor *monitor)
 		obs_source_remove_audio_capture_callback(
 			monitor->source, on_audio_playback, monitor);
 
-	audio_resampler_destroy(monitor->resampler);
-	circlebuf_free(&monitor->new_data);
+	if (bus) {
+		pthread_mutex_lock(&bus->mutex);
+		da_erase_item(bus->monitors, &monitor);
+		bus->stats.sources = (uint32_t)bus->monitors.num;
+		pthread_mutex_unlock(&bus->mutex);
 
-	if (monitor->stream)
-		pulseaudio_stop_playback(monitor);
-	pulseaudio_unref();
+		bus_release(bus);
+		monitor->bus = NULL;
+	}
 
-	bfree(monitor->device);
+	pthread_mutex_destroy(&monitor->playback_mutex);
 }
 
 struct audio_monitor *audio_monitor_create(obs_source_t *source)
@@ -529,18 +928,16 @@ fail:
 void audio_monitor_reset(struct audio_monitor *monitor)
 {
 	struct audio_monitor new_monitor = {0};
-	bool success;
-	audio_monitor_free(monitor);
+	obs_source_t *source = monitor->source;
 
-	pthread_mutex_lock(&monitor->playback_mutex);
-	success = audio_monitor_init(&new_monitor, monitor->source);
-	pthread_mutex_unlock(&monitor->playback_mutex);
+	audio_monitor_free(monitor);
 
-	if (success) {
+	if (audio_monitor_init(&new_monitor, source)) {
 		*monitor = new_monitor;
 		audio_monitor_init_final(monitor);
 	} else {
 		audio_monitor_free(&new_monitor);
+		monitor->ignore = true;
 	}
 }
 
@@ -556,3 +953,19 @@ void audio_monitor_destroy(struct audio_monitor *monitor)
 		bfree(monitor);
 	}
 }
+
+bool audio_monitoring_get_stats(struct obs_audio_monitoring_stats *stats)
+{
+	bool success = false;
+
+	pthread_mutex_lock(&bus_mutex);
+	if (cur_bus) {
+		pthread_mutex_lock(&cur_bus->mutex);
+		*stats = cur_bus->stats;
+		pthread_mutex_unlock(&cur_bus->mutex);
+		success = true;
+	}
+	pthread_mutex_unlock(&bus_mutex);
+
+	return success;
+}
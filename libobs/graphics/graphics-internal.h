@@ -178,6 +178,10 @@ struct gs_exports {
 	bool (*gs_texture_map)(gs_texture_t *tex, uint8_t **ptr,
 			       uint32_t *linesize);
 	void (*gs_texture_unmap)(gs_texture_t *tex);
+	void (*gs_texture_set_image_rows)(gs_texture_t *tex,
+					  const uint8_t *data,
+					  uint32_t linesize, uint32_t y,
+					  uint32_t height);
 	bool (*gs_texture_is_rect)(const gs_texture_t *tex);
 	void *(*gs_texture_get_obj)(const gs_texture_t *tex);
 
@@ -322,6 +326,17 @@ struct blend_state {
 	enum gs_blend_type dest_a;
 };
 
+struct gs_pooled_target;
+
+struct gs_texrender_pool {
+	DARRAY(struct gs_pooled_target *) targets;
+	uint64_t frame;
+	uint64_t peak_bytes;
+};
+
+extern void gs_texrender_pool_begin_frame(struct gs_texrender_pool *pool);
+extern void gs_texrender_pool_free(struct gs_texrender_pool *pool);
+
 struct graphics_subsystem {
 	void *module;
 	gs_device_t *device;
@@ -353,4 +368,6 @@ struct graphics_subsystem {
 
 	struct blend_state cur_blend_state;
 	DARRAY(struct blend_state) blend_state_stack;
+
+	struct gs_texrender_pool texrender_pool;
 };
@@ -178,6 +178,7 @@ int gs_create(graphics_t **pgraphics, const char *module, uint32_t adapter)
 	graphics_t *graphics = bzalloc(sizeof(struct graphics_subsystem));
 	pthread_mutex_init_value(&graphics->mutex);
 	pthread_mutex_init_value(&graphics->effect_mutex);
+	graphics->texrender_pool.frame = 1;
 
 	graphics->module = os_dlopen(module);
 	if (!graphics->module) {
@@ -228,6 +229,7 @@ void gs_destroy(graphics_t *graphics)
 			effect = next;
 		}
 
+		gs_texrender_pool_free(&graphics->texrender_pool);
 		graphics->exports.gs_vertexbuffer_destroy(
 			graphics->sprite_buffer);
 		graphics->exports.gs_vertexbuffer_destroy(
@@ -1741,6 +1743,7 @@ void gs_begin_frame(void)
 	if (!gs_valid("gs_begin_frame"))
 		return;
 
+	gs_texrender_pool_begin_frame(&graphics->texrender_pool);
 	graphics->exports.device_begin_frame(graphics->device);
 }
 
@@ -2296,6 +2299,24 @@ void gs_texture_unmap(gs_texture_t *tex)
 	graphics->exports.gs_texture_unmap(tex);
 }
 
+void gs_texture_set_image_rows(gs_texture_t *tex, const uint8_t *data,
+			       uint32_t linesize, uint32_t y, uint32_t height)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid_p2("gs_texture_set_image_rows", tex, data))
+		return;
+	if (!height || y + height > gs_texture_get_height(tex))
+		return;
+
+	if (graphics->exports.gs_texture_set_image_rows)
+		graphics->exports.gs_texture_set_image_rows(tex, data,
+							    linesize, y,
+							    height);
+	else
+		gs_texture_set_image(tex, data, linesize, false);
+}
+
 bool gs_texture_is_rect(const gs_texture_t *tex)
 {
 	graphics_t *graphics = thread_graphics;
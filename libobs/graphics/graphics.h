@@ -73,6 +73,7 @@ enum gs_color_format {
 	GS_DXT3,
 	GS_DXT5,
 	GS_R8G8,
+	GS_R16G16,
 };
 
 enum gs_zstencil_format {
@@ -434,6 +435,9 @@ EXPORT void gs_effect_set_color(gs_eparam_t *param, uint32_t argb);
 
 EXPORT gs_texrender_t *gs_texrender_create(enum gs_color_format format,
 					   enum gs_zstencil_format zsformat);
+EXPORT gs_texrender_t *
+gs_texrender_create_transient(enum gs_color_format format,
+			      enum gs_zstencil_format zsformat);
 EXPORT void gs_texrender_destroy(gs_texrender_t *texrender);
 EXPORT bool gs_texrender_begin(gs_texrender_t *texrender, uint32_t cx,
 			       uint32_t cy);
@@ -441,6 +445,16 @@ EXPORT void gs_texrender_end(gs_texrender_t *texrender);
 EXPORT void gs_texrender_reset(gs_texrender_t *texrender);
 EXPORT gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender);
 
+struct gs_texrender_pool_stats {
+	size_t num_targets;
+	size_t num_leased;
+	uint64_t bytes;
+	uint64_t leased_bytes;
+	uint64_t peak_bytes;
+};
+
+EXPORT void gs_texrender_pool_get_stats(struct gs_texrender_pool_stats *stats);
+
 /* ---------------------------------------------------
  * graphics subsystem
  * --------------------------------------------------- */
@@ -729,6 +743,12 @@ gs_texture_get_color_format(const gs_texture_t *tex);
 EXPORT bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr,
 			   uint32_t *linesize);
 EXPORT void gs_texture_unmap(gs_texture_t *tex);
+/** uploads rows y to y + height - 1 of an image with the texture's size,
+ * other rows are left as they are.  falls back to uploading the whole
+ * image if the renderer cannot upload part of a texture */
+EXPORT void gs_texture_set_image_rows(gs_texture_t *tex, const uint8_t *data,
+				      uint32_t linesize, uint32_t y,
+				      uint32_t height);
 /** special-case function (GL only) - specifies whether the texture is a
  * GL_TEXTURE_RECTANGLE type, which doesn't use normalized texture
  * coordinates, doesn't support mipmapping, and requires address clamping */
@@ -926,6 +946,8 @@ static inline uint32_t gs_get_format_bpp(enum gs_color_format format)
 		return 8;
 	case GS_R8G8:
 		return 16;
+	case GS_R16G16:
+		return 32;
 	case GS_UNKNOWN:
 		return 0;
 	}
@@ -21,7 +21,31 @@
  */
 
 #include <assert.h>
-#include "graphics.h"
+#include <inttypes.h>
+#include "graphics-internal.h"
+
+/*
+ *   Transient texture renders don't own their render target.  They lease one
+ * from a pool shared by the graphics context on begin, and the lease expires
+ * at the next gs_begin_frame, after which the target can go to any other
+ * transient texture render of the same size and format.  Targets that have
+ * not been leased for a while are destroyed.
+ */
+
+#define POOL_MAX_IDLE_FRAMES 60
+
+struct gs_pooled_target {
+	gs_texture_t *tex;
+	gs_zstencil_t *zs;
+
+	uint32_t cx, cy;
+
+	enum gs_color_format format;
+	enum gs_zstencil_format zsformat;
+
+	uint64_t lease_frame;
+	uint64_t last_frame;
+};
 
 struct gs_texture_render {
 	gs_texture_t *target, *prev_target;
@@ -33,8 +57,220 @@ struct gs_texture_render {
 	enum gs_zstencil_format zsformat;
 
 	bool rendered;
+
+	bool transient;
+	struct gs_pooled_target *pooled;
+	uint64_t lease_frame;
 };
 
+static uint32_t get_zstencil_bpp(enum gs_zstencil_format format)
+{
+	switch (format) {
+	case GS_ZS_NONE:
+		return 0;
+	case GS_Z16:
+		return 16;
+	case GS_Z24_S8:
+		return 32;
+	case GS_Z32F:
+		return 32;
+	case GS_Z32F_S8X24:
+		return 64;
+	}
+
+	return 0;
+}
+
+static inline uint64_t pooled_target_size(const struct gs_pooled_target *pt)
+{
+	uint64_t bpp = gs_get_format_bpp(pt->format) +
+		       get_zstencil_bpp(pt->zsformat);
+	return (uint64_t)pt->cx * (uint64_t)pt->cy * bpp / 8;
+}
+
+static void pooled_target_destroy(struct gs_pooled_target *pt)
+{
+	gs_texture_destroy(pt->tex);
+	gs_zstencil_destroy(pt->zs);
+	bfree(pt);
+}
+
+static uint64_t pool_get_size(const struct gs_texrender_pool *pool)
+{
+	uint64_t size = 0;
+
+	for (size_t i = 0; i < pool->targets.num; i++)
+		size += pooled_target_size(pool->targets.array[i]);
+
+	return size;
+}
+
+static struct gs_pooled_target *pool_create_target(
+	struct gs_texrender_pool *pool, enum gs_color_format format,
+	enum gs_zstencil_format zsformat, uint32_t cx, uint32_t cy)
+{
+	struct gs_pooled_target *pt = bzalloc(sizeof(*pt));
+	uint64_t size;
+
+	pt->cx = cx;
+	pt->cy = cy;
+	pt->format = format;
+	pt->zsformat = zsformat;
+
+	pt->tex = gs_texture_create(cx, cy, format, 1, NULL, GS_RENDER_TARGET);
+	if (!pt->tex)
+		goto fail;
+
+	if (zsformat != GS_ZS_NONE) {
+		pt->zs = gs_zstencil_create(cx, cy, zsformat);
+		if (!pt->zs)
+			goto fail;
+	}
+
+	da_push_back(pool->targets, &pt);
+
+	size = pool_get_size(pool);
+	if (size > pool->peak_bytes)
+		pool->peak_bytes = size;
+	return pt;
+
+fail:
+	pooled_target_destroy(pt);
+	return NULL;
+}
+
+static struct gs_pooled_target *pool_lease(struct gs_texrender_pool *pool,
+					   enum gs_color_format format,
+					   enum gs_zstencil_format zsformat,
+					   uint32_t cx, uint32_t cy)
+{
+	struct gs_pooled_target *pt = NULL;
+
+	for (size_t i = 0; i < pool->targets.num; i++) {
+		struct gs_pooled_target *cur = pool->targets.array[i];
+
+		if (cur->lease_frame != pool->frame && cur->cx == cx &&
+		    cur->cy == cy && cur->format == format &&
+		    cur->zsformat == zsformat) {
+			pt = cur;
+			break;
+		}
+	}
+
+	if (!pt)
+		pt = pool_create_target(pool, format, zsformat, cx, cy);
+	if (pt)
+		pt->lease_frame = pt->last_frame = pool->frame;
+	return pt;
+}
+
+void gs_texrender_pool_begin_frame(struct gs_texrender_pool *pool)
+{
+	/* every lease ends here, so idle targets can be destroyed safely */
+	pool->frame++;
+
+	for (size_t i = pool->targets.num; i > 0; i--) {
+		struct gs_pooled_target *pt = pool->targets.array[i - 1];
+
+		if (pool->frame - pt->last_frame > POOL_MAX_IDLE_FRAMES) {
+			pooled_target_destroy(pt);
+			da_erase(pool->targets, i - 1);
+		}
+	}
+}
+
+void gs_texrender_pool_free(struct gs_texrender_pool *pool)
+{
+	if (pool->peak_bytes)
+		blog(LOG_INFO,
+		     "Render target pool peak usage: %" PRIu64 " KB",
+		     pool->peak_bytes / 1024);
+
+	for (size_t i = 0; i < pool->targets.num; i++)
+		pooled_target_destroy(pool->targets.array[i]);
+	da_free(pool->targets);
+}
+
+void gs_texrender_pool_get_stats(struct gs_texrender_pool_stats *stats)
+{
+	graphics_t *graphics = gs_get_context();
+	struct gs_texrender_pool *pool;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!graphics)
+		return;
+
+	pool = &graphics->texrender_pool;
+
+	for (size_t i = 0; i < pool->targets.num; i++) {
+		struct gs_pooled_target *pt = pool->targets.array[i];
+		uint64_t size = pooled_target_size(pt);
+
+		stats->num_targets++;
+		stats->bytes += size;
+
+		if (pt->lease_frame == pool->frame) {
+			stats->num_leased++;
+			stats->leased_bytes += size;
+		}
+	}
+
+	stats->peak_bytes = pool->peak_bytes;
+}
+
+static inline struct gs_texrender_pool *get_pool(void)
+{
+	graphics_t *graphics = gs_get_context();
+	return graphics ? &graphics->texrender_pool : NULL;
+}
+
+static bool lease_valid(const gs_texrender_t *texrender)
+{
+	struct gs_texrender_pool *pool = get_pool();
+	return pool && texrender->pooled &&
+	       texrender->lease_frame == pool->frame;
+}
+
+static void texrender_end_lease(gs_texrender_t *texrender)
+{
+	if (lease_valid(texrender))
+		texrender->pooled->lease_frame = 0;
+
+	texrender->pooled = NULL;
+	texrender->target = NULL;
+	texrender->zs = NULL;
+	texrender->cx = 0;
+	texrender->cy = 0;
+}
+
+static bool texrender_lease(gs_texrender_t *texrender, uint32_t cx,
+			    uint32_t cy)
+{
+	struct gs_texrender_pool *pool = get_pool();
+	struct gs_pooled_target *pt;
+
+	if (lease_valid(texrender) && texrender->cx == cx &&
+	    texrender->cy == cy)
+		return true;
+
+	texrender_end_lease(texrender);
+
+	if (!pool)
+		return false;
+
+	pt = pool_lease(pool, texrender->format, texrender->zsformat, cx, cy);
+	if (!pt)
+		return false;
+
+	texrender->pooled = pt;
+	texrender->lease_frame = pool->frame;
+	texrender->target = pt->tex;
+	texrender->zs = pt->zs;
+	texrender->cx = cx;
+	texrender->cy = cy;
+	return true;
+}
+
 gs_texrender_t *gs_texrender_create(enum gs_color_format format,
 				    enum gs_zstencil_format zsformat)
 {
@@ -46,11 +282,23 @@ gs_texrender_t *gs_texrender_create(enum gs_color_format format,
 	return texrender;
 }
 
+gs_texrender_t *gs_texrender_create_transient(enum gs_color_format format,
+					      enum gs_zstencil_format zsformat)
+{
+	gs_texrender_t *texrender = gs_texrender_create(format, zsformat);
+	texrender->transient = true;
+	return texrender;
+}
+
 void gs_texrender_destroy(gs_texrender_t *texrender)
 {
 	if (texrender) {
-		gs_texture_destroy(texrender->target);
-		gs_zstencil_destroy(texrender->zs);
+		if (texrender->transient) {
+			texrender_end_lease(texrender);
+		} else {
+			gs_texture_destroy(texrender->target);
+			gs_zstencil_destroy(texrender->zs);
+		}
 		bfree(texrender);
 	}
 }
@@ -89,15 +337,27 @@ static bool texrender_resetbuffer(gs_texrender_t *texrender, uint32_t cx,
 
 bool gs_texrender_begin(gs_texrender_t *texrender, uint32_t cx, uint32_t cy)
 {
-	if (!texrender || texrender->rendered)
+	if (!texrender)
+		return false;
+
+	/* an expired lease means the contents may belong to someone else */
+	if (texrender->transient && !lease_valid(texrender))
+		texrender->rendered = false;
+
+	if (texrender->rendered)
 		return false;
 
 	if (!cx || !cy)
 		return false;
 
-	if (texrender->cx != cx || texrender->cy != cy)
+	if (texrender->transient) {
+		if (!texrender_lease(texrender, cx, cy))
+			return false;
+
+	} else if (texrender->cx != cx || texrender->cy != cy) {
 		if (!texrender_resetbuffer(texrender, cx, cy))
 			return false;
+	}
 
 	if (!texrender->target)
 		return false;
@@ -138,5 +398,9 @@ void gs_texrender_reset(gs_texrender_t *texrender)
 
 gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender)
 {
-	return texrender ? texrender->target : NULL;
+	if (!texrender)
+		return NULL;
+	if (texrender->transient && !lease_valid(texrender))
+		return NULL;
+	return texrender->target;
 }
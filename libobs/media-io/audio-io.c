@@ -31,29 +31,53 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 /* #define DEBUG_AUDIO */
 
+/* how long the audio thread waits on an external clock before falling back
+ * to the system clock until the clock advances again */
+#define CLOCK_TIMEOUT_MS 200
+
 #define nop()                    \
 	do {                     \
 		int invalid = 0; \
 	} while (0)
 
-struct audio_input {
+/* inputs of a mix that want the same conversion share one resampler, so
+ * each conversion is only done once per tick */
+struct audio_mix_resampler {
 	struct audio_convert_info conversion;
 	audio_resampler_t *resampler;
+	long refs;
+
+	bool resampled;
+	bool success;
+	struct audio_data data;
+};
+
+struct audio_input {
+	struct audio_convert_info conversion;
+	struct audio_mix_resampler *resampler;
 
 	audio_output_callback_t callback;
 	void *param;
 };
 
-static inline void audio_input_free(struct audio_input *input)
-{
-	audio_resampler_destroy(input->resampler);
-}
-
 struct audio_mix {
 	DARRAY(struct audio_input) inputs;
+	DARRAY(struct audio_mix_resampler *) resamplers;
 	float buffer[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES];
 };
 
+static void audio_input_free(struct audio_mix *mix, struct audio_input *input)
+{
+	struct audio_mix_resampler *resampler = input->resampler;
+
+	if (!resampler || --resampler->refs > 0)
+		return;
+
+	da_erase_item(mix->resamplers, &resampler);
+	audio_resampler_destroy(resampler->resampler);
+	bfree(resampler);
+}
+
 struct audio_output {
 	struct audio_output_info info;
 	size_t block_size;
@@ -69,6 +93,23 @@ struct audio_output {
 	void *input_param;
 	pthread_mutex_t input_mutex;
 	struct audio_mix mixes[MAX_AUDIO_MIXES];
+
+	/* external clock, the audio thread ticks when the clock has passed
+	 * the end of the next tick rather than on a timer.  clock time is
+	 * clock_frames at clock_rate from clock_base, which is anchored to
+	 * the end of the last tick (audio_time) when the clock starts. */
+	pthread_mutex_t clock_mutex;
+	os_event_t *clock_event;
+	bool clock_external;
+	bool clock_stalled;
+	uint64_t clock_base;
+	uint64_t clock_frames;
+	uint32_t clock_rate;
+	uint64_t audio_time;
+
+	/* set by the input callback to be called again for the same tick,
+	 * see audio_output_request_extra_tick */
+	bool extra_tick;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -121,26 +162,31 @@ static inline size_t min_size(size_t a, size_t b)
 static bool resample_audio_output(struct audio_input *input,
 				  struct audio_data *data)
 {
-	bool success = true;
+	struct audio_mix_resampler *resampler = input->resampler;
+
+	if (!resampler)
+		return true;
 
-	if (input->resampler) {
+	if (!resampler->resampled) {
 		uint8_t *output[MAX_AV_PLANES];
 		uint32_t frames;
 		uint64_t offset;
 
 		memset(output, 0, sizeof(output));
 
-		success = audio_resampler_resample(
-			input->resampler, output, &frames, &offset,
+		resampler->success = audio_resampler_resample(
+			resampler->resampler, output, &frames, &offset,
 			(const uint8_t *const *)data->data, data->frames);
 
 		for (size_t i = 0; i < MAX_AV_PLANES; i++)
-			data->data[i] = output[i];
-		data->frames = frames;
-		data->timestamp -= offset;
+			resampler->data.data[i] = output[i];
+		resampler->data.frames = frames;
+		resampler->data.timestamp = data->timestamp - offset;
+		resampler->resampled = true;
 	}
 
-	return success;
+	*data = resampler->data;
+	return resampler->success;
 }
 
 static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
@@ -151,6 +197,9 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 
 	pthread_mutex_lock(&audio->input_mutex);
 
+	for (size_t i = 0; i < mix->resamplers.num; i++)
+		mix->resamplers.array[i]->resampled = false;
+
 	for (size_t i = mix->inputs.num; i > 0; i--) {
 		struct audio_input *input = mix->inputs.array + (i - 1);
 
@@ -239,6 +288,59 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 	/* output */
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
 		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+
+	if (audio->extra_tick) {
+		audio->extra_tick = false;
+		input_and_output(audio, audio_time, prev_time);
+	}
+}
+
+static inline uint64_t get_clock_time(const struct audio_output *audio)
+{
+	return audio->clock_base +
+	       audio_frames_to_ns(audio->clock_rate, audio->clock_frames);
+}
+
+/* returns the time the audio thread can tick up to, or 0 to tick on the
+ * system timer */
+static uint64_t wait_for_clock(struct audio_output *audio)
+{
+	uint64_t cur_time = 0;
+
+	pthread_mutex_lock(&audio->clock_mutex);
+	bool external = audio->clock_external && !audio->clock_stalled &&
+			audio->clock_rate;
+	pthread_mutex_unlock(&audio->clock_mutex);
+
+	if (!external)
+		return 0;
+
+	int ret = os_event_timedwait(audio->clock_event, CLOCK_TIMEOUT_MS);
+
+	pthread_mutex_lock(&audio->clock_mutex);
+	if (!audio->clock_external || !audio->clock_rate) {
+		cur_time = 0;
+
+	} else if (ret == ETIMEDOUT) {
+		blog(LOG_WARNING,
+		     "audio-io: external clock stopped advancing, "
+		     "using the system clock until it resumes");
+		audio->clock_stalled = true;
+
+	} else {
+		cur_time = get_clock_time(audio);
+	}
+	pthread_mutex_unlock(&audio->clock_mutex);
+
+	return cur_time;
+}
+
+static inline void set_audio_time(struct audio_output *audio,
+				  uint64_t audio_time)
+{
+	pthread_mutex_lock(&audio->clock_mutex);
+	audio->audio_time = audio_time;
+	pthread_mutex_unlock(&audio->clock_mutex);
 }
 
 static void *audio_thread(void *param)
@@ -258,14 +360,18 @@ static void *audio_thread(void *param)
 		profile_store_name(obs_get_profiler_name_store(),
 				   "audio_thread(%s)", audio->info.name);
 
+	set_audio_time(audio, audio_time);
+
 	while (os_event_try(audio->stop_event) == EAGAIN) {
-		uint64_t cur_time;
+		uint64_t cur_time = wait_for_clock(audio);
 
-		os_sleep_ms(audio_wait_time);
+		if (!cur_time) {
+			os_sleep_ms(audio_wait_time);
+			cur_time = os_gettime_ns();
+		}
 
 		profile_start(audio_thread_name);
 
-		cur_time = os_gettime_ns();
 		while (audio_time <= cur_time) {
 			samples += AUDIO_OUTPUT_FRAMES;
 			audio_time =
@@ -275,6 +381,8 @@ static void *audio_thread(void *param)
 			prev_time = audio_time;
 		}
 
+		set_audio_time(audio, audio_time);
+
 		profile_end(audio_thread_name);
 
 		profile_reenable_thread();
@@ -300,23 +408,61 @@ static size_t audio_get_input_idx(const audio_t *audio, size_t mix_idx,
 	return DARRAY_INVALID;
 }
 
+static inline bool same_conversion(const struct audio_convert_info *a,
+				   const struct audio_convert_info *b)
+{
+	return a->format == b->format &&
+	       a->samples_per_sec == b->samples_per_sec &&
+	       a->speakers == b->speakers;
+}
+
+static struct audio_mix_resampler *
+get_mix_resampler(struct audio_output *audio, struct audio_mix *mix,
+		  const struct audio_convert_info *conversion)
+{
+	struct audio_mix_resampler *resampler;
+
+	for (size_t i = 0; i < mix->resamplers.num; i++) {
+		resampler = mix->resamplers.array[i];
+
+		if (same_conversion(&resampler->conversion, conversion)) {
+			resampler->refs++;
+			return resampler;
+		}
+	}
+
+	struct resample_info from = {
+		.format = audio->info.format,
+		.samples_per_sec = audio->info.samples_per_sec,
+		.speakers = audio->info.speakers};
+
+	struct resample_info to = {.format = conversion->format,
+				   .samples_per_sec =
+					   conversion->samples_per_sec,
+				   .speakers = conversion->speakers};
+
+	resampler = bzalloc(sizeof(struct audio_mix_resampler));
+	resampler->conversion = *conversion;
+	resampler->refs = 1;
+	resampler->resampler = audio_resampler_create(&to, &from);
+	if (!resampler->resampler) {
+		bfree(resampler);
+		return NULL;
+	}
+
+	da_push_back(mix->resamplers, &resampler);
+	return resampler;
+}
+
 static inline bool audio_input_init(struct audio_input *input,
-				    struct audio_output *audio)
+				    struct audio_output *audio,
+				    struct audio_mix *mix)
 {
 	if (input->conversion.format != audio->info.format ||
 	    input->conversion.samples_per_sec != audio->info.samples_per_sec ||
 	    input->conversion.speakers != audio->info.speakers) {
-		struct resample_info from = {
-			.format = audio->info.format,
-			.samples_per_sec = audio->info.samples_per_sec,
-			.speakers = audio->info.speakers};
-
-		struct resample_info to = {
-			.format = input->conversion.format,
-			.samples_per_sec = input->conversion.samples_per_sec,
-			.speakers = input->conversion.speakers};
-
-		input->resampler = audio_resampler_create(&to, &from);
+		input->resampler =
+			get_mix_resampler(audio, mix, &input->conversion);
 		if (!input->resampler) {
 			blog(LOG_ERROR, "audio_input_init: Failed to "
 					"create resampler");
@@ -363,7 +509,7 @@ bool audio_output_connect(audio_t *audio, size_t mi,
 			input.conversion.samples_per_sec =
 				audio->info.samples_per_sec;
 
-		success = audio_input_init(&input, audio);
+		success = audio_input_init(&input, audio, mix);
 		if (success)
 			da_push_back(mix->inputs, &input);
 	}
@@ -384,7 +530,7 @@ void audio_output_disconnect(audio_t *audio, size_t mix_idx,
 	size_t idx = audio_get_input_idx(audio, mix_idx, callback, param);
 	if (idx != DARRAY_INVALID) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
-		audio_input_free(mix->inputs.array + idx);
+		audio_input_free(mix, mix->inputs.array + idx);
 		da_erase(mix->inputs, idx);
 	}
 
@@ -410,6 +556,9 @@ int audio_output_open(audio_t **audio, struct audio_output_info *info)
 	if (!out)
 		goto fail;
 
+	pthread_mutex_init_value(&out->input_mutex);
+	pthread_mutex_init_value(&out->clock_mutex);
+
 	memcpy(&out->info, info, sizeof(struct audio_output_info));
 	out->channels = get_audio_channels(info->speakers);
 	out->planes = planar ? out->channels : 1;
@@ -424,8 +573,12 @@ int audio_output_open(audio_t **audio, struct audio_output_info *info)
 		goto fail;
 	if (pthread_mutex_init(&out->input_mutex, &attr) != 0)
 		goto fail;
+	if (pthread_mutex_init(&out->clock_mutex, NULL) != 0)
+		goto fail;
 	if (os_event_init(&out->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
+	if (os_event_init(&out->clock_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
 	if (pthread_create(&out->thread, NULL, audio_thread, out) != 0)
 		goto fail;
 
@@ -447,6 +600,7 @@ void audio_output_close(audio_t *audio)
 
 	if (audio->initialized) {
 		os_event_signal(audio->stop_event);
+		os_event_signal(audio->clock_event);
 		pthread_join(audio->thread, &thread_ret);
 	}
 
@@ -454,12 +608,15 @@ void audio_output_close(audio_t *audio)
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
 		for (size_t i = 0; i < mix->inputs.num; i++)
-			audio_input_free(mix->inputs.array + i);
+			audio_input_free(mix, mix->inputs.array + i);
 
 		da_free(mix->inputs);
+		da_free(mix->resamplers);
 	}
 
 	os_event_destroy(audio->stop_event);
+	os_event_destroy(audio->clock_event);
+	pthread_mutex_destroy(&audio->clock_mutex);
 	bfree(audio);
 }
 
@@ -502,3 +659,72 @@ uint32_t audio_output_get_sample_rate(const audio_t *audio)
 {
 	return audio ? audio->info.samples_per_sec : 0;
 }
+
+void audio_output_set_external_clock(audio_t *audio, bool external)
+{
+	if (!audio)
+		return;
+
+	pthread_mutex_lock(&audio->clock_mutex);
+	audio->clock_external = external;
+	audio->clock_stalled = false;
+	audio->clock_rate = 0;
+	pthread_mutex_unlock(&audio->clock_mutex);
+
+	/* wake the audio thread so it switches right away */
+	os_event_signal(audio->clock_event);
+}
+
+bool audio_output_get_clock_time(audio_t *audio, uint32_t sample_rate,
+				 uint64_t *ts)
+{
+	if (!audio || !sample_rate)
+		return false;
+
+	pthread_mutex_lock(&audio->clock_mutex);
+
+	bool external = audio->clock_external;
+	if (external) {
+		/* (re)start the clock where the audio thread currently is,
+		 * without going back on timestamps already handed out */
+		if (audio->clock_stalled || audio->clock_rate != sample_rate) {
+			uint64_t base = 0;
+
+			if (audio->clock_rate)
+				base = get_clock_time(audio);
+
+			audio->clock_base = base > audio->audio_time
+						    ? base
+						    : audio->audio_time;
+			audio->clock_frames = 0;
+			audio->clock_rate = sample_rate;
+			audio->clock_stalled = false;
+		}
+
+		*ts = get_clock_time(audio);
+	}
+
+	pthread_mutex_unlock(&audio->clock_mutex);
+	return external;
+}
+
+void audio_output_advance_clock(audio_t *audio, uint32_t frames)
+{
+	if (!audio)
+		return;
+
+	pthread_mutex_lock(&audio->clock_mutex);
+	bool advanced = audio->clock_external && audio->clock_rate;
+	if (advanced)
+		audio->clock_frames += frames;
+	pthread_mutex_unlock(&audio->clock_mutex);
+
+	if (advanced)
+		os_event_signal(audio->clock_event);
+}
+
+void audio_output_request_extra_tick(audio_t *audio)
+{
+	if (audio)
+		audio->extra_tick = true;
+}
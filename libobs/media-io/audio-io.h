@@ -235,6 +235,30 @@ EXPORT uint32_t audio_output_get_sample_rate(const audio_t *audio);
 EXPORT const struct audio_output_info *
 audio_output_get_info(const audio_t *audio);
 
+/**
+ * Drives the audio thread from an external clock, such as an audio device
+ * callback, instead of the system timer.  The clock owner gets the time of
+ * the audio it is about to output with audio_output_get_clock_time, outputs
+ * it with that timestamp, then calls audio_output_advance_clock with the
+ * number of frames output.  The audio thread ticks as soon as the clock has
+ * passed the end of the next tick, so the owner's audio never needs to be
+ * buffered against the system timer.
+ *
+ * If the clock stops advancing the system timer is used until it resumes.
+ */
+EXPORT void audio_output_set_external_clock(audio_t *audio, bool external);
+EXPORT bool audio_output_get_clock_time(audio_t *audio, uint32_t sample_rate,
+					uint64_t *ts);
+EXPORT void audio_output_advance_clock(audio_t *audio, uint32_t frames);
+
+/**
+ * Called from the input callback to have it called again with the same
+ * timestamps as soon as the current tick has been output, rather than on
+ * the next tick.  Lets the callback output audio it already has ahead of
+ * time, for example to reduce its buffering without leaving a gap.
+ */
+EXPORT void audio_output_request_extra_tick(audio_t *audio);
+
 #ifdef __cplusplus
 }
 #endif
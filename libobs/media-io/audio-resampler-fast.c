@@ -0,0 +1,640 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "../util/bmem.h"
+#include "../util/sse-intrin.h"
+#include "audio-resampler-fast.h"
+
+/* Audio is decoded to planar float, resampled per channel if the rate
+ * changes, then encoded to the output format.  Conversions between planar
+ * float and the other formats, stereo (de)interleaving and the filter taps
+ * are done four samples at a time with SSE. */
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+/* filter taps per output sample, must be a multiple of 4 */
+#define FIR_TAPS 24
+
+/* the passband ends a little below the lower of the two nyquist rates */
+#define FIR_CUTOFF 0.92
+
+struct fast_resampler {
+	enum audio_format in_format;
+	enum audio_format out_format;
+	uint32_t in_ch;
+	uint32_t out_ch;
+	uint32_t out_planes;
+	size_t out_block_size;
+
+	/* mono upmix, whether each output channel gets the mono channel */
+	bool upmix;
+	bool upmix_map[MAX_AUDIO_CHANNELS];
+
+	/* integer ratio rate change, at most one of these is above 1 */
+	uint32_t up;
+	uint32_t down;
+	uint32_t taps;
+	float *coeffs;
+	uint32_t history;
+	uint32_t phase;
+	uint64_t delay_ns;
+
+	float *hist[MAX_AUDIO_CHANNELS];
+	float *dec[MAX_AUDIO_CHANNELS];
+	float *res[MAX_AUDIO_CHANNELS];
+	float *interleaved;
+	float *silence;
+	size_t interleaved_capacity;
+	uint32_t in_capacity;
+	uint32_t out_capacity;
+
+	uint8_t *output[MAX_AV_PLANES];
+};
+
+/* same channel mapping as the swresample mono upmix matrix */
+static const bool mono_upmix[MAX_AUDIO_CHANNELS][MAX_AUDIO_CHANNELS] = {
+	{1},
+	{1, 1},
+	{1, 1, 0},
+	{1, 1, 1, 1},
+	{1, 1, 1, 0, 1},
+	{1, 1, 1, 1, 1, 1},
+	{1, 1, 1, 0, 1, 1, 1},
+	{1, 1, 1, 0, 1, 1, 1, 1},
+};
+
+/* ------------------------------------------------------------------------- */
+/* sample conversion */
+
+static void u8_to_float(const uint8_t *src, float *dst, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		dst[i] = ((float)src[i] - 128.0f) / 128.0f;
+}
+
+static void s16_to_float(const int16_t *src, float *dst, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i val = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(val, val), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(val, val), 16);
+
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 4,
+			      _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+
+	for (; i < n; i++)
+		dst[i] = (float)src[i] / 32768.0f;
+}
+
+static void s32_to_float(const int32_t *src, float *dst, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i val = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(val), scale));
+	}
+
+	for (; i < n; i++)
+		dst[i] = (float)src[i] / 2147483648.0f;
+}
+
+static void float_to_u8(const float *src, uint8_t *dst, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		long val = lrintf(src[i] * 128.0f) + 128;
+		dst[i] = (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+	}
+}
+
+static void float_to_s16(const float *src, int16_t *dst, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	const __m128 max = _mm_set1_ps(1.0f);
+	const __m128 min = _mm_set1_ps(-1.0f);
+	size_t i = 0;
+
+	/* saturating pack clips 32768 to 32767 */
+	for (; i + 8 <= n; i += 8) {
+		__m128 lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), min),
+				       max);
+		__m128 hi = _mm_min_ps(
+			_mm_max_ps(_mm_loadu_ps(src + i + 4), min), max);
+		__m128i lo_i = _mm_cvtps_epi32(_mm_mul_ps(lo, scale));
+		__m128i hi_i = _mm_cvtps_epi32(_mm_mul_ps(hi, scale));
+
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm_packs_epi32(lo_i, hi_i));
+	}
+
+	for (; i < n; i++) {
+		long val = lrintf(src[i] * 32768.0f);
+		dst[i] = (int16_t)(val < -32768 ? -32768
+						: (val > 32767 ? 32767 : val));
+	}
+}
+
+static void float_to_s32(const float *src, int32_t *dst, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(2147483648.0f);
+	const __m128 max = _mm_set1_ps(2147483520.0f);
+	const __m128 min = _mm_set1_ps(-1.0f);
+	size_t i = 0;
+
+	/* 2147483520 is the largest float below 2^31 */
+	for (; i + 4 <= n; i += 4) {
+		__m128 val = _mm_max_ps(_mm_loadu_ps(src + i), min);
+		val = _mm_min_ps(_mm_mul_ps(val, scale), max);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_cvtps_epi32(val));
+	}
+
+	for (; i < n; i++) {
+		double val = (double)src[i] * 2147483648.0;
+		val = val < -2147483648.0 ? -2147483648.0 : val;
+		val = val > 2147483647.0 ? 2147483647.0 : val;
+		dst[i] = (int32_t)llrint(val);
+	}
+}
+
+static void decode_samples(enum audio_format format, const uint8_t *src,
+			   float *dst, size_t n)
+{
+	switch (format) {
+	case AUDIO_FORMAT_U8BIT:
+	case AUDIO_FORMAT_U8BIT_PLANAR:
+		u8_to_float(src, dst, n);
+		break;
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		s16_to_float((const int16_t *)src, dst, n);
+		break;
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		s32_to_float((const int32_t *)src, dst, n);
+		break;
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		memcpy(dst, src, n * sizeof(float));
+		break;
+	case AUDIO_FORMAT_UNKNOWN:
+		break;
+	}
+}
+
+static void encode_samples(enum audio_format format, const float *src,
+			   uint8_t *dst, size_t n)
+{
+	switch (format) {
+	case AUDIO_FORMAT_U8BIT:
+	case AUDIO_FORMAT_U8BIT_PLANAR:
+		float_to_u8(src, dst, n);
+		break;
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		float_to_s16(src, (int16_t *)dst, n);
+		break;
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		float_to_s32(src, (int32_t *)dst, n);
+		break;
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		memcpy(dst, src, n * sizeof(float));
+		break;
+	case AUDIO_FORMAT_UNKNOWN:
+		break;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* channel layout */
+
+static void deinterleave(const float *src, float *dst[], uint32_t channels,
+			 size_t frames)
+{
+	size_t i = 0;
+
+	if (channels == 2) {
+		float *left = dst[0];
+		float *right = dst[1];
+
+		for (; i + 4 <= frames; i += 4) {
+			__m128 a = _mm_loadu_ps(src + i * 2);
+			__m128 b = _mm_loadu_ps(src + i * 2 + 4);
+
+			_mm_storeu_ps(left + i,
+				      _mm_shuffle_ps(a, b,
+						     _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(right + i,
+				      _mm_shuffle_ps(a, b,
+						     _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	}
+
+	for (; i < frames; i++) {
+		for (uint32_t ch = 0; ch < channels; ch++)
+			dst[ch][i] = src[i * channels + ch];
+	}
+}
+
+static void interleave(const float *const src[], float *dst,
+		       uint32_t channels, size_t frames)
+{
+	size_t i = 0;
+
+	if (channels == 2) {
+		const float *left = src[0];
+		const float *right = src[1];
+
+		for (; i + 4 <= frames; i += 4) {
+			__m128 l = _mm_loadu_ps(left + i);
+			__m128 r = _mm_loadu_ps(right + i);
+
+			_mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+		}
+	}
+
+	for (; i < frames; i++) {
+		for (uint32_t ch = 0; ch < channels; ch++)
+			dst[i * channels + ch] = src[ch][i];
+	}
+}
+
+static void decode(struct fast_resampler *fr, const uint8_t *const input[],
+		   float *dst[], uint32_t frames)
+{
+	if (is_audio_planar(fr->in_format) || fr->in_ch == 1) {
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++)
+			decode_samples(fr->in_format, input[ch], dst[ch],
+				       frames);
+
+	} else if (fr->in_format == AUDIO_FORMAT_FLOAT) {
+		deinterleave((const float *)input[0], dst, fr->in_ch, frames);
+
+	} else {
+		decode_samples(fr->in_format, input[0], fr->interleaved,
+			       (size_t)frames * fr->in_ch);
+		deinterleave(fr->interleaved, dst, fr->in_ch, frames);
+	}
+}
+
+static void encode(struct fast_resampler *fr, const float *const src[],
+		   uint32_t frames)
+{
+	const float *channels[MAX_AUDIO_CHANNELS];
+
+	for (uint32_t ch = 0; ch < fr->out_ch; ch++) {
+		if (!fr->upmix)
+			channels[ch] = src[ch];
+		else
+			channels[ch] = fr->upmix_map[ch] ? src[0]
+							 : fr->silence;
+	}
+
+	if (is_audio_planar(fr->out_format) || fr->out_ch == 1) {
+		for (uint32_t ch = 0; ch < fr->out_ch; ch++)
+			encode_samples(fr->out_format, channels[ch],
+				       fr->output[ch], frames);
+
+	} else if (fr->out_format == AUDIO_FORMAT_FLOAT) {
+		interleave(channels, (float *)fr->output[0], fr->out_ch,
+			   frames);
+
+	} else {
+		interleave(channels, fr->interleaved, fr->out_ch, frames);
+		encode_samples(fr->out_format, fr->interleaved, fr->output[0],
+			       (size_t)frames * fr->out_ch);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* integer ratio rate change */
+
+static inline float dot_product(const float *x, const float *c, uint32_t n)
+{
+	__m128 sum = _mm_setzero_ps();
+	float out[4];
+
+	for (uint32_t i = 0; i < n; i += 4)
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + i),
+						 _mm_loadu_ps(c + i)));
+
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ps(sum,
+			 _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+	_mm_storeu_ps(out, sum);
+	return out[0];
+}
+
+/* windowed sinc low-pass at the lower of the two nyquist rates, stored
+ * reversed so each output is a dot product over contiguous input.  when
+ * upsampling, the filter is split into one set of taps per output phase. */
+static void init_filter(struct fast_resampler *fr)
+{
+	uint32_t factor = fr->up > 1 ? fr->up : fr->down;
+	uint32_t total = FIR_TAPS * factor;
+	double cutoff = 0.5 * FIR_CUTOFF / (double)factor;
+	double center = (double)(total - 1) / 2.0;
+	double *h = bmalloc(sizeof(double) * total);
+	double sum = 0.0;
+
+	for (uint32_t i = 0; i < total; i++) {
+		double x = (double)i - center;
+		double w = 0.42 - 0.5 * cos(2.0 * M_PI * i / (total - 1)) +
+			   0.08 * cos(4.0 * M_PI * i / (total - 1));
+		double sinc = x == 0.0 ? 1.0
+				       : sin(2.0 * M_PI * cutoff * x) /
+						 (2.0 * M_PI * cutoff * x);
+
+		h[i] = 2.0 * cutoff * sinc * w;
+		sum += h[i];
+	}
+
+	fr->coeffs = bmalloc(sizeof(float) * total);
+
+	if (fr->up > 1) {
+		uint32_t up = fr->up;
+
+		for (uint32_t p = 0; p < up; p++) {
+			float *c = fr->coeffs + p * FIR_TAPS;
+			for (uint32_t i = 0; i < FIR_TAPS; i++)
+				c[i] = (float)(h[p + (FIR_TAPS - 1 - i) * up] *
+					       up / sum);
+		}
+
+		fr->taps = FIR_TAPS;
+		fr->history = FIR_TAPS - 1;
+	} else {
+		for (uint32_t i = 0; i < total; i++)
+			fr->coeffs[i] = (float)(h[total - 1 - i] / sum);
+
+		fr->taps = total;
+		fr->history = total - 1;
+	}
+
+	bfree(h);
+}
+
+/* buf holds the history followed by the new input */
+static uint32_t upsample(struct fast_resampler *fr, float *buf, float *out,
+			 uint32_t frames)
+{
+	uint32_t up = fr->up;
+
+	for (uint32_t i = 0; i < frames; i++) {
+		for (uint32_t p = 0; p < up; p++)
+			*(out++) = dot_product(buf + i,
+					       fr->coeffs + p * FIR_TAPS,
+					       FIR_TAPS);
+	}
+
+	memmove(buf, buf + frames, fr->history * sizeof(float));
+	return frames * up;
+}
+
+static uint32_t downsample(struct fast_resampler *fr, float *buf, float *out,
+			   uint32_t frames, uint32_t *phase)
+{
+	uint32_t pos = fr->phase;
+	uint32_t count = 0;
+
+	for (; pos < frames; pos += fr->down)
+		out[count++] = dot_product(buf + pos, fr->coeffs, fr->taps);
+
+	memmove(buf, buf + frames, fr->history * sizeof(float));
+	*phase = pos - frames;
+	return count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline bool resampling(const struct fast_resampler *fr)
+{
+	return fr->up > 1 || fr->down > 1;
+}
+
+static inline uint32_t max_out_frames(const struct fast_resampler *fr,
+				      uint32_t in_frames)
+{
+	if (fr->up > 1)
+		return in_frames * fr->up;
+	if (fr->down > 1)
+		return in_frames / fr->down + 1;
+	return in_frames;
+}
+
+static void ensure_capacity(struct fast_resampler *fr, uint32_t in_frames)
+{
+	uint32_t out_frames = max_out_frames(fr, in_frames);
+	uint32_t channels = fr->in_ch > fr->out_ch ? fr->in_ch : fr->out_ch;
+
+	if (in_frames > fr->in_capacity) {
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++) {
+			if (resampling(fr)) {
+				bool first = !fr->hist[ch];
+
+				fr->hist[ch] = brealloc(
+					fr->hist[ch],
+					sizeof(float) *
+						(fr->history + in_frames));
+
+				/* the filter starts on silence */
+				if (first)
+					memset(fr->hist[ch], 0,
+					       sizeof(float) * fr->history);
+			} else {
+				fr->dec[ch] = brealloc(fr->dec[ch],
+						       sizeof(float) *
+							       in_frames);
+			}
+		}
+
+		fr->in_capacity = in_frames;
+	}
+
+	if (out_frames > fr->out_capacity) {
+		size_t plane_size = fr->out_block_size * out_frames;
+
+		for (uint32_t ch = 0; resampling(fr) && ch < fr->in_ch; ch++)
+			fr->res[ch] = brealloc(fr->res[ch],
+					       sizeof(float) * out_frames);
+		for (uint32_t i = 0; i < fr->out_planes; i++)
+			fr->output[i] = brealloc(fr->output[i], plane_size);
+
+		if (fr->upmix) {
+			bfree(fr->silence);
+			fr->silence = bzalloc(sizeof(float) * out_frames);
+		}
+
+		fr->out_capacity = out_frames;
+	}
+
+	/* shared by decoding and encoding */
+	uint32_t max_frames = in_frames > out_frames ? in_frames : out_frames;
+	size_t interleaved = (size_t)max_frames * channels;
+
+	if (interleaved > fr->interleaved_capacity) {
+		bfree(fr->interleaved);
+		fr->interleaved = bmalloc(sizeof(float) * interleaved);
+		fr->interleaved_capacity = interleaved;
+	}
+}
+
+struct fast_resampler *fast_resampler_create(const struct resample_info *dst,
+					     const struct resample_info *src)
+{
+	struct fast_resampler *fr;
+	uint32_t in_ch = get_audio_channels(src->speakers);
+	uint32_t out_ch = get_audio_channels(dst->speakers);
+	uint32_t up = 1, down = 1;
+
+	if (src->format == AUDIO_FORMAT_UNKNOWN ||
+	    dst->format == AUDIO_FORMAT_UNKNOWN || !in_ch || !out_ch)
+		return NULL;
+	if (src->speakers != dst->speakers && src->speakers != SPEAKERS_MONO)
+		return NULL;
+	if (!src->samples_per_sec || !dst->samples_per_sec)
+		return NULL;
+
+	if (dst->samples_per_sec > src->samples_per_sec) {
+		if (dst->samples_per_sec % src->samples_per_sec != 0)
+			return NULL;
+		up = dst->samples_per_sec / src->samples_per_sec;
+	} else if (src->samples_per_sec > dst->samples_per_sec) {
+		if (src->samples_per_sec % dst->samples_per_sec != 0)
+			return NULL;
+		down = src->samples_per_sec / dst->samples_per_sec;
+	}
+
+	if (up > FAST_RESAMPLER_MAX_RATIO || down > FAST_RESAMPLER_MAX_RATIO)
+		return NULL;
+
+	fr = bzalloc(sizeof(struct fast_resampler));
+	fr->in_format = src->format;
+	fr->out_format = dst->format;
+	fr->in_ch = in_ch;
+	fr->out_ch = out_ch;
+	fr->out_planes = is_audio_planar(dst->format) ? out_ch : 1;
+	fr->out_block_size = get_audio_bytes_per_channel(dst->format) *
+			     (is_audio_planar(dst->format) ? 1 : out_ch);
+	fr->up = up;
+	fr->down = down;
+
+	if (in_ch == 1 && out_ch > 1) {
+		fr->upmix = true;
+		for (uint32_t ch = 0; ch < out_ch; ch++)
+			fr->upmix_map[ch] = mono_upmix[out_ch - 1][ch];
+	}
+
+	if (resampling(fr)) {
+		uint32_t rate = up > 1 ? dst->samples_per_sec
+				       : src->samples_per_sec;
+		uint32_t factor = up > 1 ? up : down;
+		double delay = (double)(FIR_TAPS * factor - 1) / 2.0;
+
+		init_filter(fr);
+		fr->delay_ns = (uint64_t)(delay * 1000000000.0 / rate);
+	}
+
+	return fr;
+}
+
+void fast_resampler_destroy(struct fast_resampler *fr)
+{
+	if (!fr)
+		return;
+
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++) {
+		bfree(fr->hist[ch]);
+		bfree(fr->dec[ch]);
+		bfree(fr->res[ch]);
+	}
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		bfree(fr->output[i]);
+
+	bfree(fr->interleaved);
+	bfree(fr->silence);
+	bfree(fr->coeffs);
+	bfree(fr);
+}
+
+bool fast_resampler_resample(struct fast_resampler *fr, uint8_t *output[],
+			     uint32_t *out_frames, uint64_t *ts_offset,
+			     const uint8_t *const input[], uint32_t in_frames)
+{
+	const float *channels[MAX_AUDIO_CHANNELS];
+	float *dst[MAX_AUDIO_CHANNELS];
+	uint32_t frames = in_frames;
+
+	ensure_capacity(fr, in_frames);
+
+	if (resampling(fr)) {
+		uint32_t phase = fr->phase;
+
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++)
+			dst[ch] = fr->hist[ch] + fr->history;
+		decode(fr, input, dst, in_frames);
+
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++) {
+			if (fr->up > 1)
+				frames = upsample(fr, fr->hist[ch],
+						  fr->res[ch], in_frames);
+			else
+				frames = downsample(fr, fr->hist[ch],
+						    fr->res[ch], in_frames,
+						    &phase);
+			channels[ch] = fr->res[ch];
+		}
+
+		fr->phase = phase;
+
+	} else if (fr->in_format == AUDIO_FORMAT_FLOAT_PLANAR ||
+		   (fr->in_format == AUDIO_FORMAT_FLOAT && fr->in_ch == 1)) {
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++)
+			channels[ch] = (const float *)input[ch];
+
+	} else {
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++)
+			dst[ch] = fr->dec[ch];
+		decode(fr, input, dst, in_frames);
+
+		for (uint32_t ch = 0; ch < fr->in_ch; ch++)
+			channels[ch] = dst[ch];
+	}
+
+	if (frames)
+		encode(fr, channels, frames);
+
+	for (uint32_t i = 0; i < fr->out_planes; i++)
+		output[i] = fr->output[i];
+
+	*out_frames = frames;
+	*ts_offset = fr->delay_ns;
+	return true;
+}
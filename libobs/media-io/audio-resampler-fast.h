@@ -0,0 +1,40 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "audio-resampler.h"
+
+/* Conversions the audio resampler handles without swresample: any sample
+ * format and planar/interleaved change, mono upmixing, and rate changes by
+ * an integer ratio of up to FAST_RESAMPLER_MAX_RATIO.  Returns NULL from
+ * create for anything else. */
+
+#define FAST_RESAMPLER_MAX_RATIO 6
+
+struct fast_resampler;
+
+extern struct fast_resampler *
+fast_resampler_create(const struct resample_info *dst,
+		      const struct resample_info *src);
+extern void fast_resampler_destroy(struct fast_resampler *fr);
+
+extern bool fast_resampler_resample(struct fast_resampler *fr,
+				    uint8_t *output[], uint32_t *out_frames,
+				    uint64_t *ts_offset,
+				    const uint8_t *const input[],
+				    uint32_t in_frames);
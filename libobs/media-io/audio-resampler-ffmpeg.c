@@ -17,12 +17,16 @@
 
 #include "../util/bmem.h"
 #include "audio-resampler.h"
+#include "audio-resampler-fast.h"
 #include "audio-io.h"
 #include <libavutil/avutil.h>
 #include <libavformat/avformat.h>
 #include <libswresample/swresample.h>
 
 struct audio_resampler {
+	/* used instead of swresample for the conversions it supports */
+	struct fast_resampler *fast;
+
 	struct SwrContext *context;
 	bool opened;
 
@@ -97,6 +101,10 @@ audio_resampler_t *audio_resampler_create(const struct resample_info *dst,
 	struct audio_resampler *rs = bzalloc(sizeof(struct audio_resampler));
 	int errcode;
 
+	rs->fast = fast_resampler_create(dst, src);
+	if (rs->fast)
+		return rs;
+
 	rs->opened = false;
 	rs->input_freq = src->samples_per_sec;
 	rs->input_layout = convert_speaker_layout(src->speakers);
@@ -151,6 +159,7 @@ audio_resampler_t *audio_resampler_create(const struct resample_info *dst,
 void audio_resampler_destroy(audio_resampler_t *rs)
 {
 	if (rs) {
+		fast_resampler_destroy(rs->fast);
 		if (rs->context)
 			swr_free(&rs->context);
 		if (rs->output_buffer[0])
@@ -167,6 +176,10 @@ bool audio_resampler_resample(audio_resampler_t *rs, uint8_t *output[],
 	if (!rs)
 		return false;
 
+	if (rs->fast)
+		return fast_resampler_resample(rs->fast, output, out_frames,
+					       ts_offset, input, in_frames);
+
 	struct SwrContext *context = rs->context;
 	int ret;
 
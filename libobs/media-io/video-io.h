@@ -68,6 +68,16 @@ enum video_format {
 
 	/* packed 4:4:4 with alpha */
 	VIDEO_FORMAT_AYUV,
+
+	/* planar 4:2:0 format, 10 bpp, 16-bit little-endian samples */
+	VIDEO_FORMAT_I010, /* three-plane */
+	VIDEO_FORMAT_P010, /* two-plane, luma and packed chroma, MSB-aligned */
+
+	/* planar 4:2:2 format, 10 bpp */
+	VIDEO_FORMAT_I210,
+
+	/* planar 4:4:4 format, 10 bpp */
+	VIDEO_FORMAT_I410,
 };
 
 enum video_colorspace {
@@ -116,6 +126,10 @@ static inline bool format_is_yuv(enum video_format format)
 	case VIDEO_FORMAT_I42A:
 	case VIDEO_FORMAT_YUVA:
 	case VIDEO_FORMAT_AYUV:
+	case VIDEO_FORMAT_I010:
+	case VIDEO_FORMAT_P010:
+	case VIDEO_FORMAT_I210:
+	case VIDEO_FORMAT_I410:
 		return true;
 	case VIDEO_FORMAT_NONE:
 	case VIDEO_FORMAT_RGBA:
@@ -164,6 +178,14 @@ static inline const char *get_video_format_name(enum video_format format)
 		return "YUVA";
 	case VIDEO_FORMAT_AYUV:
 		return "AYUV";
+	case VIDEO_FORMAT_I010:
+		return "I010";
+	case VIDEO_FORMAT_P010:
+		return "P010";
+	case VIDEO_FORMAT_I210:
+		return "I210";
+	case VIDEO_FORMAT_I410:
+		return "I410";
 	case VIDEO_FORMAT_NONE:;
 	}
 
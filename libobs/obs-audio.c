@@ -26,6 +26,12 @@ struct ts_info {
 #define DEBUG_AUDIO 0
 #define MAX_BUFFERING_TICKS 45
 
+/* audio buffering is reduced by a tick when every source has been early by
+ * at least HEADROOM_TICKS for BUFFERING_REDUCTION_SEC, so they are still
+ * early by a tick afterward */
+#define BUFFERING_REDUCTION_SEC 10
+#define HEADROOM_TICKS 2
+
 static void push_audio_tree(obs_source_t *parent, obs_source_t *source, void *p)
 {
 	struct obs_core_audio *audio = p;
@@ -231,7 +237,7 @@ static inline void discard_audio(struct obs_core_audio *audio,
 
 static void add_audio_buffering(struct obs_core_audio *audio,
 				size_t sample_rate, struct ts_info *ts,
-				uint64_t min_ts, const char *buffering_name)
+				uint64_t min_ts, obs_source_t *buffering_source)
 {
 	struct ts_info new_ts;
 	uint64_t offset;
@@ -258,6 +264,18 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 		blog(LOG_WARNING, "Max audio buffering reached!");
 	}
 
+	if (audio->total_buffering_ticks > audio->max_buffering_ticks)
+		audio->max_buffering_ticks = audio->total_buffering_ticks;
+	audio->buffering_increases++;
+
+	/* start measuring again for reduction */
+	audio->reduction_window_ticks = 0;
+	audio->window_min_headroom = INT64_MAX;
+
+	/* called with audio_sources_mutex held, so take no source locks */
+	if (buffering_source)
+		os_atomic_inc_long(&buffering_source->audio_late_count);
+
 	ms = ticks * AUDIO_OUTPUT_FRAMES * 1000 / sample_rate;
 	total_ms = audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES * 1000 /
 		   sample_rate;
@@ -266,7 +284,9 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 	     "adding %d milliseconds of audio buffering, total "
 	     "audio buffering is now %d milliseconds"
 	     " (source: %s)\n",
-	     (int)ms, (int)total_ms, buffering_name);
+	     (int)ms, (int)total_ms,
+	     buffering_source ? obs_source_get_name(buffering_source)
+			      : "(null)");
 #if DEBUG_AUDIO == 1
 	blog(LOG_DEBUG,
 	     "min_ts (%" PRIu64 ") < start timestamp "
@@ -332,8 +352,8 @@ static bool audio_buffer_insuffient(struct obs_source *source,
 	return false;
 }
 
-static inline const char *find_min_ts(struct obs_core_data *data,
-				      uint64_t *min_ts)
+static inline obs_source_t *find_min_ts(struct obs_core_data *data,
+					uint64_t *min_ts)
 {
 	obs_source_t *buffering_source = NULL;
 	struct obs_source *source = data->first_audio_source;
@@ -346,7 +366,7 @@ static inline const char *find_min_ts(struct obs_core_data *data,
 
 		source = (struct obs_source *)source->next_audio_source;
 	}
-	return buffering_source ? obs_source_get_name(buffering_source) : NULL;
+	return buffering_source;
 }
 
 static inline bool mark_invalid_sources(struct obs_core_data *data,
@@ -364,13 +384,94 @@ static inline bool mark_invalid_sources(struct obs_core_data *data,
 	return recalculate;
 }
 
-static inline const char *calc_min_ts(struct obs_core_data *data,
-				      size_t sample_rate, uint64_t *min_ts)
+static inline obs_source_t *calc_min_ts(struct obs_core_data *data,
+					size_t sample_rate, uint64_t *min_ts)
 {
-	const char *buffering_name = find_min_ts(data, min_ts);
+	obs_source_t *buffering_source = find_min_ts(data, min_ts);
 	if (mark_invalid_sources(data, sample_rate, *min_ts))
-		buffering_name = find_min_ts(data, min_ts);
-	return buffering_name;
+		buffering_source = find_min_ts(data, min_ts);
+	return buffering_source;
+}
+
+/* measures how far past the end of the mixed tick the source's audio
+ * reaches, before it is discarded */
+static void measure_headroom(struct obs_core_audio *audio,
+			     obs_source_t *source, size_t sample_rate,
+			     const struct ts_info *ts, bool window_end)
+{
+	size_t frames = source->audio_input_buf[0].size / sizeof(float);
+	int64_t headroom;
+
+	if (source->info.audio_render || !source->audio_ts) {
+		source->audio_headroom_valid = false;
+		return;
+	}
+
+	headroom = (int64_t)(source->audio_ts +
+			     audio_frames_to_ns(sample_rate, frames)) -
+		   (int64_t)ts->end;
+
+	if (!source->audio_headroom_valid) {
+		source->audio_window_min_headroom = headroom;
+		source->audio_min_headroom = headroom;
+		source->audio_headroom_valid = true;
+	}
+
+	source->audio_headroom = headroom;
+	if (headroom < source->audio_window_min_headroom)
+		source->audio_window_min_headroom = headroom;
+	if (headroom < audio->window_min_headroom)
+		audio->window_min_headroom = headroom;
+
+	if (window_end) {
+		source->audio_min_headroom = source->audio_window_min_headroom;
+		source->audio_window_min_headroom = INT64_MAX;
+	}
+}
+
+/* outputs the next buffered tick right away instead of waiting a tick for
+ * it, which keeps the output continuous while dropping a tick of latency */
+static void reduce_audio_buffering(struct obs_core_audio *audio,
+				   size_t sample_rate)
+{
+	size_t ms = AUDIO_OUTPUT_FRAMES * 1000 / sample_rate;
+	size_t total_ms;
+
+	audio->reducing_buffering = true;
+	audio->total_buffering_ticks--;
+	audio->buffering_reductions++;
+
+	total_ms = audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES * 1000 /
+		   sample_rate;
+
+	blog(LOG_INFO,
+	     "removing %d milliseconds of audio buffering, total "
+	     "audio buffering is now %d milliseconds",
+	     (int)ms, (int)total_ms);
+
+	audio_output_request_extra_tick(audio->audio);
+}
+
+static void update_buffering_reduction(struct obs_core_audio *audio,
+				       size_t sample_rate, bool window_end)
+{
+	int64_t min_headroom = audio_frames_to_ns(
+		sample_rate, HEADROOM_TICKS * AUDIO_OUTPUT_FRAMES);
+
+	if (!window_end)
+		return;
+
+	audio->min_headroom = audio->window_min_headroom;
+	audio->window_min_headroom = INT64_MAX;
+	audio->reduction_window_ticks = 0;
+
+	if (!os_atomic_load_bool(&audio->buffering_reduction))
+		return;
+	if (!audio->total_buffering_ticks || audio->buffering_wait_ticks)
+		return;
+
+	if (audio->min_headroom >= min_headroom)
+		reduce_audio_buffering(audio, sample_rate);
 }
 
 static inline void release_audio_sources(struct obs_core_audio *audio)
@@ -391,11 +492,18 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	struct ts_info ts = {start_ts_in, end_ts_in};
 	size_t audio_size;
 	uint64_t min_ts;
+	bool window_end;
 
 	da_resize(audio->render_order, 0);
 	da_resize(audio->root_nodes, 0);
 
-	circlebuf_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
+	/* when reducing buffering, this is an extra call to output the next
+	 * buffered tick, so there is no new tick to add */
+	if (audio->reducing_buffering)
+		audio->reducing_buffering = false;
+	else
+		circlebuf_push_back(&audio->buffered_timestamps, &ts,
+				    sizeof(ts));
 	circlebuf_peek_front(&audio->buffered_timestamps, &ts, sizeof(ts));
 	min_ts = ts.start;
 
@@ -440,14 +548,16 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	/* ------------------------------------------------ */
 	/* get minimum audio timestamp */
 	pthread_mutex_lock(&data->audio_sources_mutex);
-	const char *buffering_name = calc_min_ts(data, sample_rate, &min_ts);
-	pthread_mutex_unlock(&data->audio_sources_mutex);
+	obs_source_t *buffering_source =
+		calc_min_ts(data, sample_rate, &min_ts);
 
 	/* ------------------------------------------------ */
 	/* if a source has gone backward in time, buffer */
 	if (min_ts < ts.start)
 		add_audio_buffering(audio, sample_rate, &ts, min_ts,
-				    buffering_name);
+				    buffering_source);
+
+	pthread_mutex_unlock(&data->audio_sources_mutex);
 
 	/* ------------------------------------------------ */
 	/* mix audio */
@@ -470,11 +580,16 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* discard audio */
+	window_end = ++audio->reduction_window_ticks >=
+		     (int)(BUFFERING_REDUCTION_SEC * sample_rate /
+			   AUDIO_OUTPUT_FRAMES);
+
 	pthread_mutex_lock(&data->audio_sources_mutex);
 
 	source = data->first_audio_source;
 	while (source) {
 		pthread_mutex_lock(&source->audio_buf_mutex);
+		measure_headroom(audio, source, sample_rate, &ts, window_end);
 		discard_audio(audio, source, channels, sample_rate, &ts);
 		pthread_mutex_unlock(&source->audio_buf_mutex);
 
@@ -491,6 +606,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	*out_ts = ts.start;
 
+	update_buffering_reduction(audio, sample_rate, window_end);
+
 	if (audio->buffering_wait_ticks) {
 		audio->buffering_wait_ticks--;
 		return false;
@@ -183,6 +183,29 @@ static inline void render_display_end()
 	gs_end_scene();
 }
 
+/* frames land on the output's frame grid, so half a frame of slack keeps a
+ * display that is limited to the output's frame rate (or a divisor of it)
+ * from skipping frames */
+static bool display_render_due(struct obs_display *display)
+{
+	struct obs_core_video *video = &obs->video;
+	uint64_t now = video->video_time;
+
+	if (display->occluded)
+		return false;
+	if (display->pause_while_active && obs_video_active())
+		return false;
+
+	if (display->min_interval_ns && display->last_render_ns &&
+	    now - display->last_render_ns +
+			    video->video_frame_interval_ns / 2 <
+		    display->min_interval_ns)
+		return false;
+
+	display->last_render_ns = now;
+	return true;
+}
+
 void render_display(struct obs_display *display)
 {
 	uint32_t cx, cy;
@@ -191,12 +214,15 @@ void render_display(struct obs_display *display)
 	if (!display || !display->enabled)
 		return;
 
-	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_DISPLAY, "obs_display");
-
 	/* -------------------------------------------- */
 
 	pthread_mutex_lock(&display->draw_info_mutex);
 
+	if (!display_render_due(display)) {
+		pthread_mutex_unlock(&display->draw_info_mutex);
+		return;
+	}
+
 	cx = display->cx;
 	cy = display->cy;
 	size_changed = display->size_changed;
@@ -206,6 +232,8 @@ void render_display(struct obs_display *display)
 
 	pthread_mutex_unlock(&display->draw_info_mutex);
 
+	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_DISPLAY, "obs_display");
+
 	/* -------------------------------------------- */
 
 	render_display_begin(display, cx, cy, size_changed);
@@ -239,6 +267,37 @@ bool obs_display_enabled(obs_display_t *display)
 	return display ? display->enabled : false;
 }
 
+void obs_display_set_max_fps(obs_display_t *display, double fps)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->min_interval_ns =
+		fps > 0.0 ? (uint64_t)(1000000000.0 / fps) : 0;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+}
+
+void obs_display_set_occluded(obs_display_t *display, bool occluded)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->occluded = occluded;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+}
+
+void obs_display_set_pause_while_active(obs_display_t *display, bool pause)
+{
+	if (!display)
+		return;
+
+	pthread_mutex_lock(&display->draw_info_mutex);
+	display->pause_while_active = pause;
+	pthread_mutex_unlock(&display->draw_info_mutex);
+}
+
 void obs_display_set_background_color(obs_display_t *display, uint32_t color)
 {
 	if (display)
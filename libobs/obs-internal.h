@@ -202,6 +202,13 @@ struct obs_display {
 	bool size_changed;
 	bool enabled;
 	uint32_t cx, cy;
+
+	/* protected by draw_info_mutex */
+	uint64_t min_interval_ns;
+	bool occluded;
+	bool pause_while_active;
+
+	uint64_t last_render_ns;
 	uint32_t background_color;
 	gs_swapchain_t *swap;
 	pthread_mutex_t draw_callbacks_mutex;
@@ -216,6 +223,27 @@ extern bool obs_display_init(struct obs_display *display,
 			     const struct gs_init_data *graphics_data);
 extern void obs_display_free(struct obs_display *display);
 
+/* ------------------------------------------------------------------------- */
+/* thumbnails */
+
+struct obs_thumbnail {
+	obs_weak_source_t *source;
+	uint32_t cx, cy;
+	uint32_t interval;
+	uint64_t phase;
+
+	/* graphics thread only */
+	gs_texrender_t *texrender;
+	uint32_t rendered_cx, rendered_cy;
+	uint32_t source_cx, source_cy;
+	bool rendered;
+
+	struct obs_thumbnail *next;
+	struct obs_thumbnail **prev_next;
+};
+
+extern void obs_render_thumbnails(void);
+
 /* ------------------------------------------------------------------------- */
 /* core */
 
@@ -234,6 +262,16 @@ struct obs_tex_frame {
 	bool released;
 };
 
+/* frames a GPU timer result is read back after */
+#define OBS_PERF_GPU_FRAMES 4
+
+struct obs_fused_effect {
+	char *key;
+	gs_effect_t *effect;
+};
+
+struct obs_video_copy;
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_stagesurf_t *copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
@@ -257,8 +295,12 @@ struct obs_core_video {
 	gs_effect_t *area_effect;
 	gs_effect_t *bilinear_lowres_effect;
 	gs_effect_t *premultiplied_alpha_effect;
+	DARRAY(struct obs_fused_effect) fused_effects;
 	gs_samplerstate_t *point_sampler;
 	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
+	struct obs_video_copy *video_copy;
+	pthread_mutex_t video_copy_stats_mutex;
+	struct obs_video_copy_stats video_copy_stats;
 	int cur_texture;
 	long raw_active;
 	long gpu_encoder_active;
@@ -305,6 +347,15 @@ struct obs_core_video {
 	gs_effect_t *deinterlace_yadif_effect;
 	gs_effect_t *deinterlace_yadif_2x_effect;
 
+	/* source perf stats, see obs-source-perf.c */
+	volatile bool source_perf_enabled;
+	bool perf_frame_active;
+	uint64_t perf_frame;
+	gs_timer_range_t *perf_ranges[OBS_PERF_GPU_FRAMES];
+	uint64_t perf_range_frames[OBS_PERF_GPU_FRAMES];
+	uint64_t perf_read_frame;
+	uint64_t perf_read_freq;
+
 	struct obs_video_info ovi;
 };
 
@@ -321,12 +372,28 @@ struct obs_core_audio {
 	int buffering_wait_ticks;
 	int total_buffering_ticks;
 
+	/* buffering is reduced a tick at a time once every source has been
+	 * early by more than a tick over a whole window, see obs-audio.c */
+	volatile bool buffering_reduction;
+	bool reducing_buffering;
+	int reduction_window_ticks;
+	int64_t window_min_headroom;
+
+	int max_buffering_ticks;
+	uint32_t buffering_increases;
+	uint32_t buffering_reductions;
+	int64_t min_headroom;
+
 	float user_volume;
 
 	pthread_mutex_t monitoring_mutex;
 	DARRAY(struct audio_monitor *) monitors;
 	char *monitoring_device_name;
 	char *monitoring_device_id;
+	uint32_t monitoring_latency_ms;
+
+	/* protected by obs->data.audio_sources_mutex */
+	struct obs_source *clock_source;
 };
 
 /* user sources, output channels, and displays */
@@ -334,12 +401,14 @@ struct obs_core_data {
 	struct obs_source *first_source;
 	struct obs_source *first_audio_source;
 	struct obs_display *first_display;
+	struct obs_thumbnail *first_thumbnail;
 	struct obs_output *first_output;
 	struct obs_encoder *first_encoder;
 	struct obs_service *first_service;
 
 	pthread_mutex_t sources_mutex;
 	pthread_mutex_t displays_mutex;
+	pthread_mutex_t thumbnails_mutex;
 	pthread_mutex_t outputs_mutex;
 	pthread_mutex_t encoders_mutex;
 	pthread_mutex_t services_mutex;
@@ -350,6 +419,9 @@ struct obs_core_data {
 
 	struct obs_view main_view;
 
+	uint64_t thumbnail_count;
+	uint64_t thumbnail_frame;
+
 	long long unnamed_index;
 
 	obs_data_t *private_data;
@@ -555,6 +627,24 @@ struct audio_cb_info {
 	void *param;
 };
 
+struct obs_source_perf {
+	pthread_mutex_t mutex;
+	struct obs_source_perf_stats stats;
+
+	/* graphics thread only */
+	gs_timer_t *gpu_timers[OBS_PERF_GPU_FRAMES];
+	uint64_t gpu_timer_frames[OBS_PERF_GPU_FRAMES];
+	uint64_t gpu_last_frame;
+};
+
+/* one timed call, calls timed from within it are subtracted from its
+ * self time */
+struct obs_perf_scope {
+	uint64_t start;
+	uint64_t saved_child_ns;
+	int gpu_slot;
+};
+
 struct obs_source {
 	struct obs_context_data context;
 	struct obs_source_info info;
@@ -644,6 +734,7 @@ struct obs_source {
 	bool async_flip;
 	bool async_active;
 	bool async_update_texture;
+	bool async_frame_selected;
 	bool async_unbuffered;
 	bool async_decoupled;
 	struct obs_source_frame *async_preload_frame;
@@ -674,10 +765,34 @@ struct obs_source {
 	struct obs_source *filter_target;
 	DARRAY(struct obs_source *) filters;
 	pthread_mutex_t filter_mutex;
+	volatile long filter_chain_serial;
 	gs_texrender_t *filter_texrender;
 	enum obs_allow_direct_render allow_direct;
 	bool rendering_filter;
 
+	/* obs_source_video_render_cached */
+	gs_texrender_t *frame_cache_texrender;
+	uint32_t frame_cache_cx;
+	uint32_t frame_cache_cy;
+	uint64_t frame_cache_time;
+	uint32_t frame_cache_draws;
+	uint32_t frame_cache_last_draws;
+	bool rendering_frame_cache;
+
+	/* pointwise filters drawn in this filter's pass, this one first, and
+	 * the source below the last of them.  the chain is collected again
+	 * when the parent's filter_chain_serial changes */
+	DARRAY(struct obs_source *) fused_filters;
+	DARRAY(struct obs_filter_pointwise) fused_ops;
+	struct obs_source *fused_chain_parent;
+	struct obs_source *fused_chain_target;
+	long fused_chain_serial;
+	gs_effect_t *fused_effect;
+	bool fused_effect_valid;
+
+	/* set while the fused chain is drawn this frame */
+	struct obs_source *fused_target;
+
 	/* sources specific hotkeys */
 	obs_hotkey_pair_id mute_unmute_key;
 	obs_hotkey_id push_to_mute_key;
@@ -717,7 +832,22 @@ struct obs_source {
 	struct audio_monitor *monitor;
 	enum obs_monitoring_type monitoring_type;
 
+	/* drives the audio thread, see obs_set_audio_clock_source */
+	volatile bool audio_clock;
+
+	/* how far ahead of the audio mix the source's audio is, protected by
+	 * audio_buf_mutex */
+	bool audio_headroom_valid;
+	int64_t audio_headroom;
+	int64_t audio_min_headroom;
+	int64_t audio_window_min_headroom;
+
+	/* times the source made the mix add buffering, atomic */
+	volatile long audio_late_count;
+
 	obs_data_t *private_settings;
+
+	struct obs_source_perf perf;
 };
 
 extern struct obs_source_info *get_source_info(const char *id);
@@ -737,6 +867,8 @@ extern void obs_transition_load(obs_source_t *source, obs_data_t *data);
 struct audio_monitor *audio_monitor_create(obs_source_t *source);
 void audio_monitor_reset(struct audio_monitor *monitor);
 extern void audio_monitor_destroy(struct audio_monitor *monitor);
+extern bool
+audio_monitoring_get_stats(struct obs_audio_monitoring_stats *stats);
 
 extern obs_source_t *obs_source_create_set_last_ver(const char *id,
 						    const char *name,
@@ -796,7 +928,18 @@ convert_video_format(enum video_format format)
 
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
-extern void obs_source_video_tick(obs_source_t *source, float seconds);
+
+/* source tick phases, see obs-source-tick.c */
+extern bool obs_source_tick_needed(const obs_source_t *source);
+extern void obs_source_tick_skipped(obs_source_t *source);
+extern void obs_source_tick_async(obs_source_t *source, float seconds);
+extern void obs_source_tick_graphics(obs_source_t *source, float seconds);
+extern void obs_source_tick_threaded(obs_source_t *source, float seconds);
+
+struct obs_tick_pool;
+extern struct obs_tick_pool *obs_tick_pool_create(void);
+extern void obs_tick_pool_destroy(struct obs_tick_pool *pool);
+extern void obs_tick_sources(struct obs_tick_pool *pool, float seconds);
 extern float obs_source_get_target_volume(obs_source_t *source,
 					  obs_source_t *target);
 
@@ -820,6 +963,30 @@ extern bool set_async_texture_size(struct obs_source *source,
 extern void remove_async_frame(obs_source_t *source,
 			       struct obs_source_frame *frame);
 
+extern bool obs_source_perf_init(obs_source_t *source);
+extern void obs_source_perf_free(obs_source_t *source);
+extern void obs_source_perf_render_begin(obs_source_t *source,
+					 struct obs_perf_scope *scope);
+extern void obs_source_perf_render_end(obs_source_t *source,
+				       struct obs_perf_scope *scope);
+extern void obs_source_perf_begin(struct obs_perf_scope *scope);
+extern void obs_source_perf_end(obs_source_t *source,
+				struct obs_perf_scope *scope,
+				struct obs_source_perf_timing *timing);
+extern void obs_perf_frame_begin(struct obs_core_video *video);
+extern void obs_perf_frame_end(struct obs_core_video *video);
+extern void obs_perf_free(struct obs_core_video *video);
+
+/* pointwise filter fusing, see obs-source-fuse.c */
+extern bool obs_source_fuse_filters(obs_source_t *filter);
+extern void obs_source_set_fused_params(obs_source_t *filter);
+extern void obs_free_fused_effects(struct obs_core_video *video);
+
+static inline bool obs_source_perf_active(void)
+{
+	return obs->video.source_perf_enabled;
+}
+
 extern void set_deinterlace_texture_size(obs_source_t *source);
 extern void deinterlace_process_last_frame(obs_source_t *source,
 					   uint64_t sys_time);
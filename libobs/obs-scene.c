@@ -424,7 +424,8 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 
 	} else if (!item->item_render && item_texture_enabled(item)) {
 		obs_enter_graphics();
-		item->item_render = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		item->item_render =
+			gs_texrender_create_transient(GS_RGBA, GS_ZS_NONE);
 		obs_leave_graphics();
 	}
 
@@ -796,7 +797,8 @@ static void scene_load_item(struct obs_scene *scene, obs_data_t *item_data)
 
 	} else if (!item->item_render && item_texture_enabled(item)) {
 		obs_enter_graphics();
-		item->item_render = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		item->item_render =
+			gs_texrender_create_transient(GS_RGBA, GS_ZS_NONE);
 		obs_leave_graphics();
 	}
 
@@ -1165,7 +1167,7 @@ const struct obs_source_info scene_info = {
 	.id = "scene",
 	.type = OBS_SOURCE_TYPE_SCENE,
 	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW |
-			OBS_SOURCE_COMPOSITE,
+			OBS_SOURCE_COMPOSITE | OBS_SOURCE_THREADED_TICK,
 	.get_name = scene_getname,
 	.create = scene_create,
 	.destroy = scene_destroy,
@@ -1183,7 +1185,7 @@ const struct obs_source_info group_info = {
 	.id = "group",
 	.type = OBS_SOURCE_TYPE_SCENE,
 	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW |
-			OBS_SOURCE_COMPOSITE,
+			OBS_SOURCE_COMPOSITE | OBS_SOURCE_THREADED_TICK,
 	.get_name = group_getname,
 	.create = scene_create,
 	.destroy = scene_destroy,
@@ -1304,8 +1306,8 @@ static inline void duplicate_item_data(struct obs_scene_item *dst,
 	} else {
 		if (!dst->item_render && item_texture_enabled(dst)) {
 			obs_enter_graphics();
-			dst->item_render =
-				gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+			dst->item_render = gs_texrender_create_transient(
+				GS_RGBA, GS_ZS_NONE);
 			obs_leave_graphics();
 		}
 	}
@@ -1676,7 +1678,8 @@ static obs_sceneitem_t *obs_scene_add_internal(obs_scene_t *scene,
 
 	if (item_texture_enabled(item)) {
 		obs_enter_graphics();
-		item->item_render = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		item->item_render =
+			gs_texrender_create_transient(GS_RGBA, GS_ZS_NONE);
 		obs_leave_graphics();
 	}
 
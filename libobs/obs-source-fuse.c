@@ -0,0 +1,344 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "util/dstr.h"
+#include "obs-internal.h"
+
+/* Pointwise filter fusing.
+ *
+ * When a filter that implements filter_get_pointwise is processed, the
+ * enabled pointwise filters directly below it are collected, and all of
+ * them are drawn in its pass with an effect generated for that sequence of
+ * operations.  The filters below are not rendered to their own textures.
+ *
+ * The chain is kept on the filter until the parent's filters are added,
+ * removed, reordered, enabled or disabled, or until one of them changes the
+ * operations it does.  Generated effects are cached by their sequence of
+ * operations, so the values of the operations can change freely. */
+
+#define MAX_FUSED_FILTERS 8
+
+static const char *fused_header = "\
+uniform float4x4 ViewProj;\n\
+uniform texture2d image;\n\
+\n\
+sampler_state textureSampler {\n\
+	Filter   = Linear;\n\
+	AddressU = Clamp;\n\
+	AddressV = Clamp;\n\
+};\n\
+\n\
+struct VertData {\n\
+	float4 pos : POSITION;\n\
+	float2 uv  : TEXCOORD0;\n\
+};\n\
+\n\
+VertData VSDefault(VertData v_in)\n\
+{\n\
+	VertData vert_out;\n\
+	vert_out.pos = mul(float4(v_in.pos.xyz, 1.0), ViewProj);\n\
+	vert_out.uv  = v_in.uv;\n\
+	return vert_out;\n\
+}\n\
+\n";
+
+static const char *fused_footer = "\
+	return color;\n\
+}\n\
+\n\
+technique Draw\n\
+{\n\
+	pass\n\
+	{\n\
+		vertex_shader = VSDefault(v_in);\n\
+		pixel_shader  = PSFused(v_in);\n\
+	}\n\
+}\n";
+
+/* '$' is replaced by the index of the operation */
+static const char *gamma_uniforms = "uniform float3 gamma$;\n";
+static const char *gamma_stage = "\tcolor.rgb = pow(color.rgb, gamma$);\n";
+
+static const char *matrix_uniforms = "uniform float4x4 color_matrix$;\n";
+static const char *matrix_stage = "\tcolor = mul(color_matrix$, color);\n";
+
+static const char *clut_uniforms = "\
+uniform texture2d clut$;\n\
+uniform float clut_amount$;\n";
+
+static const char *clut_stage = "\
+	float blue$ = color.b * 63.0;\n\
+	float2 quad1_$;\n\
+	quad1_$.y = floor(floor(blue$) / 8.0);\n\
+	quad1_$.x = floor(blue$) - (quad1_$.y * 8.0);\n\
+	float2 quad2_$;\n\
+	quad2_$.y = floor(ceil(blue$) / 8.0);\n\
+	quad2_$.x = ceil(blue$) - (quad2_$.y * 8.0);\n\
+	float2 pos1_$ = (quad1_$ * 0.125) + 0.5 / 512.0 +\n\
+		((0.125 - 1.0 / 512.0) * color.rg);\n\
+	float2 pos2_$ = (quad2_$ * 0.125) + 0.5 / 512.0 +\n\
+		((0.125 - 1.0 / 512.0) * color.rg);\n\
+	float4 lut$ = lerp(clut$.Sample(textureSampler, pos1_$),\n\
+		clut$.Sample(textureSampler, pos2_$), frac(blue$));\n\
+	color = float4(lerp(color, lut$, clut_amount$).rgb, color.a);\n";
+
+/* each filter would have written to an 8 bit texture */
+static const char *filter_end_stage = "\tcolor = saturate(color);\n";
+
+static void cat_indexed(struct dstr *str, const char *code, size_t idx)
+{
+	struct dstr part = {0};
+	char idx_str[16];
+
+	snprintf(idx_str, sizeof(idx_str), "%d", (int)idx);
+
+	dstr_copy(&part, code);
+	dstr_replace(&part, "$", idx_str);
+	dstr_cat_dstr(str, &part);
+	dstr_free(&part);
+}
+
+/* operations are stored from the top filter down, but are applied from the
+ * bottom filter up */
+static void build_key(struct dstr *key, const struct obs_filter_pointwise *ops,
+		      size_t num)
+{
+	for (size_t i = num; i > 0; i--)
+		dstr_catf(key, "%x;", ops[i - 1].ops);
+}
+
+static void build_effect(struct dstr *code,
+			 const struct obs_filter_pointwise *ops, size_t num)
+{
+	dstr_copy(code, fused_header);
+
+	for (size_t i = num; i > 0; i--) {
+		uint32_t flags = ops[i - 1].ops;
+
+		if (flags & OBS_POINTWISE_GAMMA)
+			cat_indexed(code, gamma_uniforms, i - 1);
+		if (flags & OBS_POINTWISE_COLOR_MATRIX)
+			cat_indexed(code, matrix_uniforms, i - 1);
+		if (flags & OBS_POINTWISE_CLUT)
+			cat_indexed(code, clut_uniforms, i - 1);
+	}
+
+	dstr_cat(code, "\nfloat4 PSFused(VertData v_in) : TARGET\n{\n"
+		       "\tfloat4 color = image.Sample(textureSampler, "
+		       "v_in.uv);\n");
+
+	for (size_t i = num; i > 0; i--) {
+		uint32_t flags = ops[i - 1].ops;
+
+		if (flags & OBS_POINTWISE_GAMMA)
+			cat_indexed(code, gamma_stage, i - 1);
+		if (flags & OBS_POINTWISE_COLOR_MATRIX)
+			cat_indexed(code, matrix_stage, i - 1);
+		if (flags & OBS_POINTWISE_CLUT)
+			cat_indexed(code, clut_stage, i - 1);
+
+		dstr_cat(code, filter_end_stage);
+	}
+
+	dstr_cat(code, fused_footer);
+}
+
+static gs_effect_t *get_fused_effect(const struct obs_filter_pointwise *ops,
+				     size_t num)
+{
+	struct obs_core_video *video = &obs->video;
+	struct obs_fused_effect *fused;
+	struct dstr key = {0};
+	struct dstr code = {0};
+	char *errors = NULL;
+
+	build_key(&key, ops, num);
+
+	for (size_t i = 0; i < video->fused_effects.num; i++) {
+		fused = &video->fused_effects.array[i];
+
+		if (strcmp(fused->key, key.array) == 0) {
+			dstr_free(&key);
+			return fused->effect;
+		}
+	}
+
+	build_effect(&code, ops, num);
+
+	fused = da_push_back_new(video->fused_effects);
+	fused->key = key.array;
+	fused->effect = gs_effect_create(code.array, "fused_filters.effect",
+					 &errors);
+
+	/* failures are cached too, so that they are only logged once */
+	if (!fused->effect)
+		blog(LOG_WARNING,
+		     "Failed to create effect for fused filters (%s): %s",
+		     key.array, errors ? errors : "(unknown error)");
+
+	bfree(errors);
+	dstr_free(&code);
+	return fused->effect;
+}
+
+static inline bool get_pointwise(obs_source_t *filter,
+				 struct obs_filter_pointwise *op)
+{
+	memset(op, 0, sizeof(*op));
+
+	return filter->context.data && filter->info.filter_get_pointwise &&
+	       filter->info.filter_get_pointwise(filter->context.data, op) &&
+	       op->ops != 0;
+}
+
+static void collect_fused_filters(obs_source_t *filter, obs_source_t *parent,
+				  long serial)
+{
+	obs_source_t *target = filter->filter_target;
+	struct obs_filter_pointwise op;
+
+	da_resize(filter->fused_filters, 0);
+	da_resize(filter->fused_ops, 0);
+
+	if (get_pointwise(filter, &op)) {
+		da_push_back(filter->fused_filters, &filter);
+		da_push_back(filter->fused_ops, &op);
+	} else {
+		target = filter;
+	}
+
+	while (filter->fused_filters.num &&
+	       filter->fused_filters.num < MAX_FUSED_FILTERS && target &&
+	       target != parent) {
+		if (target->enabled) {
+			if (!get_pointwise(target, &op))
+				break;
+
+			da_push_back(filter->fused_filters, &target);
+			da_push_back(filter->fused_ops, &op);
+		}
+
+		target = target->filter_target;
+	}
+
+	filter->fused_chain_parent = parent;
+	filter->fused_chain_target = target;
+	filter->fused_chain_serial = serial;
+	filter->fused_effect_valid = false;
+}
+
+/* gets the current values of the cached chain, returns false if a filter in
+ * it stopped being pointwise, or the source below it started being */
+static bool update_fused_ops(obs_source_t *filter, obs_source_t *parent)
+{
+	obs_source_t *target = filter->fused_chain_target;
+	struct obs_filter_pointwise op;
+
+	for (size_t i = 0; i < filter->fused_filters.num; i++) {
+		struct obs_filter_pointwise *cur = &filter->fused_ops.array[i];
+		uint32_t prev_ops = cur->ops;
+
+		if (!get_pointwise(filter->fused_filters.array[i], cur))
+			return false;
+
+		/* the effect only depends on the operations */
+		if (cur->ops != prev_ops)
+			filter->fused_effect_valid = false;
+	}
+
+	if (filter->fused_filters.num < MAX_FUSED_FILTERS && target &&
+	    target != parent && get_pointwise(target, &op))
+		return false;
+
+	return true;
+}
+
+bool obs_source_fuse_filters(obs_source_t *filter)
+{
+	obs_source_t *parent = filter->filter_parent;
+	long serial;
+
+	filter->fused_target = NULL;
+
+	if (!filter->info.filter_get_pointwise)
+		return false;
+
+	serial = os_atomic_load_long(&parent->filter_chain_serial);
+
+	if (filter->fused_chain_parent != parent ||
+	    filter->fused_chain_serial != serial ||
+	    !update_fused_ops(filter, parent))
+		collect_fused_filters(filter, parent, serial);
+
+	if (filter->fused_filters.num < 2 || !filter->fused_chain_target)
+		return false;
+
+	if (!filter->fused_effect_valid) {
+		filter->fused_effect = get_fused_effect(filter->fused_ops.array,
+							filter->fused_ops.num);
+		filter->fused_effect_valid = true;
+	}
+
+	if (!filter->fused_effect)
+		return false;
+
+	filter->fused_target = filter->fused_chain_target;
+	return true;
+}
+
+void obs_source_set_fused_params(obs_source_t *filter)
+{
+	gs_effect_t *effect = filter->fused_effect;
+	gs_eparam_t *param;
+	char name[32];
+
+	for (size_t i = 0; i < filter->fused_ops.num; i++) {
+		struct obs_filter_pointwise *op = &filter->fused_ops.array[i];
+
+		if (op->ops & OBS_POINTWISE_GAMMA) {
+			snprintf(name, sizeof(name), "gamma%d", (int)i);
+			param = gs_effect_get_param_by_name(effect, name);
+			gs_effect_set_vec3(param, &op->gamma);
+		}
+		if (op->ops & OBS_POINTWISE_COLOR_MATRIX) {
+			snprintf(name, sizeof(name), "color_matrix%d", (int)i);
+			param = gs_effect_get_param_by_name(effect, name);
+			gs_effect_set_matrix4(param, &op->color_matrix);
+		}
+		if (op->ops & OBS_POINTWISE_CLUT) {
+			snprintf(name, sizeof(name), "clut%d", (int)i);
+			param = gs_effect_get_param_by_name(effect, name);
+			gs_effect_set_texture(param, op->clut);
+
+			snprintf(name, sizeof(name), "clut_amount%d", (int)i);
+			param = gs_effect_get_param_by_name(effect, name);
+			gs_effect_set_float(param, op->clut_amount);
+		}
+	}
+}
+
+void obs_free_fused_effects(struct obs_core_video *video)
+{
+	for (size_t i = 0; i < video->fused_effects.num; i++) {
+		struct obs_fused_effect *fused = &video->fused_effects.array[i];
+
+		gs_effect_destroy(fused->effect);
+		bfree(fused->key);
+	}
+
+	da_free(video->fused_effects);
+}
@@ -0,0 +1,283 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Per-source cost accounting.
+ *
+ * CPU time is measured around render, tick and audio calls.  Calls timed
+ * from within another timed call on the same thread (a scene rendering its
+ * items, a filter rendering its target) are subtracted from the outer
+ * call's self time.
+ *
+ * GPU time is measured with timestamp queries around the first render of a
+ * source in each graphics thread frame.  Queries are read back
+ * OBS_PERF_GPU_FRAMES frames later so the graphics thread never waits on
+ * the GPU, together with the timer range that gives the tick frequency. */
+
+static THREAD_LOCAL uint64_t perf_child_ns = 0;
+
+static inline void add_timing(struct obs_source_perf_timing *timing,
+			      uint64_t ns)
+{
+	timing->count++;
+	timing->total_ns += ns;
+	if (ns > timing->max_ns)
+		timing->max_ns = ns;
+}
+
+static inline uint64_t average_ns(const struct obs_source_perf_timing *timing)
+{
+	return timing->count ? timing->total_ns / timing->count : 0;
+}
+
+static void get_perf_stats_proc(void *data, calldata_t *cd)
+{
+	struct obs_source_perf_stats stats;
+
+	obs_source_get_perf_stats(data, &stats);
+
+	calldata_set_int(cd, "render_ns", (long long)average_ns(&stats.render));
+	calldata_set_int(cd, "render_total_ns",
+			 (long long)average_ns(&stats.render_total));
+	calldata_set_int(cd, "render_gpu_ns",
+			 (long long)average_ns(&stats.render_gpu));
+	calldata_set_int(cd, "tick_ns", (long long)average_ns(&stats.tick));
+	calldata_set_int(cd, "audio_ns", (long long)average_ns(&stats.audio));
+	calldata_set_int(cd, "render_count", (long long)stats.render.count);
+}
+
+bool obs_source_perf_init(obs_source_t *source)
+{
+	if (pthread_mutex_init(&source->perf.mutex, NULL) != 0)
+		return false;
+
+	proc_handler_add(source->context.procs,
+			 "void get_perf_stats(out int render_ns, "
+			 "out int render_total_ns, out int render_gpu_ns, "
+			 "out int tick_ns, out int audio_ns, "
+			 "out int render_count)",
+			 get_perf_stats_proc, source);
+	return true;
+}
+
+/* requires the graphics context */
+void obs_source_perf_free(obs_source_t *source)
+{
+	for (size_t i = 0; i < OBS_PERF_GPU_FRAMES; i++) {
+		if (source->perf.gpu_timers[i])
+			gs_timer_destroy(source->perf.gpu_timers[i]);
+	}
+
+	pthread_mutex_destroy(&source->perf.mutex);
+}
+
+void obs_source_perf_begin(struct obs_perf_scope *scope)
+{
+	scope->saved_child_ns = perf_child_ns;
+	scope->gpu_slot = -1;
+	perf_child_ns = 0;
+	scope->start = os_gettime_ns();
+}
+
+static uint64_t end_scope(struct obs_perf_scope *scope, uint64_t *self_ns)
+{
+	uint64_t elapsed = os_gettime_ns() - scope->start;
+
+	*self_ns = elapsed > perf_child_ns ? elapsed - perf_child_ns : 0;
+	perf_child_ns = scope->saved_child_ns + elapsed;
+	return elapsed;
+}
+
+void obs_source_perf_end(obs_source_t *source, struct obs_perf_scope *scope,
+			 struct obs_source_perf_timing *timing)
+{
+	uint64_t self_ns;
+
+	end_scope(scope, &self_ns);
+
+	pthread_mutex_lock(&source->perf.mutex);
+	add_timing(timing, self_ns);
+	pthread_mutex_unlock(&source->perf.mutex);
+}
+
+static void read_gpu_timer(obs_source_t *source, int slot)
+{
+	struct obs_core_video *video = &obs->video;
+	uint64_t frame = source->perf.gpu_timer_frames[slot];
+	uint64_t ticks;
+
+	source->perf.gpu_timer_frames[slot] = 0;
+
+	/* the source may have skipped frames, in which case the range that
+	 * had the frequency for its query is gone */
+	if (frame != video->perf_read_frame || !video->perf_read_freq)
+		return;
+	if (!gs_timer_get_data(source->perf.gpu_timers[slot], &ticks))
+		return;
+
+	uint64_t ns = (uint64_t)((double)ticks * 1000000000.0 /
+				 (double)video->perf_read_freq);
+
+	pthread_mutex_lock(&source->perf.mutex);
+	add_timing(&source->perf.stats.render_gpu, ns);
+	pthread_mutex_unlock(&source->perf.mutex);
+}
+
+void obs_source_perf_render_begin(obs_source_t *source,
+				  struct obs_perf_scope *scope)
+{
+	struct obs_core_video *video = &obs->video;
+
+	obs_source_perf_begin(scope);
+
+	if (!video->perf_frame_active ||
+	    source->perf.gpu_last_frame == video->perf_frame ||
+	    !pthread_equal(pthread_self(), video->video_thread))
+		return;
+
+	int slot = (int)(video->perf_frame % OBS_PERF_GPU_FRAMES);
+	gs_timer_t **timer = &source->perf.gpu_timers[slot];
+
+	if (source->perf.gpu_timer_frames[slot])
+		read_gpu_timer(source, slot);
+
+	if (!*timer) {
+		*timer = gs_timer_create();
+		if (!*timer)
+			return;
+	}
+
+	source->perf.gpu_last_frame = video->perf_frame;
+	source->perf.gpu_timer_frames[slot] = video->perf_frame;
+	scope->gpu_slot = slot;
+
+	gs_timer_begin(*timer);
+
+	/* don't count the query setup as render time */
+	scope->start = os_gettime_ns();
+}
+
+void obs_source_perf_render_end(obs_source_t *source,
+				struct obs_perf_scope *scope)
+{
+	uint64_t self_ns;
+	uint64_t total_ns = end_scope(scope, &self_ns);
+
+	if (scope->gpu_slot >= 0)
+		gs_timer_end(source->perf.gpu_timers[scope->gpu_slot]);
+
+	pthread_mutex_lock(&source->perf.mutex);
+	add_timing(&source->perf.stats.render, self_ns);
+	add_timing(&source->perf.stats.render_total, total_ns);
+	pthread_mutex_unlock(&source->perf.mutex);
+}
+
+/* called by the graphics thread around each frame, with the graphics
+ * context entered */
+void obs_perf_frame_begin(struct obs_core_video *video)
+{
+	video->perf_frame++;
+
+	int slot = (int)(video->perf_frame % OBS_PERF_GPU_FRAMES);
+	gs_timer_range_t **range = &video->perf_ranges[slot];
+	bool disjoint;
+	uint64_t freq;
+
+	video->perf_read_frame = 0;
+	video->perf_read_freq = 0;
+
+	if (*range && video->perf_range_frames[slot] &&
+	    gs_timer_range_get_data(*range, &disjoint, &freq) && !disjoint) {
+		video->perf_read_frame = video->perf_range_frames[slot];
+		video->perf_read_freq = freq;
+	}
+
+	if (!*range)
+		*range = gs_timer_range_create();
+
+	video->perf_range_frames[slot] = *range ? video->perf_frame : 0;
+	if (*range)
+		gs_timer_range_begin(*range);
+
+	video->perf_frame_active = true;
+}
+
+void obs_perf_frame_end(struct obs_core_video *video)
+{
+	int slot = (int)(video->perf_frame % OBS_PERF_GPU_FRAMES);
+
+	if (video->perf_range_frames[slot] == video->perf_frame)
+		gs_timer_range_end(video->perf_ranges[slot]);
+
+	video->perf_frame_active = false;
+}
+
+/* requires the graphics context */
+void obs_perf_free(struct obs_core_video *video)
+{
+	for (size_t i = 0; i < OBS_PERF_GPU_FRAMES; i++) {
+		if (video->perf_ranges[i])
+			gs_timer_range_destroy(video->perf_ranges[i]);
+		video->perf_ranges[i] = NULL;
+		video->perf_range_frames[i] = 0;
+	}
+}
+
+void obs_set_source_perf_stats_enabled(bool enabled)
+{
+	if (!obs)
+		return;
+
+	os_atomic_set_bool(&obs->video.source_perf_enabled, enabled);
+}
+
+bool obs_source_perf_stats_enabled(void)
+{
+	return obs ? os_atomic_load_bool(&obs->video.source_perf_enabled)
+		   : false;
+}
+
+bool obs_source_get_perf_stats(const obs_source_t *source,
+			       struct obs_source_perf_stats *stats)
+{
+	if (!obs_ptr_valid(stats, "obs_source_get_perf_stats"))
+		return false;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!obs_source_valid(source, "obs_source_get_perf_stats"))
+		return false;
+
+	pthread_mutex_t *mutex = (pthread_mutex_t *)&source->perf.mutex;
+
+	pthread_mutex_lock(mutex);
+	*stats = source->perf.stats;
+	pthread_mutex_unlock(mutex);
+
+	return stats->render.count || stats->tick.count || stats->audio.count;
+}
+
+void obs_source_reset_perf_stats(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_reset_perf_stats"))
+		return;
+
+	pthread_mutex_lock(&source->perf.mutex);
+	memset(&source->perf.stats, 0, sizeof(source->perf.stats));
+	pthread_mutex_unlock(&source->perf.mutex);
+}
@@ -0,0 +1,233 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* Source tick scheduling.
+ *
+ * Only sources that are showing or active (or were last frame), that have a
+ * deferred update or async frames pending, or that have the
+ * OBS_SOURCE_BACKGROUND_TICK flag are ticked.  Filters are ticked with their
+ * parent.
+ *
+ * Ticked sources go through three phases each frame, and a phase starts
+ * only once the previous one has finished for every source:
+ *
+ *  1. async frame selection, on the tick threads
+ *  2. anything that may use graphics or calls into the source: transitions,
+ *     async texture sizes, deferred updates, show/hide, activate/deactivate
+ *     and video_tick, in source order on the graphics thread
+ *  3. video_tick of sources with OBS_SOURCE_THREADED_TICK, on the tick
+ *     threads
+ *
+ * The graphics thread works through phases 1 and 3 along with the tick
+ * threads, and small batches are run on the graphics thread alone. */
+
+#define MAX_TICK_THREADS 8
+#define MIN_PARALLEL_SOURCES 16
+
+typedef void (*tick_job_t)(obs_source_t *source, float seconds);
+
+struct obs_tick_pool {
+	pthread_t threads[MAX_TICK_THREADS];
+	size_t num_threads;
+	os_sem_t *start_sem;
+	os_event_t *done_event;
+	volatile bool stop;
+
+	tick_job_t job;
+	obs_source_t **sources;
+	long num_sources;
+	float seconds;
+	volatile long next;
+	volatile long running;
+
+	DARRAY(obs_source_t *) ticked;
+	DARRAY(obs_source_t *) async;
+	DARRAY(obs_source_t *) threaded;
+};
+
+static void run_jobs(struct obs_tick_pool *pool)
+{
+	long idx;
+
+	while ((idx = os_atomic_inc_long(&pool->next) - 1) <
+	       pool->num_sources)
+		pool->job(pool->sources[idx], pool->seconds);
+}
+
+static void *tick_thread(void *data)
+{
+	struct obs_tick_pool *pool = data;
+
+	os_set_thread_name("libobs: tick thread");
+
+	while (os_sem_wait(pool->start_sem) == 0) {
+		if (os_atomic_load_bool(&pool->stop))
+			break;
+
+		run_jobs(pool);
+
+		if (os_atomic_dec_long(&pool->running) == 0)
+			os_event_signal(pool->done_event);
+	}
+
+	return NULL;
+}
+
+static void run_parallel(struct obs_tick_pool *pool, tick_job_t job,
+			 obs_source_t **sources, size_t num, float seconds)
+{
+	if (!pool->num_threads || num < MIN_PARALLEL_SOURCES) {
+		for (size_t i = 0; i < num; i++)
+			job(sources[i], seconds);
+		return;
+	}
+
+	pool->job = job;
+	pool->sources = sources;
+	pool->num_sources = (long)num;
+	pool->seconds = seconds;
+	pool->next = 0;
+	pool->running = (long)pool->num_threads;
+
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->start_sem);
+
+	run_jobs(pool);
+
+	/* the last thread to finish signals, even if a thread took more than
+	 * one wakeup */
+	os_event_wait(pool->done_event);
+}
+
+static size_t get_tick_thread_count(void)
+{
+	int cores = os_get_logical_cores();
+	size_t count = cores > 1 ? (size_t)(cores - 1) : 0;
+
+	return count > MAX_TICK_THREADS ? MAX_TICK_THREADS : count;
+}
+
+struct obs_tick_pool *obs_tick_pool_create(void)
+{
+	struct obs_tick_pool *pool = bzalloc(sizeof(*pool));
+	size_t count = get_tick_thread_count();
+
+	if (!count)
+		return pool;
+
+	if (os_sem_init(&pool->start_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	for (size_t i = 0; i < count; i++) {
+		if (pthread_create(&pool->threads[i], NULL, tick_thread,
+				   pool) != 0)
+			break;
+		pool->num_threads++;
+	}
+
+	blog(LOG_INFO, "Ticking sources on %d thread(s)",
+	     (int)pool->num_threads + 1);
+	return pool;
+
+fail:
+	blog(LOG_WARNING, "Failed to create source tick threads, sources "
+			  "will be ticked on the graphics thread only");
+	os_sem_destroy(pool->start_sem);
+	os_event_destroy(pool->done_event);
+	pool->start_sem = NULL;
+	pool->done_event = NULL;
+	return pool;
+}
+
+void obs_tick_pool_destroy(struct obs_tick_pool *pool)
+{
+	if (!pool)
+		return;
+
+	os_atomic_set_bool(&pool->stop, true);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->start_sem);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	os_sem_destroy(pool->start_sem);
+	os_event_destroy(pool->done_event);
+	da_free(pool->ticked);
+	da_free(pool->async);
+	da_free(pool->threaded);
+	bfree(pool);
+}
+
+static void collect_sources(struct obs_tick_pool *pool)
+{
+	struct obs_core_data *data = &obs->data;
+	struct obs_source *source;
+
+	da_resize(pool->ticked, 0);
+	da_resize(pool->async, 0);
+	da_resize(pool->threaded, 0);
+
+	pthread_mutex_lock(&data->sources_mutex);
+
+	source = data->first_source;
+	while (source) {
+		struct obs_source *cur_source = obs_source_get_ref(source);
+		source = (struct obs_source *)source->context.next;
+
+		if (!cur_source)
+			continue;
+
+		if (!obs_source_tick_needed(cur_source)) {
+			obs_source_tick_skipped(cur_source);
+			obs_source_release(cur_source);
+			continue;
+		}
+
+		uint32_t flags = cur_source->info.output_flags;
+
+		da_push_back(pool->ticked, &cur_source);
+		if (flags & OBS_SOURCE_ASYNC)
+			da_push_back(pool->async, &cur_source);
+		if (flags & OBS_SOURCE_THREADED_TICK)
+			da_push_back(pool->threaded, &cur_source);
+	}
+
+	pthread_mutex_unlock(&data->sources_mutex);
+}
+
+void obs_tick_sources(struct obs_tick_pool *pool, float seconds)
+{
+	/* sources are held by reference rather than under sources_mutex, so
+	 * ticks may look up or create sources from the tick threads */
+	collect_sources(pool);
+
+	run_parallel(pool, obs_source_tick_async, pool->async.array,
+		     pool->async.num, seconds);
+
+	for (size_t i = 0; i < pool->ticked.num; i++)
+		obs_source_tick_graphics(pool->ticked.array[i], seconds);
+
+	run_parallel(pool, obs_source_tick_threaded, pool->threaded.array,
+		     pool->threaded.num, seconds);
+
+	for (size_t i = 0; i < pool->ticked.num; i++)
+		obs_source_release(pool->ticked.array[i]);
+}
@@ -160,6 +160,7 @@ static bool obs_source_init(struct obs_source *source)
 	pthread_mutex_init_value(&source->audio_mutex);
 	pthread_mutex_init_value(&source->audio_buf_mutex);
 	pthread_mutex_init_value(&source->audio_cb_mutex);
+	pthread_mutex_init_value(&source->perf.mutex);
 
 	if (pthread_mutexattr_init(&attr) != 0)
 		return false;
@@ -177,6 +178,8 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->async_mutex, NULL) != 0)
 		return false;
+	if (!obs_source_perf_init(source))
+		return false;
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
@@ -573,6 +576,9 @@ void obs_source_destroy(struct obs_source *source)
 	}
 	pthread_mutex_unlock(&obs->data.audio_sources_mutex);
 
+	if (os_atomic_load_bool(&source->audio_clock))
+		obs_set_audio_clock_source(NULL);
+
 	if (source->filter_parent)
 		obs_source_filter_remove_refless(source->filter_parent, source);
 
@@ -611,6 +617,8 @@ void obs_source_destroy(struct obs_source *source)
 	}
 	if (source->filter_texrender)
 		gs_texrender_destroy(source->filter_texrender);
+	gs_texrender_destroy(source->frame_cache_texrender);
+	obs_source_perf_free(source);
 	gs_leave_context();
 
 	for (i = 0; i < MAX_AV_PLANES; i++)
@@ -631,6 +639,8 @@ void obs_source_destroy(struct obs_source *source)
 	da_free(source->async_cache);
 	da_free(source->async_frames);
 	da_free(source->filters);
+	da_free(source->fused_filters);
+	da_free(source->fused_ops);
 	pthread_mutex_destroy(&source->filter_mutex);
 	pthread_mutex_destroy(&source->audio_actions_mutex);
 	pthread_mutex_destroy(&source->audio_buf_mutex);
@@ -1034,37 +1044,108 @@ static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 bool set_async_texture_size(struct obs_source *source,
 			    const struct obs_source_frame *frame);
 
-static void async_tick(obs_source_t *source)
+static void async_select_frame(obs_source_t *source)
 {
 	uint64_t sys_time = obs->video.video_time;
 
 	pthread_mutex_lock(&source->async_mutex);
 
-	if (deinterlacing_enabled(source)) {
-		deinterlace_process_last_frame(source, sys_time);
-	} else {
-		if (source->cur_async_frame) {
-			remove_async_frame(source, source->cur_async_frame);
-			source->cur_async_frame = NULL;
-		}
-
-		source->cur_async_frame = get_closest_frame(source, sys_time);
+	if (source->cur_async_frame) {
+		remove_async_frame(source, source->cur_async_frame);
+		source->cur_async_frame = NULL;
 	}
 
+	source->cur_async_frame = get_closest_frame(source, sys_time);
 	source->last_sys_timestamp = sys_time;
+
 	pthread_mutex_unlock(&source->async_mutex);
+}
+
+static void async_tick(obs_source_t *source)
+{
+	uint64_t sys_time = obs->video.video_time;
+
+	if (source->async_frame_selected) {
+		source->async_frame_selected = false;
+
+	} else if (deinterlacing_enabled(source)) {
+		pthread_mutex_lock(&source->async_mutex);
+		deinterlace_process_last_frame(source, sys_time);
+		source->last_sys_timestamp = sys_time;
+		pthread_mutex_unlock(&source->async_mutex);
+
+	} else {
+		async_select_frame(source);
+	}
 
 	if (source->cur_async_frame)
 		source->async_update_texture =
 			set_async_texture_size(source, source->cur_async_frame);
 }
 
-void obs_source_video_tick(obs_source_t *source, float seconds)
+static inline bool threaded_tick(const obs_source_t *source)
 {
-	bool now_showing, now_active;
+	return (source->info.output_flags & OBS_SOURCE_THREADED_TICK) != 0;
+}
 
-	if (!obs_source_valid(source, "obs_source_video_tick"))
+static inline void end_tick(obs_source_t *source)
+{
+	source->async_rendered = false;
+	source->deinterlace_rendered = false;
+}
+
+bool obs_source_tick_needed(const obs_source_t *source)
+{
+	const obs_source_t *parent = source->filter_parent;
+
+	if (source->defer_update)
+		return true;
+	if (parent && source->info.type == OBS_SOURCE_TYPE_FILTER)
+		source = parent;
+
+	if (source->info.output_flags & OBS_SOURCE_BACKGROUND_TICK)
+		return true;
+	if (os_atomic_load_long(&source->show_refs) || source->showing)
+		return true;
+	if (os_atomic_load_long(&source->activate_refs) || source->active)
+		return true;
+
+	/* keep consuming frames so they don't pile up while hidden */
+	return (source->info.output_flags & OBS_SOURCE_ASYNC) != 0 &&
+	       source->async_frames.num;
+}
+
+void obs_source_tick_skipped(obs_source_t *source)
+{
+	if (source->filter_texrender)
+		gs_texrender_reset(source->filter_texrender);
+
+	end_tick(source);
+}
+
+/* CPU only, may be called from a tick thread before obs_source_tick_graphics
+ * for the same frame */
+void obs_source_tick_async(obs_source_t *source, float seconds)
+{
+	if ((source->info.output_flags & OBS_SOURCE_ASYNC) == 0)
 		return;
+	if (deinterlacing_enabled(source))
+		return;
+
+	async_select_frame(source);
+	source->async_frame_selected = true;
+
+	UNUSED_PARAMETER(seconds);
+}
+
+void obs_source_tick_graphics(obs_source_t *source, float seconds)
+{
+	bool perf = obs_source_perf_active() && !threaded_tick(source);
+	struct obs_perf_scope scope;
+	bool now_showing, now_active;
+
+	if (perf)
+		obs_source_perf_begin(&scope);
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source);
@@ -1127,11 +1208,35 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
+	if (threaded_tick(source))
+		return;
+
 	if (source->context.data && source->info.video_tick)
 		source->info.video_tick(source->context.data, seconds);
 
-	source->async_rendered = false;
-	source->deinterlace_rendered = false;
+	end_tick(source);
+
+	if (perf)
+		obs_source_perf_end(source, &scope, &source->perf.stats.tick);
+}
+
+/* may be called from a tick thread after obs_source_tick_graphics for the
+ * same frame, for sources with OBS_SOURCE_THREADED_TICK */
+void obs_source_tick_threaded(obs_source_t *source, float seconds)
+{
+	bool perf = obs_source_perf_active();
+	struct obs_perf_scope scope;
+
+	if (perf)
+		obs_source_perf_begin(&scope);
+
+	if (source->context.data && source->info.video_tick)
+		source->info.video_tick(source->context.data, seconds);
+
+	end_tick(source);
+
+	if (perf)
+		obs_source_perf_end(source, &scope, &source->perf.stats.tick);
 }
 
 /* unless the value is 3+ hours worth of frames, this won't overflow */
@@ -1396,6 +1501,10 @@ enum convert_type {
 	CONVERT_800,
 	CONVERT_RGB_LIMITED,
 	CONVERT_BGR3,
+	CONVERT_I010,
+	CONVERT_P010,
+	CONVERT_I210,
+	CONVERT_I410,
 };
 
 static inline enum convert_type get_convert_type(enum video_format format,
@@ -1439,6 +1548,18 @@ static inline enum convert_type get_convert_type(enum video_format format,
 
 	case VIDEO_FORMAT_AYUV:
 		return CONVERT_444_A_PACK;
+
+	case VIDEO_FORMAT_I010:
+		return CONVERT_I010;
+
+	case VIDEO_FORMAT_P010:
+		return CONVERT_P010;
+
+	case VIDEO_FORMAT_I210:
+		return CONVERT_I210;
+
+	case VIDEO_FORMAT_I410:
+		return CONVERT_I410;
 	}
 
 	return CONVERT_NONE;
@@ -1586,6 +1707,67 @@ static inline bool set_nv12_sizes(struct obs_source *source,
 	return true;
 }
 
+static inline bool set_i010_sizes(struct obs_source *source,
+				  const struct obs_source_frame *frame)
+{
+	source->async_convert_width[0] = frame->width;
+	source->async_convert_width[1] = frame->width / 2;
+	source->async_convert_width[2] = frame->width / 2;
+	source->async_convert_height[0] = frame->height;
+	source->async_convert_height[1] = frame->height / 2;
+	source->async_convert_height[2] = frame->height / 2;
+	source->async_texture_formats[0] = GS_R16;
+	source->async_texture_formats[1] = GS_R16;
+	source->async_texture_formats[2] = GS_R16;
+	source->async_channel_count = 3;
+	return true;
+}
+
+static inline bool set_p010_sizes(struct obs_source *source,
+				  const struct obs_source_frame *frame)
+{
+	source->async_convert_width[0] = frame->width;
+	source->async_convert_width[1] = frame->width / 2;
+	source->async_convert_height[0] = frame->height;
+	source->async_convert_height[1] = frame->height / 2;
+	source->async_texture_formats[0] = GS_R16;
+	source->async_texture_formats[1] = GS_R16G16;
+	source->async_channel_count = 2;
+	return true;
+}
+
+static inline bool set_i210_sizes(struct obs_source *source,
+				  const struct obs_source_frame *frame)
+{
+	source->async_convert_width[0] = frame->width;
+	source->async_convert_width[1] = frame->width / 2;
+	source->async_convert_width[2] = frame->width / 2;
+	source->async_convert_height[0] = frame->height;
+	source->async_convert_height[1] = frame->height;
+	source->async_convert_height[2] = frame->height;
+	source->async_texture_formats[0] = GS_R16;
+	source->async_texture_formats[1] = GS_R16;
+	source->async_texture_formats[2] = GS_R16;
+	source->async_channel_count = 3;
+	return true;
+}
+
+static inline bool set_i410_sizes(struct obs_source *source,
+				  const struct obs_source_frame *frame)
+{
+	source->async_convert_width[0] = frame->width;
+	source->async_convert_width[1] = frame->width;
+	source->async_convert_width[2] = frame->width;
+	source->async_convert_height[0] = frame->height;
+	source->async_convert_height[1] = frame->height;
+	source->async_convert_height[2] = frame->height;
+	source->async_texture_formats[0] = GS_R16;
+	source->async_texture_formats[1] = GS_R16;
+	source->async_texture_formats[2] = GS_R16;
+	source->async_channel_count = 3;
+	return true;
+}
+
 static inline bool set_y800_sizes(struct obs_source *source,
 				  const struct obs_source_frame *frame)
 {
@@ -1656,6 +1838,18 @@ static inline bool init_gpu_conversion(struct obs_source *source,
 	case CONVERT_444_A_PACK:
 		return set_packed444_alpha_sizes(source, frame);
 
+	case CONVERT_I010:
+		return set_i010_sizes(source, frame);
+
+	case CONVERT_P010:
+		return set_p010_sizes(source, frame);
+
+	case CONVERT_I210:
+		return set_i210_sizes(source, frame);
+
+	case CONVERT_I410:
+		return set_i410_sizes(source, frame);
+
 	case CONVERT_NONE:
 		assert(false && "No conversion requested");
 		break;
@@ -1738,6 +1932,10 @@ static void upload_raw_frame(gs_texture_t *tex[MAX_AV_PLANES],
 	case CONVERT_422_A:
 	case CONVERT_444_A:
 	case CONVERT_444_A_PACK:
+	case CONVERT_I010:
+	case CONVERT_P010:
+	case CONVERT_I210:
+	case CONVERT_I410:
 		for (size_t c = 0; c < MAX_AV_PLANES; c++) {
 			if (tex[c])
 				gs_texture_set_image(tex[c], frame->data[c],
@@ -1794,6 +1992,18 @@ static const char *select_conversion_technique(enum video_format format,
 	case VIDEO_FORMAT_AYUV:
 		return "AYUV_Reverse";
 
+	case VIDEO_FORMAT_I010:
+		return "I010_Reverse";
+
+	case VIDEO_FORMAT_P010:
+		return "P010_Reverse";
+
+	case VIDEO_FORMAT_I210:
+		return "I210_Reverse";
+
+	case VIDEO_FORMAT_I410:
+		return "I410_Reverse";
+
 	case VIDEO_FORMAT_BGRA:
 	case VIDEO_FORMAT_BGRX:
 	case VIDEO_FORMAT_RGBA:
@@ -2145,14 +2355,172 @@ static inline void render_video(obs_source_t *source)
 
 void obs_source_video_render(obs_source_t *source)
 {
+	struct obs_perf_scope scope;
+	bool perf;
+
 	if (!obs_source_valid(source, "obs_source_video_render"))
 		return;
 
+	/* when a source has filters it is rendered twice: once to start the
+	 * filter chain and once by the last filter.  only the second one is
+	 * the source's own work. */
+	perf = obs_source_perf_active() &&
+	       !(source->filters.num && !source->rendering_filter);
+
 	obs_source_addref(source);
+	if (perf)
+		obs_source_perf_render_begin(source, &scope);
 	render_video(source);
+	if (perf)
+		obs_source_perf_render_end(source, &scope);
 	obs_source_release(source);
 }
 
+/* picks the canvas scale filter, the same way scene items pick theirs */
+static gs_effect_t *get_frame_cache_effect(float scale_x, float scale_y,
+					   const char **tech)
+{
+	struct obs_core_video *video = &obs->video;
+
+	if (scale_x < 0.5f || scale_y < 0.5f)
+		return video->bilinear_lowres_effect;
+
+	switch (video->scale_type) {
+	case OBS_SCALE_BICUBIC:
+		return video->bicubic_effect;
+	case OBS_SCALE_LANCZOS:
+		return video->lanczos_effect;
+	case OBS_SCALE_AREA:
+		if (scale_x >= 1.0f && scale_y >= 1.0f)
+			*tech = "DrawUpscale";
+		return video->area_effect;
+	default:;
+	}
+
+	return video->default_effect;
+}
+
+static void draw_frame_cache(gs_texture_t *tex, float scale_x, float scale_y)
+{
+	gs_effect_t *effect = obs->video.default_effect;
+	const char *tech = "Draw";
+
+	if (obs->video.scale_type == OBS_SCALE_POINT) {
+		gs_eparam_t *image =
+			gs_effect_get_param_by_name(effect, "image");
+		gs_effect_set_next_sampler(image, obs->video.point_sampler);
+
+	} else if (!close_float(scale_x, 1.0f, EPSILON) ||
+		   !close_float(scale_y, 1.0f, EPSILON)) {
+		uint32_t cx = gs_texture_get_width(tex);
+		uint32_t cy = gs_texture_get_height(tex);
+		gs_effect_t *scale_effect;
+		gs_eparam_t *param;
+
+		scale_effect = get_frame_cache_effect(scale_x, scale_y, &tech);
+		if (scale_effect)
+			effect = scale_effect;
+		else
+			tech = "Draw";
+
+		param = gs_effect_get_param_by_name(effect, "base_dimension");
+		if (param) {
+			struct vec2 base_res;
+
+			vec2_set(&base_res, (float)cx, (float)cy);
+			gs_effect_set_vec2(param, &base_res);
+		}
+
+		param = gs_effect_get_param_by_name(effect,
+						    "base_dimension_i");
+		if (param) {
+			struct vec2 base_res_i;
+
+			vec2_set(&base_res_i, 1.0f / (float)cx,
+				 1.0f / (float)cy);
+			gs_effect_set_vec2(param, &base_res_i);
+		}
+	}
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	while (gs_effect_loop(effect, tech))
+		obs_source_draw(tex, 0, 0, 0, 0, false);
+
+	gs_blend_state_pop();
+}
+
+/* the cache costs a pass of its own, so it is only used for sources that
+ * were drawn more than once in the previous frame */
+static bool frame_cache_wanted(obs_source_t *source)
+{
+	uint64_t frame_time = obs->video.video_time;
+
+	if (source->frame_cache_time != frame_time) {
+		source->frame_cache_last_draws = source->frame_cache_draws;
+		source->frame_cache_draws = 0;
+		source->frame_cache_time = frame_time;
+	}
+
+	source->frame_cache_draws++;
+	return source->frame_cache_last_draws > 1;
+}
+
+void obs_source_video_render_cached(obs_source_t *source, float scale_x,
+				    float scale_y)
+{
+	gs_texrender_t *texrender;
+	gs_texture_t *tex;
+	uint32_t cx, cy;
+
+	if (!obs_source_valid(source, "obs_source_video_render_cached"))
+		return;
+
+	cx = obs_source_get_width(source);
+	cy = obs_source_get_height(source);
+
+	/* sources drawn once per frame, and a source that ends up drawing
+	 * itself, are rendered directly */
+	if (!cx || !cy || source->rendering_frame_cache ||
+	    !frame_cache_wanted(source)) {
+		obs_source_video_render(source);
+		return;
+	}
+
+	/* the texture render is transient, so the cached texture expires at
+	 * the start of the next frame */
+	if (!source->frame_cache_texrender)
+		source->frame_cache_texrender =
+			gs_texrender_create_transient(GS_RGBA, GS_ZS_NONE);
+	texrender = source->frame_cache_texrender;
+
+	/* a size change within a frame renders the source again */
+	if (cx != source->frame_cache_cx || cy != source->frame_cache_cy) {
+		gs_texrender_reset(texrender);
+		source->frame_cache_cx = cx;
+		source->frame_cache_cy = cy;
+	}
+
+	if (gs_texrender_begin(texrender, cx, cy)) {
+		struct vec4 clear_color;
+
+		vec4_zero(&clear_color);
+		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+		gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+
+		source->rendering_frame_cache = true;
+		obs_source_video_render(source);
+		source->rendering_frame_cache = false;
+
+		gs_texrender_end(texrender);
+	}
+
+	tex = gs_texrender_get_texture(texrender);
+	if (tex)
+		draw_frame_cache(tex, scale_x, scale_y);
+}
+
 static uint32_t get_base_width(const obs_source_t *source)
 {
 	bool is_filter = !!source->filter_parent;
@@ -2311,6 +2679,7 @@ void obs_source_filter_add(obs_source_t *source, obs_source_t *filter)
 						     : source->filters.array[0];
 
 	da_insert(source->filters, 0, &filter);
+	os_atomic_inc_long(&source->filter_chain_serial);
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
@@ -2345,6 +2714,7 @@ static bool obs_source_filter_remove_refless(obs_source_t *source,
 	}
 
 	da_erase(source->filters, idx);
+	os_atomic_inc_long(&source->filter_chain_serial);
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
@@ -2458,6 +2828,7 @@ static bool move_filter_dir(obs_source_t *source, obs_source_t *filter,
 		source->filters.array[i]->filter_target = next_filter;
 	}
 
+	os_atomic_inc_long(&source->filter_chain_serial);
 	return true;
 }
 
@@ -2554,18 +2925,22 @@ static void copy_frame_data(struct obs_source_frame *dst,
 
 	switch (src->format) {
 	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_I010:
 		copy_frame_data_plane(dst, src, 0, dst->height);
 		copy_frame_data_plane(dst, src, 1, dst->height / 2);
 		copy_frame_data_plane(dst, src, 2, dst->height / 2);
 		break;
 
 	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_P010:
 		copy_frame_data_plane(dst, src, 0, dst->height);
 		copy_frame_data_plane(dst, src, 1, dst->height / 2);
 		break;
 
 	case VIDEO_FORMAT_I444:
 	case VIDEO_FORMAT_I422:
+	case VIDEO_FORMAT_I210:
+	case VIDEO_FORMAT_I410:
 		copy_frame_data_plane(dst, src, 0, dst->height);
 		copy_frame_data_plane(dst, src, 1, dst->height);
 		copy_frame_data_plane(dst, src, 2, dst->height);
@@ -2902,8 +3277,16 @@ filter_async_audio(obs_source_t *source, struct obs_audio_data *in)
 			continue;
 
 		if (filter->context.data && filter->info.filter_audio) {
+			struct obs_perf_scope scope;
+			bool perf = obs_source_perf_active();
+
+			if (perf)
+				obs_source_perf_begin(&scope);
 			in = filter->info.filter_audio(filter->context.data,
 						       in);
+			if (perf)
+				obs_source_perf_end(filter, &scope,
+						    &filter->perf.stats.audio);
 			if (!in)
 				return NULL;
 		}
@@ -3071,12 +3454,31 @@ void obs_source_output_audio(obs_source_t *source,
 			     const struct obs_source_audio *audio)
 {
 	struct obs_audio_data *output;
+	struct obs_source_audio clocked;
+	struct obs_perf_scope scope;
+	bool perf = obs_source_perf_active();
+	bool clock;
 
 	if (!obs_source_valid(source, "obs_source_output_audio"))
 		return;
 	if (!obs_ptr_valid(audio, "obs_source_output_audio"))
 		return;
 
+	if (perf)
+		obs_source_perf_begin(&scope);
+
+	/* the clock source's audio goes at the current clock time, and the
+	 * clock advances once it has been placed */
+	clock = os_atomic_load_bool(&source->audio_clock);
+	if (clock) {
+		clocked = *audio;
+		clock = audio_output_get_clock_time(obs->audio.audio,
+						    audio->samples_per_sec,
+						    &clocked.timestamp);
+		if (clock)
+			audio = &clocked;
+	}
+
 	process_audio(source, audio);
 
 	pthread_mutex_lock(&source->filter_mutex);
@@ -3097,6 +3499,12 @@ void obs_source_output_audio(obs_source_t *source,
 	}
 
 	pthread_mutex_unlock(&source->filter_mutex);
+
+	if (clock)
+		audio_output_advance_clock(obs->audio.audio, audio->frames);
+
+	if (perf)
+		obs_source_perf_end(source, &scope, &source->perf.stats.audio);
 }
 
 void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
@@ -3386,6 +3794,11 @@ bool obs_source_process_filter_begin(obs_source_t *filter,
 		return false;
 	}
 
+	/* pointwise filters below this one are drawn in its pass, straight
+	 * from the target below them */
+	if (obs_source_fuse_filters(filter))
+		target = filter->fused_target;
+
 	parent_flags = parent->info.output_flags;
 	cx = get_base_width(target);
 	cy = get_base_height(target);
@@ -3407,7 +3820,7 @@ bool obs_source_process_filter_begin(obs_source_t *filter,
 
 	if (!filter->filter_texrender)
 		filter->filter_texrender =
-			gs_texrender_create(format, GS_ZS_NONE);
+			gs_texrender_create_transient(format, GS_ZS_NONE);
 
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
@@ -3454,6 +3867,13 @@ void obs_source_process_filter_tech_end(obs_source_t *filter,
 
 	const char *tech = tech_name ? tech_name : "Draw";
 
+	if (filter->fused_target) {
+		target = filter->fused_target;
+		effect = filter->fused_effect;
+		tech = "Draw";
+		obs_source_set_fused_params(filter);
+	}
+
 	if (can_bypass(target, parent, parent_flags, filter->allow_direct)) {
 		render_filter_bypass(target, effect, tech);
 	} else {
@@ -3875,6 +4295,36 @@ uint32_t obs_source_get_audio_mixers(const obs_source_t *source)
 	return source->audio_mixers;
 }
 
+bool obs_source_get_audio_lateness(const obs_source_t *source,
+				   struct obs_source_audio_lateness *lateness)
+{
+	pthread_mutex_t *mutex;
+	bool valid;
+
+	if (!obs_ptr_valid(lateness, "obs_source_get_audio_lateness"))
+		return false;
+
+	memset(lateness, 0, sizeof(*lateness));
+
+	if (!obs_source_valid(source, "obs_source_get_audio_lateness"))
+		return false;
+
+	mutex = (pthread_mutex_t *)&source->audio_buf_mutex;
+
+	pthread_mutex_lock(mutex);
+	valid = source->audio_headroom_valid;
+	if (valid) {
+		lateness->headroom_ns = source->audio_headroom;
+		lateness->min_headroom_ns = source->audio_min_headroom;
+	}
+	pthread_mutex_unlock(mutex);
+
+	lateness->late_count =
+		(uint32_t)os_atomic_load_long(&source->audio_late_count);
+
+	return valid;
+}
+
 void obs_source_draw_set_color_matrix(const struct matrix4 *color_matrix,
 				      const struct vec3 *color_range_min,
 				      const struct vec3 *color_range_max)
@@ -4026,6 +4476,10 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 
 	source->enabled = enabled;
 
+	/* disabled filters are left out of fused filter chains */
+	if (source->filter_parent)
+		os_atomic_inc_long(&source->filter_parent->filter_chain_serial);
+
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
 	calldata_set_bool(&data, "enabled", enabled);
@@ -4513,12 +4967,28 @@ void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 	}
 
 	if (source->info.audio_render) {
+		struct obs_perf_scope scope;
+		bool perf = obs_source_perf_active();
+
+		if (perf)
+			obs_source_perf_begin(&scope);
 		custom_audio_render(source, mixers, channels, sample_rate);
+		if (perf)
+			obs_source_perf_end(source, &scope,
+					    &source->perf.stats.audio);
 		return;
 	}
 
 	if (source->info.audio_mix) {
+		struct obs_perf_scope scope;
+		bool perf = obs_source_perf_active();
+
+		if (perf)
+			obs_source_perf_begin(&scope);
 		audio_submix(source, channels, sample_rate);
+		if (perf)
+			obs_source_perf_end(source, &scope,
+					    &source->perf.stats.audio);
 	}
 
 	if (!source->audio_ts) {
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "obs.h"
+#include "graphics/matrix4.h"
 
 /**
  * @file
@@ -165,6 +166,23 @@ enum obs_icon_type {
 /** Used internally for audio submixing */
 #define OBS_SOURCE_SUBMIX (1 << 12)
 
+/**
+ * Source needs video_tick called even when it is not showing or active
+ *
+ * Sources are otherwise only ticked while they are showing or active.
+ */
+#define OBS_SOURCE_BACKGROUND_TICK (1 << 13)
+
+/**
+ * Source's video_tick may be called from a worker thread
+ *
+ * Specifies that video_tick does not use the graphics subsystem, so it can
+ * be called in parallel with the video_tick of other sources.  It is always
+ * called after the source's show/hide and activate/deactivate callbacks
+ * for the frame.
+ */
+#define OBS_SOURCE_THREADED_TICK (1 << 14)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
@@ -174,6 +192,41 @@ struct obs_source_audio_mix {
 	struct audio_output_data output[MAX_AUDIO_MIXES];
 };
 
+/**
+ * @name Pointwise filter operations
+ *
+ * Operations a filter can describe itself with in filter_get_pointwise.
+ * They are applied in this order.
+ * @{
+ */
+
+/** Raises the RGB channels to the power of gamma */
+#define OBS_POINTWISE_GAMMA (1 << 0)
+
+/** Multiplies the RGBA color by color_matrix */
+#define OBS_POINTWISE_COLOR_MATRIX (1 << 1)
+
+/**
+ * Looks up the RGB color in clut, a 512x512 texture of 8x8 tiles of 64x64,
+ * and mixes it with the color by clut_amount.  Alpha is kept.
+ */
+#define OBS_POINTWISE_CLUT (1 << 2)
+
+/** @} */
+
+/**
+ * Describes a filter whose output pixel only depends on the same pixel of
+ * its input.  Consecutive filters that describe themselves this way are
+ * drawn in a single pass.
+ */
+struct obs_filter_pointwise {
+	uint32_t ops;
+	struct vec3 gamma;
+	struct matrix4 color_matrix;
+	gs_texture_t *clut;
+	float clut_amount;
+};
+
 /**
  * Source definition structure
  */
@@ -272,7 +325,8 @@ struct obs_source_info {
 	void (*hide)(void *data);
 
 	/**
-	 * Called each video frame with the time elapsed
+	 * Called each video frame with the time elapsed, while the source
+	 * is showing or active (see OBS_SOURCE_BACKGROUND_TICK)
 	 *
 	 * @param  data     Source data
 	 * @param  seconds  Seconds elapsed since the last frame
@@ -491,6 +545,23 @@ struct obs_source_info {
 
 	/** Icon type for the source */
 	enum obs_icon_type icon_type;
+
+	/**
+	 * Describes the filter as pointwise color operations so that it
+	 * can be drawn in the same pass as neighbouring pointwise filters,
+	 * without rendering to an intermediate texture.
+	 *
+	 * When the filter is drawn along with others, its video_render is
+	 * not called.  The filter must draw with the "Draw" technique and
+	 * must not change the size of its target.
+	 *
+	 * @param       data  Filter data
+	 * @param[out]  op    Operations to apply, in the order of the
+	 *                    OBS_POINTWISE_* flags
+	 * @return            false if the filter can't be combined right now
+	 */
+	bool (*filter_get_pointwise)(void *data,
+				     struct obs_filter_pointwise *op);
 };
 
 EXPORT void obs_register_source_s(const struct obs_source_info *info,
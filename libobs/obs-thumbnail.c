@@ -0,0 +1,187 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "graphics/vec4.h"
+#include "obs.h"
+#include "obs-internal.h"
+
+/* Source thumbnails.
+ *
+ * Each thumbnail renders its source to its own texture at a reduced size,
+ * once every 'interval' frames, on the graphics thread before the displays
+ * are rendered.  Thumbnails with the same interval are spread out over the
+ * frames of that interval so that they don't all update on the same frame.
+ * Drawing a thumbnail only draws its texture. */
+
+obs_thumbnail_t *obs_thumbnail_create(obs_source_t *source, uint32_t cx,
+				      uint32_t cy, uint32_t interval)
+{
+	struct obs_thumbnail *thumbnail;
+
+	if (!obs_source_valid(source, "obs_thumbnail_create"))
+		return NULL;
+
+	thumbnail = bzalloc(sizeof(struct obs_thumbnail));
+	thumbnail->source = obs_source_get_weak_source(source);
+	thumbnail->cx = cx;
+	thumbnail->cy = cy;
+	thumbnail->interval = interval ? interval : 1;
+
+	pthread_mutex_lock(&obs->data.thumbnails_mutex);
+	thumbnail->phase = obs->data.thumbnail_count++;
+	thumbnail->prev_next = &obs->data.first_thumbnail;
+	thumbnail->next = obs->data.first_thumbnail;
+	obs->data.first_thumbnail = thumbnail;
+	if (thumbnail->next)
+		thumbnail->next->prev_next = &thumbnail->next;
+	pthread_mutex_unlock(&obs->data.thumbnails_mutex);
+
+	return thumbnail;
+}
+
+void obs_thumbnail_destroy(obs_thumbnail_t *thumbnail)
+{
+	if (thumbnail) {
+		pthread_mutex_lock(&obs->data.thumbnails_mutex);
+		if (thumbnail->prev_next)
+			*thumbnail->prev_next = thumbnail->next;
+		if (thumbnail->next)
+			thumbnail->next->prev_next = thumbnail->prev_next;
+		pthread_mutex_unlock(&obs->data.thumbnails_mutex);
+
+		obs_enter_graphics();
+		gs_texrender_destroy(thumbnail->texrender);
+		obs_leave_graphics();
+
+		obs_weak_source_release(thumbnail->source);
+		bfree(thumbnail);
+	}
+}
+
+void obs_thumbnail_set_size(obs_thumbnail_t *thumbnail, uint32_t cx,
+			    uint32_t cy)
+{
+	if (!obs_ptr_valid(thumbnail, "obs_thumbnail_set_size"))
+		return;
+
+	pthread_mutex_lock(&obs->data.thumbnails_mutex);
+	thumbnail->cx = cx;
+	thumbnail->cy = cy;
+	pthread_mutex_unlock(&obs->data.thumbnails_mutex);
+}
+
+void obs_thumbnail_set_interval(obs_thumbnail_t *thumbnail, uint32_t interval)
+{
+	if (!obs_ptr_valid(thumbnail, "obs_thumbnail_set_interval"))
+		return;
+
+	pthread_mutex_lock(&obs->data.thumbnails_mutex);
+	thumbnail->interval = interval ? interval : 1;
+	pthread_mutex_unlock(&obs->data.thumbnails_mutex);
+}
+
+static void render_thumbnail(struct obs_thumbnail *thumbnail)
+{
+	obs_source_t *source = obs_weak_source_get_source(thumbnail->source);
+	uint32_t width, height;
+	struct vec4 clear_color;
+
+	if (!source)
+		return;
+
+	width = obs_source_get_width(source);
+	height = obs_source_get_height(source);
+	if (!width || !height || !thumbnail->cx || !thumbnail->cy)
+		goto finish;
+
+	if (!thumbnail->texrender)
+		thumbnail->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	gs_texrender_reset(thumbnail->texrender);
+	if (!gs_texrender_begin(thumbnail->texrender, thumbnail->cx,
+				thumbnail->cy))
+		goto finish;
+
+	vec4_zero(&clear_color);
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+	gs_ortho(0.0f, (float)width, 0.0f, (float)height, -100.0f, 100.0f);
+
+	obs_source_video_render(source);
+
+	gs_texrender_end(thumbnail->texrender);
+
+	thumbnail->source_cx = width;
+	thumbnail->source_cy = height;
+	thumbnail->rendered = true;
+
+finish:
+	obs_source_release(source);
+}
+
+void obs_render_thumbnails(void)
+{
+	struct obs_core_data *data = &obs->data;
+	uint64_t frame = data->thumbnail_frame++;
+	struct obs_thumbnail *thumbnail;
+
+	gs_enable_depth_test(false);
+	gs_set_cull_mode(GS_NEITHER);
+
+	pthread_mutex_lock(&data->thumbnails_mutex);
+
+	thumbnail = data->first_thumbnail;
+	while (thumbnail) {
+		bool sized = thumbnail->cx == thumbnail->rendered_cx &&
+			     thumbnail->cy == thumbnail->rendered_cy;
+
+		/* new and resized thumbnails are rendered right away */
+		if (!thumbnail->rendered || !sized ||
+		    (frame + thumbnail->phase) % thumbnail->interval == 0) {
+			render_thumbnail(thumbnail);
+			thumbnail->rendered_cx = thumbnail->cx;
+			thumbnail->rendered_cy = thumbnail->cy;
+		}
+
+		thumbnail = thumbnail->next;
+	}
+
+	pthread_mutex_unlock(&data->thumbnails_mutex);
+}
+
+void obs_thumbnail_render(obs_thumbnail_t *thumbnail)
+{
+	gs_effect_t *effect = obs->video.default_effect;
+	gs_texture_t *tex;
+
+	if (!obs_ptr_valid(thumbnail, "obs_thumbnail_render"))
+		return;
+	if (!thumbnail->rendered)
+		return;
+
+	tex = gs_texrender_get_texture(thumbnail->texrender);
+	if (!tex)
+		return;
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	while (gs_effect_loop(effect, "Draw"))
+		obs_source_draw(tex, 0, 0, thumbnail->source_cx,
+				thumbnail->source_cy, false);
+
+	gs_blend_state_pop();
+}
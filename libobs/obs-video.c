@@ -17,6 +17,7 @@
 
 #include <time.h>
 #include <stdlib.h>
+#include <inttypes.h>
 
 #include "obs.h"
 #include "obs-internal.h"
@@ -24,10 +25,9 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 
-static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
+static uint64_t tick_sources(struct obs_tick_pool *pool, uint64_t cur_time,
+			     uint64_t last_time)
 {
-	struct obs_core_data *data = &obs->data;
-	struct obs_source *source;
 	uint64_t delta_time;
 	float seconds;
 
@@ -54,20 +54,7 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	/* ------------------------------------- */
 	/* call the tick function of each source */
 
-	pthread_mutex_lock(&data->sources_mutex);
-
-	source = data->first_source;
-	while (source) {
-		struct obs_source *cur_source = obs_source_get_ref(source);
-		source = (struct obs_source *)source->context.next;
-
-		if (cur_source) {
-			obs_source_video_tick(cur_source, seconds);
-			obs_source_release(cur_source);
-		}
-	}
-
-	pthread_mutex_unlock(&data->sources_mutex);
+	obs_tick_sources(pool, seconds);
 
 	return cur_time;
 }
@@ -98,6 +85,16 @@ static inline void render_displays(void)
 	gs_leave_context();
 }
 
+static inline void render_thumbnails(void)
+{
+	if (!obs->data.valid)
+		return;
+
+	gs_enter_context(obs->video.graphics);
+	obs_render_thumbnails();
+	gs_leave_context();
+}
+
 static inline void set_render_size(uint32_t width, uint32_t height)
 {
 	gs_enable_depth_test(false);
@@ -107,8 +104,52 @@ static inline void set_render_size(uint32_t width, uint32_t height)
 	gs_set_viewport(0, 0, width, height);
 }
 
+/* Video copy thread.
+ *
+ * Mapped staging surfaces are copied to the video output on their own
+ * thread, so the graphics thread can tick and render the next frame while
+ * the last one is copied.  A surface stays mapped until its copy has
+ * finished: the graphics thread waits for the copy before it unmaps the
+ * surface to stage a new frame into it. */
+
+struct obs_video_copy {
+	pthread_t thread;
+	os_sem_t *start_sem;
+	os_event_t *done_event;
+	volatile bool stop;
+
+	/* graphics thread only */
+	bool pending;
+
+	struct video_data frame;
+	int count;
+};
+
+static void video_copy_wait(struct obs_core_video *video)
+{
+	struct obs_video_copy *copy = video->video_copy;
+	uint64_t start;
+
+	if (!copy || !copy->pending)
+		return;
+
+	copy->pending = false;
+	if (os_event_try(copy->done_event) == 0)
+		return;
+
+	start = os_gettime_ns();
+	os_event_wait(copy->done_event);
+
+	pthread_mutex_lock(&video->video_copy_stats_mutex);
+	video->video_copy_stats.stalls++;
+	video->video_copy_stats.stall_time_ns += os_gettime_ns() - start;
+	pthread_mutex_unlock(&video->video_copy_stats_mutex);
+}
+
 static inline void unmap_last_surface(struct obs_core_video *video)
 {
+	video_copy_wait(video);
+
 	for (int c = 0; c < NUM_CHANNELS; ++c) {
 		if (video->mapped_surfaces[c]) {
 			gs_stagesurface_unmap(video->mapped_surfaces[c]);
@@ -652,6 +693,10 @@ static void set_gpu_converted_data(struct obs_core_video *video,
 		case VIDEO_FORMAT_I42A:
 		case VIDEO_FORMAT_YUVA:
 		case VIDEO_FORMAT_AYUV:
+		case VIDEO_FORMAT_I010:
+		case VIDEO_FORMAT_P010:
+		case VIDEO_FORMAT_I210:
+		case VIDEO_FORMAT_I410:
 			/* unimplemented */
 			;
 		}
@@ -700,6 +745,111 @@ static inline void output_video_data(struct obs_core_video *video,
 	}
 }
 
+static void *video_copy_thread(void *param)
+{
+	struct obs_video_copy *copy = param;
+	struct obs_core_video *video = &obs->video;
+
+	os_set_thread_name("libobs: video copy thread");
+
+	while (os_sem_wait(copy->start_sem) == 0) {
+		uint64_t start, end, latency;
+
+		if (os_atomic_load_bool(&copy->stop))
+			break;
+
+		start = os_gettime_ns();
+		output_video_data(video, &copy->frame, copy->count);
+		end = os_gettime_ns();
+		latency = end - copy->frame.timestamp;
+
+		pthread_mutex_lock(&video->video_copy_stats_mutex);
+		video->video_copy_stats.frames++;
+		video->video_copy_stats.copy_time_ns += end - start;
+		video->video_copy_stats.latency_ns += latency;
+		pthread_mutex_unlock(&video->video_copy_stats_mutex);
+
+		os_event_signal(copy->done_event);
+	}
+
+	return NULL;
+}
+
+static struct obs_video_copy *video_copy_create(void)
+{
+	struct obs_video_copy *copy = bzalloc(sizeof(*copy));
+
+	if (os_sem_init(&copy->start_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&copy->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+	if (pthread_create(&copy->thread, NULL, video_copy_thread, copy) != 0)
+		goto fail;
+
+	return copy;
+
+fail:
+	blog(LOG_WARNING, "Failed to create video copy thread, frames will "
+			  "be copied on the graphics thread");
+	os_sem_destroy(copy->start_sem);
+	os_event_destroy(copy->done_event);
+	bfree(copy);
+	return NULL;
+}
+
+static void video_copy_destroy(struct obs_core_video *video)
+{
+	struct obs_video_copy *copy = video->video_copy;
+	struct obs_video_copy_stats stats;
+
+	if (!copy)
+		return;
+
+	video_copy_wait(video);
+	video->video_copy = NULL;
+
+	os_atomic_set_bool(&copy->stop, true);
+	os_sem_post(copy->start_sem);
+	pthread_join(copy->thread, NULL);
+
+	os_sem_destroy(copy->start_sem);
+	os_event_destroy(copy->done_event);
+	bfree(copy);
+
+	obs_get_video_copy_stats(&stats);
+	if (stats.frames)
+		blog(LOG_INFO,
+		     "Video copy thread: %" PRIu64 " frames, average copy "
+		     "%.2f ms, average latency %.2f ms, graphics thread "
+		     "waited %" PRIu64 " time(s)",
+		     stats.frames,
+		     (double)stats.copy_time_ns / (double)stats.frames /
+			     1000000.0,
+		     (double)stats.latency_ns / (double)stats.frames /
+			     1000000.0,
+		     stats.stalls);
+}
+
+/* hands the mapped frame to the copy thread, or copies it right away if
+ * there is none */
+static inline void video_copy_queue(struct obs_core_video *video,
+				    struct video_data *frame, int count)
+{
+	struct obs_video_copy *copy = video->video_copy;
+
+	if (!copy) {
+		output_video_data(video, frame, count);
+		return;
+	}
+
+	video_copy_wait(video);
+
+	copy->frame = *frame;
+	copy->count = count;
+	copy->pending = true;
+	os_sem_post(copy->start_sem);
+}
+
 static inline void video_sleep(struct obs_core_video *video, bool raw_active,
 			       const bool gpu_active, uint64_t *p_time,
 			       uint64_t interval_ns)
@@ -777,7 +927,7 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 
 		frame.timestamp = vframe_info.timestamp;
 		profile_start(output_frame_output_video_data_name);
-		output_video_data(video, &frame, vframe_info.count);
+		video_copy_queue(video, &frame, vframe_info.count);
 		profile_end(output_frame_output_video_data_name);
 	}
 
@@ -812,6 +962,7 @@ static void clear_gpu_frame_data(void)
 #endif
 
 static const char *tick_sources_name = "tick_sources";
+static const char *render_thumbnails_name = "render_thumbnails";
 static const char *render_displays_name = "render_displays";
 static const char *output_frame_name = "output_frame";
 void *obs_graphics_thread(void *param)
@@ -826,6 +977,9 @@ void *obs_graphics_thread(void *param)
 #endif
 	bool raw_was_active = false;
 	bool was_active = false;
+	struct obs_tick_pool *tick_pool = obs_tick_pool_create();
+
+	obs->video.video_copy = video_copy_create();
 
 	obs->video.video_time = os_gettime_ns();
 	obs->video.video_frame_interval_ns = interval;
@@ -843,6 +997,7 @@ void *obs_graphics_thread(void *param)
 		uint64_t frame_start = os_gettime_ns();
 		uint64_t frame_time_ns;
 		bool raw_active = obs->video.raw_active > 0;
+		bool perf = obs_source_perf_active();
 #ifdef _WIN32
 		const bool gpu_active = obs->video.gpu_encoder_active > 0;
 		const bool active = raw_active || gpu_active;
@@ -868,20 +1023,33 @@ void *obs_graphics_thread(void *param)
 
 		gs_enter_context(obs->video.graphics);
 		gs_begin_frame();
+		if (perf)
+			obs_perf_frame_begin(&obs->video);
 		gs_leave_context();
 
 		profile_start(tick_sources_name);
-		last_time = tick_sources(obs->video.video_time, last_time);
+		last_time = tick_sources(tick_pool, obs->video.video_time,
+					 last_time);
 		profile_end(tick_sources_name);
 
 		profile_start(output_frame_name);
 		output_frame(raw_active, gpu_active);
 		profile_end(output_frame_name);
 
+		profile_start(render_thumbnails_name);
+		render_thumbnails();
+		profile_end(render_thumbnails_name);
+
 		profile_start(render_displays_name);
 		render_displays();
 		profile_end(render_displays_name);
 
+		if (perf) {
+			gs_enter_context(obs->video.graphics);
+			obs_perf_frame_end(&obs->video);
+			gs_leave_context();
+		}
+
 		frame_time_ns = os_gettime_ns() - frame_start;
 
 		profile_end(video_thread_name);
@@ -909,6 +1077,9 @@ void *obs_graphics_thread(void *param)
 		}
 	}
 
+	obs_tick_pool_destroy(tick_pool);
+	video_copy_destroy(&obs->video);
+
 	UNUSED_PARAMETER(param);
 	return NULL;
 }
@@ -137,8 +137,11 @@ void obs_view_render(obs_view_t *view)
 			if (source->removed) {
 				obs_source_release(source);
 				view->channels[i] = NULL;
-			} else {
+			} else if (view == &obs->data.main_view) {
 				obs_source_video_render(source);
+			} else {
+				obs_source_video_render_cached(source, 1.0f,
+							       1.0f);
 			}
 		}
 	}
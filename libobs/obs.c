@@ -426,6 +426,9 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	if (pthread_mutex_init(&video->gpu_encoder_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->video_copy_stats_mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
+	memset(&video->video_copy_stats, 0, sizeof(video->video_copy_stats));
 
 	errorcode = pthread_create(&video->video_thread, NULL,
 				   obs_graphics_thread, obs);
@@ -519,6 +522,8 @@ static void obs_free_video(void)
 
 		pthread_mutex_destroy(&video->gpu_encoder_mutex);
 		pthread_mutex_init_value(&video->gpu_encoder_mutex);
+		pthread_mutex_destroy(&video->video_copy_stats_mutex);
+		pthread_mutex_init_value(&video->video_copy_stats_mutex);
 		da_free(video->gpu_encoders);
 
 		video->gpu_encoder_active = 0;
@@ -547,8 +552,11 @@ static void obs_free_graphics(void)
 		gs_effect_destroy(video->lanczos_effect);
 		gs_effect_destroy(video->area_effect);
 		gs_effect_destroy(video->bilinear_lowres_effect);
+		obs_free_fused_effects(video);
 		video->default_effect = NULL;
 
+		obs_perf_free(video);
+
 		gs_leave_context();
 
 		gs_destroy(video->graphics);
@@ -573,6 +581,9 @@ static bool obs_init_audio(struct audio_output_info *ai)
 		return false;
 
 	audio->user_volume = 1.0f;
+	audio->buffering_reduction = true;
+	audio->window_min_headroom = INT64_MAX;
+	audio->min_headroom = INT64_MAX;
 
 	audio->monitoring_device_name = bstrdup("Default");
 	audio->monitoring_device_id = bstrdup("default");
@@ -614,6 +625,7 @@ static bool obs_init_data(void)
 	assert(data != NULL);
 
 	pthread_mutex_init_value(&obs->data.displays_mutex);
+	pthread_mutex_init_value(&obs->data.thumbnails_mutex);
 	pthread_mutex_init_value(&obs->data.draw_callbacks_mutex);
 
 	if (pthread_mutexattr_init(&attr) != 0)
@@ -626,6 +638,8 @@ static bool obs_init_data(void)
 		goto fail;
 	if (pthread_mutex_init(&data->displays_mutex, &attr) != 0)
 		goto fail;
+	if (pthread_mutex_init(&data->thumbnails_mutex, &attr) != 0)
+		goto fail;
 	if (pthread_mutex_init(&data->outputs_mutex, &attr) != 0)
 		goto fail;
 	if (pthread_mutex_init(&data->encoders_mutex, &attr) != 0)
@@ -683,11 +697,13 @@ static void obs_free_data(void)
 	FREE_OBS_LINKED_LIST(output);
 	FREE_OBS_LINKED_LIST(encoder);
 	FREE_OBS_LINKED_LIST(display);
+	FREE_OBS_LINKED_LIST(thumbnail);
 	FREE_OBS_LINKED_LIST(service);
 
 	pthread_mutex_destroy(&data->sources_mutex);
 	pthread_mutex_destroy(&data->audio_sources_mutex);
 	pthread_mutex_destroy(&data->displays_mutex);
+	pthread_mutex_destroy(&data->thumbnails_mutex);
 	pthread_mutex_destroy(&data->outputs_mutex);
 	pthread_mutex_destroy(&data->encoders_mutex);
 	pthread_mutex_destroy(&data->services_mutex);
@@ -843,6 +859,7 @@ static bool obs_init(const char *locale, const char *module_config_path,
 
 	pthread_mutex_init_value(&obs->audio.monitoring_mutex);
 	pthread_mutex_init_value(&obs->video.gpu_encoder_mutex);
+	pthread_mutex_init_value(&obs->video.video_copy_stats_mutex);
 
 	obs->name_store_owned = !store;
 	obs->name_store = store ? store : profiler_name_store_create();
@@ -2222,6 +2239,21 @@ uint64_t obs_get_frame_interval_ns(void)
 	return obs ? obs->video.video_frame_interval_ns : 0;
 }
 
+void obs_get_video_copy_stats(struct obs_video_copy_stats *stats)
+{
+	struct obs_core_video *video;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!obs)
+		return;
+
+	video = &obs->video;
+
+	pthread_mutex_lock(&video->video_copy_stats_mutex);
+	*stats = video->video_copy_stats;
+	pthread_mutex_unlock(&video->video_copy_stats_mutex);
+}
+
 enum obs_obj_type obs_obj_get_type(void *obj)
 {
 	struct obs_context_data *context = obj;
@@ -2311,6 +2343,126 @@ void obs_get_audio_monitoring_device(const char **name, const char **id)
 		*id = obs->audio.monitoring_device_id;
 }
 
+void obs_set_audio_monitoring_latency(uint32_t latency_ms)
+{
+	if (!obs)
+		return;
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+
+	if (obs->audio.monitoring_latency_ms != latency_ms) {
+		obs->audio.monitoring_latency_ms = latency_ms;
+
+		for (size_t i = 0; i < obs->audio.monitors.num; i++) {
+			struct audio_monitor *monitor =
+				obs->audio.monitors.array[i];
+			audio_monitor_reset(monitor);
+		}
+	}
+
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+}
+
+uint32_t obs_get_audio_monitoring_latency(void)
+{
+	return obs ? obs->audio.monitoring_latency_ms : 0;
+}
+
+bool obs_get_audio_monitoring_stats(struct obs_audio_monitoring_stats *stats)
+{
+	if (!obs_ptr_valid(stats, "obs_get_audio_monitoring_stats"))
+		return false;
+
+	memset(stats, 0, sizeof(*stats));
+	return obs ? audio_monitoring_get_stats(stats) : false;
+}
+
+void obs_set_audio_buffering_reduction(bool enable)
+{
+	if (obs)
+		os_atomic_set_bool(&obs->audio.buffering_reduction, enable);
+}
+
+bool obs_audio_buffering_reduction_enabled(void)
+{
+	return obs ? os_atomic_load_bool(&obs->audio.buffering_reduction)
+		   : false;
+}
+
+static inline uint32_t ticks_to_ms(int ticks)
+{
+	uint32_t rate = audio_output_get_sample_rate(obs->audio.audio);
+	return rate ? (uint32_t)((uint64_t)ticks * AUDIO_OUTPUT_FRAMES * 1000 /
+				 rate)
+		    : 0;
+}
+
+bool obs_get_audio_buffering_stats(struct obs_audio_buffering_stats *stats)
+{
+	struct obs_core_audio *audio;
+
+	if (!obs_ptr_valid(stats, "obs_get_audio_buffering_stats"))
+		return false;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!obs || !obs->audio.audio)
+		return false;
+
+	audio = &obs->audio;
+	stats->buffering_ms = ticks_to_ms(audio->total_buffering_ticks);
+	stats->max_buffering_ms = ticks_to_ms(audio->max_buffering_ticks);
+	stats->increases = audio->buffering_increases;
+	stats->reductions = audio->buffering_reductions;
+	stats->min_headroom_ns = audio->min_headroom == INT64_MAX
+					 ? 0
+					 : audio->min_headroom;
+	return true;
+}
+
+void obs_set_audio_clock_source(obs_source_t *source)
+{
+	obs_source_t *prev;
+
+	if (!obs)
+		return;
+	if (source && (source->info.output_flags & OBS_SOURCE_AUDIO) == 0) {
+		blog(LOG_WARNING, "obs_set_audio_clock_source: source '%s' "
+				  "has no audio",
+		     obs_source_get_name(source));
+		return;
+	}
+
+	pthread_mutex_lock(&obs->data.audio_sources_mutex);
+
+	prev = obs->audio.clock_source;
+	obs->audio.clock_source = source;
+
+	if (prev)
+		os_atomic_set_bool(&prev->audio_clock, false);
+	if (source)
+		os_atomic_set_bool(&source->audio_clock, true);
+
+	pthread_mutex_unlock(&obs->data.audio_sources_mutex);
+
+	if (prev == source)
+		return;
+
+	audio_output_set_external_clock(obs->audio.audio, !!source);
+
+	if (source)
+		blog(LOG_INFO, "Using '%s' as the audio clock",
+		     obs_source_get_name(source));
+	else
+		blog(LOG_INFO, "Using the system clock for audio");
+}
+
+bool obs_source_is_audio_clock(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_is_audio_clock")
+		       ? os_atomic_load_bool(&source->audio_clock)
+		       : false;
+}
+
 void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 			   void *param)
 {
@@ -40,6 +40,7 @@ struct matrix4;
 
 /* opaque types */
 struct obs_display;
+struct obs_thumbnail;
 struct obs_view;
 struct obs_source;
 struct obs_scene;
@@ -52,6 +53,7 @@ struct obs_fader;
 struct obs_volmeter;
 
 typedef struct obs_display obs_display_t;
+typedef struct obs_thumbnail obs_thumbnail_t;
 typedef struct obs_view obs_view_t;
 typedef struct obs_source obs_source_t;
 typedef struct obs_scene obs_scene_t;
@@ -259,6 +261,37 @@ struct obs_source_frame2 {
 	bool flip;
 };
 
+/** Time spent in one kind of source callback */
+struct obs_source_perf_timing {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
+/**
+ * Cost of a source, collected while source perf stats are enabled.
+ *
+ * Filters are sources of their own and have their own stats.  The render
+ * stats of a source with filters only cover the source itself, as rendered
+ * from the last filter.
+ */
+struct obs_source_perf_stats {
+	/** CPU time of video rendering, without the sources and filters
+	 * rendered from within */
+	struct obs_source_perf_timing render;
+	/** CPU time of video rendering, including everything rendered from
+	 * within */
+	struct obs_source_perf_timing render_total;
+	/** GPU time of the first render each frame, including everything
+	 * rendered from within.  Results arrive a few frames late. */
+	struct obs_source_perf_timing render_gpu;
+	/** CPU time of video_tick */
+	struct obs_source_perf_timing tick;
+	/** CPU time of audio processing and audio filters for
+	 * obs_source_output_audio, and of custom audio rendering */
+	struct obs_source_perf_timing audio;
+};
+
 /** Access to the argc/argv used to start OBS. What you see is what you get. */
 struct obs_cmdline_args {
 	int argc;
@@ -640,6 +673,13 @@ EXPORT signal_handler_t *obs_get_signal_handler(void);
 /** Returns the primary obs procedure handler */
 EXPORT proc_handler_t *obs_get_proc_handler(void);
 
+/**
+ * Enables or disables collecting per-source perf stats.  Disabled by
+ * default, in which case collecting costs a single check per call.
+ */
+EXPORT void obs_set_source_perf_stats_enabled(bool enabled);
+EXPORT bool obs_source_perf_stats_enabled(void);
+
 #ifndef SWIG
 /** Renders the main view */
 DEPRECATED
@@ -709,6 +749,86 @@ EXPORT void obs_enum_audio_monitoring_devices(obs_enum_audio_device_cb cb,
 EXPORT bool obs_set_audio_monitoring_device(const char *name, const char *id);
 EXPORT void obs_get_audio_monitoring_device(const char **name, const char **id);
 
+/**
+ * Sets how much audio the monitoring output keeps queued, in milliseconds.
+ * 0 uses the default, which grows the buffer when the device underruns.
+ * Only the PulseAudio monitoring backend currently honors a target.
+ */
+EXPORT void obs_set_audio_monitoring_latency(uint32_t latency_ms);
+EXPORT uint32_t obs_get_audio_monitoring_latency(void);
+
+struct obs_audio_monitoring_stats {
+	uint32_t target_latency_ms;
+	uint32_t latency_ms;
+	uint32_t max_latency_ms;
+	uint32_t sources;
+	uint64_t underruns;
+	uint64_t dropped_frames;
+	uint64_t late_frames;
+
+	/** playback speed used to compensate for clock drift */
+	double drift_ratio;
+};
+
+/**
+ * Gets statistics of the shared monitoring output.  Returns false if
+ * nothing is being monitored or the backend does not provide them.
+ */
+EXPORT bool
+obs_get_audio_monitoring_stats(struct obs_audio_monitoring_stats *stats);
+
+/**
+ * Enables reducing audio buffering again once every source has been
+ * comfortably early for a while.  Buffering is added when a source's audio
+ * arrives late, and is otherwise kept until audio is reset.  Enabled by
+ * default.
+ */
+EXPORT void obs_set_audio_buffering_reduction(bool enable);
+EXPORT bool obs_audio_buffering_reduction_enabled(void);
+
+struct obs_audio_buffering_stats {
+	uint32_t buffering_ms;
+	uint32_t max_buffering_ms;
+	uint32_t increases;
+	uint32_t reductions;
+
+	/** least any source's audio was ahead of the mix over the last
+	 * measurement window, negative if a source was late */
+	int64_t min_headroom_ns;
+};
+
+EXPORT bool
+obs_get_audio_buffering_stats(struct obs_audio_buffering_stats *stats);
+
+struct obs_source_audio_lateness {
+	/** how far the source's audio is ahead of the mix, negative if it
+	 * is late */
+	int64_t headroom_ns;
+	/** least headroom over the last measurement window */
+	int64_t min_headroom_ns;
+	/** times the source caused audio buffering to be added */
+	uint32_t late_count;
+};
+
+/**
+ * Gets how early or late a source's audio arrives relative to the audio
+ * mix.  Returns false if the source has no audio buffered.
+ */
+EXPORT bool
+obs_source_get_audio_lateness(const obs_source_t *source,
+			      struct obs_source_audio_lateness *lateness);
+
+/**
+ * Makes an audio source the clock of the audio subsystem, for sources fed
+ * by an audio device callback such as JACK.  Audio is mixed and output as
+ * soon as the source has delivered it instead of on the system timer, and
+ * its audio is timestamped from its own frame count so it needs no extra
+ * buffering or timestamp smoothing.  Other sources are still mixed by
+ * their system timestamps.  Pass NULL to go back to the system clock.
+ */
+EXPORT void obs_set_audio_clock_source(obs_source_t *source);
+EXPORT bool obs_source_is_audio_clock(const obs_source_t *source);
+
 EXPORT void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 				  void *param);
 EXPORT void obs_remove_tick_callback(void (*tick)(void *param, float seconds),
@@ -735,6 +855,26 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/**
+ * Raw video frames are copied to the video output on a separate thread
+ * while the graphics thread renders the next frame.  These are totals since
+ * video was last reset.
+ */
+struct obs_video_copy_stats {
+	/** Frames copied to the video output */
+	uint64_t frames;
+	/** Time spent copying frames */
+	uint64_t copy_time_ns;
+	/** Time from the timestamp of each frame until it was copied */
+	uint64_t latency_ns;
+	/** Times the graphics thread had to wait for a copy to finish */
+	uint64_t stalls;
+	/** Time the graphics thread spent waiting for copies to finish */
+	uint64_t stall_time_ns;
+};
+
+EXPORT void obs_get_video_copy_stats(struct obs_video_copy_stats *stats);
+
 EXPORT bool obs_nv12_tex_active(void);
 
 EXPORT void obs_apply_private_data(obs_data_t *settings);
@@ -810,9 +950,64 @@ EXPORT bool obs_display_enabled(obs_display_t *display);
 EXPORT void obs_display_set_background_color(obs_display_t *display,
 					     uint32_t color);
 
+/**
+ * Limits how often a display is rendered.  Displays are only rendered along
+ * with output frames, so the actual rate depends on the output's frame rate.
+ * Use 0 to render every frame.
+ */
+EXPORT void obs_display_set_max_fps(obs_display_t *display, double fps);
+
+/**
+ * Marks a display as occluded, such as when its window is minimized or
+ * hidden.  Occluded displays are not rendered.
+ */
+EXPORT void obs_display_set_occluded(obs_display_t *display, bool occluded);
+
+/**
+ * Pauses rendering of a display while any output is active (see
+ * obs_video_active), such as while streaming or recording.
+ */
+EXPORT void obs_display_set_pause_while_active(obs_display_t *display,
+					       bool pause);
+
 EXPORT void obs_display_size(obs_display_t *display, uint32_t *width,
 			     uint32_t *height);
 
+/* ------------------------------------------------------------------------- */
+/* Thumbnails */
+
+/**
+ * Creates a thumbnail of a source.  The source is rendered to a texture of
+ * the given size on the graphics thread once every 'interval' frames, before
+ * the displays are rendered.  Only a weak reference to the source is held,
+ * so the caller should keep it showing with obs_source_inc_showing.
+ *
+ * @param  source    The source to render.
+ * @param  cx        Width of the thumbnail texture.
+ * @param  cy        Height of the thumbnail texture.
+ * @param  interval  Number of frames between updates, 1 for every frame.
+ * @return           The new thumbnail.
+ */
+EXPORT obs_thumbnail_t *obs_thumbnail_create(obs_source_t *source, uint32_t cx,
+					     uint32_t cy, uint32_t interval);
+
+/** Destroys a thumbnail */
+EXPORT void obs_thumbnail_destroy(obs_thumbnail_t *thumbnail);
+
+/** Changes the size of the thumbnail texture, which is updated next frame */
+EXPORT void obs_thumbnail_set_size(obs_thumbnail_t *thumbnail, uint32_t cx,
+				   uint32_t cy);
+
+/** Changes the number of frames between updates of a thumbnail */
+EXPORT void obs_thumbnail_set_interval(obs_thumbnail_t *thumbnail,
+				       uint32_t interval);
+
+/**
+ * Draws the last texture of a thumbnail.  It is drawn at the size of the
+ * source, like obs_source_video_render, so it can be used in its place.
+ */
+EXPORT void obs_thumbnail_render(obs_thumbnail_t *thumbnail);
+
 /* ------------------------------------------------------------------------- */
 /* Sources */
 
@@ -889,6 +1084,27 @@ EXPORT void obs_source_update(obs_source_t *source, obs_data_t *settings);
 /** Renders a video source. */
 EXPORT void obs_source_video_render(obs_source_t *source);
 
+/**
+ * Renders a video source through a per-frame cache.  The first call in a
+ * frame renders the source to a texture at its own size, and every other
+ * call in that frame just draws the texture, scaled by scale_x/scale_y
+ * with the canvas scale filter.  Sources drawn only once per frame are
+ * rendered directly.  Use this for sources that may be drawn in more than
+ * one display or view.
+ */
+EXPORT void obs_source_video_render_cached(obs_source_t *source,
+					   float scale_x, float scale_y);
+
+/**
+ * Gets the perf stats collected for a source since it was created or its
+ * stats were last reset.  Returns false if nothing was collected.
+ */
+EXPORT bool obs_source_get_perf_stats(const obs_source_t *source,
+				      struct obs_source_perf_stats *stats);
+
+/** Resets the perf stats of a source */
+EXPORT void obs_source_reset_perf_stats(obs_source_t *source);
+
 /** Gets the width of a source (if it has video) */
 EXPORT uint32_t obs_source_get_width(obs_source_t *source);
 
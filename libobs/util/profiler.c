@@ -256,24 +256,190 @@ static void merge_call(profile_entry *entry, profile_call *call,
 #endif
 }
 
-static bool enabled = false;
+/* ------------------------------------------------------------------------- */
+/* Per-thread event buffers
+ *
+ * profile_start/profile_end only append an event to a ring buffer owned by
+ * the calling thread.  The aggregator thread drains the rings, rebuilds the
+ * call trees and merges them into the root entries, so recording takes no
+ * locks once a thread has its buffer. */
+
+#define PROFILE_RING_SIZE 8192 /* power of two */
+#define PROFILE_RING_MASK (PROFILE_RING_SIZE - 1)
+#define PROFILE_AGGREGATE_INTERVAL_MS 10
+#define PROFILE_TRACE_MAX_EVENTS (1 << 20)
+
+enum profile_event_type {
+	PROFILE_EVENT_START,
+	PROFILE_EVENT_END,
+};
+
+typedef struct profile_event profile_event;
+struct profile_event {
+	const char *name;
+	uint64_t time;
+#ifdef TRACK_OVERHEAD
+	uint64_t overhead;
+#endif
+	enum profile_event_type type;
+};
+
+typedef struct profile_thread profile_thread;
+struct profile_thread {
+	profile_event events[PROFILE_RING_SIZE];
+	volatile long head;
+	volatile long tail;
+	volatile bool exited;
+
+	/* owning thread only */
+	DARRAY(const char *) stack;
+	size_t drop_depth;
+	bool dropping;
+	long dropped;
+
+	/* aggregator only */
+	profile_call *context;
+	const char *name;
+	uint32_t id;
+};
+
+typedef struct profile_trace_event profile_trace_event;
+struct profile_trace_event {
+	const char *name;
+	uint64_t start_time;
+	uint64_t end_time;
+	uint32_t thread_id;
+};
+
+typedef struct profile_trace_thread profile_trace_thread;
+struct profile_trace_thread {
+	const char *name;
+	uint32_t id;
+};
+
+static volatile bool enabled = false;
 static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
 static DARRAY(profile_root_entry) root_entries;
 
-static THREAD_LOCAL profile_call *thread_context = NULL;
+/* lock order: aggregate_mutex -> threads_mutex -> root_mutex */
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(profile_thread *) threads;
+static uint32_t next_thread_id = 1;
+static long generation = 1;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_key;
+
+static pthread_mutex_t aggregate_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t aggregator;
+static os_event_t *aggregator_stop = NULL;
+static bool aggregator_active = false;
+
+static void *aggregator_thread(void *unused);
+
+static bool trace_enabled = false;
+static uint64_t trace_start_time = 0;
+static DARRAY(profile_trace_event) trace_events;
+static DARRAY(profile_trace_thread) trace_threads;
+
+static THREAD_LOCAL profile_thread *thread_buffer = NULL;
+static THREAD_LOCAL long thread_generation = 0;
 static THREAD_LOCAL bool thread_enabled = true;
 
+static void thread_buffer_release(void *data)
+{
+	profile_thread *t = data;
+
+	/* the buffer may have been freed by profiler_free already */
+	pthread_mutex_lock(&threads_mutex);
+	if (thread_generation == generation)
+		os_atomic_set_bool(&t->exited, true);
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+static void thread_key_init(void)
+{
+	pthread_key_create(&thread_key, thread_buffer_release);
+}
+
+static profile_thread *get_thread_buffer(void)
+{
+	if (thread_buffer && thread_generation == os_atomic_load_long(&generation))
+		return thread_buffer;
+
+	profile_thread *t = bzalloc(sizeof(profile_thread));
+
+	pthread_once(&thread_key_once, thread_key_init);
+
+	pthread_mutex_lock(&threads_mutex);
+	t->id = next_thread_id++;
+	da_push_back(threads, &t);
+	thread_generation = generation;
+	pthread_mutex_unlock(&threads_mutex);
+
+	pthread_setspecific(thread_key, t);
+	thread_buffer = t;
+	return t;
+}
+
+static inline size_t ring_free_space(const profile_thread *t)
+{
+	unsigned long used = (unsigned long)t->head -
+			     (unsigned long)os_atomic_load_long(&t->tail);
+	return PROFILE_RING_SIZE - used;
+}
+
+static inline profile_event *ring_next(profile_thread *t)
+{
+	return &t->events[(unsigned long)t->head & PROFILE_RING_MASK];
+}
+
+static void end_call(profile_thread *t, const char *name, uint64_t time)
+{
+	size_t depth = t->stack.num;
+
+	da_pop_back(t->stack);
+
+	if (t->dropping) {
+		if (depth == t->drop_depth)
+			t->dropping = false;
+		return;
+	}
+
+	/* space for this was reserved when the call started */
+	profile_event *ev = ring_next(t);
+	ev->name = name;
+	ev->type = PROFILE_EVENT_END;
+	ev->time = time;
+#ifdef TRACK_OVERHEAD
+	ev->overhead = os_gettime_ns() - time;
+#endif
+	os_atomic_inc_long(&t->head);
+}
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = true;
+	os_atomic_set_bool(&enabled, true);
 	pthread_mutex_unlock(&root_mutex);
+
+	pthread_mutex_lock(&aggregate_mutex);
+	if (!aggregator_active &&
+	    os_event_init(&aggregator_stop, OS_EVENT_TYPE_MANUAL) == 0) {
+		aggregator_active = pthread_create(&aggregator, NULL,
+						   aggregator_thread,
+						   NULL) == 0;
+		if (!aggregator_active) {
+			os_event_destroy(aggregator_stop);
+			aggregator_stop = NULL;
+		}
+	}
+	pthread_mutex_unlock(&aggregate_mutex);
 }
 
 void profiler_stop(void)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
 	pthread_mutex_unlock(&root_mutex);
 }
 
@@ -282,9 +448,7 @@ void profile_reenable_thread(void)
 	if (thread_enabled)
 		return;
 
-	pthread_mutex_lock(&root_mutex);
-	thread_enabled = enabled;
-	pthread_mutex_unlock(&root_mutex);
+	thread_enabled = os_atomic_load_bool(&enabled);
 }
 
 static bool lock_root(void)
@@ -336,13 +500,16 @@ void profile_register_root(const char *name,
 
 static void free_call_context(profile_call *context);
 
+/* called from the aggregator */
 static void merge_context(profile_call *context)
 {
 	pthread_mutex_t *mutex = NULL;
 	profile_entry *entry = NULL;
 	profile_call *prev_call = NULL;
 
-	if (!lock_root()) {
+	pthread_mutex_lock(&root_mutex);
+	if (!enabled) {
+		pthread_mutex_unlock(&root_mutex);
 		free_call_context(context);
 		return;
 	}
@@ -370,26 +537,38 @@ void profile_start(const char *name)
 	if (!thread_enabled)
 		return;
 
-	profile_call new_call = {
-		.name = name,
 #ifdef TRACK_OVERHEAD
-		.overhead_start = os_gettime_ns(),
+	uint64_t overhead_start = os_gettime_ns();
 #endif
-		.parent = thread_context,
-	};
+	profile_thread *t = get_thread_buffer();
+
+	if (!t->stack.num && !os_atomic_load_bool(&enabled)) {
+		thread_enabled = false;
+		return;
+	}
 
-	profile_call *call = NULL;
+	da_push_back(t->stack, &name);
 
-	if (new_call.parent) {
-		size_t idx = da_push_back(new_call.parent->children, &new_call);
-		call = &new_call.parent->children.array[idx];
-	} else {
-		call = bmalloc(sizeof(profile_call));
-		memcpy(call, &new_call, sizeof(profile_call));
+	if (t->dropping)
+		return;
+
+	/* keep room for the end of every open call, so a tree is either
+	 * recorded completely or its subtree is dropped as a whole */
+	if (ring_free_space(t) < t->stack.num + 1) {
+		t->dropping = true;
+		t->drop_depth = t->stack.num;
+		t->dropped++;
+		return;
 	}
 
-	thread_context = call;
-	call->start_time = os_gettime_ns();
+	profile_event *ev = ring_next(t);
+	ev->name = name;
+	ev->type = PROFILE_EVENT_START;
+	ev->time = os_gettime_ns();
+#ifdef TRACK_OVERHEAD
+	ev->overhead = ev->time - overhead_start;
+#endif
+	os_atomic_inc_long(&t->head);
 }
 
 void profile_end(const char *name)
@@ -398,47 +577,267 @@ void profile_end(const char *name)
 	if (!thread_enabled)
 		return;
 
-	profile_call *call = thread_context;
-	if (!call) {
+	profile_thread *t = thread_buffer;
+	if (!t || thread_generation != os_atomic_load_long(&generation) ||
+	    !t->stack.num) {
 		blog(LOG_ERROR, "Called profile end with no active profile");
 		return;
 	}
 
-	if (!call->name)
-		call->name = name;
-
-	if (call->name != name) {
+	const char *call_name = t->stack.array[t->stack.num - 1];
+	if (call_name && call_name != name) {
 		blog(LOG_ERROR,
 		     "Called profile end with mismatching name: "
 		     "start(\"%s\"[%p]) <-> end(\"%s\"[%p])",
-		     call->name, call->name, name, name);
+		     call_name, call_name, name, name);
 
-		profile_call *parent = call->parent;
-		while (parent && parent->parent && parent->name != name)
-			parent = parent->parent;
+		size_t idx = t->stack.num - 1;
+		while (idx > 0 && t->stack.array[idx] != name)
+			idx--;
 
-		if (!parent || parent->name != name)
+		if (t->stack.array[idx] != name)
 			return;
 
-		while (call->name != name) {
-			profile_end(call->name);
-			call = call->parent;
+		while (t->stack.num > idx + 1)
+			end_call(t, t->stack.array[t->stack.num - 1], end);
+	}
+
+	end_call(t, name, end);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Aggregation */
+
+static void add_trace_thread(profile_thread *t)
+{
+	profile_trace_thread *thread = da_push_back_new(trace_threads);
+	thread->name = t->name;
+	thread->id = t->id;
+}
+
+static void add_trace_event(profile_thread *t, profile_call *call)
+{
+	if (trace_events.num >= PROFILE_TRACE_MAX_EVENTS) {
+		blog(LOG_WARNING, "Profiler trace buffer full, "
+				  "stopped recording trace");
+		trace_enabled = false;
+		return;
+	}
+
+	profile_trace_event *ev = da_push_back_new(trace_events);
+	ev->name = call->name;
+	ev->start_time = call->start_time;
+	ev->end_time = call->end_time;
+	ev->thread_id = t->id;
+}
+
+static void process_event(profile_thread *t, const profile_event *ev)
+{
+	if (ev->type == PROFILE_EVENT_START) {
+		profile_call new_call = {
+			.name = ev->name,
+#ifdef TRACK_OVERHEAD
+			.overhead_start = ev->time - ev->overhead,
+#endif
+			.start_time = ev->time,
+			.parent = t->context,
+		};
+
+		profile_call *call = NULL;
+
+		if (new_call.parent) {
+			size_t idx = da_push_back(new_call.parent->children,
+						  &new_call);
+			call = &new_call.parent->children.array[idx];
+		} else {
+			call = bmalloc(sizeof(profile_call));
+			memcpy(call, &new_call, sizeof(profile_call));
 		}
+
+		t->context = call;
+		return;
 	}
 
-	thread_context = call->parent;
+	profile_call *call = t->context;
+	if (!call->name)
+		call->name = ev->name;
 
-	call->end_time = end;
+	t->context = call->parent;
+
+	call->end_time = ev->time;
 #ifdef TRACK_OVERHEAD
-	call->overhead_end = os_gettime_ns();
+	call->overhead_end = ev->time + ev->overhead;
 #endif
 
+	if (!t->name && !call->parent) {
+		t->name = call->name;
+		add_trace_thread(t);
+	}
+
+	if (trace_enabled)
+		add_trace_event(t, call);
+
 	if (call->parent)
 		return;
 
 	merge_context(call);
 }
 
+static void drain_thread(profile_thread *t)
+{
+	unsigned long head = (unsigned long)os_atomic_load_long(&t->head);
+	unsigned long tail = (unsigned long)t->tail;
+
+	for (; tail != head; tail++)
+		process_event(t, &t->events[tail & PROFILE_RING_MASK]);
+
+	os_atomic_set_long(&t->tail, (long)tail);
+}
+
+static void free_thread_buffer(profile_thread *t)
+{
+	profile_call *root = t->context;
+	while (root && root->parent)
+		root = root->parent;
+
+	free_call_context(root);
+	da_free(t->stack);
+	bfree(t);
+}
+
+static void aggregate(void)
+{
+	pthread_mutex_lock(&aggregate_mutex);
+	pthread_mutex_lock(&threads_mutex);
+
+	for (size_t i = threads.num; i > 0; i--) {
+		profile_thread *t = threads.array[i - 1];
+		bool exited = os_atomic_load_bool(&t->exited);
+
+		drain_thread(t);
+
+		if (exited) {
+			if (t->dropped)
+				blog(LOG_WARNING,
+				     "Profiler dropped %ld calls on "
+				     "thread '%s', buffer full",
+				     t->dropped, t->name ? t->name : "");
+			da_erase(threads, i - 1);
+			free_thread_buffer(t);
+		}
+	}
+
+	pthread_mutex_unlock(&threads_mutex);
+	pthread_mutex_unlock(&aggregate_mutex);
+}
+
+static void *aggregator_thread(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	os_set_thread_name("profiler: aggregator");
+
+	while (os_event_timedwait(aggregator_stop,
+				  PROFILE_AGGREGATE_INTERVAL_MS) == ETIMEDOUT)
+		aggregate();
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Trace export */
+
+void profiler_trace_start(void)
+{
+	pthread_mutex_lock(&aggregate_mutex);
+	da_resize(trace_events, 0);
+	trace_start_time = os_gettime_ns();
+	trace_enabled = true;
+	pthread_mutex_unlock(&aggregate_mutex);
+}
+
+void profiler_trace_stop(void)
+{
+	aggregate();
+
+	pthread_mutex_lock(&aggregate_mutex);
+	trace_enabled = false;
+	pthread_mutex_unlock(&aggregate_mutex);
+}
+
+static void trace_cat_name(struct dstr *buffer, const char *name)
+{
+	dstr_cat_ch(buffer, '"');
+
+	for (const char *ch = name ? name : ""; *ch; ch++) {
+		if (*ch == '"' || *ch == '\\') {
+			dstr_cat_ch(buffer, '\\');
+			dstr_cat_ch(buffer, *ch);
+		} else if ((unsigned char)*ch < 0x20) {
+			dstr_catf(buffer, "\\u%04x", (unsigned char)*ch);
+		} else {
+			dstr_cat_ch(buffer, *ch);
+		}
+	}
+
+	dstr_cat_ch(buffer, '"');
+}
+
+bool profiler_trace_dump_json(const char *filename)
+{
+	struct dstr buffer = {0};
+	bool first = true;
+
+	aggregate();
+
+	FILE *f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	pthread_mutex_lock(&aggregate_mutex);
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+
+	for (size_t i = 0; i < trace_threads.num; i++) {
+		profile_trace_thread *thread = &trace_threads.array[i];
+
+		dstr_printf(&buffer,
+			    "%s\n{\"name\":\"thread_name\",\"ph\":\"M\","
+			    "\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":",
+			    first ? "" : ",", thread->id);
+		trace_cat_name(&buffer, thread->name);
+		dstr_cat(&buffer, "}}");
+		fwrite(buffer.array, 1, buffer.len, f);
+		first = false;
+	}
+
+	for (size_t i = 0; i < trace_events.num; i++) {
+		profile_trace_event *ev = &trace_events.array[i];
+
+		if (ev->start_time < trace_start_time)
+			continue;
+
+		dstr_printf(&buffer, "%s\n{\"name\":", first ? "" : ",");
+		trace_cat_name(&buffer, ev->name);
+		dstr_catf(&buffer,
+			  ",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32
+			  ",\"ts\":%.3f,\"dur\":%.3f}",
+			  ev->thread_id,
+			  (ev->start_time - trace_start_time) / 1000.0,
+			  (ev->end_time - ev->start_time) / 1000.0);
+		fwrite(buffer.array, 1, buffer.len, f);
+		first = false;
+	}
+
+	fputs("\n]}\n", f);
+
+	pthread_mutex_unlock(&aggregate_mutex);
+
+	dstr_free(&buffer);
+	fclose(f);
+	return true;
+}
+
 static int profiler_time_entry_compare(const void *first, const void *second)
 {
 	int64_t diff = ((profiler_time_entry *)second)->time_delta -
@@ -802,9 +1201,45 @@ static void free_profile_entry(profile_entry *entry)
 void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
+	DARRAY(profile_thread *) old_threads = {0};
+	long dropped = 0;
+
+	pthread_mutex_lock(&root_mutex);
+	os_atomic_set_bool(&enabled, false);
+	pthread_mutex_unlock(&root_mutex);
+
+	pthread_mutex_lock(&aggregate_mutex);
+	if (aggregator_active) {
+		os_event_signal(aggregator_stop);
+		pthread_join(aggregator, NULL);
+		os_event_destroy(aggregator_stop);
+		aggregator_stop = NULL;
+		aggregator_active = false;
+	}
+
+	/* buffers of threads that are still alive are replaced on their next
+	 * call, the generation tells them theirs is gone */
+	pthread_mutex_lock(&threads_mutex);
+	da_move(old_threads, threads);
+	generation++;
+	pthread_mutex_unlock(&threads_mutex);
+
+	for (size_t i = 0; i < old_threads.num; i++) {
+		dropped += old_threads.array[i]->dropped;
+		free_thread_buffer(old_threads.array[i]);
+	}
+	da_free(old_threads);
+
+	trace_enabled = false;
+	da_free(trace_events);
+	da_free(trace_threads);
+	pthread_mutex_unlock(&aggregate_mutex);
+
+	if (dropped)
+		blog(LOG_WARNING, "Profiler dropped %ld calls, buffer full",
+		     dropped);
 
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
 	da_move(old_root_entries, root_entries);
 	pthread_mutex_unlock(&root_mutex);
 
@@ -926,6 +1361,9 @@ profiler_snapshot_t *profile_snapshot_create(void)
 {
 	profiler_snapshot_t *snap = bzalloc(sizeof(profiler_snapshot_t));
 
+	/* include everything recorded up to now */
+	aggregate();
+
 	pthread_mutex_lock(&root_mutex);
 	da_reserve(snap->roots, root_entries.num);
 	for (size_t i = 0; i < root_entries.num; i++) {
@@ -33,6 +33,18 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Trace recording
+ *
+ * While a trace is recorded every profiled call is kept with its thread and
+ * start/end time.  The dump is in the Chrome trace event format and can be
+ * opened in chrome://tracing or Perfetto.  Recording stops by itself after
+ * about a million calls. */
+
+EXPORT void profiler_trace_start(void);
+EXPORT void profiler_trace_stop(void);
+EXPORT bool profiler_trace_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
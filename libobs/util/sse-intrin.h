@@ -54,6 +54,12 @@
 #define _mm_srai_epi16 simde_mm_srai_epi16
 #define _mm_shufflelo_epi16 simde_mm_shufflelo_epi16
 #define _mm_storeu_si128 simde_mm_storeu_si128
+#define _mm_loadu_si128 simde_mm_loadu_si128
+#define _mm_unpacklo_epi16 simde_mm_unpacklo_epi16
+#define _mm_unpackhi_epi16 simde_mm_unpackhi_epi16
+#define _mm_srai_epi32 simde_mm_srai_epi32
+#define _mm_cvtepi32_ps simde_mm_cvtepi32_ps
+#define _mm_cvtps_epi32 simde_mm_cvtps_epi32
 
 #define _MM_SHUFFLE SIMDE_MM_SHUFFLE
 #define _MM_TRANSPOSE4_PS SIMDE_MM_TRANSPOSE4_PS
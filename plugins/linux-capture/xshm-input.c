@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <xcb/damage.h>
 #include <xcb/randr.h>
 #include <xcb/shm.h>
 #include <xcb/xfixes.h>
@@ -25,6 +26,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <obs-module.h>
 #include <util/dstr.h>
+#include <util/darray.h>
+#include <util/platform.h>
+#include <util/threading.h>
 #include "xcursor-xcb.h"
 #include "xhelpers.h"
 
@@ -32,14 +36,67 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define blog(level, msg, ...) blog(level, "xshm-input: " msg, ##__VA_ARGS__)
 
+/* above this many separate dirty bands a single full frame fetch is cheaper */
+#define XSHM_MAX_BANDS 16
+
+/**
+ * A range of full-width rows of the captured area
+ */
+struct xshm_band {
+	int32_t y;
+	int32_t height;
+};
+
+/**
+ * Set of dirty rows, either a list of disjoint sorted bands or everything
+ */
+struct xshm_bands {
+	DARRAY(struct xshm_band) bands;
+	bool full;
+};
+
+/**
+ * One of the two shared memory frames the capture thread alternates between
+ *
+ * Each buffer always holds a complete frame, apart from the rows in @stale
+ * which changed on screen since the buffer was last filled.
+ */
+struct xshm_buffer {
+	xcb_shm_t *shm;
+	struct xshm_bands stale;
+};
+
 struct xshm_data {
 	obs_source_t *source;
 
 	xcb_connection_t *xcb;
 	xcb_screen_t *xcb_screen;
-	xcb_shm_t *xshm;
 	xcb_xcursor_t *cursor;
 
+	struct xshm_buffer buffers[2];
+
+	bool use_damage;
+	xcb_damage_damage_t damage;
+	xcb_xfixes_region_t region;
+	uint8_t damage_event;
+
+	pthread_t thread;
+	os_event_t *stop_event;
+	bool thread_active;
+
+	/* shared between the capture and graphics threads, protected by
+	 * mutex */
+	pthread_mutex_t mutex;
+	int latest;  /* buffer holding the newest frame */
+	int reading; /* buffer being uploaded, -1 when none */
+	bool frame_ready;
+	struct xshm_bands pending;
+	xcb_xfixes_get_cursor_image_reply_t *cursor_reply;
+
+	/* rows the texture is missing, only used on the graphics thread */
+	struct xshm_bands upload;
+	bool texture_valid;
+
 	char *server;
 	uint_fast32_t screen_id;
 	int_fast32_t x_org;
@@ -68,6 +125,70 @@ static inline void xshm_resize_texture(struct xshm_data *data)
 		gs_texture_destroy(data->texture);
 	data->texture = gs_texture_create(data->width, data->height, GS_BGRA, 1,
 					  NULL, GS_DYNAMIC);
+	data->texture_valid = false;
+}
+
+static inline void xshm_bands_clear(struct xshm_bands *set)
+{
+	da_resize(set->bands, 0);
+	set->full = false;
+}
+
+static inline void xshm_bands_set_full(struct xshm_bands *set)
+{
+	da_resize(set->bands, 0);
+	set->full = true;
+}
+
+static inline bool xshm_bands_empty(const struct xshm_bands *set)
+{
+	return !set->full && !set->bands.num;
+}
+
+/**
+ * Add a range of rows, merging it with the bands it touches
+ */
+static void xshm_bands_add(struct xshm_bands *set, int32_t y, int32_t height)
+{
+	int32_t end = y + height;
+	size_t idx = 0;
+
+	if (set->full || height <= 0)
+		return;
+
+	while (idx < set->bands.num &&
+	       set->bands.array[idx].y + set->bands.array[idx].height < y)
+		idx++;
+
+	while (idx < set->bands.num && set->bands.array[idx].y <= end) {
+		struct xshm_band *band = set->bands.array + idx;
+		int32_t band_end = band->y + band->height;
+
+		if (band->y < y)
+			y = band->y;
+		if (band_end > end)
+			end = band_end;
+		da_erase(set->bands, idx);
+	}
+
+	struct xshm_band band = {y, end - y};
+	da_insert(set->bands, idx, &band);
+
+	if (set->bands.num > XSHM_MAX_BANDS)
+		xshm_bands_set_full(set);
+}
+
+static void xshm_bands_merge(struct xshm_bands *dst,
+			     const struct xshm_bands *src)
+{
+	if (src->full) {
+		xshm_bands_set_full(dst);
+		return;
+	}
+
+	for (size_t i = 0; i < src->bands.num; i++)
+		xshm_bands_add(dst, src->bands.array[i].y,
+			       src->bands.array[i].height);
 }
 
 /**
@@ -88,6 +209,9 @@ static bool xshm_check_extensions(xcb_connection_t *xcb)
 	if (!xcb_get_extension_data(xcb, &xcb_randr_id)->present)
 		blog(LOG_INFO, "Missing Randr extension !");
 
+	if (!xcb_get_extension_data(xcb, &xcb_damage_id)->present)
+		blog(LOG_INFO, "Missing Damage extension !");
+
 	return ok;
 }
 
@@ -149,11 +273,231 @@ static const char *xshm_getname(void *unused)
 	return obs_module_text("X11SharedMemoryScreenInput");
 }
 
+/**
+ * Set up damage tracking on the root window
+ *
+ * @return false if the server can't report damage, in which case every frame
+ *         is fetched in full
+ */
+static bool xshm_init_damage(struct xshm_data *data)
+{
+	const xcb_query_extension_reply_t *ext;
+	xcb_damage_query_version_cookie_t ver_c;
+
+	ext = xcb_get_extension_data(data->xcb, &xcb_damage_id);
+	if (!ext->present)
+		return false;
+
+	ver_c = xcb_damage_query_version_unchecked(data->xcb,
+						   XCB_DAMAGE_MAJOR_VERSION,
+						   XCB_DAMAGE_MINOR_VERSION);
+	free(xcb_damage_query_version_reply(data->xcb, ver_c, NULL));
+
+	data->damage_event = ext->first_event + XCB_DAMAGE_NOTIFY;
+	data->damage = xcb_generate_id(data->xcb);
+	data->region = xcb_generate_id(data->xcb);
+
+	xcb_damage_create(data->xcb, data->damage, data->xcb_screen->root,
+			  XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+	xcb_xfixes_create_region(data->xcb, data->region, 0, NULL);
+
+	return true;
+}
+
+/**
+ * Collect the rows of the captured area that changed since the last call
+ *
+ * With the non-empty report level the server sends a single event once the
+ * damage region stops being empty, so the region is only fetched when there
+ * actually is something to fetch.
+ */
+static void xshm_poll_damage(struct xshm_data *data, bool *damaged,
+			     struct xshm_bands *fresh)
+{
+	xcb_generic_event_t *ev;
+
+	while ((ev = xcb_poll_for_event(data->xcb))) {
+		if ((ev->response_type & ~0x80) == data->damage_event)
+			*damaged = true;
+		free(ev);
+	}
+
+	if (!*damaged)
+		return;
+
+	xcb_xfixes_fetch_region_cookie_t reg_c;
+	xcb_xfixes_fetch_region_reply_t *reg_r;
+
+	xcb_damage_subtract(data->xcb, data->damage, XCB_NONE, data->region);
+	reg_c = xcb_xfixes_fetch_region_unchecked(data->xcb, data->region);
+	reg_r = xcb_xfixes_fetch_region_reply(data->xcb, reg_c, NULL);
+	*damaged = false;
+
+	if (!reg_r) {
+		xshm_bands_set_full(fresh);
+		return;
+	}
+
+	xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reg_r);
+	int count = xcb_xfixes_fetch_region_rectangles_length(reg_r);
+
+	for (int i = 0; i < count; i++) {
+		int_fast32_t x = rects[i].x - data->x_org;
+		int_fast32_t y = rects[i].y - data->y_org;
+		int_fast32_t y_end = y + rects[i].height;
+
+		if (x >= data->width || x + rects[i].width <= 0)
+			continue;
+		if (y < 0)
+			y = 0;
+		if (y_end > data->height)
+			y_end = data->height;
+
+		xshm_bands_add(fresh, (int32_t)y, (int32_t)(y_end - y));
+	}
+
+	free(reg_r);
+}
+
+/**
+ * Fetch the stale rows of a buffer from the server
+ *
+ * Only whole rows are fetched so every band lands at its place in the
+ * segment and the buffer keeps the layout of a full frame.
+ */
+static bool xshm_fetch_buffer(struct xshm_data *data, struct xshm_buffer *buf)
+{
+	xcb_shm_get_image_cookie_t img_c[XSHM_MAX_BANDS];
+	struct xshm_band full = {0, (int32_t)data->height};
+	const struct xshm_band *bands = &full;
+	size_t count = 1;
+	bool success = true;
+
+	if (!buf->stale.full) {
+		bands = buf->stale.bands.array;
+		count = buf->stale.bands.num;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		img_c[i] = xcb_shm_get_image_unchecked(
+			data->xcb, data->xcb_screen->root, data->x_org,
+			data->y_org + bands[i].y, data->width,
+			bands[i].height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP,
+			buf->shm->seg, bands[i].y * data->width * 4);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		xcb_shm_get_image_reply_t *img_r =
+			xcb_shm_get_image_reply(data->xcb, img_c[i], NULL);
+		if (!img_r)
+			success = false;
+		free(img_r);
+	}
+
+	if (success)
+		xshm_bands_clear(&buf->stale);
+	return success;
+}
+
+/**
+ * Capture thread
+ *
+ * Runs at the video frame rate, fetches what changed on screen into the
+ * buffer the graphics thread is not using and hands it over.  When nothing
+ * changed no frame is produced and the graphics thread skips the upload.
+ */
+static void *xshm_capture_thread(void *vptr)
+{
+	XSHM_DATA(vptr);
+
+	struct xshm_bands fresh = {0};
+	struct xshm_bands unpublished = {0};
+	struct obs_video_info ovi;
+	uint64_t interval = 1000000000ULL / 30;
+	bool damaged = false;
+
+	os_set_thread_name("xshm-input: capture");
+
+	if (obs_get_video_info(&ovi))
+		interval = 1000000000ULL * ovi.fps_den / ovi.fps_num;
+
+	xshm_bands_set_full(&unpublished);
+	uint64_t next = os_gettime_ns();
+
+	while (os_event_try(data->stop_event) == EAGAIN) {
+		xcb_xfixes_get_cursor_image_cookie_t cur_c = {0};
+		bool showing = obs_source_showing(data->source);
+		bool want_cursor = showing && data->show_cursor;
+
+		if (want_cursor)
+			cur_c = xcb_xfixes_get_cursor_image_unchecked(
+				data->xcb);
+
+		if (data->use_damage)
+			xshm_poll_damage(data, &damaged, &fresh);
+		else
+			xshm_bands_set_full(&fresh);
+
+		for (size_t i = 0; i < 2; i++)
+			xshm_bands_merge(&data->buffers[i].stale, &fresh);
+		xshm_bands_merge(&unpublished, &fresh);
+		xshm_bands_clear(&fresh);
+
+		if (showing && !xshm_bands_empty(&unpublished)) {
+			pthread_mutex_lock(&data->mutex);
+			int back = data->latest ^ 1;
+			bool busy = data->reading == back;
+			pthread_mutex_unlock(&data->mutex);
+
+			if (!busy &&
+			    xshm_fetch_buffer(data, &data->buffers[back])) {
+				pthread_mutex_lock(&data->mutex);
+				data->latest = back;
+				data->frame_ready = true;
+				xshm_bands_merge(&data->pending, &unpublished);
+				pthread_mutex_unlock(&data->mutex);
+
+				xshm_bands_clear(&unpublished);
+			}
+		}
+
+		if (want_cursor) {
+			xcb_xfixes_get_cursor_image_reply_t *cur_r =
+				xcb_xfixes_get_cursor_image_reply(data->xcb,
+								  cur_c, NULL);
+
+			pthread_mutex_lock(&data->mutex);
+			free(data->cursor_reply);
+			data->cursor_reply = cur_r;
+			pthread_mutex_unlock(&data->mutex);
+		}
+
+		next += interval;
+		if (!os_sleepto_ns(next))
+			next = os_gettime_ns();
+	}
+
+	da_free(fresh.bands);
+	da_free(unpublished.bands);
+	return NULL;
+}
+
 /**
  * Stop the capture
  */
 static void xshm_capture_stop(struct xshm_data *data)
 {
+	if (data->thread_active) {
+		os_event_signal(data->stop_event);
+		pthread_join(data->thread, NULL);
+		data->thread_active = false;
+	}
+
+	if (data->stop_event) {
+		os_event_destroy(data->stop_event);
+		data->stop_event = NULL;
+	}
+
 	obs_enter_graphics();
 
 	if (data->texture) {
@@ -167,9 +511,26 @@ static void xshm_capture_stop(struct xshm_data *data)
 
 	obs_leave_graphics();
 
-	if (data->xshm) {
-		xshm_xcb_detach(data->xshm);
-		data->xshm = NULL;
+	free(data->cursor_reply);
+	data->cursor_reply = NULL;
+
+	for (size_t i = 0; i < 2; i++) {
+		struct xshm_buffer *buf = &data->buffers[i];
+
+		if (buf->shm) {
+			xshm_xcb_detach(buf->shm);
+			buf->shm = NULL;
+		}
+		da_free(buf->stale.bands);
+	}
+
+	da_free(data->pending.bands);
+	da_free(data->upload.bands);
+
+	if (data->use_damage) {
+		xcb_damage_destroy(data->xcb, data->damage);
+		xcb_xfixes_destroy_region(data->xcb, data->region);
+		data->use_damage = false;
 	}
 
 	if (data->xcb) {
@@ -208,21 +569,44 @@ static void xshm_capture_start(struct xshm_data *data)
 		goto fail;
 	}
 
-	data->xshm = xshm_xcb_attach(data->xcb, data->width, data->height);
-	if (!data->xshm) {
-		blog(LOG_ERROR, "failed to attach shm !");
-		goto fail;
+	for (size_t i = 0; i < 2; i++) {
+		struct xshm_buffer *buf = &data->buffers[i];
+
+		buf->shm = xshm_xcb_attach(data->xcb, data->width,
+					   data->height);
+		if (!buf->shm) {
+			blog(LOG_ERROR, "failed to attach shm !");
+			goto fail;
+		}
+		xshm_bands_set_full(&buf->stale);
 	}
 
 	data->cursor = xcb_xcursor_init(data->xcb);
 	xcb_xcursor_offset(data->cursor, data->x_org, data->y_org);
 
+	data->use_damage = xshm_init_damage(data);
+
+	data->latest = 1;
+	data->reading = -1;
+	data->frame_ready = false;
+	xshm_bands_clear(&data->pending);
+	xshm_bands_set_full(&data->upload);
+
 	obs_enter_graphics();
 
 	xshm_resize_texture(data);
 
 	obs_leave_graphics();
 
+	if (os_event_init(&data->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail;
+	if (pthread_create(&data->thread, NULL, xshm_capture_thread, data) !=
+	    0) {
+		blog(LOG_ERROR, "failed to create capture thread !");
+		goto fail;
+	}
+	data->thread_active = true;
+
 	return;
 fail:
 	xshm_capture_stop(data);
@@ -387,6 +771,7 @@ static void xshm_destroy(void *vptr)
 
 	xshm_capture_stop(data);
 
+	pthread_mutex_destroy(&data->mutex);
 	bfree(data);
 }
 
@@ -398,13 +783,51 @@ static void *xshm_create(obs_data_t *settings, obs_source_t *source)
 	struct xshm_data *data = bzalloc(sizeof(struct xshm_data));
 	data->source = source;
 
+	if (pthread_mutex_init(&data->mutex, NULL) != 0) {
+		bfree(data);
+		return NULL;
+	}
+
 	xshm_update(data, settings);
 
 	return data;
 }
 
+/**
+ * Bring the texture up to date with a captured frame
+ *
+ * Once the texture holds a complete frame, only the damaged bands are
+ * uploaded to it.
+ *
+ * @note requires to be called within the obs graphics context
+ */
+static void xshm_upload_frame(struct xshm_data *data, const uint8_t *frame)
+{
+	const uint32_t frame_linesize = data->width * 4;
+
+	if (!data->texture_valid || data->upload.full) {
+		gs_texture_set_image(data->texture, frame, frame_linesize,
+				     false);
+		data->texture_valid = true;
+		xshm_bands_clear(&data->upload);
+		return;
+	}
+
+	for (size_t i = 0; i < data->upload.bands.num; i++) {
+		const struct xshm_band *band = data->upload.bands.array + i;
+
+		gs_texture_set_image_rows(data->texture, frame, frame_linesize,
+					  (uint32_t)band->y,
+					  (uint32_t)band->height);
+	}
+
+	xshm_bands_clear(&data->upload);
+}
+
 /**
  * Prepare the capture data
+ *
+ * Picks up the newest frame from the capture thread, if there is one.
  */
 static void xshm_video_tick(void *vptr, float seconds)
 {
@@ -416,34 +839,42 @@ static void xshm_video_tick(void *vptr, float seconds)
 	if (!obs_source_showing(data->source))
 		return;
 
-	xcb_shm_get_image_cookie_t img_c;
-	xcb_shm_get_image_reply_t *img_r;
-	xcb_xfixes_get_cursor_image_cookie_t cur_c;
 	xcb_xfixes_get_cursor_image_reply_t *cur_r;
+	int buffer = -1;
 
-	img_c = xcb_shm_get_image_unchecked(data->xcb, data->xcb_screen->root,
-					    data->x_org, data->y_org,
-					    data->width, data->height, ~0,
-					    XCB_IMAGE_FORMAT_Z_PIXMAP,
-					    data->xshm->seg, 0);
-	cur_c = xcb_xfixes_get_cursor_image_unchecked(data->xcb);
+	pthread_mutex_lock(&data->mutex);
 
-	img_r = xcb_shm_get_image_reply(data->xcb, img_c, NULL);
-	cur_r = xcb_xfixes_get_cursor_image_reply(data->xcb, cur_c, NULL);
+	cur_r = data->cursor_reply;
+	data->cursor_reply = NULL;
+
+	if (data->frame_ready) {
+		buffer = data->latest;
+		data->reading = buffer;
+		data->frame_ready = false;
+		xshm_bands_merge(&data->upload, &data->pending);
+		xshm_bands_clear(&data->pending);
+	}
 
-	if (!img_r)
-		goto exit;
+	pthread_mutex_unlock(&data->mutex);
+
+	if (buffer < 0 && !cur_r)
+		return;
 
 	obs_enter_graphics();
 
-	gs_texture_set_image(data->texture, (void *)data->xshm->data,
-			     data->width * 4, false);
-	xcb_xcursor_update(data->cursor, cur_r);
+	if (buffer >= 0)
+		xshm_upload_frame(data, data->buffers[buffer].shm->data);
+	if (cur_r)
+		xcb_xcursor_update(data->cursor, cur_r);
 
 	obs_leave_graphics();
 
-exit:
-	free(img_r);
+	if (buffer >= 0) {
+		pthread_mutex_lock(&data->mutex);
+		data->reading = -1;
+		pthread_mutex_unlock(&data->mutex);
+	}
+
 	free(cur_r);
 }
 
@@ -59,6 +59,7 @@ static void jack_update(void *vptr, obs_data_t *settings)
 	bool settings_changed = false;
 	bool new_jack_start_server = obs_data_get_bool(settings, "startjack");
 	int new_channel_count = obs_data_get_int(settings, "channels");
+	bool audio_clock = obs_data_get_bool(settings, "audio_clock");
 
 	if (new_jack_start_server != data->start_jack_server) {
 		data->start_jack_server = new_jack_start_server;
@@ -89,6 +90,11 @@ static void jack_update(void *vptr, obs_data_t *settings)
 			deactivate_jack(data);
 		}
 	}
+
+	if (audio_clock && data->jack_client)
+		obs_set_audio_clock_source(data->source);
+	else if (obs_source_is_audio_clock(data->source))
+		obs_set_audio_clock_source(NULL);
 }
 
 /**
@@ -118,6 +124,7 @@ static void jack_input_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_int(settings, "channels", 2);
 	obs_data_set_default_bool(settings, "startjack", false);
+	obs_data_set_default_bool(settings, "audio_clock", false);
 }
 
 /**
@@ -133,6 +140,8 @@ static obs_properties_t *jack_input_properties(void *unused)
 			       1, 8, 1);
 	obs_properties_add_bool(props, "startjack",
 				obs_module_text("StartJACKServer"));
+	obs_properties_add_bool(props, "audio_clock",
+				obs_module_text("UseAsAudioClock"));
 
 	return props;
 }
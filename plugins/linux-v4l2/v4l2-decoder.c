@@ -0,0 +1,506 @@
+/*
+Copyright (C) 2026 by agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <inttypes.h>
+
+#include <libavcodec/avcodec.h>
+
+#include <util/bmem.h>
+#include <util/circlebuf.h>
+#include <util/darray.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "v4l2-helpers.h"
+#include "v4l2-decoder.h"
+
+#define blog(level, msg, ...) blog(level, "v4l2-decoder: " msg, ##__VA_ARGS__)
+
+#define MAX_DECODE_WORKERS 4
+
+/* frames queued or being decoded per worker before new frames are dropped */
+#define FRAMES_PER_WORKER 2
+
+/* dropping H.264 frames corrupts the picture until the next keyframe, so
+ * allow a deeper queue to ride out short stalls */
+#define MAX_H264_FRAMES 8
+
+/**
+ * A compressed frame on its way through the pool
+ */
+struct v4l2_decode_job {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	int64_t pts;
+
+	/* decoder output, the first frame_count frames are valid when done
+	 * is set.  a packet can yield several frames once the decoder has
+	 * buffered some, the frames are kept allocated for reuse */
+	DARRAY(AVFrame *) frames;
+	size_t frame_count;
+	bool done;
+};
+
+struct v4l2_decode_worker {
+	struct v4l2_decoder *decoder;
+	AVCodecContext *context;
+	pthread_t thread;
+	bool active;
+
+	/* jobs this worker is outputting, outside of the mutex */
+	DARRAY(struct v4l2_decode_job *) output;
+};
+
+struct v4l2_decoder {
+	obs_source_t *source;
+	const AVCodec *codec;
+	enum video_range_type range;
+
+	struct v4l2_decode_worker workers[MAX_DECODE_WORKERS];
+	size_t worker_count;
+	size_t max_jobs;
+
+	os_sem_t *sem;
+	pthread_mutex_t mutex;
+	bool mutex_valid;
+	bool stop;
+
+	/* set while a worker outputs frames, so that only one worker outputs
+	 * at a time and the frames stay in capture order */
+	bool outputting;
+
+	/* jobs waiting for a worker */
+	struct circlebuf queue;
+	/* all jobs not yet output, in capture order */
+	DARRAY(struct v4l2_decode_job *) in_flight;
+	DARRAY(struct v4l2_decode_job *) free_jobs;
+
+	struct obs_source_frame2 out;
+	uint64_t decoded;
+	uint64_t dropped;
+	uint64_t errors;
+};
+
+static inline enum AVCodecID v4l2_to_av_codec(uint_fast32_t pixfmt)
+{
+	switch (pixfmt) {
+	case V4L2_PIX_FMT_MJPEG:
+	case V4L2_PIX_FMT_JPEG:
+		return AV_CODEC_ID_MJPEG;
+	case V4L2_PIX_FMT_H264:
+		return AV_CODEC_ID_H264;
+	default:
+		return AV_CODEC_ID_NONE;
+	}
+}
+
+static inline enum video_format convert_pixel_format(int f)
+{
+	switch (f) {
+	case AV_PIX_FMT_YUV420P:
+	case AV_PIX_FMT_YUVJ420P:
+		return VIDEO_FORMAT_I420;
+	case AV_PIX_FMT_YUV422P:
+	case AV_PIX_FMT_YUVJ422P:
+		return VIDEO_FORMAT_I422;
+	case AV_PIX_FMT_YUV444P:
+	case AV_PIX_FMT_YUVJ444P:
+		return VIDEO_FORMAT_I444;
+	case AV_PIX_FMT_NV12:
+		return VIDEO_FORMAT_NV12;
+	case AV_PIX_FMT_YUYV422:
+		return VIDEO_FORMAT_YUY2;
+	case AV_PIX_FMT_UYVY422:
+		return VIDEO_FORMAT_UYVY;
+	case AV_PIX_FMT_BGRA:
+		return VIDEO_FORMAT_BGRA;
+	case AV_PIX_FMT_BGR0:
+		return VIDEO_FORMAT_BGRX;
+	default:
+		return VIDEO_FORMAT_NONE;
+	}
+}
+
+static void job_free(struct v4l2_decode_job *job)
+{
+	for (size_t i = 0; i < job->frames.num; i++)
+		av_frame_free(&job->frames.array[i]);
+	da_free(job->frames);
+	bfree(job->data);
+	bfree(job);
+}
+
+/**
+ * Get the frame to receive the next decoder output into
+ */
+static AVFrame *job_next_frame(struct v4l2_decode_job *job)
+{
+	if (job->frame_count == job->frames.num) {
+		AVFrame *frame = av_frame_alloc();
+		da_push_back(job->frames, &frame);
+	}
+
+	return job->frames.array[job->frame_count];
+}
+
+/**
+ * Pass a decoded frame to obs
+ *
+ * @note called without the mutex held by the only worker outputting
+ *
+ * @return false if the pixel format is not supported
+ */
+static bool output_frame(struct v4l2_decoder *d, AVFrame *frame)
+{
+	struct obs_source_frame2 *out = &d->out;
+	enum video_range_type range = d->range;
+
+	out->format = convert_pixel_format(frame->format);
+	if (out->format == VIDEO_FORMAT_NONE)
+		return false;
+
+	if (range == VIDEO_RANGE_DEFAULT)
+		range = (frame->color_range == AVCOL_RANGE_JPEG)
+				? VIDEO_RANGE_FULL
+				: VIDEO_RANGE_PARTIAL;
+
+	if (range != out->range) {
+		video_format_get_parameters(VIDEO_CS_DEFAULT, range,
+					    out->color_matrix,
+					    out->color_range_min,
+					    out->color_range_max);
+		out->range = range;
+	}
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		out->data[i] = frame->data[i];
+		out->linesize[i] = frame->linesize[i];
+	}
+
+	out->width = frame->width;
+	out->height = frame->height;
+	out->timestamp = (uint64_t)frame->pts;
+
+	obs_source_output_video2(d->source, out);
+	return true;
+}
+
+/**
+ * Output finished jobs at the head of the in flight list
+ *
+ * Workers finish out of order, so a job that completes early waits for the
+ * ones captured before it.  The frames are output without the mutex held,
+ * so that the capture thread is never blocked by the source.  A worker that
+ * finishes while another one is outputting leaves its job to that worker.
+ *
+ * @note called with the mutex held, returns with it held
+ */
+static void flush_done_jobs(struct v4l2_decode_worker *w)
+{
+	struct v4l2_decoder *d = w->decoder;
+
+	if (d->outputting)
+		return;
+
+	d->outputting = true;
+
+	for (;;) {
+		uint64_t decoded = 0;
+		uint64_t errors = 0;
+
+		da_resize(w->output, 0);
+		for (size_t i = 0; i < d->in_flight.num; i++) {
+			struct v4l2_decode_job *job = d->in_flight.array[i];
+			if (!job->done)
+				break;
+			da_push_back(w->output, &job);
+		}
+
+		if (!w->output.num)
+			break;
+
+		pthread_mutex_unlock(&d->mutex);
+
+		for (size_t i = 0; i < w->output.num; i++) {
+			struct v4l2_decode_job *job = w->output.array[i];
+
+			for (size_t j = 0; j < job->frame_count; j++) {
+				AVFrame *frame = job->frames.array[j];
+
+				if (output_frame(d, frame))
+					decoded++;
+				else
+					errors++;
+				av_frame_unref(frame);
+			}
+
+			job->frame_count = 0;
+			job->done = false;
+		}
+
+		pthread_mutex_lock(&d->mutex);
+
+		da_erase_range(d->in_flight, 0, w->output.num);
+		da_push_back_array(d->free_jobs, w->output.array,
+				   w->output.num);
+		d->decoded += decoded;
+		d->errors += errors;
+	}
+
+	d->outputting = false;
+}
+
+static void decode_job(struct v4l2_decode_worker *w,
+		       struct v4l2_decode_job *job)
+{
+	AVPacket packet;
+	int ret;
+
+	av_init_packet(&packet);
+	packet.data = job->data;
+	packet.size = (int)job->size;
+	packet.pts = job->pts;
+
+	job->frame_count = 0;
+
+	/* the decoder can return any number of frames per packet, including
+	 * none while it is still filling its buffers */
+	ret = avcodec_send_packet(w->context, &packet);
+	while (ret == 0) {
+		ret = avcodec_receive_frame(w->context, job_next_frame(job));
+		if (ret == 0)
+			job->frame_count++;
+	}
+
+	if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+		pthread_mutex_lock(&w->decoder->mutex);
+		w->decoder->errors++;
+		pthread_mutex_unlock(&w->decoder->mutex);
+	}
+}
+
+static void *decode_thread(void *vptr)
+{
+	struct v4l2_decode_worker *w = vptr;
+	struct v4l2_decoder *d = w->decoder;
+
+	os_set_thread_name("v4l2: decode");
+
+	while (os_sem_wait(d->sem) == 0) {
+		struct v4l2_decode_job *job;
+
+		pthread_mutex_lock(&d->mutex);
+		if (d->stop) {
+			pthread_mutex_unlock(&d->mutex);
+			break;
+		}
+		circlebuf_pop_front(&d->queue, &job, sizeof(job));
+		pthread_mutex_unlock(&d->mutex);
+
+		decode_job(w, job);
+
+		pthread_mutex_lock(&d->mutex);
+		job->done = true;
+		flush_done_jobs(w);
+		pthread_mutex_unlock(&d->mutex);
+	}
+
+	return NULL;
+}
+
+static bool init_worker(struct v4l2_decoder *d, struct v4l2_decode_worker *w)
+{
+	w->decoder = d;
+	w->context = avcodec_alloc_context3(d->codec);
+	if (!w->context)
+		return false;
+
+	if (d->codec->id == AV_CODEC_ID_H264) {
+		/* a single worker gets the whole stream, let libavcodec split
+		 * slices across threads without adding frame delay */
+		w->context->thread_count = 0;
+		w->context->thread_type = FF_THREAD_SLICE;
+		w->context->flags |= AV_CODEC_FLAG_LOW_DELAY;
+	} else {
+		w->context->thread_count = 1;
+	}
+
+	if (avcodec_open2(w->context, d->codec, NULL) < 0) {
+		blog(LOG_ERROR, "Failed to open %s decoder", d->codec->name);
+		return false;
+	}
+
+	if (pthread_create(&w->thread, NULL, decode_thread, w) != 0)
+		return false;
+
+	w->active = true;
+	return true;
+}
+
+struct v4l2_decoder *v4l2_decoder_create(obs_source_t *source,
+					 uint_fast32_t pixfmt, int width,
+					 int height,
+					 enum video_range_type range)
+{
+	struct v4l2_decoder *d = bzalloc(sizeof(struct v4l2_decoder));
+	enum AVCodecID id = v4l2_to_av_codec(pixfmt);
+
+	d->source = source;
+	d->range = range;
+	d->out.range = VIDEO_RANGE_DEFAULT;
+
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+	avcodec_register_all();
+#endif
+
+	d->codec = avcodec_find_decoder(id);
+	if (!d->codec) {
+		blog(LOG_ERROR, "No decoder found");
+		goto fail;
+	}
+
+	if (id == AV_CODEC_ID_H264) {
+		d->worker_count = 1;
+	} else {
+		/* a single core decodes 1080p MJPEG at about 100 fps */
+		int cores = os_get_logical_cores();
+		size_t wanted = ((size_t)width * height + 1920 * 1080 - 1) /
+				(1920 * 1080);
+
+		d->worker_count = wanted + 1;
+		if (d->worker_count > (size_t)(cores > 1 ? cores / 2 : 1))
+			d->worker_count = cores > 1 ? cores / 2 : 1;
+		if (d->worker_count > MAX_DECODE_WORKERS)
+			d->worker_count = MAX_DECODE_WORKERS;
+	}
+	d->max_jobs = (id == AV_CODEC_ID_H264)
+			      ? MAX_H264_FRAMES
+			      : d->worker_count * FRAMES_PER_WORKER;
+
+	if (pthread_mutex_init(&d->mutex, NULL) != 0)
+		goto fail;
+	d->mutex_valid = true;
+
+	if (os_sem_init(&d->sem, 0) != 0)
+		goto fail;
+
+	for (size_t i = 0; i < d->worker_count; i++) {
+		if (!init_worker(d, &d->workers[i]))
+			goto fail;
+	}
+
+	blog(LOG_INFO, "Decoding %s with %zu worker(s)", d->codec->name,
+	     d->worker_count);
+	return d;
+
+fail:
+	v4l2_decoder_destroy(d);
+	return NULL;
+}
+
+void v4l2_decoder_destroy(struct v4l2_decoder *d)
+{
+	if (!d)
+		return;
+
+	if (d->mutex_valid) {
+		pthread_mutex_lock(&d->mutex);
+		d->stop = true;
+		pthread_mutex_unlock(&d->mutex);
+	}
+
+	for (size_t i = 0; i < d->worker_count; i++) {
+		if (d->workers[i].active)
+			os_sem_post(d->sem);
+	}
+
+	for (size_t i = 0; i < d->worker_count; i++) {
+		struct v4l2_decode_worker *w = &d->workers[i];
+
+		if (w->active)
+			pthread_join(w->thread, NULL);
+		if (w->context) {
+			avcodec_close(w->context);
+			av_free(w->context);
+		}
+		da_free(w->output);
+	}
+
+	if (d->codec)
+		blog(LOG_INFO,
+		     "Decoded %" PRIu64 " frames, dropped %" PRIu64
+		     ", %" PRIu64 " errors",
+		     d->decoded, d->dropped, d->errors);
+
+	for (size_t i = 0; i < d->in_flight.num; i++)
+		job_free(d->in_flight.array[i]);
+	for (size_t i = 0; i < d->free_jobs.num; i++)
+		job_free(d->free_jobs.array[i]);
+
+	da_free(d->in_flight);
+	da_free(d->free_jobs);
+	circlebuf_free(&d->queue);
+
+	os_sem_destroy(d->sem);
+	if (d->mutex_valid)
+		pthread_mutex_destroy(&d->mutex);
+	bfree(d);
+}
+
+bool v4l2_decoder_push(struct v4l2_decoder *d, const uint8_t *data,
+		       size_t size, uint64_t timestamp)
+{
+	struct v4l2_decode_job *job = NULL;
+
+	pthread_mutex_lock(&d->mutex);
+
+	if (d->in_flight.num >= d->max_jobs) {
+		d->dropped++;
+		pthread_mutex_unlock(&d->mutex);
+		return false;
+	}
+
+	if (d->free_jobs.num) {
+		job = d->free_jobs.array[d->free_jobs.num - 1];
+		da_pop_back(d->free_jobs);
+	}
+
+	pthread_mutex_unlock(&d->mutex);
+
+	/* filling the job needs no lock, no worker can see it yet */
+	if (!job)
+		job = bzalloc(sizeof(struct v4l2_decode_job));
+
+	if (job->capacity < size + AV_INPUT_BUFFER_PADDING_SIZE) {
+		job->capacity = size + AV_INPUT_BUFFER_PADDING_SIZE;
+		job->data = brealloc(job->data, job->capacity);
+	}
+
+	memcpy(job->data, data, size);
+	memset(job->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+	job->size = size;
+	job->pts = (int64_t)timestamp;
+
+	pthread_mutex_lock(&d->mutex);
+	da_push_back(d->in_flight, &job);
+	circlebuf_push_back(&d->queue, &job, sizeof(job));
+	pthread_mutex_unlock(&d->mutex);
+
+	os_sem_post(d->sem);
+	return true;
+}
@@ -0,0 +1,77 @@
+/*
+Copyright (C) 2026 by agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <obs-module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pool of decode threads for compressed capture formats
+ *
+ * The capture thread only copies the compressed frame and hands it over, so
+ * the v4l2 buffer can be queued again right away. MJPEG frames are decoded
+ * in parallel by several workers, H.264 by a single worker since frames
+ * depend on each other. Decoded frames are passed to obs in capture order.
+ */
+struct v4l2_decoder;
+
+/**
+ * Create a decoder pool
+ *
+ * @param source source the decoded frames are output to
+ * @param pixfmt v4l2 pixel format of the compressed frames
+ * @param width width of the frames
+ * @param height height of the frames
+ * @param range color range, VIDEO_RANGE_DEFAULT to use the one signaled by
+ *              the stream
+ *
+ * @return NULL on error
+ */
+struct v4l2_decoder *v4l2_decoder_create(obs_source_t *source,
+					 uint_fast32_t pixfmt, int width,
+					 int height,
+					 enum video_range_type range);
+
+/**
+ * Stop the workers and destroy the pool
+ *
+ * Frames still queued are discarded.
+ */
+void v4l2_decoder_destroy(struct v4l2_decoder *decoder);
+
+/**
+ * Queue a compressed frame for decoding
+ *
+ * The data is copied, so the buffer can be reused once this returns. When
+ * all workers are busy and the queue is full the frame is dropped.
+ *
+ * @param data compressed frame
+ * @param size size of the compressed frame
+ * @param timestamp timestamp of the frame in nanoseconds
+ *
+ * @return false if the frame was dropped
+ */
+bool v4l2_decoder_push(struct v4l2_decoder *decoder, const uint8_t *data,
+		       size_t size, uint64_t timestamp);
+
+#ifdef __cplusplus
+}
+#endif
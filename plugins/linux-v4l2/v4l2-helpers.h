@@ -84,6 +84,24 @@ static inline enum video_format v4l2_to_obs_video_format(uint_fast32_t format)
 	}
 }
 
+/**
+ * Check if a v4l2 pixel format is a compressed format
+ *
+ * Compressed formats can only be captured when the plugin is built with
+ * decoding support.
+ */
+static inline bool v4l2_is_compressed_format(uint_fast32_t format)
+{
+	switch (format) {
+	case V4L2_PIX_FMT_MJPEG:
+	case V4L2_PIX_FMT_JPEG:
+	case V4L2_PIX_FMT_H264:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /**
  * Fixed framesizes for devices that don't support enumerating discrete values.
  *
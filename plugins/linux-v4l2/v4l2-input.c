@@ -41,6 +41,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "v4l2-udev.h"
 #endif
 
+#if HAVE_V4L2_DECODER
+#include "v4l2-decoder.h"
+#endif
+
 /* The new dv timing api was introduced in Linux 3.4
  * Currently we simply disable dv timings when this is not defined */
 #if !defined(VIDIOC_ENUM_DV_TIMINGS) || !defined(V4L2_IN_CAP_DV_TIMINGS)
@@ -85,12 +89,30 @@ struct v4l2_data {
 	int height;
 	int linesize;
 	struct v4l2_buffer_data buffers;
+
+#if HAVE_V4L2_DECODER
+	struct v4l2_decoder *decoder;
+#endif
 };
 
 /* forward declarations */
 static void v4l2_init(struct v4l2_data *data);
 static void v4l2_terminate(struct v4l2_data *data);
 
+/**
+ * Check if frames in the pixel format can be passed to obs
+ */
+static bool v4l2_format_supported(uint_fast32_t pixfmt)
+{
+	if (v4l2_to_obs_video_format(pixfmt) != VIDEO_FORMAT_NONE)
+		return true;
+#if HAVE_V4L2_DECODER
+	if (v4l2_is_compressed_format(pixfmt))
+		return true;
+#endif
+	return false;
+}
+
 /**
  * Prepare the output frame structure for obs and compute plane offsets
  *
@@ -198,9 +220,20 @@ static void *v4l2_thread(void *vptr)
 		out.timestamp -= first_ts;
 
 		start = (uint8_t *)data->buffers.info[buf.index].start;
-		for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i)
-			out.data[i] = start + plane_offsets[i];
-		obs_source_output_video(data->source, &out);
+
+#if HAVE_V4L2_DECODER
+		/* compressed frames are copied out so the buffer goes back
+		 * to the driver while the frame is still being decoded */
+		if (data->decoder) {
+			v4l2_decoder_push(data->decoder, start, buf.bytesused,
+					  out.timestamp);
+		} else
+#endif
+		{
+			for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i)
+				out.data[i] = start + plane_offsets[i];
+			obs_source_output_video(data->source, &out);
+		}
 
 		if (v4l2_ioctl(data->dev, VIDIOC_QBUF, &buf) < 0) {
 			blog(LOG_DEBUG, "failed to enqueue buffer");
@@ -393,8 +426,7 @@ static void v4l2_format_list(int dev, obs_property_t *prop)
 		if (fmt.flags & V4L2_FMT_FLAG_EMULATED)
 			dstr_cat(&buffer, " (Emulated)");
 
-		if (v4l2_to_obs_video_format(fmt.pixelformat) !=
-		    VIDEO_FORMAT_NONE) {
+		if (v4l2_format_supported(fmt.pixelformat)) {
 			obs_property_list_add_int(prop, buffer.array,
 						  fmt.pixelformat);
 			blog(LOG_INFO, "Pixelformat: %s (available)",
@@ -805,6 +837,11 @@ static void v4l2_terminate(struct v4l2_data *data)
 		data->thread = 0;
 	}
 
+#if HAVE_V4L2_DECODER
+	v4l2_decoder_destroy(data->decoder);
+	data->decoder = NULL;
+#endif
+
 	v4l2_destroy_mmap(&data->buffers);
 
 	if (data->dev != -1) {
@@ -895,7 +932,7 @@ static void v4l2_init(struct v4l2_data *data)
 		blog(LOG_ERROR, "Unable to set format");
 		goto fail;
 	}
-	if (v4l2_to_obs_video_format(data->pixfmt) == VIDEO_FORMAT_NONE) {
+	if (!v4l2_format_supported(data->pixfmt)) {
 		blog(LOG_ERROR, "Selected video format not supported");
 		goto fail;
 	}
@@ -918,6 +955,19 @@ static void v4l2_init(struct v4l2_data *data)
 		goto fail;
 	}
 
+#if HAVE_V4L2_DECODER
+	/* set up decoding for compressed formats */
+	if (v4l2_is_compressed_format(data->pixfmt)) {
+		data->decoder = v4l2_decoder_create(data->source, data->pixfmt,
+						    data->width, data->height,
+						    data->color_range);
+		if (!data->decoder) {
+			blog(LOG_ERROR, "Unable to create decoder");
+			goto fail;
+		}
+	}
+#endif
+
 	/* start the capture thread */
 	if (os_event_init(&data->event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
@@ -51,6 +51,10 @@ struct ffmpeg_source {
 	int buffering_mb;
 	int speed_percent;
 	bool is_looping;
+	bool seamless_loop;
+	int loop_cache_seconds;
+	int loop_cache_max_mb;
+	int preroll_max_mb;
 	bool is_local_file;
 	bool is_hw_decoding;
 	bool is_clear_on_media_end;
@@ -70,6 +74,11 @@ static bool is_local_file_modified(obs_properties_t *props,
 		obs_properties_get(props, "input_format");
 	obs_property_t *local_file = obs_properties_get(props, "local_file");
 	obs_property_t *looping = obs_properties_get(props, "looping");
+	obs_property_t *seamless = obs_properties_get(props, "seamless_loop");
+	obs_property_t *loop_cache =
+		obs_properties_get(props, "loop_cache_seconds");
+	obs_property_t *loop_cache_max =
+		obs_properties_get(props, "loop_cache_max_mb");
 	obs_property_t *buffering = obs_properties_get(props, "buffering_mb");
 	obs_property_t *close =
 		obs_properties_get(props, "close_when_inactive");
@@ -81,6 +90,9 @@ static bool is_local_file_modified(obs_properties_t *props,
 	obs_property_set_visible(close, enabled);
 	obs_property_set_visible(local_file, enabled);
 	obs_property_set_visible(looping, enabled);
+	obs_property_set_visible(seamless, enabled);
+	obs_property_set_visible(loop_cache, enabled);
+	obs_property_set_visible(loop_cache_max, enabled);
 	obs_property_set_visible(speed, enabled);
 	obs_property_set_visible(seekable, !enabled);
 
@@ -91,6 +103,9 @@ static void ffmpeg_source_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_bool(settings, "is_local_file", true);
 	obs_data_set_default_bool(settings, "looping", false);
+	obs_data_set_default_bool(settings, "seamless_loop", false);
+	obs_data_set_default_int(settings, "loop_cache_seconds", 0);
+	obs_data_set_default_int(settings, "loop_cache_max_mb", 1024);
 	obs_data_set_default_bool(settings, "clear_on_media_end", true);
 	obs_data_set_default_bool(settings, "restart_on_activate", true);
 	obs_data_set_default_int(settings, "buffering_mb", 2);
@@ -149,6 +164,25 @@ static obs_properties_t *ffmpeg_source_getproperties(void *data)
 	prop = obs_properties_add_bool(props, "looping",
 				       obs_module_text("Looping"));
 
+	prop = obs_properties_add_bool(props, "seamless_loop",
+				       obs_module_text("SeamlessLoop"));
+	obs_property_set_long_description(
+		prop, obs_module_text("SeamlessLoop.ToolTip"));
+
+	prop = obs_properties_add_int_slider(
+		props, "loop_cache_seconds",
+		obs_module_text("LoopCacheSeconds"), 0, 30, 1);
+	obs_property_int_set_suffix(prop, " s");
+	obs_property_set_long_description(
+		prop, obs_module_text("LoopCacheSeconds.ToolTip"));
+
+	prop = obs_properties_add_int_slider(
+		props, "loop_cache_max_mb",
+		obs_module_text("LoopCacheMaxMB"), 64, 4096, 64);
+	obs_property_int_set_suffix(prop, " MB");
+	obs_property_set_long_description(
+		prop, obs_module_text("LoopCacheMaxMB.ToolTip"));
+
 	obs_properties_add_bool(props, "restart_on_activate",
 				obs_module_text("RestartWhenActivated"));
 
@@ -209,13 +243,19 @@ static void dump_source_info(struct ffmpeg_source *s, const char *input,
 		"\tinput_format:            %s\n"
 		"\tspeed:                   %d\n"
 		"\tis_looping:              %s\n"
+		"\tseamless_loop:           %s\n"
+		"\tloop_cache_seconds:      %d\n"
+		"\tloop_cache_max_mb:       %d\n"
+		"\tpreroll_max_mb:          %d\n"
 		"\tis_hw_decoding:          %s\n"
 		"\tis_clear_on_media_end:   %s\n"
 		"\trestart_on_activate:     %s\n"
 		"\tclose_when_inactive:     %s",
 		input ? input : "(null)",
 		input_format ? input_format : "(null)", s->speed_percent,
-		s->is_looping ? "yes" : "no", s->is_hw_decoding ? "yes" : "no",
+		s->is_looping ? "yes" : "no", s->seamless_loop ? "yes" : "no",
+		s->loop_cache_seconds, s->loop_cache_max_mb, s->preroll_max_mb,
+		s->is_hw_decoding ? "yes" : "no",
 		s->is_clear_on_media_end ? "yes" : "no",
 		s->restart_on_activate ? "yes" : "no",
 		s->close_when_inactive ? "yes" : "no");
@@ -268,7 +308,12 @@ static void ffmpeg_source_open(struct ffmpeg_source *s)
 			.speed = s->speed_percent,
 			.force_range = s->range,
 			.hardware_decoding = s->is_hw_decoding,
-			.is_local_file = s->is_local_file || s->seekable};
+			.is_local_file = s->is_local_file || s->seekable,
+			.seamless_loop = s->is_looping && s->seamless_loop,
+			.loop_cache_seconds =
+				s->is_looping ? s->loop_cache_seconds : 0,
+			.loop_cache_max_mb = s->loop_cache_max_mb,
+			.preroll_max_mb = s->preroll_max_mb};
 
 		s->media_valid = mp_media_init(&s->media, &info);
 	}
@@ -316,13 +361,28 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 		input = (char *)obs_data_get_string(settings, "local_file");
 		input_format = NULL;
 		s->is_looping = obs_data_get_bool(settings, "looping");
+		s->seamless_loop =
+			obs_data_get_bool(settings, "seamless_loop");
+		s->loop_cache_seconds =
+			(int)obs_data_get_int(settings, "loop_cache_seconds");
+		s->loop_cache_max_mb =
+			(int)obs_data_get_int(settings, "loop_cache_max_mb");
 		s->close_when_inactive =
 			obs_data_get_bool(settings, "close_when_inactive");
+
+		/* not exposed in the properties, set by sources that play
+		 * short clips on demand such as the stinger transition */
+		s->preroll_max_mb =
+			(int)obs_data_get_int(settings, "preroll_max_mb");
 	} else {
 		input = (char *)obs_data_get_string(settings, "input");
 		input_format =
 			(char *)obs_data_get_string(settings, "input_format");
 		s->is_looping = false;
+		s->seamless_loop = false;
+		s->loop_cache_seconds = 0;
+		s->loop_cache_max_mb = 0;
+		s->preroll_max_mb = 0;
 		s->close_when_inactive = true;
 	}
 
@@ -495,7 +555,8 @@ struct obs_source_info ffmpeg_source = {
 	.id = "ffmpeg_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
 	.output_flags = OBS_SOURCE_ASYNC_VIDEO | OBS_SOURCE_AUDIO |
-			OBS_SOURCE_DO_NOT_DUPLICATE,
+			OBS_SOURCE_DO_NOT_DUPLICATE |
+			OBS_SOURCE_BACKGROUND_TICK | OBS_SOURCE_THREADED_TICK,
 	.get_name = ffmpeg_source_getname,
 	.create = ffmpeg_source_create,
 	.destroy = ffmpeg_source_destroy,
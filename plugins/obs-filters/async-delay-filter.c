@@ -10,14 +10,45 @@
 #endif
 
 #define SETTING_DELAY_MS "delay_ms"
+#define SETTING_STORAGE "storage"
 
 #define TEXT_DELAY_MS obs_module_text("DelayMs")
+#define TEXT_STORAGE obs_module_text("DelayStorage")
+#define TEXT_STORAGE_FULL obs_module_text("DelayStorage.Full")
+#define TEXT_STORAGE_COMPACT obs_module_text("DelayStorage.Compact")
+
+enum delay_storage {
+	DELAY_STORAGE_FULL,
+	DELAY_STORAGE_COMPACT,
+};
+
+/* a delayed frame copied out of the source's frame cache.  4:2:2 and 4:4:4
+ * frames are stored as 4:2:0, everything else is stored as-is. */
+struct compact_frame {
+	uint8_t *data;
+	size_t size;
+	uint64_t timestamp;
+};
 
 struct async_delay_data {
 	obs_source_t *context;
 
-	/* contains struct obs_source_frame* */
+	/* contains struct obs_source_frame*, or struct compact_frame when
+	 * storing compact frames */
 	struct circlebuf video_frames;
+	enum delay_storage storage;
+
+	/* set by update, applied by the video path once the frames stored
+	 * with the previous layout are freed */
+	enum delay_storage next_storage;
+	enum video_format compact_format;
+	uint32_t compact_width;
+	uint32_t compact_height;
+	size_t stored_bytes;
+	size_t max_stored_bytes;
+
+	/* buffer of the last frame output, reused to store the next one */
+	struct compact_frame spare;
 
 	/* stores the audio data */
 	struct circlebuf audio_frames;
@@ -39,9 +70,32 @@ static const char *async_delay_filter_name(void *unused)
 	return obs_module_text("AsyncDelayFilter");
 }
 
+static void free_compact_frames(struct async_delay_data *filter)
+{
+	while (filter->video_frames.size) {
+		struct compact_frame frame;
+
+		circlebuf_pop_front(&filter->video_frames, &frame,
+				    sizeof(frame));
+		bfree(frame.data);
+	}
+
+	bfree(filter->spare.data);
+	filter->spare.data = NULL;
+	filter->spare.size = 0;
+
+	filter->stored_bytes = 0;
+	filter->max_stored_bytes = 0;
+}
+
 static void free_video_data(struct async_delay_data *filter,
 			    obs_source_t *parent)
 {
+	if (filter->storage == DELAY_STORAGE_COMPACT) {
+		free_compact_frames(filter);
+		return;
+	}
+
 	while (filter->video_frames.size) {
 		struct obs_source_frame *frame;
 
@@ -75,9 +129,12 @@ static void async_delay_filter_update(void *data, obs_data_t *settings)
 	uint64_t new_interval =
 		(uint64_t)obs_data_get_int(settings, SETTING_DELAY_MS) *
 		MSEC_TO_NSEC;
+	enum delay_storage storage =
+		(enum delay_storage)obs_data_get_int(settings, SETTING_STORAGE);
 
-	if (new_interval < filter->interval)
-		free_video_data(filter, obs_filter_get_parent(filter->context));
+	/* the video thread may be storing frames right now, so the stored
+	 * frames are only freed there, on the reset */
+	filter->next_storage = storage;
 
 	filter->reset_audio = true;
 	filter->reset_video = true;
@@ -94,6 +151,7 @@ static void *async_delay_filter_create(obs_data_t *settings,
 
 	filter->context = context;
 	async_delay_filter_update(filter, settings);
+	filter->storage = filter->next_storage;
 
 	obs_get_audio_info(&oai);
 	filter->samplerate = oai.samples_per_sec;
@@ -106,6 +164,8 @@ static void async_delay_filter_destroy(void *data)
 	struct async_delay_data *filter = data;
 
 	free_audio_packet(&filter->audio_output);
+	if (filter->storage == DELAY_STORAGE_COMPACT)
+		free_compact_frames(filter);
 	circlebuf_free(&filter->video_frames);
 	circlebuf_free(&filter->audio_frames);
 	bfree(data);
@@ -119,10 +179,22 @@ static obs_properties_t *async_delay_filter_properties(void *data)
 						   TEXT_DELAY_MS, 0, 20000, 1);
 	obs_property_int_set_suffix(p, " ms");
 
+	p = obs_properties_add_list(props, SETTING_STORAGE, TEXT_STORAGE,
+				    OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, TEXT_STORAGE_FULL, DELAY_STORAGE_FULL);
+	obs_property_list_add_int(p, TEXT_STORAGE_COMPACT,
+				  DELAY_STORAGE_COMPACT);
+
 	UNUSED_PARAMETER(data);
 	return props;
 }
 
+static void async_delay_filter_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, SETTING_STORAGE,
+				 DELAY_STORAGE_FULL);
+}
+
 static void async_delay_filter_remove(void *data, obs_source_t *parent)
 {
 	struct async_delay_data *filter = data;
@@ -140,6 +212,322 @@ static inline bool is_timestamp_jump(uint64_t ts, uint64_t prev_ts)
 	return ts < prev_ts || (ts - prev_ts) > SEC_TO_NSEC;
 }
 
+/* ------------------------------------------------------------------------- */
+/* compact storage */
+
+static inline bool is_compact_format(enum video_format format)
+{
+	return format == VIDEO_FORMAT_YUY2 || format == VIDEO_FORMAT_UYVY ||
+	       format == VIDEO_FORMAT_YVYU || format == VIDEO_FORMAT_I422 ||
+	       format == VIDEO_FORMAT_I444;
+}
+
+static inline bool has_half_height_chroma(enum video_format format)
+{
+	return format == VIDEO_FORMAT_I420 || format == VIDEO_FORMAT_NV12 ||
+	       format == VIDEO_FORMAT_I40A || format == VIDEO_FORMAT_I010 ||
+	       format == VIDEO_FORMAT_P010;
+}
+
+static inline size_t get_plane_size(const struct obs_source_frame *frame,
+				    size_t plane)
+{
+	uint32_t lines = frame->height;
+	if (has_half_height_chroma(frame->format) && (plane == 1 || plane == 2))
+		lines = (lines + 1) / 2;
+
+	return (size_t)frame->linesize[plane] * lines;
+}
+
+static inline size_t get_compact_size(const struct obs_source_frame *frame)
+{
+	size_t size = 0;
+
+	if (is_compact_format(frame->format)) {
+		size_t cx = (frame->width + 1) / 2;
+		size_t cy = (frame->height + 1) / 2;
+		return (size_t)frame->width * frame->height + cx * cy * 2;
+	}
+
+	for (size_t i = 0; i < MAX_AV_PLANES && frame->data[i]; i++)
+		size += get_plane_size(frame, i);
+	return size;
+}
+
+/* byte offsets of Y0, U, Y1 and V within a packed 4:2:2 macropixel */
+static inline void get_packed_offsets(enum video_format format, size_t *y0,
+				      size_t *u, size_t *y1, size_t *v)
+{
+	switch (format) {
+	case VIDEO_FORMAT_UYVY:
+		*u = 0, *y0 = 1, *v = 2, *y1 = 3;
+		break;
+	case VIDEO_FORMAT_YVYU:
+		*y0 = 0, *v = 1, *y1 = 2, *u = 3;
+		break;
+	default:
+		*y0 = 0, *u = 1, *y1 = 2, *v = 3;
+	}
+}
+
+static inline uint8_t avg2(uint8_t a, uint8_t b)
+{
+	return (uint8_t)(((uint32_t)a + b + 1) >> 1);
+}
+
+static inline uint8_t avg4(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	return (uint8_t)(((uint32_t)a + b + c + d + 2) >> 2);
+}
+
+static void pack_packed422(const struct obs_source_frame *frame, uint8_t *y,
+			   uint8_t *u, uint8_t *v)
+{
+	size_t cx = (frame->width + 1) / 2;
+	size_t o_y0, o_u, o_y1, o_v;
+
+	get_packed_offsets(frame->format, &o_y0, &o_u, &o_y1, &o_v);
+
+	for (uint32_t row = 0; row < frame->height; row++) {
+		const uint8_t *in = frame->data[0] + row * frame->linesize[0];
+		const uint8_t *next = row + 1 < frame->height
+					      ? in + frame->linesize[0]
+					      : in;
+		uint8_t *y_out = y + row * frame->width;
+		bool chroma_row = (row & 1) == 0;
+
+		for (size_t x = 0; x < cx; x++) {
+			const uint8_t *px = in + x * 4;
+
+			y_out[x * 2] = px[o_y0];
+			if (x * 2 + 1 < frame->width)
+				y_out[x * 2 + 1] = px[o_y1];
+
+			if (chroma_row) {
+				size_t c = (row / 2) * cx + x;
+				u[c] = avg2(px[o_u], next[x * 4 + o_u]);
+				v[c] = avg2(px[o_v], next[x * 4 + o_v]);
+			}
+		}
+	}
+}
+
+static void unpack_packed422(struct obs_source_frame *frame, const uint8_t *y,
+			     const uint8_t *u, const uint8_t *v)
+{
+	size_t cx = (frame->width + 1) / 2;
+	size_t o_y0, o_u, o_y1, o_v;
+
+	get_packed_offsets(frame->format, &o_y0, &o_u, &o_y1, &o_v);
+
+	for (uint32_t row = 0; row < frame->height; row++) {
+		uint8_t *out = frame->data[0] + row * frame->linesize[0];
+		const uint8_t *y_in = y + row * frame->width;
+		const uint8_t *u_in = u + (row / 2) * cx;
+		const uint8_t *v_in = v + (row / 2) * cx;
+
+		for (size_t x = 0; x < cx; x++) {
+			uint8_t *px = out + x * 4;
+
+			px[o_y0] = y_in[x * 2];
+			px[o_y1] = x * 2 + 1 < frame->width ? y_in[x * 2 + 1]
+							    : y_in[x * 2];
+			px[o_u] = u_in[x];
+			px[o_v] = v_in[x];
+		}
+	}
+}
+
+static void pack_chroma_plane(const struct obs_source_frame *frame,
+			      size_t plane, uint8_t *out)
+{
+	bool full_width = frame->format == VIDEO_FORMAT_I444;
+	size_t cx = (frame->width + 1) / 2;
+	size_t cy = (frame->height + 1) / 2;
+	uint32_t linesize = frame->linesize[plane];
+
+	for (size_t row = 0; row < cy; row++) {
+		size_t next_row = row * 2 + 1 < frame->height ? row * 2 + 1
+							      : row * 2;
+		const uint8_t *in0 = frame->data[plane] + row * 2 * linesize;
+		const uint8_t *in1 = frame->data[plane] + next_row * linesize;
+
+		for (size_t x = 0; x < cx; x++) {
+			if (full_width) {
+				size_t x1 = x * 2 + 1 < frame->width ? x * 2 + 1
+								     : x * 2;
+				out[x] = avg4(in0[x * 2], in0[x1], in1[x * 2],
+					      in1[x1]);
+			} else {
+				out[x] = avg2(in0[x], in1[x]);
+			}
+		}
+
+		out += cx;
+	}
+}
+
+static void unpack_chroma_plane(struct obs_source_frame *frame, size_t plane,
+				const uint8_t *in)
+{
+	bool full_width = frame->format == VIDEO_FORMAT_I444;
+	size_t cx = (frame->width + 1) / 2;
+	uint32_t linesize = frame->linesize[plane];
+
+	for (uint32_t row = 0; row < frame->height; row++) {
+		uint8_t *out = frame->data[plane] + row * linesize;
+		const uint8_t *line = in + (row / 2) * cx;
+
+		if (!full_width) {
+			memcpy(out, line, cx);
+			continue;
+		}
+
+		for (uint32_t x = 0; x < frame->width; x++)
+			out[x] = line[x / 2];
+	}
+}
+
+static void pack_frame(const struct obs_source_frame *frame, uint8_t *data)
+{
+	size_t luma_size = (size_t)frame->width * frame->height;
+	size_t chroma_size = ((frame->width + 1) / 2) *
+			     (size_t)((frame->height + 1) / 2);
+
+	if (!is_compact_format(frame->format)) {
+		for (size_t i = 0; i < MAX_AV_PLANES && frame->data[i]; i++) {
+			size_t size = get_plane_size(frame, i);
+			memcpy(data, frame->data[i], size);
+			data += size;
+		}
+		return;
+	}
+
+	if (frame->format != VIDEO_FORMAT_I422 &&
+	    frame->format != VIDEO_FORMAT_I444) {
+		pack_packed422(frame, data, data + luma_size,
+			       data + luma_size + chroma_size);
+		return;
+	}
+
+	for (uint32_t row = 0; row < frame->height; row++)
+		memcpy(data + row * frame->width,
+		       frame->data[0] + row * frame->linesize[0], frame->width);
+
+	pack_chroma_plane(frame, 1, data + luma_size);
+	pack_chroma_plane(frame, 2, data + luma_size + chroma_size);
+}
+
+static void unpack_frame(struct obs_source_frame *frame, const uint8_t *data)
+{
+	size_t luma_size = (size_t)frame->width * frame->height;
+	size_t chroma_size = ((frame->width + 1) / 2) *
+			     (size_t)((frame->height + 1) / 2);
+
+	if (!is_compact_format(frame->format)) {
+		for (size_t i = 0; i < MAX_AV_PLANES && frame->data[i]; i++) {
+			size_t size = get_plane_size(frame, i);
+			memcpy(frame->data[i], data, size);
+			data += size;
+		}
+		return;
+	}
+
+	if (frame->format != VIDEO_FORMAT_I422 &&
+	    frame->format != VIDEO_FORMAT_I444) {
+		unpack_packed422(frame, data, data + luma_size,
+				 data + luma_size + chroma_size);
+		return;
+	}
+
+	for (uint32_t row = 0; row < frame->height; row++)
+		memcpy(frame->data[0] + row * frame->linesize[0],
+		       data + row * frame->width, frame->width);
+
+	unpack_chroma_plane(frame, 1, data + luma_size);
+	unpack_chroma_plane(frame, 2, data + luma_size + chroma_size);
+}
+
+static inline bool compact_format_changed(struct async_delay_data *filter,
+					  const struct obs_source_frame *frame)
+{
+	return filter->compact_format != frame->format ||
+	       filter->compact_width != frame->width ||
+	       filter->compact_height != frame->height;
+}
+
+/* the incoming frame is copied into compact storage and handed back to the
+ * source right away, and the oldest delayed frame is unpacked into it, so
+ * the source's frame cache does not have to hold the whole delay */
+static struct obs_source_frame *
+async_delay_filter_video_compact(struct async_delay_data *filter,
+				 struct obs_source_frame *frame)
+{
+	obs_source_t *parent = obs_filter_get_parent(filter->context);
+	struct compact_frame stored;
+	struct compact_frame output;
+	uint64_t cur_interval;
+
+	if (filter->reset_video ||
+	    is_timestamp_jump(frame->timestamp, filter->last_video_ts) ||
+	    compact_format_changed(filter, frame)) {
+		free_compact_frames(filter);
+		filter->compact_format = frame->format;
+		filter->compact_width = frame->width;
+		filter->compact_height = frame->height;
+		filter->video_delay_reached = false;
+		filter->reset_video = false;
+	}
+
+	filter->last_video_ts = frame->timestamp;
+
+	stored.size = get_compact_size(frame);
+	if (filter->spare.data && filter->spare.size == stored.size) {
+		stored.data = filter->spare.data;
+		filter->spare.data = NULL;
+	} else {
+		stored.data = bmalloc(stored.size);
+	}
+	stored.timestamp = frame->timestamp;
+	pack_frame(frame, stored.data);
+
+	filter->stored_bytes += stored.size;
+	if (filter->stored_bytes > filter->max_stored_bytes)
+		filter->max_stored_bytes = filter->stored_bytes;
+
+	circlebuf_push_back(&filter->video_frames, &stored, sizeof(stored));
+	circlebuf_peek_front(&filter->video_frames, &output, sizeof(output));
+
+	cur_interval = frame->timestamp - output.timestamp;
+	if (!filter->video_delay_reached && cur_interval < filter->interval) {
+		obs_source_release_frame(parent, frame);
+		return NULL;
+	}
+
+	circlebuf_pop_front(&filter->video_frames, NULL, sizeof(output));
+	filter->stored_bytes -= output.size;
+
+	if (!filter->video_delay_reached) {
+		filter->video_delay_reached = true;
+		blog(LOG_INFO,
+		     "[async_delay_filter: '%s'] Delaying %d frames in "
+		     "%d KB of compact storage",
+		     obs_source_get_name(filter->context),
+		     (int)(filter->video_frames.size / sizeof(output)),
+		     (int)(filter->max_stored_bytes / 1024));
+	}
+
+	unpack_frame(frame, output.data);
+	frame->timestamp = output.timestamp;
+
+	bfree(filter->spare.data);
+	filter->spare = output;
+
+	return frame;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static struct obs_source_frame *
 async_delay_filter_video(void *data, struct obs_source_frame *frame)
 {
@@ -148,6 +536,14 @@ async_delay_filter_video(void *data, struct obs_source_frame *frame)
 	struct obs_source_frame *output;
 	uint64_t cur_interval;
 
+	if (filter->storage != filter->next_storage) {
+		free_video_data(filter, parent);
+		filter->storage = filter->next_storage;
+	}
+
+	if (filter->storage == DELAY_STORAGE_COMPACT)
+		return async_delay_filter_video_compact(filter, frame);
+
 	if (filter->reset_video ||
 	    is_timestamp_jump(frame->timestamp, filter->last_video_ts)) {
 		free_video_data(filter, parent);
@@ -238,6 +634,7 @@ struct obs_source_info async_delay_filter = {
 	.destroy = async_delay_filter_destroy,
 	.update = async_delay_filter_update,
 	.get_properties = async_delay_filter_properties,
+	.get_defaults = async_delay_filter_defaults,
 	.filter_video = async_delay_filter_video,
 #ifdef DELAY_AUDIO
 	.filter_audio = async_delay_filter_audio,
@@ -356,6 +356,21 @@ static void color_correction_filter_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+/*
+ * Describes what the render function above does to each pixel, so that OBS
+ * can draw this filter in the same pass as other color filters next to it.
+ */
+static bool color_correction_filter_get_pointwise(
+	void *data, struct obs_filter_pointwise *op)
+{
+	struct color_correction_filter_data *filter = data;
+
+	op->ops = OBS_POINTWISE_GAMMA | OBS_POINTWISE_COLOR_MATRIX;
+	op->gamma = filter->gamma;
+	op->color_matrix = filter->final_matrix;
+	return true;
+}
+
 /*
  * This function sets the interface. the types (add_*_Slider), the type of
  * data collected (int), the internal name, user-facing name, minimum,
@@ -425,4 +440,5 @@ struct obs_source_info color_filter = {
 	.update = color_correction_filter_update,
 	.get_properties = color_correction_filter_properties,
 	.get_defaults = color_correction_filter_defaults,
+	.filter_get_pointwise = color_correction_filter_get_pointwise,
 };
@@ -154,6 +154,20 @@ static void color_grade_filter_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static bool color_grade_filter_get_pointwise(void *data,
+					     struct obs_filter_pointwise *op)
+{
+	struct lut_filter_data *filter = data;
+
+	if (!filter->target)
+		return false;
+
+	op->ops = OBS_POINTWISE_CLUT;
+	op->clut = filter->target;
+	op->clut_amount = filter->clut_amount;
+	return true;
+}
+
 struct obs_source_info color_grade_filter = {
 	.id = "clut_filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
@@ -165,4 +179,5 @@ struct obs_source_info color_grade_filter = {
 	.get_defaults = color_grade_filter_defaults,
 	.get_properties = color_grade_filter_properties,
 	.video_render = color_grade_filter_render,
+	.filter_get_pointwise = color_grade_filter_get_pointwise,
 };
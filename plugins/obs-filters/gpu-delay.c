@@ -2,16 +2,35 @@
 #include <util/circlebuf.h>
 
 #define S_DELAY_MS "delay_ms"
+#define S_STORAGE "storage"
 #define T_DELAY_MS obs_module_text("DelayMs")
+#define T_STORAGE obs_module_text("DelayStorage")
+#define T_STORAGE_FULL obs_module_text("DelayStorage.Full")
+#define T_STORAGE_COMPACT obs_module_text("DelayStorage.Compact")
+#define T_STORAGE_COMPACT_OPAQUE \
+	obs_module_text("DelayStorage.CompactOpaque")
+
+/* compact storage keeps frames as full size luma (plus alpha) and half size
+ * chroma textures instead of RGBA, for 2.5 or 1.5 bytes per pixel instead
+ * of 4 */
+enum delay_storage {
+	DELAY_STORAGE_FULL,
+	DELAY_STORAGE_COMPACT,
+	DELAY_STORAGE_COMPACT_OPAQUE,
+};
 
 struct frame {
 	gs_texrender_t *render;
+	gs_texrender_t *chroma;
 	uint64_t ts;
 };
 
 struct gpu_delay_filter_data {
 	obs_source_t *context;
 	struct circlebuf frames;
+	enum delay_storage storage;
+	gs_texrender_t *capture;
+	gs_effect_t *pack_effect;
 	uint64_t delay_ns;
 	uint64_t interval_ns;
 	uint32_t cx;
@@ -20,19 +39,80 @@ struct gpu_delay_filter_data {
 	bool processed_frame;
 };
 
+/* shared by all instances, only used within the graphics context */
+static gs_effect_t *pack_effect = NULL;
+static long pack_effect_refs = 0;
+
+static gs_effect_t *pack_effect_acquire(void)
+{
+	if (!pack_effect_refs++) {
+		char *effect_path = obs_module_file("delay_pack.effect");
+		pack_effect = gs_effect_create_from_file(effect_path, NULL);
+		bfree(effect_path);
+	}
+
+	return pack_effect;
+}
+
+static void pack_effect_release(void)
+{
+	if (pack_effect_refs && !--pack_effect_refs) {
+		gs_effect_destroy(pack_effect);
+		pack_effect = NULL;
+	}
+}
+
 static const char *gpu_delay_filter_get_name(void *unused)
 {
 	UNUSED_PARAMETER(unused);
 	return obs_module_text("GPUDelayFilter");
 }
 
+static void create_frame(struct gpu_delay_filter_data *f, struct frame *frame)
+{
+	switch (f->storage) {
+	case DELAY_STORAGE_COMPACT:
+		frame->render = gs_texrender_create(GS_R8G8, GS_ZS_NONE);
+		frame->chroma = gs_texrender_create(GS_R8G8, GS_ZS_NONE);
+		break;
+	case DELAY_STORAGE_COMPACT_OPAQUE:
+		frame->render = gs_texrender_create(GS_R8, GS_ZS_NONE);
+		frame->chroma = gs_texrender_create(GS_R8G8, GS_ZS_NONE);
+		break;
+	default:
+		frame->render = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		frame->chroma = NULL;
+	}
+}
+
+static void destroy_frame(struct frame *frame)
+{
+	gs_texrender_destroy(frame->render);
+	gs_texrender_destroy(frame->chroma);
+}
+
+static size_t get_frame_size(struct gpu_delay_filter_data *f)
+{
+	size_t pixels = (size_t)f->cx * f->cy;
+	size_t chroma = (size_t)((f->cx + 1) / 2) * ((f->cy + 1) / 2);
+
+	switch (f->storage) {
+	case DELAY_STORAGE_COMPACT:
+		return pixels * 2 + chroma * 2;
+	case DELAY_STORAGE_COMPACT_OPAQUE:
+		return pixels + chroma * 2;
+	default:
+		return pixels * 4;
+	}
+}
+
 static void free_textures(struct gpu_delay_filter_data *f)
 {
 	obs_enter_graphics();
 	while (f->frames.size) {
 		struct frame frame;
 		circlebuf_pop_front(&f->frames, &frame, sizeof(frame));
-		gs_texrender_destroy(frame.render);
+		destroy_frame(&frame);
 	}
 	circlebuf_free(&f->frames);
 	obs_leave_graphics();
@@ -64,8 +144,7 @@ static void update_interval(struct gpu_delay_filter_data *f,
 		for (size_t i = prev_num; i < num; i++) {
 			struct frame *frame =
 				circlebuf_data(&f->frames, i * sizeof(*frame));
-			frame->render =
-				gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+			create_frame(f, frame);
 		}
 
 		obs_leave_graphics();
@@ -76,11 +155,19 @@ static void update_interval(struct gpu_delay_filter_data *f,
 		while (num_frames(&f->frames) > num) {
 			struct frame frame;
 			circlebuf_pop_front(&f->frames, &frame, sizeof(frame));
-			gs_texrender_destroy(frame.render);
+			destroy_frame(&frame);
 		}
 
 		obs_leave_graphics();
+	} else {
+		return;
 	}
+
+	blog(LOG_INFO,
+	     "[gpu_delay: '%s'] Delaying %d frames using %d KB of video "
+	     "memory",
+	     obs_source_get_name(f->context), (int)num,
+	     (int)(num * get_frame_size(f) / 1024));
 }
 
 static inline void check_interval(struct gpu_delay_filter_data *f)
@@ -136,6 +223,10 @@ static void gpu_delay_filter_update(void *data, obs_data_t *s)
 	struct gpu_delay_filter_data *f = data;
 
 	f->delay_ns = (uint64_t)obs_data_get_int(s, S_DELAY_MS) * 1000000ULL;
+	f->storage = (enum delay_storage)obs_data_get_int(s, S_STORAGE);
+
+	if (!f->pack_effect)
+		f->storage = DELAY_STORAGE_FULL;
 
 	/* full reset */
 	f->cx = 0;
@@ -152,16 +243,34 @@ static obs_properties_t *gpu_delay_filter_properties(void *data)
 						   T_DELAY_MS, 0, 500, 1);
 	obs_property_int_set_suffix(p, " ms");
 
+	p = obs_properties_add_list(props, S_STORAGE, T_STORAGE,
+				    OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p, T_STORAGE_FULL, DELAY_STORAGE_FULL);
+	obs_property_list_add_int(p, T_STORAGE_COMPACT, DELAY_STORAGE_COMPACT);
+	obs_property_list_add_int(p, T_STORAGE_COMPACT_OPAQUE,
+				  DELAY_STORAGE_COMPACT_OPAQUE);
+
 	UNUSED_PARAMETER(data);
 	return props;
 }
 
+static void gpu_delay_filter_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, S_STORAGE, DELAY_STORAGE_FULL);
+}
+
 static void *gpu_delay_filter_create(obs_data_t *settings,
 				     obs_source_t *context)
 {
 	struct gpu_delay_filter_data *f = bzalloc(sizeof(*f));
+
 	f->context = context;
 
+	obs_enter_graphics();
+	f->capture = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	f->pack_effect = pack_effect_acquire();
+	obs_leave_graphics();
+
 	obs_source_update(context, settings);
 	return f;
 }
@@ -171,6 +280,12 @@ static void gpu_delay_filter_destroy(void *data)
 	struct gpu_delay_filter_data *f = data;
 
 	free_textures(f);
+
+	obs_enter_graphics();
+	gs_texrender_destroy(f->capture);
+	pack_effect_release();
+	obs_leave_graphics();
+
 	bfree(f);
 }
 
@@ -187,11 +302,37 @@ static void gpu_delay_filter_tick(void *data, float t)
 	check_interval(f);
 }
 
+static void draw_compact_frame(struct gpu_delay_filter_data *f,
+			       struct frame *frame)
+{
+	gs_effect_t *effect = f->pack_effect;
+	gs_texture_t *tex = gs_texrender_get_texture(frame->render);
+	gs_texture_t *chroma = gs_texrender_get_texture(frame->chroma);
+	const char *tech = f->storage == DELAY_STORAGE_COMPACT ? "UnpackA"
+							       : "Unpack";
+
+	if (!tex || !chroma)
+		return;
+
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"),
+			      tex);
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image1"),
+			      chroma);
+
+	while (gs_effect_loop(effect, tech))
+		gs_draw_sprite(tex, 0, f->cx, f->cy);
+}
+
 static void draw_frame(struct gpu_delay_filter_data *f)
 {
 	struct frame frame;
 	circlebuf_peek_front(&f->frames, &frame, sizeof(frame));
 
+	if (frame.chroma) {
+		draw_compact_frame(f, &frame);
+		return;
+	}
+
 	gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 	gs_texture_t *tex = gs_texrender_get_texture(frame.render);
 	if (tex) {
@@ -204,6 +345,60 @@ static void draw_frame(struct gpu_delay_filter_data *f)
 	}
 }
 
+static void render_target(gs_texrender_t *render, uint32_t cx, uint32_t cy,
+			  obs_source_t *target, obs_source_t *parent)
+{
+	gs_texrender_reset(render);
+
+	if (gs_texrender_begin(render, cx, cy)) {
+		uint32_t parent_flags = obs_source_get_output_flags(target);
+		bool custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
+		bool async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
+		struct vec4 clear_color;
+
+		vec4_zero(&clear_color);
+		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+		gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+
+		if (target == parent && !custom_draw && !async)
+			obs_source_default_render(target);
+		else
+			obs_source_video_render(target);
+
+		gs_texrender_end(render);
+	}
+}
+
+static void pack_plane(struct gpu_delay_filter_data *f, gs_texrender_t *render,
+		       const char *tech, uint32_t cx, uint32_t cy)
+{
+	gs_texture_t *tex = gs_texrender_get_texture(f->capture);
+	gs_eparam_t *image =
+		gs_effect_get_param_by_name(f->pack_effect, "image");
+
+	gs_texrender_reset(render);
+
+	if (tex && gs_texrender_begin(render, cx, cy)) {
+		gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+		gs_effect_set_texture(image, tex);
+
+		while (gs_effect_loop(f->pack_effect, tech))
+			gs_draw_sprite(tex, 0, cx, cy);
+
+		gs_texrender_end(render);
+	}
+}
+
+static void pack_frame(struct gpu_delay_filter_data *f, struct frame *frame)
+{
+	const char *tech = f->storage == DELAY_STORAGE_COMPACT ? "PackYA"
+							       : "PackY";
+
+	pack_plane(f, frame->render, tech, f->cx, f->cy);
+	pack_plane(f, frame->chroma, "PackUV", (f->cx + 1) / 2,
+		   (f->cy + 1) / 2);
+}
+
 static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
 {
 	struct gpu_delay_filter_data *f = data;
@@ -223,28 +418,14 @@ static void gpu_delay_filter_render(void *data, gs_effect_t *effect)
 	struct frame frame;
 	circlebuf_pop_front(&f->frames, &frame, sizeof(frame));
 
-	gs_texrender_reset(frame.render);
-
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
 
-	if (gs_texrender_begin(frame.render, f->cx, f->cy)) {
-		uint32_t parent_flags = obs_source_get_output_flags(target);
-		bool custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
-		bool async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
-		struct vec4 clear_color;
-
-		vec4_zero(&clear_color);
-		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
-		gs_ortho(0.0f, (float)f->cx, 0.0f, (float)f->cy, -100.0f,
-			 100.0f);
-
-		if (target == parent && !custom_draw && !async)
-			obs_source_default_render(target);
-		else
-			obs_source_video_render(target);
-
-		gs_texrender_end(frame.render);
+	if (frame.chroma) {
+		render_target(f->capture, f->cx, f->cy, target, parent);
+		pack_frame(f, &frame);
+	} else {
+		render_target(frame.render, f->cx, f->cy, target, parent);
 	}
 
 	gs_blend_state_pop();
@@ -264,6 +445,7 @@ struct obs_source_info gpu_delay_filter = {
 	.create = gpu_delay_filter_create,
 	.destroy = gpu_delay_filter_destroy,
 	.update = gpu_delay_filter_update,
+	.get_defaults = gpu_delay_filter_defaults,
 	.get_properties = gpu_delay_filter_properties,
 	.video_tick = gpu_delay_filter_tick,
 	.video_render = gpu_delay_filter_render,
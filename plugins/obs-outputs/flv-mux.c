@@ -180,11 +180,31 @@ bool flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 static int32_t last_time = 0;
 #endif
 
+size_t flv_packet_prefix(struct encoder_packet *packet, bool is_header,
+			 uint8_t *prefix)
+{
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		int32_t offset =
+			get_ms_time(packet, packet->pts - packet->dts);
+
+		prefix[0] = packet->keyframe ? 0x17 : 0x27;
+		prefix[1] = is_header ? 0 : 1;
+		prefix[2] = (uint8_t)(offset >> 16);
+		prefix[3] = (uint8_t)(offset >> 8);
+		prefix[4] = (uint8_t)offset;
+		return FLV_VIDEO_PREFIX_SIZE;
+	}
+
+	prefix[0] = 0xaf;
+	prefix[1] = is_header ? 0 : 1;
+	return FLV_AUDIO_PREFIX_SIZE;
+}
+
 static void flv_video(struct serializer *s, int32_t dts_offset,
 		      struct encoder_packet *packet, bool is_header)
 {
-	int64_t offset = packet->pts - packet->dts;
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+	uint8_t prefix[FLV_VIDEO_PREFIX_SIZE];
 
 	if (!packet->data || !packet->size)
 		return;
@@ -206,9 +226,8 @@ static void flv_video(struct serializer *s, int32_t dts_offset,
 	s_wb24(s, 0);
 
 	/* these are the 5 extra bytes mentioned above */
-	s_w8(s, packet->keyframe ? 0x17 : 0x27);
-	s_w8(s, is_header ? 0 : 1);
-	s_wb24(s, get_ms_time(packet, offset));
+	flv_packet_prefix(packet, is_header, prefix);
+	s_write(s, prefix, FLV_VIDEO_PREFIX_SIZE);
 	s_write(s, packet->data, packet->size);
 
 	/* write tag size (starting byte doesn't count) */
@@ -219,6 +238,7 @@ static void flv_audio(struct serializer *s, int32_t dts_offset,
 		      struct encoder_packet *packet, bool is_header)
 {
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+	uint8_t prefix[FLV_AUDIO_PREFIX_SIZE];
 
 	if (!packet->data || !packet->size)
 		return;
@@ -240,8 +260,8 @@ static void flv_audio(struct serializer *s, int32_t dts_offset,
 	s_wb24(s, 0);
 
 	/* these are the two extra bytes mentioned above */
-	s_w8(s, 0xaf);
-	s_w8(s, is_header ? 0 : 1);
+	flv_packet_prefix(packet, is_header, prefix);
+	s_write(s, prefix, FLV_AUDIO_PREFIX_SIZE);
 	s_write(s, packet->data, packet->size);
 
 	/* write tag size (starting byte doesn't count) */
@@ -21,6 +21,15 @@
 
 #define MILLISECOND_DEN 1000
 
+/* size of the codec bytes that precede the encoded data in a tag body */
+#define FLV_VIDEO_PREFIX_SIZE 5
+#define FLV_AUDIO_PREFIX_SIZE 2
+#define FLV_MAX_PREFIX_SIZE FLV_VIDEO_PREFIX_SIZE
+
+/* size of an FLV tag header and of the trailing previous-tag-size field */
+#define FLV_TAG_HEADER_SIZE 11
+#define FLV_TAG_TRAILER_SIZE 4
+
 static int32_t get_ms_time(struct encoder_packet *packet, int64_t val)
 {
 	return (int32_t)(val * MILLISECOND_DEN / packet->timebase_den);
@@ -32,3 +41,8 @@ extern bool flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 			  bool write_header, size_t audio_idx);
 extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 			   uint8_t **output, size_t *size, bool is_header);
+
+/* writes the tag body prefix for a packet into a buffer of at least
+ * FLV_MAX_PREFIX_SIZE bytes and returns its size */
+extern size_t flv_packet_prefix(struct encoder_packet *packet, bool is_header,
+				uint8_t *prefix);
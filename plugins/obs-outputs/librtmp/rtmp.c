@@ -5526,3 +5526,237 @@ RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
     }
     return size+s2;
 }
+
+/* number of chunks gathered into a single vectored send */
+#define RTMP_IOV_BATCH 64
+
+#ifdef _WIN32
+typedef WSABUF RTMPIOVec;
+#define IOV_BASE(v) ((v)->buf)
+#define IOV_LEN(v) ((v)->len)
+#define IOV_SET(v, p, l) ((v)->buf = (char *)(p), (v)->len = (ULONG)(l))
+#else
+typedef struct iovec RTMPIOVec;
+#define IOV_BASE(v) ((v)->iov_base)
+#define IOV_LEN(v) ((v)->iov_len)
+#define IOV_SET(v, p, l) ((v)->iov_base = (void *)(p), (v)->iov_len = (size_t)(l))
+#endif
+
+static int
+SendIOV(RTMP *r, RTMPIOVec *iov, int cnt)
+{
+    while (cnt > 0)
+    {
+        int nBytes;
+#ifdef _WIN32
+        DWORD sent = 0;
+
+        if (WSASend(r->m_sb.sb_socket, iov, (DWORD)cnt, &sent, 0, NULL, NULL) == 0)
+            nBytes = (int)sent;
+        else
+            nBytes = -1;
+#else
+        struct msghdr msg;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = cnt;
+        nBytes = (int)sendmsg(r->m_sb.sb_socket, &msg, MSG_NOSIGNAL);
+#endif
+
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d", __FUNCTION__,
+                     sockerr);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            r->last_error_code = sockerr;
+
+            RTMP_Close(r);
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        /* skip what was fully written and trim a partially written vector */
+        while (cnt > 0 && (size_t)nBytes >= (size_t)IOV_LEN(iov))
+        {
+            nBytes -= (int)IOV_LEN(iov);
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0 && nBytes)
+        {
+            IOV_BASE(iov) = (char *)IOV_BASE(iov) + nBytes;
+            IOV_LEN(iov) -= nBytes;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Sends an audio/video message whose body is prefix + data without first
+ * copying it into an RTMPPacket.  Chunk headers are built on the stack and
+ * the payload is referenced in place; on a plain socket the chunks are
+ * written with one vectored send per batch, otherwise each piece goes
+ * through WriteN so encryption and custom send functions still apply. */
+int
+RTMP_WriteMedia(RTMP *r, int packetType, uint32_t timestamp,
+                const char *prefix, int prefixSize, const char *data,
+                int dataSize, int streamIdx)
+{
+    const RTMPPacket *prevPacket;
+    RTMPPacket packet = {0};
+    RTMPIOVec iov[RTMP_IOV_BATCH * 3];
+    char hbuf[RTMP_MAX_HEADER_SIZE], *hptr;
+    char *hend = hbuf + sizeof(hbuf);
+    const char *seg[2];
+    int segLen[2];
+    int s = 0, off = 0, hSize, remaining, direct;
+    uint32_t last = 0, t;
+    char cont;
+
+    packet.m_nChannel = 0x04;	/* source channel */
+    packet.m_nInfoField2 = r->Link.streams[streamIdx].id;
+    packet.m_packetType = packetType;
+    packet.m_nTimeStamp = timestamp;
+    packet.m_nBodySize = prefixSize + dataSize;
+    packet.m_headerType = timestamp ? RTMP_PACKET_SIZE_MEDIUM
+                                    : RTMP_PACKET_SIZE_LARGE;
+
+    /* RTMPT posts all chunks in one request and an unallocated channel
+     * table needs the bookkeeping in RTMP_SendPacket, so copy as before */
+    if ((r->Link.protocol & RTMP_FEATURE_HTTP) ||
+            packet.m_nChannel >= r->m_channelsAllocatedOut)
+    {
+        int ret;
+
+        if (!RTMPPacket_Alloc(&packet, packet.m_nBodySize))
+            return FALSE;
+
+        memcpy(packet.m_body, prefix, prefixSize);
+        memcpy(packet.m_body + prefixSize, data, dataSize);
+        ret = RTMP_SendPacket(r, &packet, FALSE);
+        RTMPPacket_Free(&packet);
+        return ret;
+    }
+
+    prevPacket = r->m_vecChannelsOut[packet.m_nChannel];
+    if (prevPacket && packet.m_headerType != RTMP_PACKET_SIZE_LARGE)
+    {
+        if (prevPacket->m_nBodySize == packet.m_nBodySize
+                && prevPacket->m_packetType == packet.m_packetType)
+            packet.m_headerType = RTMP_PACKET_SIZE_SMALL;
+
+        if (prevPacket->m_nTimeStamp == packet.m_nTimeStamp
+                && packet.m_headerType == RTMP_PACKET_SIZE_SMALL)
+            packet.m_headerType = RTMP_PACKET_SIZE_MINIMUM;
+        last = prevPacket->m_nTimeStamp;
+    }
+
+    hSize = packetSize[packet.m_headerType];
+    t = packet.m_nTimeStamp - last;
+
+    hptr = hbuf;
+    cont = (char)(packet.m_headerType << 6 | packet.m_nChannel);
+    *hptr++ = cont;
+
+    if (hSize > 1)
+        hptr = AMF_EncodeInt24(hptr, hend, t > 0xffffff ? 0xffffff : t);
+
+    if (hSize > 4)
+    {
+        hptr = AMF_EncodeInt24(hptr, hend, packet.m_nBodySize);
+        *hptr++ = packet.m_packetType;
+    }
+
+    if (hSize > 8)
+        hptr += EncodeInt32LE(hptr, packet.m_nInfoField2);
+
+    if (hSize > 1 && t >= 0xffffff)
+        hptr = AMF_EncodeInt32(hptr, hend, t);
+
+    hSize = (int)(hptr - hbuf);
+    cont = (char)(0xc0 | packet.m_nChannel);
+
+    direct = !(r->m_bCustomSend && r->m_customSendFunc) && !r->m_sb.sb_ssl;
+#ifdef CRYPTO
+    if (r->Link.rc4keyOut)
+        direct = FALSE;
+#endif
+#if defined(RTMP_NETSTACK_DUMP)
+    direct = FALSE;
+#endif
+
+    seg[0] = prefix;
+    segLen[0] = prefixSize;
+    seg[1] = data;
+    segLen[1] = dataSize;
+    remaining = packet.m_nBodySize;
+
+    while (remaining > 0)
+    {
+        int cnt = 0, chunks = 0, i;
+
+        while (remaining > 0 && chunks < RTMP_IOV_BATCH)
+        {
+            int chunk = remaining < r->m_outChunkSize ? remaining
+                                                      : r->m_outChunkSize;
+
+            if (hSize)
+            {
+                IOV_SET(&iov[cnt], hbuf, hSize);
+                hSize = 0;
+            }
+            else
+            {
+                IOV_SET(&iov[cnt], &cont, 1);
+            }
+            cnt++;
+
+            remaining -= chunk;
+            while (chunk > 0)
+            {
+                int n = segLen[s] - off;
+                if (n > chunk)
+                    n = chunk;
+                if (n)
+                {
+                    IOV_SET(&iov[cnt], seg[s] + off, n);
+                    cnt++;
+                }
+                off += n;
+                chunk -= n;
+                if (off == segLen[s])
+                {
+                    s++;
+                    off = 0;
+                }
+            }
+            chunks++;
+        }
+
+        if (direct)
+        {
+            if (!SendIOV(r, iov, cnt))
+                return FALSE;
+        }
+        else
+        {
+            for (i = 0; i < cnt; i++)
+            {
+                if (!WriteN(r, IOV_BASE(&iov[i]), (int)IOV_LEN(&iov[i])))
+                    return FALSE;
+            }
+        }
+    }
+
+    if (!r->m_vecChannelsOut[packet.m_nChannel])
+        r->m_vecChannelsOut[packet.m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet.m_nChannel], &packet, sizeof(RTMPPacket));
+    return TRUE;
+}
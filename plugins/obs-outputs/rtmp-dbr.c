@@ -0,0 +1,427 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+    Copyright (C) 2014 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <string.h>
+#include <util/bmem.h>
+#include <util/circlebuf.h>
+#include "rtmp-dbr.h"
+
+#define MSEC_TO_NSEC 1000000ULL
+#define SEC_TO_NSEC 1000000000ULL
+#define MSEC_TO_USEC 1000LL
+
+/* ------------------------------------------------------------------------- */
+/* send throughput estimate */
+
+#define MIN_ESTIMATE_DURATION_MS 1000
+#define MAX_ESTIMATE_DURATION_MS 2000
+
+struct dbr_estimator {
+	struct circlebuf frames;
+	size_t data_size;
+
+	long total_bitrate; /* kbps, 0 until enough has been sent */
+	long est_bitrate;   /* total_bitrate minus audio */
+};
+
+static void estimator_add(struct dbr_estimator *e,
+			  const struct dbr_frame *back, long audio_bitrate)
+{
+	struct dbr_frame front;
+	uint64_t dur;
+
+	circlebuf_push_back(&e->frames, back, sizeof(*back));
+	circlebuf_peek_front(&e->frames, &front, sizeof(front));
+
+	e->data_size += back->size;
+
+	dur = (back->send_end - front.send_beg) / 1000000;
+
+	if (dur >= MAX_ESTIMATE_DURATION_MS) {
+		e->data_size -= front.size;
+		circlebuf_pop_front(&e->frames, NULL, sizeof(front));
+	}
+
+	e->total_bitrate = (dur >= MIN_ESTIMATE_DURATION_MS)
+				   ? (long)(e->data_size * 1000 / dur)
+				   : 0;
+	e->total_bitrate *= 8;
+	e->total_bitrate /= 1000;
+
+	e->est_bitrate = e->total_bitrate;
+	if (e->est_bitrate) {
+		e->est_bitrate -= audio_bitrate;
+		if (e->est_bitrate < DBR_MIN_BITRATE)
+			e->est_bitrate = DBR_MIN_BITRATE;
+	}
+}
+
+static void estimator_reset(struct dbr_estimator *e)
+{
+	circlebuf_pop_front(&e->frames, NULL, e->frames.size);
+	e->data_size = 0;
+	e->total_bitrate = 0;
+	e->est_bitrate = 0;
+}
+
+static inline long clamp_bitrate(long bitrate, long orig_bitrate)
+{
+	bitrate = bitrate / 50 * 50;
+	if (bitrate > orig_bitrate)
+		bitrate = orig_bitrate;
+	if (bitrate < DBR_MIN_BITRATE)
+		bitrate = DBR_MIN_BITRATE;
+	return bitrate;
+}
+
+/* time it takes to send bytes at the given kbps */
+static inline int64_t bytes_to_usec(size_t bytes, long kbps)
+{
+	return kbps > 0 ? (int64_t)bytes * 8000 / kbps : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* buffer: lower the bitrate to the measured throughput once the buffered
+ * duration passes a fixed trigger, step back up on a fixed timer */
+
+#define BUF_INC_TIMER (30ULL * SEC_TO_NSEC)
+#define BUF_TRIGGER_USEC (200LL * MSEC_TO_USEC)
+
+struct buffer_policy {
+	struct dbr_params params;
+	struct dbr_estimator est;
+
+	long prev_bitrate;
+	long inc_bitrate;
+	uint64_t inc_timeout;
+};
+
+static void *buffer_create(const struct dbr_params *params)
+{
+	struct buffer_policy *p = bzalloc(sizeof(*p));
+	p->params = *params;
+	p->inc_bitrate = params->orig_bitrate / 10;
+	return p;
+}
+
+static void buffer_destroy(void *data)
+{
+	struct buffer_policy *p = data;
+	circlebuf_free(&p->est.frames);
+	bfree(p);
+}
+
+static void buffer_frame_sent(void *data, const struct dbr_frame *frame)
+{
+	struct buffer_policy *p = data;
+	estimator_add(&p->est, frame, p->params.audio_bitrate);
+}
+
+static long buffer_lower(struct buffer_policy *p, long bitrate, uint64_t ts)
+{
+	long est_bitrate = 0;
+	long new_bitrate;
+
+	if (p->est.est_bitrate && p->est.est_bitrate < bitrate) {
+		est_bitrate = p->est.est_bitrate / 100 * 100;
+		if (est_bitrate < DBR_MIN_BITRATE)
+			est_bitrate = DBR_MIN_BITRATE;
+		estimator_reset(&p->est);
+	}
+
+	if (est_bitrate)
+		new_bitrate = est_bitrate;
+	else if (p->prev_bitrate)
+		new_bitrate = p->prev_bitrate;
+	else
+		return bitrate;
+
+	if (new_bitrate == bitrate)
+		return bitrate;
+
+	p->prev_bitrate = 0;
+	p->inc_timeout = ts + BUF_INC_TIMER;
+	return new_bitrate;
+}
+
+static long buffer_update(void *data, const struct dbr_status *status,
+			  bool *drop_frames)
+{
+	struct buffer_policy *p = data;
+	long bitrate = status->cur_bitrate;
+
+	if (p->inc_timeout && status->ts >= p->inc_timeout) {
+		p->inc_timeout = 0;
+		p->prev_bitrate = bitrate;
+		bitrate += p->inc_bitrate;
+
+		if (bitrate >= p->params.orig_bitrate)
+			bitrate = p->params.orig_bitrate;
+		else
+			p->inc_timeout = status->ts + BUF_INC_TIMER;
+	}
+
+	if (status->buffer_duration_usec >= BUF_TRIGGER_USEC)
+		bitrate = buffer_lower(p, bitrate, status->ts);
+
+	*drop_frames = false;
+	return bitrate;
+}
+
+static const struct dbr_policy_info buffer_policy_info = {
+	.id = "buffer",
+	.name = "RTMPStream.DynBitratePolicy.Buffer",
+	.create = buffer_create,
+	.destroy = buffer_destroy,
+	.frame_sent = buffer_frame_sent,
+	.update = buffer_update,
+};
+
+/* ------------------------------------------------------------------------- */
+/* throughput: track the measured send rate while the link is backed up,
+ * probe upwards once the socket has been idle for a while */
+
+#define TP_HEADROOM_PERCENT 90
+#define TP_CONGESTED_USEC (100LL * MSEC_TO_USEC)
+#define TP_CLEAR_USEC (20LL * MSEC_TO_USEC)
+#define TP_DEC_INTERVAL (1ULL * SEC_TO_NSEC)
+#define TP_INC_INTERVAL (5ULL * SEC_TO_NSEC)
+
+struct throughput_policy {
+	struct dbr_params params;
+	struct dbr_estimator est;
+
+	uint64_t last_change;
+	uint64_t clear_since;
+};
+
+static void *throughput_create(const struct dbr_params *params)
+{
+	struct throughput_policy *p = bzalloc(sizeof(*p));
+	p->params = *params;
+	return p;
+}
+
+static void throughput_destroy(void *data)
+{
+	struct throughput_policy *p = data;
+	circlebuf_free(&p->est.frames);
+	bfree(p);
+}
+
+static void throughput_frame_sent(void *data, const struct dbr_frame *frame)
+{
+	struct throughput_policy *p = data;
+	estimator_add(&p->est, frame, p->params.audio_bitrate);
+}
+
+static long throughput_update(void *data, const struct dbr_status *status,
+			      bool *drop_frames)
+{
+	struct throughput_policy *p = data;
+	long bitrate = status->cur_bitrate;
+	long est = p->est.est_bitrate;
+	int64_t backlog;
+
+	backlog = status->buffer_duration_usec +
+		  bytes_to_usec(status->socket_queued_bytes,
+				p->est.total_bitrate);
+
+	*drop_frames = false;
+
+	if (backlog >= TP_CONGESTED_USEC) {
+		p->clear_since = 0;
+
+		/* what is already buffered was encoded at the current
+		 * bitrate and drains at the measured one, so drop it now if
+		 * it will not make it out before the drop threshold */
+		if (est && backlog * bitrate / est >
+				   p->params.drop_threshold_usec)
+			*drop_frames = true;
+
+		if (est && status->ts - p->last_change >= TP_DEC_INTERVAL) {
+			long target = clamp_bitrate(
+				est * TP_HEADROOM_PERCENT / 100,
+				p->params.orig_bitrate);
+
+			if (target < bitrate) {
+				bitrate = target;
+				p->last_change = status->ts;
+				estimator_reset(&p->est);
+			}
+		}
+
+	} else if (backlog < TP_CLEAR_USEC) {
+		if (!p->clear_since)
+			p->clear_since = status->ts;
+
+		if (bitrate < p->params.orig_bitrate &&
+		    status->ts - p->clear_since >= TP_INC_INTERVAL &&
+		    status->ts - p->last_change >= TP_INC_INTERVAL) {
+			bitrate = clamp_bitrate(
+				bitrate + p->params.orig_bitrate / 20,
+				p->params.orig_bitrate);
+			p->last_change = status->ts;
+			p->clear_since = status->ts;
+		}
+	}
+
+	return bitrate;
+}
+
+static const struct dbr_policy_info throughput_policy_info = {
+	.id = "throughput",
+	.name = "RTMPStream.DynBitratePolicy.Throughput",
+	.create = throughput_create,
+	.destroy = throughput_destroy,
+	.frame_sent = throughput_frame_sent,
+	.update = throughput_update,
+};
+
+/* ------------------------------------------------------------------------- */
+/* delay gradient: react to the queueing delay growing rather than to its
+ * absolute value, which backs off before the buffer is deep */
+
+#define GD_SMOOTHING 0.1
+#define GD_OVERUSE 0.01 /* 10ms of extra delay per second */
+#define GD_MIN_DELAY_USEC (50LL * MSEC_TO_USEC)
+#define GD_CLEAR_USEC (20LL * MSEC_TO_USEC)
+#define GD_HORIZON_USEC (1000LL * MSEC_TO_USEC)
+#define GD_DEC_INTERVAL (500ULL * MSEC_TO_NSEC)
+#define GD_INC_INTERVAL (2ULL * SEC_TO_NSEC)
+#define GD_DEC_PERCENT 85
+
+struct gradient_policy {
+	struct dbr_params params;
+
+	uint64_t prev_ts;
+	int64_t prev_delay;
+	double gradient;
+
+	uint64_t last_change;
+	uint64_t clear_since;
+};
+
+static void *gradient_create(const struct dbr_params *params)
+{
+	struct gradient_policy *p = bzalloc(sizeof(*p));
+	p->params = *params;
+	return p;
+}
+
+static void gradient_destroy(void *data)
+{
+	bfree(data);
+}
+
+static void gradient_frame_sent(void *data, const struct dbr_frame *frame)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(frame);
+}
+
+static long gradient_update(void *data, const struct dbr_status *status,
+			    bool *drop_frames)
+{
+	struct gradient_policy *p = data;
+	long bitrate = status->cur_bitrate;
+	int64_t delay;
+
+	delay = status->buffer_duration_usec +
+		bytes_to_usec(status->socket_queued_bytes,
+			      bitrate + p->params.audio_bitrate);
+
+	if (p->prev_ts && status->ts > p->prev_ts) {
+		double dt = (double)(status->ts - p->prev_ts) / 1000.0;
+		double g = (double)(delay - p->prev_delay) / dt;
+
+		p->gradient += (g - p->gradient) * GD_SMOOTHING;
+	}
+
+	p->prev_ts = status->ts;
+	p->prev_delay = delay;
+
+	if (p->gradient > GD_OVERUSE && delay >= GD_MIN_DELAY_USEC) {
+		p->clear_since = 0;
+
+		if (status->ts - p->last_change >= GD_DEC_INTERVAL) {
+			bitrate = clamp_bitrate(bitrate * GD_DEC_PERCENT / 100,
+						p->params.orig_bitrate);
+			p->last_change = status->ts;
+		}
+
+	} else if (delay < GD_CLEAR_USEC && p->gradient <= 0.0) {
+		if (!p->clear_since)
+			p->clear_since = status->ts;
+
+		if (bitrate < p->params.orig_bitrate &&
+		    status->ts - p->clear_since >= GD_INC_INTERVAL &&
+		    status->ts - p->last_change >= GD_INC_INTERVAL) {
+			bitrate = clamp_bitrate(
+				bitrate + p->params.orig_bitrate / 20,
+				p->params.orig_bitrate);
+			p->last_change = status->ts;
+			p->clear_since = status->ts;
+		}
+
+	} else {
+		p->clear_since = 0;
+	}
+
+	/* extrapolate the delay and drop before it crosses the threshold */
+	*drop_frames = delay >= GD_MIN_DELAY_USEC &&
+		       delay + (int64_t)(p->gradient * GD_HORIZON_USEC) >
+			       p->params.drop_threshold_usec;
+	return bitrate;
+}
+
+static const struct dbr_policy_info gradient_policy_info = {
+	.id = "delay_gradient",
+	.name = "RTMPStream.DynBitratePolicy.DelayGradient",
+	.create = gradient_create,
+	.destroy = gradient_destroy,
+	.frame_sent = gradient_frame_sent,
+	.update = gradient_update,
+};
+
+/* ------------------------------------------------------------------------- */
+
+static const struct dbr_policy_info *policies[] = {
+	&buffer_policy_info,
+	&throughput_policy_info,
+	&gradient_policy_info,
+};
+
+#define NUM_POLICIES (sizeof(policies) / sizeof(policies[0]))
+
+const struct dbr_policy_info *dbr_enum_policies(size_t idx)
+{
+	return idx < NUM_POLICIES ? policies[idx] : NULL;
+}
+
+const struct dbr_policy_info *dbr_find_policy(const char *id)
+{
+	if (id) {
+		for (size_t i = 0; i < NUM_POLICIES; i++) {
+			if (strcmp(policies[i]->id, id) == 0)
+				return policies[i];
+		}
+	}
+
+	return &buffer_policy_info;
+}
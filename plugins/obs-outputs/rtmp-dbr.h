@@ -0,0 +1,76 @@
+/******************************************************************************
+    Copyright (C) 2026 by agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Dynamic bitrate policies.
+ *
+ * A policy is fed the send time of every packet written to the socket and a
+ * status sample every time a video packet is queued, and answers with the
+ * video bitrate it wants and whether queued non-keyframes should be dropped
+ * ahead of the regular drop threshold.  Policies never read the clock or
+ * touch the output themselves, so they can be driven from recorded traces. */
+
+#define DBR_MIN_BITRATE 50
+
+struct dbr_frame {
+	uint64_t send_beg;
+	uint64_t send_end;
+	size_t size;
+};
+
+struct dbr_params {
+	long orig_bitrate;  /* kbps, also the upper bound */
+	long audio_bitrate; /* kbps */
+	int64_t drop_threshold_usec;
+};
+
+struct dbr_status {
+	uint64_t ts; /* ns */
+
+	/* duration of the packets waiting to be sent, 0 if too few */
+	int64_t buffer_duration_usec;
+
+	/* bytes already handed to the socket but not yet on the wire */
+	size_t socket_queued_bytes;
+
+	long cur_bitrate;
+};
+
+struct dbr_policy_info {
+	const char *id;
+	const char *name; /* module locale key */
+
+	void *(*create)(const struct dbr_params *params);
+	void (*destroy)(void *data);
+
+	/* called from the send thread after each packet is sent */
+	void (*frame_sent)(void *data, const struct dbr_frame *frame);
+
+	/* returns the wanted bitrate, status->cur_bitrate to keep it */
+	long (*update)(void *data, const struct dbr_status *status,
+		       bool *drop_frames);
+};
+
+#define DBR_DEFAULT_POLICY "buffer"
+
+extern const struct dbr_policy_info *dbr_enum_policies(size_t idx);
+extern const struct dbr_policy_info *dbr_find_policy(const char *id);
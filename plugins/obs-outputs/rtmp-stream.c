@@ -29,12 +29,6 @@
 #define MSEC_TO_NSEC 1000000ULL
 #endif
 
-/* dynamic bitrate coefficients */
-#define DBR_INC_TIMER (30ULL * SEC_TO_NSEC)
-#define DBR_TRIGGER_USEC (200ULL * MSEC_TO_USEC)
-#define MIN_ESTIMATE_DURATION_MS 1000
-#define MAX_ESTIMATE_DURATION_MS 2000
-
 static const char *rtmp_stream_getname(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -125,7 +119,8 @@ static void rtmp_stream_destroy(void *data)
 #ifdef TEST_FRAMEDROPS
 	circlebuf_free(&stream->droptest_info);
 #endif
-	circlebuf_free(&stream->dbr_frames);
+	if (stream->dbr_data)
+		stream->dbr_policy->destroy(stream->dbr_data);
 	pthread_mutex_destroy(&stream->dbr_mutex);
 
 	os_event_destroy(stream->buffer_space_available_event);
@@ -402,7 +397,9 @@ static int send_packet(struct rtmp_stream *stream,
 		       struct encoder_packet *packet, bool is_header,
 		       size_t idx)
 {
-	uint8_t *data;
+	uint8_t prefix[FLV_MAX_PREFIX_SIZE];
+	size_t prefix_size;
+	int32_t time_ms;
 	size_t size;
 	int recv_size = 0;
 	int ret = 0;
@@ -421,15 +418,32 @@ static int send_packet(struct rtmp_stream *stream,
 		}
 	}
 
-	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data,
-		       &size, is_header);
+	/* the tag header is encoded straight into the RTMP chunk headers and
+	 * the packet data is sent in place rather than being muxed into a
+	 * contiguous FLV tag and copied again into an RTMP packet */
+	prefix_size = flv_packet_prefix(packet, is_header, prefix);
+	time_ms = get_ms_time(packet, packet->dts) -
+		  (is_header ? 0 : stream->start_dts_offset);
+	size = packet->size ? FLV_TAG_HEADER_SIZE + prefix_size +
+				      packet->size + FLV_TAG_TRAILER_SIZE
+			    : 0;
+	ret = 0;
 
 #ifdef TEST_FRAMEDROPS
 	droptest_cap_data_rate(stream, size);
 #endif
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, (int)idx);
-	bfree(data);
+	if (packet->data && packet->size) {
+		bool success = RTMP_WriteMedia(
+			&stream->rtmp,
+			packet->type == OBS_ENCODER_VIDEO
+				? RTMP_PACKET_TYPE_VIDEO
+				: RTMP_PACKET_TYPE_AUDIO,
+			(uint32_t)time_ms & 0x7FFFFFFF, (const char *)prefix,
+			(int)prefix_size, (const char *)packet->data,
+			(int)packet->size, (int)idx);
+		ret = success ? (int)size : -1;
+	}
 
 	if (is_header)
 		bfree(packet->data);
@@ -520,37 +534,6 @@ static void set_output_error(struct rtmp_stream *stream)
 	obs_output_set_last_error(stream->output, msg);
 }
 
-static void dbr_add_frame(struct rtmp_stream *stream, struct dbr_frame *back)
-{
-	struct dbr_frame front;
-	uint64_t dur;
-
-	circlebuf_push_back(&stream->dbr_frames, back, sizeof(*back));
-	circlebuf_peek_front(&stream->dbr_frames, &front, sizeof(front));
-
-	stream->dbr_data_size += back->size;
-
-	dur = (back->send_end - front.send_beg) / 1000000;
-
-	if (dur >= MAX_ESTIMATE_DURATION_MS) {
-		stream->dbr_data_size -= front.size;
-		circlebuf_pop_front(&stream->dbr_frames, NULL, sizeof(front));
-	}
-
-	stream->dbr_est_bitrate =
-		(dur >= MIN_ESTIMATE_DURATION_MS)
-			? (long)(stream->dbr_data_size * 1000 / dur)
-			: 0;
-	stream->dbr_est_bitrate *= 8;
-	stream->dbr_est_bitrate /= 1000;
-
-	if (stream->dbr_est_bitrate) {
-		stream->dbr_est_bitrate -= stream->audio_bitrate;
-		if (stream->dbr_est_bitrate < 50)
-			stream->dbr_est_bitrate = 50;
-	}
-}
-
 static void dbr_set_bitrate(struct rtmp_stream *stream);
 
 static void *send_thread(void *data)
@@ -598,7 +581,8 @@ static void *send_thread(void *data)
 			dbr_frame.send_end = os_gettime_ns();
 
 			pthread_mutex_lock(&stream->dbr_mutex);
-			dbr_add_frame(stream, &dbr_frame);
+			stream->dbr_policy->frame_sent(stream->dbr_data,
+						       &dbr_frame);
 			pthread_mutex_unlock(&stream->dbr_mutex);
 		}
 	}
@@ -997,6 +981,23 @@ static int try_connect(struct rtmp_stream *stream)
 	return init_send(stream);
 }
 
+static void dbr_init_policy(struct rtmp_stream *stream, const char *id)
+{
+	struct dbr_params params = {
+		.orig_bitrate = stream->dbr_orig_bitrate,
+		.audio_bitrate = stream->audio_bitrate,
+		.drop_threshold_usec = stream->drop_threshold_usec,
+	};
+
+	pthread_mutex_lock(&stream->dbr_mutex);
+	if (stream->dbr_data)
+		stream->dbr_policy->destroy(stream->dbr_data);
+
+	stream->dbr_policy = dbr_find_policy(id);
+	stream->dbr_data = stream->dbr_policy->create(&params);
+	pthread_mutex_unlock(&stream->dbr_mutex);
+}
+
 static bool init_connect(struct rtmp_stream *stream)
 {
 	obs_service_t *service;
@@ -1040,14 +1041,10 @@ static bool init_connect(struct rtmp_stream *stream)
 	obs_data_t *vsettings = obs_encoder_get_settings(venc);
 	obs_data_t *asettings = obs_encoder_get_settings(aenc);
 
-	circlebuf_free(&stream->dbr_frames);
 	stream->audio_bitrate = (long)obs_data_get_int(asettings, "bitrate");
-	stream->dbr_data_size = 0;
 	stream->dbr_orig_bitrate = (long)obs_data_get_int(vsettings, "bitrate");
 	stream->dbr_cur_bitrate = stream->dbr_orig_bitrate;
-	stream->dbr_est_bitrate = 0;
-	stream->dbr_inc_bitrate = stream->dbr_orig_bitrate / 10;
-	stream->dbr_inc_timeout = 0;
+	stream->dbr_drop_frames = false;
 	stream->dbr_enabled = obs_data_get_bool(settings, OPT_DYN_BITRATE);
 
 	caps = obs_encoder_get_caps(venc);
@@ -1059,10 +1056,6 @@ static bool init_connect(struct rtmp_stream *stream)
 		stream->dbr_enabled = false;
 	}
 
-	if (stream->dbr_enabled) {
-		info("Dynamic bitrate enabled.  Dropped frames begone!");
-	}
-
 	obs_data_release(vsettings);
 	obs_data_release(asettings);
 
@@ -1072,6 +1065,15 @@ static bool init_connect(struct rtmp_stream *stream)
 	stream->drop_threshold_usec = 1000 * drop_b;
 	stream->pframe_drop_threshold_usec = 1000 * drop_p;
 
+	if (stream->dbr_enabled) {
+		const char *policy =
+			obs_data_get_string(settings, OPT_DYN_BITRATE_POLICY);
+		dbr_init_policy(stream, policy);
+
+		info("Dynamic bitrate enabled (%s).  Dropped frames begone!",
+		     stream->dbr_policy->id);
+	}
+
 	bind_ip = obs_data_get_string(settings, OPT_BIND_IP);
 	dstr_copy(&stream->bind_ip, bind_ip);
 
@@ -1200,94 +1202,70 @@ static bool find_first_video_packet(struct rtmp_stream *stream,
 	return false;
 }
 
-static bool dbr_bitrate_lowered(struct rtmp_stream *stream)
+static void dbr_set_bitrate(struct rtmp_stream *stream)
 {
-	long prev_bitrate = stream->dbr_prev_bitrate;
-	long est_bitrate = 0;
-	long new_bitrate;
-
-	if (stream->dbr_est_bitrate &&
-	    stream->dbr_est_bitrate < stream->dbr_cur_bitrate) {
-		stream->dbr_data_size = 0;
-		circlebuf_pop_front(&stream->dbr_frames, NULL,
-				    stream->dbr_frames.size);
-		est_bitrate = stream->dbr_est_bitrate / 100 * 100;
-		if (est_bitrate < 50) {
-			est_bitrate = 50;
-		}
-	}
-
-#if 0
-	if (prev_bitrate && est_bitrate) {
-		if (prev_bitrate < est_bitrate) {
-			blog(LOG_INFO, "going back to prev bitrate: "
-					"prev_bitrate (%d) < est_bitrate (%d)",
-					prev_bitrate,
-					est_bitrate);
-			new_bitrate = prev_bitrate;
-		} else {
-			new_bitrate = est_bitrate;
-		}
-		new_bitrate = est_bitrate;
-	} else if (prev_bitrate) {
-		new_bitrate = prev_bitrate;
-		info("going back to prev bitrate");
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	obs_data_t *settings = obs_encoder_get_settings(vencoder);
 
-	} else if (est_bitrate) {
-		new_bitrate = est_bitrate;
+	obs_data_set_int(settings, "bitrate", stream->dbr_cur_bitrate);
+	obs_encoder_update(vencoder, settings);
 
-	} else {
-		return false;
-	}
-#else
-	if (est_bitrate) {
-		new_bitrate = est_bitrate;
+	obs_data_release(settings);
+}
 
-	} else if (prev_bitrate) {
-		new_bitrate = prev_bitrate;
-		info("going back to prev bitrate");
+static size_t get_socket_queued_bytes(struct rtmp_stream *stream)
+{
+	size_t queued = 0;
 
-	} else {
-		return false;
+	if (stream->new_socket_loop) {
+		pthread_mutex_lock(&stream->write_buf_mutex);
+		queued = stream->write_buf_len;
+		pthread_mutex_unlock(&stream->write_buf_mutex);
 	}
 
-	if (new_bitrate == stream->dbr_cur_bitrate) {
-		return false;
-	}
+#if defined(TIOCOUTQ)
+	int pending = 0;
+	if (ioctl(stream->rtmp.m_sb.sb_socket, TIOCOUTQ, &pending) == 0 &&
+	    pending > 0)
+		queued += (size_t)pending;
+#elif defined(SO_NWRITE)
+	int pending = 0;
+	socklen_t size = sizeof(pending);
+	if (getsockopt(stream->rtmp.m_sb.sb_socket, SOL_SOCKET, SO_NWRITE,
+		       &pending, &size) == 0 &&
+	    pending > 0)
+		queued += (size_t)pending;
 #endif
 
-	stream->dbr_prev_bitrate = 0;
-	stream->dbr_cur_bitrate = new_bitrate;
-	stream->dbr_inc_timeout = os_gettime_ns() + DBR_INC_TIMER;
-	info("bitrate decreased to: %ld", stream->dbr_cur_bitrate);
-	return true;
+	return queued;
 }
 
-static void dbr_set_bitrate(struct rtmp_stream *stream)
+static void dbr_update(struct rtmp_stream *stream,
+		       int64_t buffer_duration_usec)
 {
-	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
-	obs_data_t *settings = obs_encoder_get_settings(vencoder);
+	struct dbr_status status = {
+		.ts = os_gettime_ns(),
+		.buffer_duration_usec = buffer_duration_usec,
+		.socket_queued_bytes = get_socket_queued_bytes(stream),
+		.cur_bitrate = stream->dbr_cur_bitrate,
+	};
+	long bitrate;
+
+	pthread_mutex_lock(&stream->dbr_mutex);
+	bitrate = stream->dbr_policy->update(stream->dbr_data, &status,
+					     &stream->dbr_drop_frames);
+	pthread_mutex_unlock(&stream->dbr_mutex);
+
+	if (bitrate == stream->dbr_cur_bitrate)
+		return;
 
-	obs_data_set_int(settings, "bitrate", stream->dbr_cur_bitrate);
-	obs_encoder_update(vencoder, settings);
+	info("bitrate %s to: %ld",
+	     bitrate < stream->dbr_cur_bitrate ? "decreased" : "increased",
+	     bitrate);
+	debug("buffer_duration_msec: %" PRId64, buffer_duration_usec / 1000);
 
-	obs_data_release(settings);
-}
-
-static void dbr_inc_bitrate(struct rtmp_stream *stream)
-{
-	stream->dbr_prev_bitrate = stream->dbr_cur_bitrate;
-	stream->dbr_cur_bitrate += stream->dbr_inc_bitrate;
-
-	if (stream->dbr_cur_bitrate >= stream->dbr_orig_bitrate) {
-		stream->dbr_cur_bitrate = stream->dbr_orig_bitrate;
-		info("bitrate increased to: %ld, done",
-		     stream->dbr_cur_bitrate);
-	} else if (stream->dbr_cur_bitrate < stream->dbr_orig_bitrate) {
-		stream->dbr_inc_timeout = os_gettime_ns() + DBR_INC_TIMER;
-		info("bitrate increased to: %ld, waiting",
-		     stream->dbr_cur_bitrate);
-	}
+	stream->dbr_cur_bitrate = bitrate;
+	dbr_set_bitrate(stream);
 }
 
 static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
@@ -1301,27 +1279,16 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 	int64_t drop_threshold = pframes ? stream->pframe_drop_threshold_usec
 					 : stream->drop_threshold_usec;
 
-	if (!pframes && stream->dbr_enabled) {
-		if (stream->dbr_inc_timeout) {
-			uint64_t t = os_gettime_ns();
-
-			if (t >= stream->dbr_inc_timeout) {
-				stream->dbr_inc_timeout = 0;
-				dbr_inc_bitrate(stream);
-				dbr_set_bitrate(stream);
-			}
+	if (num_packets < 5 || !find_first_video_packet(stream, &first)) {
+		if (!pframes) {
+			if (num_packets < 5)
+				stream->congestion = 0.0f;
+			if (stream->dbr_enabled)
+				dbr_update(stream, 0);
 		}
-	}
-
-	if (num_packets < 5) {
-		if (!pframes)
-			stream->congestion = 0.0f;
 		return;
 	}
 
-	if (!find_first_video_packet(stream, &first))
-		return;
-
 	/* if the amount of time stored in the buffered packets waiting to be
 	 * sent is higher than threshold, drop frames */
 	buffer_duration_usec = stream->last_dts_usec - first.dts_usec;
@@ -1331,27 +1298,19 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 			(float)buffer_duration_usec / (float)drop_threshold;
 	}
 
-	/* alternatively, drop only pframes:
-	 * (!pframes && stream->dbr_enabled)
-	 * but let's test without dropping frames
-	 * at all first */
+	/* with dynamic bitrate the policy decides when to lower the bitrate
+	 * and whether to drop ahead of the threshold */
 	if (stream->dbr_enabled) {
-		bool bitrate_changed = false;
-
 		if (pframes) {
 			return;
 		}
 
-		if ((uint64_t)buffer_duration_usec >= DBR_TRIGGER_USEC) {
-			pthread_mutex_lock(&stream->dbr_mutex);
-			bitrate_changed = dbr_bitrate_lowered(stream);
-			pthread_mutex_unlock(&stream->dbr_mutex);
-		}
+		dbr_update(stream, buffer_duration_usec);
 
-		if (bitrate_changed) {
-			debug("buffer_duration_msec: %" PRId64,
-			      buffer_duration_usec / 1000);
-			dbr_set_bitrate(stream);
+		if (stream->dbr_drop_frames) {
+			debug("buffer_duration_usec: %" PRId64,
+			      buffer_duration_usec);
+			drop_frames(stream, name, priority, pframes);
 		}
 		return;
 	}
@@ -1433,6 +1392,8 @@ static void rtmp_stream_defaults(obs_data_t *defaults)
 	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
 	obs_data_set_default_bool(defaults, OPT_NEWSOCKETLOOP_ENABLED, false);
 	obs_data_set_default_bool(defaults, OPT_LOWLATENCY_ENABLED, false);
+	obs_data_set_default_string(defaults, OPT_DYN_BITRATE_POLICY,
+				    DBR_DEFAULT_POLICY);
 }
 
 static obs_properties_t *rtmp_stream_properties(void *unused)
@@ -1466,6 +1427,16 @@ static obs_properties_t *rtmp_stream_properties(void *unused)
 	obs_properties_add_bool(props, OPT_LOWLATENCY_ENABLED,
 				obs_module_text("RTMPStream.LowLatencyMode"));
 
+	p = obs_properties_add_list(
+		props, OPT_DYN_BITRATE_POLICY,
+		obs_module_text("RTMPStream.DynBitratePolicy"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+
+	const struct dbr_policy_info *policy;
+	for (size_t i = 0; (policy = dbr_enum_policies(i)) != NULL; i++)
+		obs_property_list_add_string(p, obs_module_text(policy->name),
+					     policy->id);
+
 	return props;
 }
 
@@ -8,6 +8,7 @@
 #include "librtmp/rtmp.h"
 #include "librtmp/log.h"
 #include "flv-mux.h"
+#include "rtmp-dbr.h"
 #include "net-if.h"
 
 #ifdef _WIN32
@@ -25,6 +26,7 @@
 #define debug(format, ...) do_log(LOG_DEBUG, format, ##__VA_ARGS__)
 
 #define OPT_DYN_BITRATE "dyn_bitrate"
+#define OPT_DYN_BITRATE_POLICY "dyn_bitrate_policy"
 #define OPT_DROP_THRESHOLD "drop_threshold_ms"
 #define OPT_PFRAME_DROP_THRESHOLD "pframe_drop_threshold_ms"
 #define OPT_MAX_SHUTDOWN_TIME_SEC "max_shutdown_time_sec"
@@ -46,12 +48,6 @@ struct droptest_info {
 };
 #endif
 
-struct dbr_frame {
-	uint64_t send_beg;
-	uint64_t send_end;
-	size_t size;
-};
-
 struct rtmp_stream {
 	obs_output_t *output;
 
@@ -101,15 +97,12 @@ struct rtmp_stream {
 #endif
 
 	pthread_mutex_t dbr_mutex;
-	struct circlebuf dbr_frames;
-	size_t dbr_data_size;
-	uint64_t dbr_inc_timeout;
+	const struct dbr_policy_info *dbr_policy;
+	void *dbr_data;
 	long audio_bitrate;
-	long dbr_est_bitrate;
 	long dbr_orig_bitrate;
-	long dbr_prev_bitrate;
 	long dbr_cur_bitrate;
-	long dbr_inc_bitrate;
+	bool dbr_drop_frames;
 	bool dbr_enabled;
 
 	RTMP rtmp;
@@ -42,8 +42,13 @@ static void stinger_update(void *data, obs_data_t *settings)
 	struct stinger_info *s = data;
 	const char *path = obs_data_get_string(settings, "path");
 
+	int preload_max_mb = (int)obs_data_get_int(settings, "preload_max_mb");
+
+	/* the media source decodes the whole file up front when it is created
+	 * so that starting the transition does not have to wait on it */
 	obs_data_t *media_settings = obs_data_create();
 	obs_data_set_string(media_settings, "local_file", path);
+	obs_data_set_int(media_settings, "preroll_max_mb", preload_max_mb);
 
 	obs_source_release(s->media_source);
 	s->media_source = obs_source_create_private("ffmpeg_source", NULL,
@@ -93,6 +98,12 @@ static void *stinger_create(obs_data_t *settings, obs_source_t *source)
 	return s;
 }
 
+static void stinger_defaults(obs_data_t *settings)
+{
+	/* fits about 6 seconds of 1080p60 video with alpha */
+	obs_data_set_default_int(settings, "preload_max_mb", 2048);
+}
+
 static void stinger_destroy(void *data)
 {
 	struct stinger_info *s = data;
@@ -328,6 +339,11 @@ static obs_properties_t *stinger_properties(void *data)
 			       obs_module_text("TransitionPoint"), 0, 120000,
 			       1);
 
+	p = obs_properties_add_int(ppts, "preload_max_mb",
+				   obs_module_text("PreloadMemoryLimit"), 0,
+				   4096, 32);
+	obs_property_int_set_suffix(p, " MB");
+
 	obs_property_t *monitor_list = obs_properties_add_list(
 		ppts, "audio_monitoring", obs_module_text("AudioMonitoring"),
 		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
@@ -363,6 +379,7 @@ struct obs_source_info stinger_transition = {
 	.create = stinger_create,
 	.destroy = stinger_destroy,
 	.update = stinger_update,
+	.get_defaults = stinger_defaults,
 	.video_render = stinger_video_render,
 	.audio_render = stinger_audio_render,
 	.get_properties = stinger_properties,
@@ -0,0 +1,806 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include <obs.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/profiler.h>
+#include <util/threading.h>
+
+/* Runs a synthetic scene collection through libobs without a frontend and
+ * reports how long each stage of the pipeline took:
+ *
+ *   obs-bench --spec specs/basic.json --duration 30 --json results.json
+ *
+ * The spec lists the scenes to build.  The first scene is put on output
+ * channel 0; each item creates "count" sources of the given type (or adds
+ * another scene from the spec), with optional filters:
+ *
+ *   {
+ *     "video": { "width": 1280, "height": 720, "fps": 60 },
+ *     "audio": { "samples_per_sec": 48000 },
+ *     "scenes": [
+ *       { "name": "main", "items": [
+ *         { "source": "color_source", "count": 8,
+ *           "settings": { "width": 320, "height": 180 },
+ *           "filters": [ { "id": "color_filter" } ] },
+ *         { "scene": "nested" } ] },
+ *       { "name": "nested", "items": [
+ *         { "source": "test_sinewave" } ] }
+ *     ]
+ *   }
+ *
+ * Raw video and audio callbacks are connected by default so the output
+ * conversion and readback stages run as they would when recording.  When
+ * there is no display server the headless EGL renderer is used, which also
+ * works with Mesa's llvmpipe on machines without a GPU. */
+
+struct bench_params {
+	const char *spec_path;
+	const char *json_path;
+	const char *trace_path;
+	const char *graphics_module;
+	const char *plugin_bin_path;
+	const char *plugin_data_path;
+	int duration_sec;
+	int warmup_sec;
+	int depth;
+	bool no_output;
+	bool verbose;
+};
+
+struct bench_counters {
+	uint32_t total_frames;
+	uint32_t lagged_frames;
+	uint32_t output_frames;
+	uint32_t skipped_frames;
+};
+
+struct bench {
+	struct bench_params params;
+	obs_data_t *spec;
+
+	DARRAY(obs_scene_t *) scenes;
+	DARRAY(obs_source_t *) sources;
+
+	volatile long video_frames;
+	volatile long audio_packets;
+
+	struct bench_counters start;
+	struct bench_counters end;
+
+	uint64_t resident_start;
+	uint64_t resident_peak;
+	uint64_t resident_end;
+	long allocs_end;
+
+	double run_sec;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void do_log(int log_level, const char *msg, va_list args, void *param)
+{
+	bool verbose = *(bool *)param;
+
+	if (log_level > LOG_WARNING && !verbose)
+		return;
+
+	vfprintf(stderr, msg, args);
+	fprintf(stderr, "\n");
+}
+
+static int get_spec_int(obs_data_t *spec, const char *obj, const char *name,
+			int def)
+{
+	obs_data_t *data = obs_data_get_obj(spec, obj);
+	int val = def;
+
+	if (data && obs_data_has_user_value(data, name))
+		val = (int)obs_data_get_int(data, name);
+
+	obs_data_release(data);
+	return val;
+}
+
+static bool init_obs(struct bench *bench)
+{
+	obs_data_t *spec = bench->spec;
+	int width = get_spec_int(spec, "video", "width", 1280);
+	int height = get_spec_int(spec, "video", "height", 720);
+	int out_width = get_spec_int(spec, "video", "output_width", width);
+	int out_height = get_spec_int(spec, "video", "output_height", height);
+	struct obs_audio_info oai = {
+		.samples_per_sec = (uint32_t)get_spec_int(
+			spec, "audio", "samples_per_sec", 48000),
+		.speakers = SPEAKERS_STEREO,
+	};
+	struct obs_video_info ovi = {
+		.graphics_module = bench->params.graphics_module,
+		.fps_num = (uint32_t)get_spec_int(spec, "video", "fps", 60),
+		.fps_den = 1,
+		.base_width = (uint32_t)width,
+		.base_height = (uint32_t)height,
+		.output_width = (uint32_t)out_width,
+		.output_height = (uint32_t)out_height,
+		.output_format = VIDEO_FORMAT_NV12,
+		.adapter = 0,
+		.gpu_conversion = true,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+		.scale_type = OBS_SCALE_BICUBIC,
+	};
+	int ret;
+
+	if (!obs_startup("en-US", NULL, NULL))
+		return false;
+	if (!obs_reset_audio(&oai)) {
+		fprintf(stderr, "failed to reset audio\n");
+		return false;
+	}
+
+	ret = obs_reset_video(&ovi);
+	if (ret != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr,
+			"failed to reset video (%d) with the '%s' graphics "
+			"module\n",
+			ret, ovi.graphics_module);
+		return false;
+	}
+
+	if (bench->params.plugin_bin_path)
+		obs_add_module_path(bench->params.plugin_bin_path,
+				    bench->params.plugin_data_path);
+
+	obs_load_all_modules();
+	obs_post_load_modules();
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* scene building */
+
+static obs_scene_t *find_scene(struct bench *bench, const char *name)
+{
+	for (size_t i = 0; i < bench->scenes.num; i++) {
+		obs_scene_t *scene = bench->scenes.array[i];
+		obs_source_t *source = obs_scene_get_source(scene);
+
+		if (strcmp(obs_source_get_name(source), name) == 0)
+			return bench->scenes.array[i];
+	}
+
+	return NULL;
+}
+
+static void add_filters(struct bench *bench, obs_source_t *source,
+			obs_data_array_t *filters)
+{
+	size_t num = obs_data_array_count(filters);
+
+	for (size_t i = 0; i < num; i++) {
+		obs_data_t *item = obs_data_array_item(filters, i);
+		obs_data_t *settings = obs_data_get_obj(item, "settings");
+		const char *id = obs_data_get_string(item, "id");
+		struct dstr name = {0};
+		obs_source_t *filter;
+
+		dstr_printf(&name, "%s: %s %d", obs_source_get_name(source),
+			    id, (int)i);
+
+		filter = obs_source_create(id, name.array, settings, NULL);
+		if (filter) {
+			obs_source_filter_add(source, filter);
+			da_push_back(bench->sources, &filter);
+		} else {
+			fprintf(stderr, "failed to create filter '%s'\n", id);
+		}
+
+		dstr_free(&name);
+		obs_data_release(settings);
+		obs_data_release(item);
+	}
+}
+
+static bool add_item_source(struct bench *bench, obs_data_t *item,
+			    int index, obs_source_t **out)
+{
+	const char *scene_name = obs_data_get_string(item, "scene");
+	const char *id = obs_data_get_string(item, "source");
+	obs_data_t *settings;
+	struct dstr name = {0};
+	obs_source_t *source;
+
+	if (*scene_name) {
+		obs_scene_t *scene = find_scene(bench, scene_name);
+		if (!scene) {
+			fprintf(stderr, "unknown scene '%s'\n", scene_name);
+			return false;
+		}
+
+		*out = obs_source_get_ref(obs_scene_get_source(scene));
+		return true;
+	}
+
+	if (!*id) {
+		fprintf(stderr, "scene items need a 'source' or 'scene'\n");
+		return false;
+	}
+
+	dstr_printf(&name, "%s %d", id, index);
+	settings = obs_data_get_obj(item, "settings");
+	source = obs_source_create(id, name.array, settings, NULL);
+	obs_data_release(settings);
+	dstr_free(&name);
+
+	if (!source) {
+		fprintf(stderr, "failed to create source '%s', is its "
+				"module available?\n",
+			id);
+		return false;
+	}
+
+	obs_source_t *ref = obs_source_get_ref(source);
+	da_push_back(bench->sources, &ref);
+	*out = source;
+	return true;
+}
+
+/* items are laid out on a grid so all of them are visible */
+static void place_item(obs_sceneitem_t *item, int index, int total)
+{
+	struct obs_video_info ovi;
+	int cols = (int)ceil(sqrt((double)total));
+	int rows = (total + cols - 1) / cols;
+	struct vec2 pos, bounds;
+
+	obs_get_video_info(&ovi);
+
+	vec2_set(&bounds, (float)ovi.base_width / (float)cols,
+		 (float)ovi.base_height / (float)rows);
+	vec2_set(&pos, bounds.x * (float)(index % cols),
+		 bounds.y * (float)(index / cols));
+
+	obs_sceneitem_set_pos(item, &pos);
+	obs_sceneitem_set_bounds_type(item, OBS_BOUNDS_SCALE_INNER);
+	obs_sceneitem_set_bounds(item, &bounds);
+}
+
+static int count_items(obs_data_array_t *items)
+{
+	size_t num = obs_data_array_count(items);
+	int total = 0;
+
+	for (size_t i = 0; i < num; i++) {
+		obs_data_t *item = obs_data_array_item(items, i);
+		int count = obs_data_has_user_value(item, "count")
+				    ? (int)obs_data_get_int(item, "count")
+				    : 1;
+		total += count;
+		obs_data_release(item);
+	}
+
+	return total;
+}
+
+static bool populate_scene(struct bench *bench, obs_scene_t *scene,
+			   obs_data_array_t *items)
+{
+	size_t num = obs_data_array_count(items);
+	int total = count_items(items);
+	int index = 0;
+	bool success = true;
+
+	for (size_t i = 0; success && i < num; i++) {
+		obs_data_t *item = obs_data_array_item(items, i);
+		obs_data_array_t *filters = obs_data_get_array(item, "filters");
+		int count = obs_data_has_user_value(item, "count")
+				    ? (int)obs_data_get_int(item, "count")
+				    : 1;
+
+		for (int j = 0; j < count; j++) {
+			int idx = (int)bench->sources.num;
+			obs_sceneitem_t *sceneitem;
+			obs_source_t *source;
+
+			if (!add_item_source(bench, item, idx, &source)) {
+				success = false;
+				break;
+			}
+
+			if (filters)
+				add_filters(bench, source, filters);
+
+			sceneitem = obs_scene_add(scene, source);
+			if (sceneitem)
+				place_item(sceneitem, index, total);
+			else
+				fprintf(stderr, "failed to add '%s' to a "
+						"scene\n",
+					obs_source_get_name(source));
+
+			obs_source_release(source);
+			index++;
+		}
+
+		obs_data_array_release(filters);
+		obs_data_release(item);
+	}
+
+	return success;
+}
+
+static bool build_scenes(struct bench *bench)
+{
+	obs_data_array_t *scenes = obs_data_get_array(bench->spec, "scenes");
+	size_t num = obs_data_array_count(scenes);
+	bool success = num > 0;
+
+	if (!num)
+		fprintf(stderr, "the spec has no scenes\n");
+
+	/* scenes are created first so items can refer to any of them */
+	for (size_t i = 0; i < num; i++) {
+		obs_data_t *data = obs_data_array_item(scenes, i);
+		obs_scene_t *scene =
+			obs_scene_create(obs_data_get_string(data, "name"));
+
+		da_push_back(bench->scenes, &scene);
+		obs_data_release(data);
+	}
+
+	for (size_t i = 0; success && i < num; i++) {
+		obs_data_t *data = obs_data_array_item(scenes, i);
+		obs_data_array_t *items = obs_data_get_array(data, "items");
+		obs_source_t *source =
+			obs_scene_get_source(bench->scenes.array[i]);
+
+		success = populate_scene(bench, bench->scenes.array[i], items);
+		da_push_back(bench->sources, &source);
+		obs_source_addref(source);
+
+		obs_data_array_release(items);
+		obs_data_release(data);
+	}
+
+	obs_data_array_release(scenes);
+
+	if (success)
+		obs_set_output_source(0, obs_scene_get_source(
+						 bench->scenes.array[0]));
+	return success;
+}
+
+static void free_scenes(struct bench *bench)
+{
+	obs_set_output_source(0, NULL);
+
+	for (size_t i = 0; i < bench->sources.num; i++)
+		obs_source_release(bench->sources.array[i]);
+	for (size_t i = 0; i < bench->scenes.num; i++)
+		obs_scene_release(bench->scenes.array[i]);
+
+	da_free(bench->sources);
+	da_free(bench->scenes);
+}
+
+/* ------------------------------------------------------------------------- */
+/* running */
+
+static void raw_video(void *param, struct video_data *frame)
+{
+	struct bench *bench = param;
+	os_atomic_inc_long(&bench->video_frames);
+	UNUSED_PARAMETER(frame);
+}
+
+static void raw_audio(void *param, size_t mix_idx, struct audio_data *data)
+{
+	struct bench *bench = param;
+	os_atomic_inc_long(&bench->audio_packets);
+	UNUSED_PARAMETER(mix_idx);
+	UNUSED_PARAMETER(data);
+}
+
+static void get_counters(struct bench_counters *counters)
+{
+	video_t *video = obs_get_video();
+
+	counters->total_frames = obs_get_total_frames();
+	counters->lagged_frames = obs_get_lagged_frames();
+	counters->output_frames = video_output_get_total_frames(video);
+	counters->skipped_frames = video_output_get_skipped_frames(video);
+}
+
+static void sample_memory(struct bench *bench)
+{
+	uint64_t resident = os_get_proc_resident_size();
+	if (resident > bench->resident_peak)
+		bench->resident_peak = resident;
+}
+
+static void wait_sampling(struct bench *bench, int sec)
+{
+	uint64_t end = os_gettime_ns() + (uint64_t)sec * 1000000000ULL;
+
+	while (os_gettime_ns() < end) {
+		os_sleep_ms(100);
+		sample_memory(bench);
+	}
+}
+
+static void run_bench(struct bench *bench)
+{
+	uint64_t start_time;
+
+	if (!bench->params.no_output) {
+		obs_add_raw_video_callback(NULL, raw_video, bench);
+		audio_output_connect(obs_get_audio(), 0, NULL, raw_audio,
+				     bench);
+	}
+
+	wait_sampling(bench, bench->params.warmup_sec);
+
+	/* everything but the profiler starts counting after the warmup */
+	for (size_t i = 0; i < bench->sources.num; i++)
+		obs_source_reset_perf_stats(bench->sources.array[i]);
+	os_atomic_set_long(&bench->video_frames, 0);
+	os_atomic_set_long(&bench->audio_packets, 0);
+	get_counters(&bench->start);
+	bench->resident_start = os_get_proc_resident_size();
+	bench->resident_peak = bench->resident_start;
+
+	if (bench->params.trace_path)
+		profiler_trace_start();
+
+	start_time = os_gettime_ns();
+	wait_sampling(bench, bench->params.duration_sec);
+	bench->run_sec = (double)(os_gettime_ns() - start_time) / 1000000000.0;
+
+	if (bench->params.trace_path)
+		profiler_trace_stop();
+
+	get_counters(&bench->end);
+	bench->resident_end = os_get_proc_resident_size();
+	bench->allocs_end = bnum_allocs();
+
+	if (!bench->params.no_output) {
+		obs_remove_raw_video_callback(raw_video, bench);
+		audio_output_disconnect(obs_get_audio(), 0, raw_audio, bench);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* reporting */
+
+struct stage_report {
+	obs_data_array_t *stages;
+	struct dstr indent;
+	struct dstr path;
+	int depth;
+	int max_depth;
+};
+
+/* profiler times are in microseconds, sorted longest first */
+static uint64_t time_percentile(profiler_time_entries_t *times,
+				uint64_t total, double pct)
+{
+	uint64_t target = (uint64_t)ceil((double)total * pct);
+	uint64_t seen = 0;
+
+	if (!target)
+		target = 1;
+
+	for (size_t i = times->num; i > 0; i--) {
+		seen += times->array[i - 1].count;
+		if (seen >= target)
+			return times->array[i - 1].time_delta;
+	}
+
+	return 0;
+}
+
+static bool report_stage(void *param, profiler_snapshot_entry_t *entry)
+{
+	struct stage_report *report = param;
+	profiler_time_entries_t *times = profiler_snapshot_entry_times(entry);
+	uint64_t calls = profiler_snapshot_entry_overall_count(entry);
+	const char *name = profiler_snapshot_entry_name(entry);
+	size_t path_len = report->path.len;
+	size_t indent_len = report->indent.len;
+
+	if (calls < 2)
+		return true;
+
+	uint64_t p50 = time_percentile(times, calls, 0.50);
+	uint64_t p90 = time_percentile(times, calls, 0.90);
+	uint64_t p99 = time_percentile(times, calls, 0.99);
+	uint64_t max = profiler_snapshot_entry_max_time(entry);
+
+	if (report->path.len)
+		dstr_cat(&report->path, " / ");
+	dstr_cat(&report->path, name);
+
+	printf("%s%-*s %8" PRIu64 " %8.3f %8.3f %8.3f %8.3f\n",
+	       report->indent.array ? report->indent.array : "",
+	       48 - (int)report->indent.len, name, calls, p50 / 1000.0,
+	       p90 / 1000.0, p99 / 1000.0, max / 1000.0);
+
+	obs_data_t *stage = obs_data_create();
+	obs_data_set_string(stage, "name", report->path.array);
+	obs_data_set_int(stage, "calls", (long long)calls);
+	obs_data_set_int(stage, "p50_us", (long long)p50);
+	obs_data_set_int(stage, "p90_us", (long long)p90);
+	obs_data_set_int(stage, "p99_us", (long long)p99);
+	obs_data_set_int(stage, "max_us", (long long)max);
+	obs_data_array_push_back(report->stages, stage);
+	obs_data_release(stage);
+
+	if (report->depth + 1 < report->max_depth) {
+		report->depth++;
+		dstr_cat(&report->indent, "  ");
+		profiler_snapshot_enumerate_children(entry, report_stage,
+						     report);
+		report->depth--;
+	}
+
+	dstr_resize(&report->path, path_len);
+	dstr_resize(&report->indent, indent_len);
+	return true;
+}
+
+static void report_stages(struct bench *bench, obs_data_t *results)
+{
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	struct stage_report report = {
+		.stages = obs_data_array_create(),
+		.max_depth = bench->params.depth,
+	};
+
+	printf("%-48s %8s %8s %8s %8s %8s\n", "stage (ms)", "calls", "p50",
+	       "p90", "p99", "max");
+	profiler_snapshot_enumerate_roots(snap, report_stage, &report);
+
+	obs_data_set_array(results, "stages", report.stages);
+	obs_data_array_release(report.stages);
+	dstr_free(&report.indent);
+	dstr_free(&report.path);
+	profile_snapshot_free(snap);
+}
+
+static inline double avg_ms(const struct obs_source_perf_timing *timing)
+{
+	return timing->count ? (double)timing->total_ns /
+				       (double)timing->count / 1000000.0
+			     : 0.0;
+}
+
+static void report_sources(struct bench *bench, obs_data_t *results)
+{
+	obs_data_array_t *array = obs_data_array_create();
+
+	printf("\n%-48s %8s %8s %8s %8s\n", "source (avg ms)", "render", "gpu",
+	       "tick", "audio");
+
+	for (size_t i = 0; i < bench->sources.num; i++) {
+		obs_source_t *source = bench->sources.array[i];
+		struct obs_source_perf_stats stats;
+
+		if (!obs_source_get_perf_stats(source, &stats))
+			continue;
+
+		printf("%-48s %8.3f %8.3f %8.3f %8.3f\n",
+		       obs_source_get_name(source), avg_ms(&stats.render),
+		       avg_ms(&stats.render_gpu), avg_ms(&stats.tick),
+		       avg_ms(&stats.audio));
+
+		obs_data_t *data = obs_data_create();
+		obs_data_set_string(data, "name", obs_source_get_name(source));
+		obs_data_set_double(data, "render_ms", avg_ms(&stats.render));
+		obs_data_set_double(data, "render_gpu_ms",
+				    avg_ms(&stats.render_gpu));
+		obs_data_set_double(data, "tick_ms", avg_ms(&stats.tick));
+		obs_data_set_double(data, "audio_ms", avg_ms(&stats.audio));
+		obs_data_array_push_back(array, data);
+		obs_data_release(data);
+	}
+
+	obs_data_set_array(results, "sources", array);
+	obs_data_array_release(array);
+}
+
+static void report_frames(struct bench *bench, obs_data_t *results)
+{
+	uint32_t total = bench->end.total_frames - bench->start.total_frames;
+	uint32_t lagged = bench->end.lagged_frames - bench->start.lagged_frames;
+	uint32_t output = bench->end.output_frames - bench->start.output_frames;
+	uint32_t skipped = bench->end.skipped_frames -
+			   bench->start.skipped_frames;
+	long video_frames = os_atomic_load_long(&bench->video_frames);
+	long audio_packets = os_atomic_load_long(&bench->audio_packets);
+
+	printf("\nduration:        %.1f s\n", bench->run_sec);
+	printf("rendered frames: %" PRIu32 " (%.2f fps)\n", total,
+	       bench->run_sec > 0.0 ? (double)total / bench->run_sec : 0.0);
+	printf("lagged frames:   %" PRIu32 " (%.2f%%)\n", lagged,
+	       total ? (double)lagged * 100.0 / (double)total : 0.0);
+	printf("skipped frames:  %" PRIu32 " / %" PRIu32 " (%.2f%%)\n",
+	       skipped, output,
+	       output ? (double)skipped * 100.0 / (double)output : 0.0);
+	printf("raw output:      %ld video frames, %ld audio packets\n",
+	       video_frames, audio_packets);
+	printf("resident memory: %.1f MB start, %.1f MB peak, %.1f MB end\n",
+	       (double)bench->resident_start / 1048576.0,
+	       (double)bench->resident_peak / 1048576.0,
+	       (double)bench->resident_end / 1048576.0);
+	printf("allocations:     %ld\n", bench->allocs_end);
+
+	obs_data_set_double(results, "duration_sec", bench->run_sec);
+	obs_data_set_int(results, "rendered_frames", total);
+	obs_data_set_int(results, "lagged_frames", lagged);
+	obs_data_set_int(results, "output_frames", output);
+	obs_data_set_int(results, "skipped_frames", skipped);
+	obs_data_set_int(results, "raw_video_frames", video_frames);
+	obs_data_set_int(results, "raw_audio_packets", audio_packets);
+	obs_data_set_int(results, "resident_start",
+			 (long long)bench->resident_start);
+	obs_data_set_int(results, "resident_peak",
+			 (long long)bench->resident_peak);
+	obs_data_set_int(results, "resident_end",
+			 (long long)bench->resident_end);
+	obs_data_set_int(results, "allocations", bench->allocs_end);
+}
+
+static bool report(struct bench *bench)
+{
+	obs_data_t *results = obs_data_create();
+	bool success = true;
+
+	report_stages(bench, results);
+	report_sources(bench, results);
+	report_frames(bench, results);
+
+	if (bench->params.json_path &&
+	    !obs_data_save_json(results, bench->params.json_path)) {
+		fprintf(stderr, "failed to write '%s'\n",
+			bench->params.json_path);
+		success = false;
+	}
+
+	if (bench->params.trace_path &&
+	    !profiler_trace_dump_json(bench->params.trace_path)) {
+		fprintf(stderr, "failed to write '%s'\n",
+			bench->params.trace_path);
+		success = false;
+	}
+
+	obs_data_release(results);
+	return success;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void usage(void)
+{
+	printf("usage: obs-bench --spec <file> [options]\n"
+	       "  --spec <file>             scene spec, see obs-bench.c\n"
+	       "  --duration <sec>          measured length of the run (20)\n"
+	       "  --warmup <sec>            unmeasured start of the run (2)\n"
+	       "  --json <file>             write the results as json\n"
+	       "  --trace <file>            write a chrome trace of the "
+	       "measured run\n"
+	       "  --depth <n>               stage tree depth to report (4)\n"
+	       "  --graphics <module>       graphics module (headless EGL "
+	       "without a display)\n"
+	       "  --plugins <bin> <data>    additional module path\n"
+	       "  --no-output               don't connect raw outputs\n"
+	       "  --verbose                 show libobs info logging\n");
+}
+
+static bool parse_args(int argc, char *argv[], struct bench_params *params)
+{
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+		bool has_val = true;
+
+		if (strcmp(arg, "--no-output") == 0) {
+			params->no_output = true;
+			has_val = false;
+		} else if (strcmp(arg, "--verbose") == 0) {
+			params->verbose = true;
+			has_val = false;
+		} else if (!val) {
+			return false;
+		} else if (strcmp(arg, "--spec") == 0) {
+			params->spec_path = val;
+		} else if (strcmp(arg, "--duration") == 0) {
+			params->duration_sec = atoi(val);
+		} else if (strcmp(arg, "--warmup") == 0) {
+			params->warmup_sec = atoi(val);
+		} else if (strcmp(arg, "--json") == 0) {
+			params->json_path = val;
+		} else if (strcmp(arg, "--trace") == 0) {
+			params->trace_path = val;
+		} else if (strcmp(arg, "--depth") == 0) {
+			params->depth = atoi(val);
+		} else if (strcmp(arg, "--graphics") == 0) {
+			params->graphics_module = val;
+		} else if (strcmp(arg, "--plugins") == 0) {
+			if (i + 2 >= argc)
+				return false;
+			params->plugin_bin_path = val;
+			params->plugin_data_path = argv[i + 2];
+			i++;
+		} else {
+			return false;
+		}
+
+		if (has_val)
+			i++;
+	}
+
+	return params->spec_path && params->duration_sec > 0 &&
+	       params->warmup_sec >= 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench bench = {
+		.params =
+			{
+				.duration_sec = 20,
+				.warmup_sec = 2,
+				.depth = 4,
+			},
+	};
+	int ret = 1;
+
+	if (!parse_args(argc, argv, &bench.params)) {
+		usage();
+		return 1;
+	}
+
+	/* without a display server, render through EGL when it was built */
+	if (!bench.params.graphics_module) {
+		bool headless = !getenv("DISPLAY") && *DL_OPENGL_EGL;
+		bench.params.graphics_module = headless ? DL_OPENGL_EGL
+							: DL_OPENGL;
+	}
+
+	base_set_log_handler(do_log, &bench.params.verbose);
+
+	bench.spec = obs_data_create_from_json_file(bench.params.spec_path);
+	if (!bench.spec) {
+		fprintf(stderr, "failed to load '%s'\n",
+			bench.params.spec_path);
+		return 1;
+	}
+
+	profiler_start();
+
+	if (!init_obs(&bench)) {
+		fprintf(stderr, "failed to initialize libobs\n");
+		goto exit;
+	}
+
+	obs_set_source_perf_stats_enabled(true);
+
+	if (build_scenes(&bench)) {
+		run_bench(&bench);
+		ret = report(&bench) ? 0 : 1;
+	}
+
+	free_scenes(&bench);
+
+exit:
+	obs_data_release(bench.spec);
+	obs_shutdown();
+	profiler_stop();
+	profiler_free();
+	return ret;
+}
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <media-io/audio-resampler.h>
+
+#include <libavutil/channel_layout.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+
+/* Times audio_resampler_resample against calling swresample directly for
+ * the conversions libobs does most often:
+ *
+ *   resampler-bench [--iterations 2000] [--frames 1024]
+ *
+ * The input is a 1 kHz sine.  For conversions that keep the sample rate the
+ * largest difference between the two outputs is reported as well; for rate
+ * changes the two filters differ, so only the frame counts are compared. */
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+
+struct bench_case {
+	const char *name;
+	struct resample_info src;
+	struct resample_info dst;
+};
+
+static const struct bench_case cases[] = {
+	{"fltp -> s16 stereo",
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO},
+	 {48000, AUDIO_FORMAT_16BIT, SPEAKERS_STEREO}},
+	{"s16 stereo -> fltp",
+	 {48000, AUDIO_FORMAT_16BIT, SPEAKERS_STEREO},
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO}},
+	{"flt -> fltp stereo",
+	 {48000, AUDIO_FORMAT_FLOAT, SPEAKERS_STEREO},
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO}},
+	{"fltp -> s32 5.1",
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_5POINT1},
+	 {48000, AUDIO_FORMAT_32BIT, SPEAKERS_5POINT1}},
+	{"s16 mono -> fltp stereo",
+	 {48000, AUDIO_FORMAT_16BIT, SPEAKERS_MONO},
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO}},
+	{"24 kHz -> 48 kHz fltp",
+	 {24000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO},
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO}},
+	{"96 kHz s16 -> 48 kHz fltp",
+	 {96000, AUDIO_FORMAT_16BIT, SPEAKERS_STEREO},
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO}},
+	{"44.1 kHz -> 48 kHz fltp",
+	 {44100, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO},
+	 {48000, AUDIO_FORMAT_FLOAT_PLANAR, SPEAKERS_STEREO}},
+};
+
+#define NUM_CASES (sizeof(cases) / sizeof(cases[0]))
+
+/* ------------------------------------------------------------------------- */
+
+static enum AVSampleFormat av_format(enum audio_format format)
+{
+	switch (format) {
+	case AUDIO_FORMAT_U8BIT:
+		return AV_SAMPLE_FMT_U8;
+	case AUDIO_FORMAT_16BIT:
+		return AV_SAMPLE_FMT_S16;
+	case AUDIO_FORMAT_32BIT:
+		return AV_SAMPLE_FMT_S32;
+	case AUDIO_FORMAT_FLOAT:
+		return AV_SAMPLE_FMT_FLT;
+	case AUDIO_FORMAT_U8BIT_PLANAR:
+		return AV_SAMPLE_FMT_U8P;
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		return AV_SAMPLE_FMT_S16P;
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		return AV_SAMPLE_FMT_S32P;
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+	case AUDIO_FORMAT_UNKNOWN:
+		break;
+	}
+
+	return AV_SAMPLE_FMT_FLTP;
+}
+
+static uint64_t av_layout(enum speaker_layout layout)
+{
+	switch (layout) {
+	case SPEAKERS_MONO:
+		return AV_CH_LAYOUT_MONO;
+	case SPEAKERS_2POINT1:
+		return AV_CH_LAYOUT_SURROUND;
+	case SPEAKERS_4POINT0:
+		return AV_CH_LAYOUT_4POINT0;
+	case SPEAKERS_4POINT1:
+		return AV_CH_LAYOUT_4POINT1;
+	case SPEAKERS_5POINT1:
+		return AV_CH_LAYOUT_5POINT1_BACK;
+	case SPEAKERS_7POINT1:
+		return AV_CH_LAYOUT_7POINT1;
+	case SPEAKERS_STEREO:
+	case SPEAKERS_UNKNOWN:
+		break;
+	}
+
+	return AV_CH_LAYOUT_STEREO;
+}
+
+static struct SwrContext *create_swr(const struct bench_case *c)
+{
+	struct SwrContext *swr = swr_alloc_set_opts(
+		NULL, (int64_t)av_layout(c->dst.speakers),
+		av_format(c->dst.format), c->dst.samples_per_sec,
+		(int64_t)av_layout(c->src.speakers), av_format(c->src.format),
+		c->src.samples_per_sec, 0, NULL);
+
+	if (swr && c->src.speakers == SPEAKERS_MONO &&
+	    c->dst.speakers != SPEAKERS_MONO) {
+		/* same upmix as audio-resampler-ffmpeg.c */
+		const double matrix[MAX_AUDIO_CHANNELS][MAX_AUDIO_CHANNELS] = {
+			{1},
+			{1, 1},
+			{1, 1, 0},
+			{1, 1, 1, 1},
+			{1, 1, 1, 0, 1},
+			{1, 1, 1, 1, 1, 1},
+			{1, 1, 1, 0, 1, 1, 1},
+			{1, 1, 1, 0, 1, 1, 1, 1},
+		};
+		uint32_t channels = get_audio_channels(c->dst.speakers);
+
+		swr_set_matrix(swr, matrix[channels - 1], 1);
+	}
+
+	if (swr && swr_init(swr) != 0)
+		swr_free(&swr);
+	return swr;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void fill_input(const struct bench_case *c, uint8_t *planes[],
+		       uint32_t frames)
+{
+	uint32_t channels = get_audio_channels(c->src.speakers);
+	bool planar = is_audio_planar(c->src.format);
+
+	for (uint32_t i = 0; i < frames; i++) {
+		double val = 0.5 * sin(2.0 * M_PI * 1000.0 * i /
+				       c->src.samples_per_sec);
+
+		for (uint32_t ch = 0; ch < channels; ch++) {
+			uint8_t *plane = planes[planar ? ch : 0];
+			size_t idx = planar ? i : i * channels + ch;
+
+			switch (c->src.format) {
+			case AUDIO_FORMAT_16BIT:
+			case AUDIO_FORMAT_16BIT_PLANAR:
+				((int16_t *)plane)[idx] =
+					(int16_t)(val * 32767.0);
+				break;
+			case AUDIO_FORMAT_FLOAT:
+			case AUDIO_FORMAT_FLOAT_PLANAR:
+				((float *)plane)[idx] = (float)val;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+static double sample_value(enum audio_format format, const uint8_t *plane,
+			   size_t idx)
+{
+	switch (format) {
+	case AUDIO_FORMAT_U8BIT:
+	case AUDIO_FORMAT_U8BIT_PLANAR:
+		return ((double)plane[idx] - 128.0) / 128.0;
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		return (double)((const int16_t *)plane)[idx] / 32768.0;
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		return (double)((const int32_t *)plane)[idx] / 2147483648.0;
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		return (double)((const float *)plane)[idx];
+	case AUDIO_FORMAT_UNKNOWN:
+		break;
+	}
+
+	return 0.0;
+}
+
+static double max_difference(const struct bench_case *c,
+			     uint8_t *const a[], uint8_t *const b[],
+			     uint32_t frames)
+{
+	uint32_t channels = get_audio_channels(c->dst.speakers);
+	size_t samples = (size_t)frames * channels;
+	bool planar = is_audio_planar(c->dst.format);
+	double max_diff = 0.0;
+
+	for (size_t i = 0; i < samples; i++) {
+		uint32_t plane = planar ? (uint32_t)(i / frames) : 0;
+		size_t idx = planar ? i % frames : i;
+		double diff = fabs(sample_value(c->dst.format, a[plane], idx) -
+				   sample_value(c->dst.format, b[plane], idx));
+
+		if (diff > max_diff)
+			max_diff = diff;
+	}
+
+	return max_diff;
+}
+
+static void run_case(const struct bench_case *c, int iterations,
+		     uint32_t frames)
+{
+	uint32_t in_ch = get_audio_channels(c->src.speakers);
+	uint32_t out_ch = get_audio_channels(c->dst.speakers);
+	bool in_planar = is_audio_planar(c->src.format);
+	bool out_planar = is_audio_planar(c->dst.format);
+	size_t in_size = get_audio_size(c->src.format, c->src.speakers, frames);
+	uint32_t max_out = frames * 8;
+	size_t out_size = get_audio_size(c->dst.format, c->dst.speakers,
+					 max_out);
+	uint8_t *input[MAX_AV_PLANES] = {0};
+	uint8_t *swr_out[MAX_AV_PLANES] = {0};
+	uint8_t *obs_out[MAX_AV_PLANES] = {0};
+	uint32_t obs_frames = 0, swr_frames = 0;
+	uint64_t obs_ns, swr_ns, offset, start;
+
+	audio_resampler_t *rs = audio_resampler_create(&c->dst, &c->src);
+	struct SwrContext *swr = create_swr(c);
+
+	if (!rs || !swr) {
+		printf("%-28s failed to create resamplers\n", c->name);
+		goto cleanup;
+	}
+
+	for (uint32_t i = 0; i < (in_planar ? in_ch : 1); i++)
+		input[i] = bzalloc(in_size);
+	for (uint32_t i = 0; i < (out_planar ? out_ch : 1); i++)
+		swr_out[i] = bzalloc(out_size);
+
+	fill_input(c, input, frames);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++) {
+		audio_resampler_resample(rs, obs_out, &obs_frames, &offset,
+					 (const uint8_t *const *)input,
+					 frames);
+	}
+	obs_ns = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < iterations; i++) {
+		int ret = swr_convert(swr, swr_out, (int)max_out,
+				      (const uint8_t **)input, (int)frames);
+		swr_frames = ret > 0 ? (uint32_t)ret : 0;
+	}
+	swr_ns = os_gettime_ns() - start;
+
+	printf("%-28s %8.2f ns/frame %8.2f ns/frame %6.2fx", c->name,
+	       (double)obs_ns / ((double)iterations * frames),
+	       (double)swr_ns / ((double)iterations * frames),
+	       obs_ns ? (double)swr_ns / (double)obs_ns : 0.0);
+
+	if (c->src.samples_per_sec == c->dst.samples_per_sec &&
+	    obs_frames == swr_frames)
+		printf("   max diff %.2e\n",
+		       max_difference(c, obs_out, swr_out, obs_frames));
+	else
+		printf("   frames %u/%u\n", obs_frames, swr_frames);
+
+cleanup:
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		bfree(input[i]);
+		bfree(swr_out[i]);
+	}
+	swr_free(&swr);
+	audio_resampler_destroy(rs);
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 2000;
+	uint32_t frames = 1024;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+			iterations = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = (uint32_t)atoi(argv[++i]);
+		} else {
+			printf("usage: %s [--iterations N] [--frames N]\n",
+			       argv[0]);
+			return 1;
+		}
+	}
+
+	if (iterations <= 0 || !frames)
+		return 1;
+
+	printf("%-28s %17s %17s %7s\n", "conversion", "libobs",
+	       "swresample", "speedup");
+
+	for (size_t i = 0; i < NUM_CASES; i++)
+		run_case(&cases[i], iterations, frames);
+
+	return 0;
+}
@@ -0,0 +1,612 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <obs.h>
+#include <obs-module.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "rtmp-sink.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+/* Streams synthetic encoder output through rtmp_output into a shaped
+ * loopback ingest and reports what made it through:
+ *
+ *   rtmp-bench --duration 60 --bitrate 6000 --bandwidth 4000 --dbr buffer
+ *
+ * The encoders emit packets of the configured size without touching the
+ * frames, so the numbers reflect the output and librtmp rather than an
+ * encoder. */
+
+struct bench_params {
+	int duration_sec;
+	long bitrate;
+	long audio_bitrate;
+	int keyint_sec;
+	const char *dbr_policy;
+	bool new_socket_loop;
+	bool low_latency;
+	bool verbose;
+	struct rtmp_sink_params sink;
+};
+
+/* ------------------------------------------------------------------------- */
+/* synthetic encoders */
+
+struct bench_encoder {
+	obs_encoder_t *encoder;
+	DARRAY(uint8_t) packet;
+	long bitrate;
+	int keyint_sec;
+	uint64_t frames;
+};
+
+/* what the output asked of the video encoder */
+static volatile long video_bitrate = 0;
+static volatile long video_bitrate_changes = 0;
+
+static const char *bench_video_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Bench Video Encoder";
+}
+
+static const char *bench_audio_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Bench Audio Encoder";
+}
+
+static bool bench_update(void *data, obs_data_t *settings)
+{
+	struct bench_encoder *enc = data;
+	long bitrate = (long)obs_data_get_int(settings, "bitrate");
+
+	if (obs_encoder_get_type(enc->encoder) == OBS_ENCODER_VIDEO) {
+		if (enc->bitrate && bitrate != enc->bitrate)
+			os_atomic_inc_long(&video_bitrate_changes);
+		os_atomic_set_long(&video_bitrate, bitrate);
+	}
+
+	enc->bitrate = bitrate;
+	enc->keyint_sec = (int)obs_data_get_int(settings, "keyint_sec");
+	return true;
+}
+
+static void *bench_create(obs_data_t *settings, obs_encoder_t *encoder)
+{
+	struct bench_encoder *enc = bzalloc(sizeof(*enc));
+	enc->encoder = encoder;
+	bench_update(enc, settings);
+	return enc;
+}
+
+static void bench_destroy(void *data)
+{
+	struct bench_encoder *enc = data;
+	da_free(enc->packet);
+	bfree(enc);
+}
+
+static bool bench_video_encode(void *data, struct encoder_frame *frame,
+			       struct encoder_packet *packet,
+			       bool *received_packet)
+{
+	struct bench_encoder *enc = data;
+	video_t *video = obs_encoder_video(enc->encoder);
+	const struct video_output_info *voi = video_output_get_info(video);
+	uint64_t keyint = (uint64_t)enc->keyint_sec * voi->fps_num /
+			  voi->fps_den;
+	size_t avg_size = (size_t)enc->bitrate * 1000 / 8 * voi->fps_den /
+			  voi->fps_num;
+	bool keyframe;
+	size_t size;
+
+	if (!keyint)
+		keyint = 1;
+
+	/* keyframes are three times the size of the frames between them,
+	 * which keeps the average at the requested bitrate */
+	keyframe = (enc->frames++ % keyint) == 0;
+	size = avg_size * keyint / (keyint + 2);
+	if (keyframe)
+		size *= 3;
+	if (size < 5 + RTMP_SINK_STAMP_SIZE)
+		size = 5 + RTMP_SINK_STAMP_SIZE;
+
+	da_resize(enc->packet, size);
+	memset(enc->packet.array, 0xAA, size);
+
+	/* annex-b start code and nal header, then the ingest latency stamp */
+	enc->packet.array[0] = 0;
+	enc->packet.array[1] = 0;
+	enc->packet.array[2] = 0;
+	enc->packet.array[3] = 1;
+	enc->packet.array[4] = keyframe ? 0x65 : 0x41;
+	rtmp_sink_write_stamp(enc->packet.array + 5, os_gettime_ns());
+
+	packet->data = enc->packet.array;
+	packet->size = size;
+	packet->type = OBS_ENCODER_VIDEO;
+	packet->pts = frame->pts;
+	packet->dts = frame->pts;
+	packet->keyframe = keyframe;
+	*received_packet = true;
+	return true;
+}
+
+static bool bench_video_extra_data(void *data, uint8_t **extra_data,
+				   size_t *size)
+{
+	static uint8_t header[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00,
+				   0x1F, 0xAC, 0xD9, 0x40, 0x50, 0x05, 0xBB,
+				   0x01, 0x10, 0x00, 0x00, 0x00, 0x01, 0x68,
+				   0xEB, 0xE3, 0xCB, 0x22, 0xC0};
+
+	UNUSED_PARAMETER(data);
+	*extra_data = header;
+	*size = sizeof(header);
+	return true;
+}
+
+static bool bench_audio_encode(void *data, struct encoder_frame *frame,
+			       struct encoder_packet *packet,
+			       bool *received_packet)
+{
+	struct bench_encoder *enc = data;
+	audio_t *audio = obs_encoder_audio(enc->encoder);
+	size_t size = (size_t)enc->bitrate * 1000 / 8 * 1024 /
+		      audio_output_get_sample_rate(audio);
+
+	da_resize(enc->packet, size);
+	memset(enc->packet.array, 0x21, size);
+
+	packet->data = enc->packet.array;
+	packet->size = size;
+	packet->type = OBS_ENCODER_AUDIO;
+	packet->pts = frame->pts;
+	packet->dts = frame->pts;
+	packet->keyframe = true;
+	*received_packet = true;
+	return true;
+}
+
+static size_t bench_audio_frame_size(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return 1024;
+}
+
+static bool bench_audio_extra_data(void *data, uint8_t **extra_data,
+				   size_t *size)
+{
+	static uint8_t header[] = {0x11, 0x90};
+
+	UNUSED_PARAMETER(data);
+	*extra_data = header;
+	*size = sizeof(header);
+	return true;
+}
+
+static void bench_audio_info(void *data, struct audio_convert_info *info)
+{
+	UNUSED_PARAMETER(data);
+	info->format = AUDIO_FORMAT_FLOAT_PLANAR;
+}
+
+static struct obs_encoder_info bench_video_encoder = {
+	.id = "bench_video_encoder",
+	.type = OBS_ENCODER_VIDEO,
+	.codec = "h264",
+	.get_name = bench_video_name,
+	.create = bench_create,
+	.destroy = bench_destroy,
+	.update = bench_update,
+	.encode = bench_video_encode,
+	.get_extra_data = bench_video_extra_data,
+	.caps = OBS_ENCODER_CAP_DYN_BITRATE,
+};
+
+static struct obs_encoder_info bench_audio_encoder = {
+	.id = "bench_audio_encoder",
+	.type = OBS_ENCODER_AUDIO,
+	.codec = "AAC",
+	.get_name = bench_audio_name,
+	.create = bench_create,
+	.destroy = bench_destroy,
+	.update = bench_update,
+	.encode = bench_audio_encode,
+	.get_frame_size = bench_audio_frame_size,
+	.get_extra_data = bench_audio_extra_data,
+	.get_audio_info = bench_audio_info,
+};
+
+/* ------------------------------------------------------------------------- */
+/* loopback service */
+
+struct bench_service {
+	struct dstr url;
+};
+
+static const char *bench_service_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Bench Service";
+}
+
+static void *bench_service_create(obs_data_t *settings, obs_service_t *service)
+{
+	struct bench_service *bs = bzalloc(sizeof(*bs));
+	dstr_copy(&bs->url, obs_data_get_string(settings, "server"));
+
+	UNUSED_PARAMETER(service);
+	return bs;
+}
+
+static void bench_service_destroy(void *data)
+{
+	struct bench_service *bs = data;
+	dstr_free(&bs->url);
+	bfree(bs);
+}
+
+static const char *bench_service_url(void *data)
+{
+	struct bench_service *bs = data;
+	return bs->url.array;
+}
+
+static const char *bench_service_key(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return "bench";
+}
+
+static struct obs_service_info bench_service = {
+	.id = "bench_service",
+	.get_name = bench_service_name,
+	.create = bench_service_create,
+	.destroy = bench_service_destroy,
+	.get_url = bench_service_url,
+	.get_key = bench_service_key,
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void do_log(int log_level, const char *msg, va_list args, void *param)
+{
+	bool verbose = *(bool *)param;
+
+	if (log_level > LOG_WARNING && !verbose)
+		return;
+
+	vfprintf(stderr, msg, args);
+	fprintf(stderr, "\n");
+}
+
+static bool init_obs(void)
+{
+	struct obs_audio_info oai = {
+		.samples_per_sec = 48000,
+		.speakers = SPEAKERS_STEREO,
+	};
+	/* without a display server, render through EGL when it was built */
+	bool headless = !getenv("DISPLAY") && *DL_OPENGL_EGL;
+	struct obs_video_info ovi = {
+		.graphics_module = headless ? DL_OPENGL_EGL : DL_OPENGL,
+		.fps_num = 30,
+		.fps_den = 1,
+		.base_width = 320,
+		.base_height = 180,
+		.output_width = 320,
+		.output_height = 180,
+		.output_format = VIDEO_FORMAT_NV12,
+		.adapter = 0,
+		.gpu_conversion = true,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+		.scale_type = OBS_SCALE_BICUBIC,
+	};
+
+	if (!obs_startup("en-US", NULL, NULL))
+		return false;
+	if (!obs_reset_audio(&oai))
+		return false;
+	if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS)
+		return false;
+
+	obs_load_all_modules();
+	obs_post_load_modules();
+
+	obs_register_encoder(&bench_video_encoder);
+	obs_register_encoder(&bench_audio_encoder);
+	obs_register_service(&bench_service);
+	return true;
+}
+
+static void output_stopped(void *data, calldata_t *cd)
+{
+	os_event_t *stopped = data;
+	os_event_signal(stopped);
+	UNUSED_PARAMETER(cd);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+	uint32_t va = *(const uint32_t *)a;
+	uint32_t vb = *(const uint32_t *)b;
+	return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+static double percentile_ms(const uint32_t *sorted, size_t num, int pct)
+{
+	if (!num)
+		return 0.0;
+	return (double)sorted[(num - 1) * pct / 100] / 1000.0;
+}
+
+static void print_report(obs_output_t *output, struct rtmp_sink_stats *stats)
+{
+	double media_sec = (double)(stats->last_media_ns -
+				    stats->first_media_ns) /
+			   1000000000.0;
+	uint32_t *lat = stats->latency_usec.array;
+	size_t num = stats->latency_usec.num;
+	int dropped = obs_output_get_frames_dropped(output);
+	int total = obs_output_get_total_frames(output);
+
+	qsort(lat, num, sizeof(*lat), compare_u32);
+
+	printf("throughput:      %.0f kbps (%" PRIu64 " bytes in %.1f s)\n",
+	       media_sec > 0.0 ? (double)stats->media_bytes * 8.0 / media_sec /
+					 1000.0
+			       : 0.0,
+	       stats->media_bytes, media_sec);
+	printf("frames:          %" PRIu64 " video, %" PRIu64 " audio\n",
+	       stats->video_frames, stats->audio_frames);
+	printf("send latency:    p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, "
+	       "max %.1f ms\n",
+	       percentile_ms(lat, num, 50), percentile_ms(lat, num, 95),
+	       percentile_ms(lat, num, 99), percentile_ms(lat, num, 100));
+	printf("dropped frames:  %d / %d (%.2f%%)\n", dropped, total,
+	       total ? (double)dropped * 100.0 / (double)total : 0.0);
+	printf("bitrate changes: %ld (final %ld kbps)\n",
+	       os_atomic_load_long(&video_bitrate_changes),
+	       os_atomic_load_long(&video_bitrate));
+	printf("connect time:    %d ms\n",
+	       obs_output_get_connect_time_ms(output));
+	printf("disconnects:     %d\n", stats->disconnects);
+
+	if (stats->disconnects && stats->publishes > 1) {
+		int reconnects = stats->publishes - 1;
+		printf("reconnect time:  avg %.0f ms, max %.0f ms\n",
+		       (double)stats->reconnect_total_ns / reconnects /
+			       1000000.0,
+		       (double)stats->reconnect_max_ns / 1000000.0);
+	}
+}
+
+static int run_bench(const struct bench_params *params, struct rtmp_sink *sink)
+{
+	obs_encoder_t *venc, *aenc;
+	obs_service_t *service;
+	obs_output_t *output;
+	obs_data_t *settings;
+	os_event_t *stopped;
+	struct rtmp_sink_stats stats;
+	struct dstr url = {0};
+	int ret = 0;
+
+	dstr_printf(&url, "rtmp://127.0.0.1:%d/live",
+		    rtmp_sink_get_port(sink));
+
+	settings = obs_data_create();
+	obs_data_set_int(settings, "bitrate", params->bitrate);
+	obs_data_set_int(settings, "keyint_sec", params->keyint_sec);
+	venc = obs_video_encoder_create("bench_video_encoder", "video",
+					settings, NULL);
+	obs_data_release(settings);
+
+	settings = obs_data_create();
+	obs_data_set_int(settings, "bitrate", params->audio_bitrate);
+	aenc = obs_audio_encoder_create("bench_audio_encoder", "audio",
+					settings, 0, NULL);
+	obs_data_release(settings);
+
+	settings = obs_data_create();
+	obs_data_set_string(settings, "server", url.array);
+	service = obs_service_create("bench_service", "service", settings,
+				     NULL);
+	obs_data_release(settings);
+
+	settings = obs_data_create();
+	obs_data_set_bool(settings, "dyn_bitrate", params->dbr_policy != NULL);
+	if (params->dbr_policy)
+		obs_data_set_string(settings, "dyn_bitrate_policy",
+				    params->dbr_policy);
+	obs_data_set_bool(settings, "new_socket_loop_enabled",
+			  params->new_socket_loop);
+	obs_data_set_bool(settings, "low_latency_mode_enabled",
+			  params->low_latency);
+	output = obs_output_create("rtmp_output", "output", settings, NULL);
+	obs_data_release(settings);
+
+	if (!venc || !aenc || !service || !output) {
+		fprintf(stderr, "failed to create the output, is the "
+				"obs-outputs module available?\n");
+		ret = 1;
+		goto cleanup;
+	}
+
+	obs_encoder_set_video(venc, obs_get_video());
+	obs_encoder_set_audio(aenc, obs_get_audio());
+	obs_output_set_video_encoder(output, venc);
+	obs_output_set_audio_encoder(output, aenc, 0);
+	obs_output_set_service(output, service);
+	obs_output_set_reconnect_settings(output, 1000, 1);
+
+	os_event_init(&stopped, OS_EVENT_TYPE_MANUAL);
+	signal_handler_connect(obs_output_get_signal_handler(output), "stop",
+			       output_stopped, stopped);
+
+	if (!obs_output_start(output)) {
+		fprintf(stderr, "failed to start the output: %s\n",
+			obs_output_get_last_error(output));
+		ret = 1;
+
+	} else {
+		os_sleep_ms((uint32_t)params->duration_sec * 1000);
+		obs_output_stop(output);
+
+		if (os_event_timedwait(stopped, 10000) != 0)
+			obs_output_force_stop(output);
+
+		rtmp_sink_get_stats(sink, &stats);
+		print_report(output, &stats);
+		rtmp_sink_stats_free(&stats);
+	}
+
+	signal_handler_disconnect(obs_output_get_signal_handler(output),
+				  "stop", output_stopped, stopped);
+	os_event_destroy(stopped);
+
+cleanup:
+	obs_output_release(output);
+	obs_service_release(service);
+	obs_encoder_release(venc);
+	obs_encoder_release(aenc);
+	dstr_free(&url);
+	return ret;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void usage(void)
+{
+	printf("usage: rtmp-bench [options]\n"
+	       "  --duration <sec>          length of the run (30)\n"
+	       "  --bitrate <kbps>          video bitrate (6000)\n"
+	       "  --audio-bitrate <kbps>    audio bitrate (160)\n"
+	       "  --keyint <sec>            keyframe interval (2)\n"
+	       "  --dbr <policy>            enable dynamic bitrate with the "
+	       "given policy\n"
+	       "  --socket-loop             use the threaded socket loop\n"
+	       "  --low-latency             low latency socket loop mode\n"
+	       "  --port <port>             ingest port (any free port)\n"
+	       "  --bandwidth <kbps>        ingest bandwidth (unlimited)\n"
+	       "  --latency <ms>            one-way latency (0)\n"
+	       "  --jitter <ms>             latency jitter (0)\n"
+	       "  --trace <file>            bandwidth schedule, "
+	       "\"<sec> <kbps>\" per line\n"
+	       "  --disconnect-every <sec>  drop the connection periodically\n"
+	       "  --outage <ms>             refuse connections after a drop\n"
+	       "  --verbose                 show libobs info logging\n");
+}
+
+static bool parse_args(int argc, char *argv[], struct bench_params *params)
+{
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+		bool has_val = true;
+
+		if (strcmp(arg, "--socket-loop") == 0) {
+			params->new_socket_loop = true;
+			has_val = false;
+		} else if (strcmp(arg, "--low-latency") == 0) {
+			params->new_socket_loop = true;
+			params->low_latency = true;
+			has_val = false;
+		} else if (strcmp(arg, "--verbose") == 0) {
+			params->verbose = true;
+			has_val = false;
+		} else if (!val) {
+			return false;
+		} else if (strcmp(arg, "--duration") == 0) {
+			params->duration_sec = atoi(val);
+		} else if (strcmp(arg, "--bitrate") == 0) {
+			params->bitrate = atol(val);
+		} else if (strcmp(arg, "--audio-bitrate") == 0) {
+			params->audio_bitrate = atol(val);
+		} else if (strcmp(arg, "--keyint") == 0) {
+			params->keyint_sec = atoi(val);
+		} else if (strcmp(arg, "--dbr") == 0) {
+			params->dbr_policy = val;
+		} else if (strcmp(arg, "--port") == 0) {
+			params->sink.port = atoi(val);
+		} else if (strcmp(arg, "--bandwidth") == 0) {
+			params->sink.bandwidth_kbps = atol(val);
+		} else if (strcmp(arg, "--latency") == 0) {
+			params->sink.latency_ms = atoi(val);
+		} else if (strcmp(arg, "--jitter") == 0) {
+			params->sink.jitter_ms = atoi(val);
+		} else if (strcmp(arg, "--trace") == 0) {
+			params->sink.trace_path = val;
+		} else if (strcmp(arg, "--disconnect-every") == 0) {
+			params->sink.disconnect_interval_sec = atoi(val);
+		} else if (strcmp(arg, "--outage") == 0) {
+			params->sink.outage_ms = atoi(val);
+		} else {
+			return false;
+		}
+
+		if (has_val)
+			i++;
+	}
+
+	return params->duration_sec > 0 && params->bitrate > 0 &&
+	       params->audio_bitrate > 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench_params params = {
+		.duration_sec = 30,
+		.bitrate = 6000,
+		.audio_bitrate = 160,
+		.keyint_sec = 2,
+	};
+	struct rtmp_sink *sink;
+	int ret = 1;
+
+#ifdef _WIN32
+	WSADATA wsad;
+	WSAStartup(MAKEWORD(2, 2), &wsad);
+#endif
+
+	if (!parse_args(argc, argv, &params)) {
+		usage();
+		return 1;
+	}
+
+	base_set_log_handler(do_log, &params.verbose);
+
+	sink = rtmp_sink_create(&params.sink);
+	if (!sink) {
+		fprintf(stderr, "failed to start the ingest sink\n");
+		goto exit;
+	}
+
+	if (!init_obs()) {
+		fprintf(stderr, "failed to initialize libobs\n");
+		goto exit;
+	}
+
+	ret = run_bench(&params, sink);
+
+exit:
+	obs_shutdown();
+	rtmp_sink_destroy(sink);
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return ret;
+}
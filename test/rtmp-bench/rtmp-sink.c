@@ -0,0 +1,849 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/circlebuf.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include "rtmp-sink.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+typedef int SOCKET;
+#define INVALID_SOCKET -1
+#define closesocket close
+#endif
+
+#define HANDSHAKE_SIZE 1536
+#define MAX_CHUNK_STREAMS 64
+#define OUT_CHUNK_SIZE 128
+#define READ_SIZE 16384
+
+#define MSG_SET_CHUNK_SIZE 1
+#define MSG_AUDIO 8
+#define MSG_VIDEO 9
+#define MSG_COMMAND 20
+
+enum sink_state {
+	SINK_HANDSHAKE,
+	SINK_HANDSHAKE_ACK,
+	SINK_CHUNKS,
+};
+
+struct chunk_stream {
+	uint32_t ts;
+	uint32_t ts_delta;
+	uint32_t len;
+	uint8_t type;
+	uint32_t stream_id;
+	DARRAY(uint8_t) body;
+};
+
+struct trace_point {
+	uint64_t ts;
+	long kbps;
+};
+
+struct delay_mark {
+	uint64_t release;
+	size_t size;
+};
+
+struct rtmp_sink {
+	struct rtmp_sink_params params;
+	DARRAY(struct trace_point) trace;
+	uint64_t start_ns;
+
+	SOCKET listen_sock;
+	int port;
+
+	pthread_t thread;
+	bool thread_created;
+	volatile bool stop;
+
+	pthread_mutex_t stats_mutex;
+	struct rtmp_sink_stats stats;
+
+	/* connection */
+	SOCKET sock;
+	enum sink_state state;
+	struct circlebuf in;
+	uint32_t in_chunk_size;
+	struct chunk_stream streams[MAX_CHUNK_STREAMS];
+
+	/* shaping */
+	double tokens;
+	uint64_t last_refill;
+	struct circlebuf delay_data;
+	struct circlebuf delay_marks;
+	uint64_t last_release;
+
+	/* fault injection */
+	uint64_t next_disconnect;
+	uint64_t outage_end;
+	uint64_t disconnect_ts;
+};
+
+/* ------------------------------------------------------------------------- */
+/* bandwidth schedule */
+
+static void load_trace(struct rtmp_sink *sink, const char *path)
+{
+	FILE *file = os_fopen(path, "r");
+	char line[256];
+
+	if (!file) {
+		blog(LOG_WARNING, "rtmp-sink: could not open trace '%s'", path);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		struct trace_point point;
+		double sec;
+
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%lf %ld", &sec, &point.kbps) != 2)
+			continue;
+
+		point.ts = (uint64_t)(sec * 1000000000.0);
+		da_push_back(sink->trace, &point);
+	}
+
+	fclose(file);
+}
+
+static long cur_bandwidth(struct rtmp_sink *sink, uint64_t now)
+{
+	long kbps = sink->params.bandwidth_kbps;
+	uint64_t elapsed = now - sink->start_ns;
+
+	for (size_t i = 0; i < sink->trace.num; i++) {
+		if (sink->trace.array[i].ts > elapsed)
+			break;
+		kbps = sink->trace.array[i].kbps;
+	}
+
+	return kbps;
+}
+
+/* bytes the token bucket currently allows to be read */
+static size_t refill_tokens(struct rtmp_sink *sink, uint64_t now)
+{
+	long kbps = cur_bandwidth(sink, now);
+	double bytes_per_sec = (double)kbps * 1000.0 / 8.0;
+	double burst = bytes_per_sec * 0.05;
+
+	if (kbps <= 0) {
+		sink->last_refill = now;
+		return READ_SIZE;
+	}
+
+	if (burst < 1500.0)
+		burst = 1500.0;
+
+	sink->tokens += (double)(now - sink->last_refill) / 1000000000.0 *
+			bytes_per_sec;
+	if (sink->tokens > burst)
+		sink->tokens = burst;
+	sink->last_refill = now;
+
+	return sink->tokens >= READ_SIZE ? READ_SIZE : (size_t)sink->tokens;
+}
+
+/* ------------------------------------------------------------------------- */
+/* replies */
+
+static bool send_all(struct rtmp_sink *sink, const uint8_t *data, size_t size)
+{
+	while (size) {
+		int ret = send(sink->sock, (const char *)data, (int)size, 0);
+		if (ret <= 0)
+			return false;
+
+		data += ret;
+		size -= ret;
+	}
+
+	return true;
+}
+
+static bool send_message(struct rtmp_sink *sink, uint8_t csid, uint8_t type,
+			 uint32_t stream_id, const uint8_t *body, size_t size)
+{
+	uint8_t header[12];
+
+	header[0] = csid;
+	memset(header + 1, 0, 3);
+	header[4] = (uint8_t)(size >> 16);
+	header[5] = (uint8_t)(size >> 8);
+	header[6] = (uint8_t)size;
+	header[7] = type;
+	header[8] = (uint8_t)stream_id;
+	header[9] = (uint8_t)(stream_id >> 8);
+	header[10] = (uint8_t)(stream_id >> 16);
+	header[11] = (uint8_t)(stream_id >> 24);
+
+	if (!send_all(sink, header, sizeof(header)))
+		return false;
+
+	while (size) {
+		size_t chunk = size < OUT_CHUNK_SIZE ? size : OUT_CHUNK_SIZE;
+		uint8_t cont = 0xC0 | csid;
+
+		if (!send_all(sink, body, chunk))
+			return false;
+
+		body += chunk;
+		size -= chunk;
+
+		if (size && !send_all(sink, &cont, 1))
+			return false;
+	}
+
+	return true;
+}
+
+static uint8_t *amf_string(uint8_t *p, const char *str)
+{
+	size_t len = strlen(str);
+	*p++ = 0x02;
+	*p++ = (uint8_t)(len >> 8);
+	*p++ = (uint8_t)len;
+	memcpy(p, str, len);
+	return p + len;
+}
+
+static uint8_t *amf_number(uint8_t *p, double val)
+{
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+
+	*p++ = 0x00;
+	for (int i = 7; i >= 0; i--)
+		*p++ = (uint8_t)(bits >> (i * 8));
+	return p;
+}
+
+static uint8_t *amf_null(uint8_t *p)
+{
+	*p++ = 0x05;
+	return p;
+}
+
+static uint8_t *amf_prop(uint8_t *p, const char *name, const char *val)
+{
+	size_t len = strlen(name);
+	*p++ = (uint8_t)(len >> 8);
+	*p++ = (uint8_t)len;
+	memcpy(p, name, len);
+	return amf_string(p + len, val);
+}
+
+static uint8_t *amf_status(uint8_t *p, const char *level, const char *code)
+{
+	*p++ = 0x03;
+	p = amf_prop(p, "level", level);
+	p = amf_prop(p, "code", code);
+	*p++ = 0;
+	*p++ = 0;
+	*p++ = 0x09;
+	return p;
+}
+
+static bool reply_connect(struct rtmp_sink *sink, double txn)
+{
+	uint8_t buf[256], *p = buf;
+
+	p = amf_string(p, "_result");
+	p = amf_number(p, txn);
+	p = amf_null(p);
+	p = amf_status(p, "status", "NetConnection.Connect.Success");
+	return send_message(sink, 3, MSG_COMMAND, 0, buf, p - buf);
+}
+
+static bool reply_create_stream(struct rtmp_sink *sink, double txn)
+{
+	uint8_t buf[64], *p = buf;
+
+	p = amf_string(p, "_result");
+	p = amf_number(p, txn);
+	p = amf_null(p);
+	p = amf_number(p, 1.0);
+	return send_message(sink, 3, MSG_COMMAND, 0, buf, p - buf);
+}
+
+static bool reply_publish(struct rtmp_sink *sink)
+{
+	uint8_t buf[256], *p = buf;
+
+	p = amf_string(p, "onStatus");
+	p = amf_number(p, 0.0);
+	p = amf_null(p);
+	p = amf_status(p, "status", "NetStream.Publish.Start");
+	return send_message(sink, 5, MSG_COMMAND, 1, buf, p - buf);
+}
+
+/* ------------------------------------------------------------------------- */
+/* incoming messages */
+
+static bool read_command(const uint8_t *body, size_t size, char *name,
+			 size_t name_size, double *txn)
+{
+	size_t len;
+	uint64_t bits = 0;
+
+	if (size < 3 || body[0] != 0x02)
+		return false;
+
+	len = ((size_t)body[1] << 8) | body[2];
+	if (3 + len + 9 > size || len >= name_size)
+		return false;
+
+	memcpy(name, body + 3, len);
+	name[len] = 0;
+
+	body += 3 + len;
+	if (body[0] != 0x00)
+		return false;
+
+	for (int i = 1; i <= 8; i++)
+		bits = (bits << 8) | body[i];
+	memcpy(txn, &bits, sizeof(*txn));
+	return true;
+}
+
+static bool handle_command(struct rtmp_sink *sink, struct chunk_stream *cs)
+{
+	char name[64];
+	double txn;
+
+	if (!read_command(cs->body.array, cs->body.num, name, sizeof(name),
+			  &txn))
+		return true;
+
+	if (strcmp(name, "connect") == 0)
+		return reply_connect(sink, txn);
+	if (strcmp(name, "createStream") == 0)
+		return reply_create_stream(sink, txn);
+
+	if (strcmp(name, "publish") == 0) {
+		uint64_t now = os_gettime_ns();
+
+		pthread_mutex_lock(&sink->stats_mutex);
+		sink->stats.publishes++;
+		if (sink->disconnect_ts) {
+			uint64_t gap = now - sink->disconnect_ts;
+
+			sink->stats.reconnect_total_ns += gap;
+			if (gap > sink->stats.reconnect_max_ns)
+				sink->stats.reconnect_max_ns = gap;
+			sink->disconnect_ts = 0;
+		}
+		pthread_mutex_unlock(&sink->stats_mutex);
+
+		return reply_publish(sink);
+	}
+
+	return true;
+}
+
+static void handle_media(struct rtmp_sink *sink, struct chunk_stream *cs)
+{
+	uint64_t now = os_gettime_ns();
+	const uint8_t *body = cs->body.array;
+	size_t size = cs->body.num;
+
+	/* 5 byte tag prefix, 4 byte nal size, nal header, then the stamp */
+	const size_t stamp_offset = 5 + 4 + 1;
+
+	pthread_mutex_lock(&sink->stats_mutex);
+
+	if (!sink->stats.first_media_ns)
+		sink->stats.first_media_ns = now;
+	sink->stats.last_media_ns = now;
+	sink->stats.media_bytes += size;
+
+	if (cs->type == MSG_AUDIO) {
+		sink->stats.audio_frames++;
+
+	} else {
+		sink->stats.video_frames++;
+
+		if (size >= stamp_offset + RTMP_SINK_STAMP_SIZE &&
+		    body[1] == 1) {
+			uint64_t ts = rtmp_sink_read_stamp(body + stamp_offset);
+			if (ts && ts <= now) {
+				uint32_t usec = (uint32_t)((now - ts) / 1000);
+				da_push_back(sink->stats.latency_usec, &usec);
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&sink->stats_mutex);
+}
+
+static bool handle_message(struct rtmp_sink *sink, struct chunk_stream *cs)
+{
+	const uint8_t *body = cs->body.array;
+
+	switch (cs->type) {
+	case MSG_SET_CHUNK_SIZE:
+		if (cs->body.num >= 4)
+			sink->in_chunk_size =
+				(((uint32_t)body[0] << 24) | (body[1] << 16) |
+				 (body[2] << 8) | body[3]) &
+				0x7FFFFFFF;
+		return sink->in_chunk_size != 0;
+	case MSG_COMMAND:
+		return handle_command(sink, cs);
+	case MSG_AUDIO:
+	case MSG_VIDEO:
+		handle_media(sink, cs);
+		return true;
+	}
+
+	return true;
+}
+
+static inline uint32_t rb24(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+/* returns 1 if a chunk was consumed, 0 if more data is needed, -1 on error */
+static int parse_chunk(struct rtmp_sink *sink)
+{
+	static const size_t msg_header_size[] = {11, 7, 3, 0};
+	struct chunk_stream *cs;
+	uint8_t hdr[18];
+	const uint8_t *msg;
+	size_t avail = sink->in.size;
+	size_t pos = 1;
+	size_t payload;
+	uint32_t ts_field = 0;
+	uint32_t len;
+	uint8_t fmt;
+	uint32_t csid;
+
+	if (!avail)
+		return 0;
+
+	circlebuf_peek_front(&sink->in, hdr, avail < 18 ? avail : 18);
+
+	fmt = hdr[0] >> 6;
+	csid = hdr[0] & 0x3F;
+	if (csid == 0) {
+		if (avail < 2)
+			return 0;
+		csid = 64 + hdr[1];
+		pos = 2;
+	} else if (csid == 1) {
+		if (avail < 3)
+			return 0;
+		csid = 64 + hdr[1] + hdr[2] * 256;
+		pos = 3;
+	}
+
+	if (csid >= MAX_CHUNK_STREAMS)
+		return -1;
+
+	cs = &sink->streams[csid];
+	msg = hdr + pos;
+
+	if (avail < pos + msg_header_size[fmt])
+		return 0;
+
+	len = cs->len;
+	if (fmt <= 2)
+		ts_field = rb24(msg);
+	if (fmt <= 1)
+		len = rb24(msg + 3);
+
+	pos += msg_header_size[fmt];
+	if (fmt <= 2 && ts_field == 0xFFFFFF) {
+		if (avail < pos + 4)
+			return 0;
+		ts_field = ((uint32_t)hdr[pos] << 24) | rb24(hdr + pos + 1);
+		pos += 4;
+	}
+
+	payload = len - cs->body.num;
+	if (payload > sink->in_chunk_size)
+		payload = sink->in_chunk_size;
+	if (avail < pos + payload)
+		return 0;
+
+	/* the whole chunk is here, commit the header */
+	if (fmt <= 1) {
+		cs->len = len;
+		cs->type = msg[6];
+	}
+
+	circlebuf_pop_front(&sink->in, NULL, pos);
+
+	if (fmt == 0) {
+		cs->stream_id = msg[7] | (msg[8] << 8) | (msg[9] << 16) |
+				((uint32_t)msg[10] << 24);
+		cs->ts = ts_field;
+	} else if (fmt <= 2) {
+		cs->ts_delta = ts_field;
+		if (!cs->body.num)
+			cs->ts += ts_field;
+	}
+
+	da_resize(cs->body, cs->body.num + payload);
+	circlebuf_pop_front(&sink->in, cs->body.array + cs->body.num - payload,
+			    payload);
+
+	if (cs->body.num == cs->len) {
+		bool success = handle_message(sink, cs);
+		da_resize(cs->body, 0);
+		if (!success)
+			return -1;
+	}
+
+	return 1;
+}
+
+static bool send_handshake(struct rtmp_sink *sink, const uint8_t *c1)
+{
+	uint8_t s0s1[HANDSHAKE_SIZE + 1] = {0x03};
+
+	return send_all(sink, s0s1, sizeof(s0s1)) &&
+	       send_all(sink, c1, HANDSHAKE_SIZE);
+}
+
+static bool parse_input(struct rtmp_sink *sink)
+{
+	uint8_t c1[HANDSHAKE_SIZE + 1];
+
+	for (;;) {
+		int ret;
+
+		switch (sink->state) {
+		case SINK_HANDSHAKE:
+			if (sink->in.size < HANDSHAKE_SIZE + 1)
+				return true;
+
+			circlebuf_pop_front(&sink->in, c1, sizeof(c1));
+			if (c1[0] != 0x03 || !send_handshake(sink, c1 + 1))
+				return false;
+
+			sink->state = SINK_HANDSHAKE_ACK;
+			break;
+
+		case SINK_HANDSHAKE_ACK:
+			if (sink->in.size < HANDSHAKE_SIZE)
+				return true;
+
+			circlebuf_pop_front(&sink->in, NULL, HANDSHAKE_SIZE);
+			sink->state = SINK_CHUNKS;
+			break;
+
+		case SINK_CHUNKS:
+			ret = parse_chunk(sink);
+			if (ret <= 0)
+				return ret == 0;
+			break;
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* connection handling */
+
+static void reset_connection(struct rtmp_sink *sink)
+{
+	sink->state = SINK_HANDSHAKE;
+	sink->in_chunk_size = 128;
+	circlebuf_pop_front(&sink->in, NULL, sink->in.size);
+	circlebuf_pop_front(&sink->delay_data, NULL, sink->delay_data.size);
+	circlebuf_pop_front(&sink->delay_marks, NULL, sink->delay_marks.size);
+	sink->last_release = 0;
+	sink->tokens = 0.0;
+	sink->last_refill = os_gettime_ns();
+
+	for (size_t i = 0; i < MAX_CHUNK_STREAMS; i++) {
+		struct chunk_stream *cs = &sink->streams[i];
+		da_resize(cs->body, 0);
+		cs->ts = cs->ts_delta = cs->len = cs->stream_id = 0;
+		cs->type = 0;
+	}
+}
+
+static void drop_connection(struct rtmp_sink *sink, bool injected)
+{
+	uint64_t now = os_gettime_ns();
+
+	closesocket(sink->sock);
+	sink->sock = INVALID_SOCKET;
+
+	if (injected) {
+		pthread_mutex_lock(&sink->stats_mutex);
+		sink->stats.disconnects++;
+		pthread_mutex_unlock(&sink->stats_mutex);
+
+		sink->disconnect_ts = now;
+		sink->outage_end =
+			now + (uint64_t)sink->params.outage_ms * 1000000ULL;
+	}
+}
+
+static bool wait_readable(SOCKET sock, int timeout_ms)
+{
+	struct timeval tv = {0, timeout_ms * 1000};
+	fd_set fds;
+
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+	return select((int)sock + 1, &fds, NULL, NULL, &tv) > 0;
+}
+
+static void accept_connection(struct rtmp_sink *sink)
+{
+	SOCKET sock;
+	int one = 1;
+
+	if (!wait_readable(sink->listen_sock, 10))
+		return;
+
+	sock = accept(sink->listen_sock, NULL, NULL);
+	if (sock == INVALID_SOCKET)
+		return;
+
+	if (os_gettime_ns() < sink->outage_end) {
+		closesocket(sock);
+		return;
+	}
+
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&one,
+		   sizeof(one));
+
+	sink->sock = sock;
+	reset_connection(sink);
+
+	if (sink->params.disconnect_interval_sec)
+		sink->next_disconnect =
+			os_gettime_ns() +
+			(uint64_t)sink->params.disconnect_interval_sec *
+				1000000000ULL;
+}
+
+static void queue_input(struct rtmp_sink *sink, const uint8_t *data,
+			size_t size, uint64_t now)
+{
+	struct delay_mark mark;
+	uint64_t delay;
+
+	if (!sink->params.latency_ms && !sink->params.jitter_ms) {
+		circlebuf_push_back(&sink->in, data, size);
+		return;
+	}
+
+	delay = (uint64_t)sink->params.latency_ms * 1000000ULL;
+	if (sink->params.jitter_ms)
+		delay += (uint64_t)(rand() % (sink->params.jitter_ms + 1)) *
+			 1000000ULL;
+
+	/* jitter delays data but never reorders it */
+	mark.release = now + delay;
+	if (mark.release < sink->last_release)
+		mark.release = sink->last_release;
+	sink->last_release = mark.release;
+	mark.size = size;
+
+	circlebuf_push_back(&sink->delay_data, data, size);
+	circlebuf_push_back(&sink->delay_marks, &mark, sizeof(mark));
+}
+
+static void release_input(struct rtmp_sink *sink, uint64_t now)
+{
+	uint8_t buf[READ_SIZE];
+
+	while (sink->delay_marks.size) {
+		struct delay_mark mark;
+
+		circlebuf_peek_front(&sink->delay_marks, &mark, sizeof(mark));
+		if (mark.release > now)
+			break;
+
+		circlebuf_pop_front(&sink->delay_marks, NULL, sizeof(mark));
+		circlebuf_pop_front(&sink->delay_data, buf, mark.size);
+		circlebuf_push_back(&sink->in, buf, mark.size);
+	}
+}
+
+static void service_connection(struct rtmp_sink *sink)
+{
+	uint8_t buf[READ_SIZE];
+	uint64_t now = os_gettime_ns();
+	size_t allowed;
+
+	if (sink->params.disconnect_interval_sec &&
+	    now >= sink->next_disconnect) {
+		drop_connection(sink, true);
+		return;
+	}
+
+	allowed = refill_tokens(sink, now);
+
+	if (!allowed) {
+		os_sleep_ms(1);
+
+	} else if (wait_readable(sink->sock, 1)) {
+		int ret = recv(sink->sock, (char *)buf, (int)allowed, 0);
+		if (ret <= 0) {
+			drop_connection(sink, false);
+			return;
+		}
+
+		if (cur_bandwidth(sink, now) > 0)
+			sink->tokens -= (double)ret;
+
+		queue_input(sink, buf, (size_t)ret, now);
+	}
+
+	release_input(sink, os_gettime_ns());
+
+	if (!parse_input(sink))
+		drop_connection(sink, false);
+}
+
+static void *sink_thread(void *data)
+{
+	struct rtmp_sink *sink = data;
+
+	os_set_thread_name("rtmp-sink");
+
+	while (!os_atomic_load_bool(&sink->stop)) {
+		if (sink->sock == INVALID_SOCKET)
+			accept_connection(sink);
+		else
+			service_connection(sink);
+	}
+
+	if (sink->sock != INVALID_SOCKET)
+		drop_connection(sink, false);
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool open_listen_socket(struct rtmp_sink *sink)
+{
+	struct sockaddr_in addr = {0};
+	socklen_t addr_len = sizeof(addr);
+	int one = 1;
+
+	sink->listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sink->listen_sock == INVALID_SOCKET)
+		return false;
+
+	setsockopt(sink->listen_sock, SOL_SOCKET, SO_REUSEADDR,
+		   (const char *)&one, sizeof(one));
+
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons((uint16_t)sink->params.port);
+
+	if (bind(sink->listen_sock, (struct sockaddr *)&addr, sizeof(addr)) !=
+	    0)
+		return false;
+	if (listen(sink->listen_sock, 4) != 0)
+		return false;
+	if (getsockname(sink->listen_sock, (struct sockaddr *)&addr,
+			&addr_len) != 0)
+		return false;
+
+	sink->port = ntohs(addr.sin_port);
+	return true;
+}
+
+struct rtmp_sink *rtmp_sink_create(const struct rtmp_sink_params *params)
+{
+	struct rtmp_sink *sink = bzalloc(sizeof(*sink));
+
+	sink->params = *params;
+	sink->params.trace_path = NULL;
+	sink->listen_sock = INVALID_SOCKET;
+	sink->sock = INVALID_SOCKET;
+	sink->start_ns = os_gettime_ns();
+	pthread_mutex_init_value(&sink->stats_mutex);
+
+	if (params->trace_path)
+		load_trace(sink, params->trace_path);
+
+	if (pthread_mutex_init(&sink->stats_mutex, NULL) != 0)
+		goto fail;
+	if (!open_listen_socket(sink)) {
+		blog(LOG_WARNING, "rtmp-sink: failed to listen on port %d",
+		     params->port);
+		goto fail;
+	}
+	if (pthread_create(&sink->thread, NULL, sink_thread, sink) != 0)
+		goto fail;
+
+	sink->thread_created = true;
+	return sink;
+
+fail:
+	rtmp_sink_destroy(sink);
+	return NULL;
+}
+
+void rtmp_sink_destroy(struct rtmp_sink *sink)
+{
+	if (!sink)
+		return;
+
+	if (sink->thread_created) {
+		os_atomic_set_bool(&sink->stop, true);
+		pthread_join(sink->thread, NULL);
+	}
+
+	if (sink->listen_sock != INVALID_SOCKET)
+		closesocket(sink->listen_sock);
+
+	for (size_t i = 0; i < MAX_CHUNK_STREAMS; i++)
+		da_free(sink->streams[i].body);
+
+	circlebuf_free(&sink->in);
+	circlebuf_free(&sink->delay_data);
+	circlebuf_free(&sink->delay_marks);
+	da_free(sink->trace);
+	rtmp_sink_stats_free(&sink->stats);
+	pthread_mutex_destroy(&sink->stats_mutex);
+	bfree(sink);
+}
+
+int rtmp_sink_get_port(const struct rtmp_sink *sink)
+{
+	return sink->port;
+}
+
+void rtmp_sink_get_stats(struct rtmp_sink *sink, struct rtmp_sink_stats *stats)
+{
+	pthread_mutex_lock(&sink->stats_mutex);
+	*stats = sink->stats;
+	memset(&stats->latency_usec, 0, sizeof(stats->latency_usec));
+	da_copy(stats->latency_usec, sink->stats.latency_usec);
+	pthread_mutex_unlock(&sink->stats_mutex);
+}
+
+void rtmp_sink_stats_free(struct rtmp_sink_stats *stats)
+{
+	da_free(stats->latency_usec);
+}
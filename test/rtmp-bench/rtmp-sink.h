@@ -0,0 +1,79 @@
+#pragma once
+
+#include <util/c99defs.h>
+#include <util/darray.h>
+
+/* Minimal RTMP ingest on loopback.  Accepts one publisher at a time, answers
+ * just enough of the command exchange for librtmp to start publishing, and
+ * counts what arrives.  Incoming data is shaped before it is parsed:
+ *
+ *   bandwidth - the socket is read through a token bucket, so TCP flow
+ *               control pushes back on the sender
+ *   latency   - received bytes are held back for latency + jitter before
+ *               being parsed, which also delays every command reply
+ *   disconnects - the connection is dropped periodically and new
+ *               connections are refused for the outage period
+ *
+ * A trace file replaces the fixed bandwidth with a recorded schedule, one
+ * "<seconds> <kbps>" pair per line, each value holding until the next. */
+
+struct rtmp_sink_params {
+	int port; /* 0 picks a free port */
+
+	long bandwidth_kbps; /* 0 for unlimited */
+	int latency_ms;
+	int jitter_ms;
+
+	int disconnect_interval_sec; /* 0 for never */
+	int outage_ms;
+
+	const char *trace_path;
+};
+
+struct rtmp_sink_stats {
+	uint64_t media_bytes;
+	uint64_t video_frames;
+	uint64_t audio_frames;
+	uint64_t first_media_ns;
+	uint64_t last_media_ns;
+
+	/* encoder-to-ingest latency of each video frame, in microseconds */
+	DARRAY(uint32_t) latency_usec;
+
+	int publishes;
+	int disconnects;
+	uint64_t reconnect_total_ns;
+	uint64_t reconnect_max_ns;
+};
+
+struct rtmp_sink;
+
+extern struct rtmp_sink *
+rtmp_sink_create(const struct rtmp_sink_params *params);
+extern void rtmp_sink_destroy(struct rtmp_sink *sink);
+
+extern int rtmp_sink_get_port(const struct rtmp_sink *sink);
+
+/* copies the stats, free with rtmp_sink_stats_free */
+extern void rtmp_sink_get_stats(struct rtmp_sink *sink,
+				struct rtmp_sink_stats *stats);
+extern void rtmp_sink_stats_free(struct rtmp_sink_stats *stats);
+
+/* video payloads carry the time they were encoded so the sink can measure
+ * latency; the stamp is written without zero bytes so it cannot be mistaken
+ * for an annex-b start code */
+#define RTMP_SINK_STAMP_SIZE 16
+
+static inline void rtmp_sink_write_stamp(uint8_t *dst, uint64_t ts)
+{
+	for (int i = 0; i < RTMP_SINK_STAMP_SIZE; i++)
+		dst[i] = (uint8_t)(0x40 | ((ts >> (60 - i * 4)) & 0xF));
+}
+
+static inline uint64_t rtmp_sink_read_stamp(const uint8_t *src)
+{
+	uint64_t ts = 0;
+	for (int i = 0; i < RTMP_SINK_STAMP_SIZE; i++)
+		ts = (ts << 4) | (src[i] & 0xF);
+	return ts;
+}